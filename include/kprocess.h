@@ -261,6 +261,8 @@ public:
     void* reTranslateChunkAddress; // will be called when the program tries to jump to memory that hasn't been translated yet or needs to be retranslated
     void* reTranslateChunkAddressFromReg; // will be called when the program tries to jump to memory that hasn't been translated yet or needs to be retranslated
     void* returnToLoopAddress; // will be called after a syscall if x64CPU.exitToStartThreadLoop is set to true.  This return will cause the program to return to x64CPU::run()
+    void* reTranslateLinkAddress; // link slots that pointed to a chunk that was released are pointed here, it translates cpu->eip again
+    void* formTraceAddress; // a link that was taken KSystem::btTraceThreshold times jumps here, see BtCPU::formTrace
 #ifdef BOXEDWINE_BT_DEBUG_NO_EXCEPTIONS
     void* jmpAndTranslateIfNecessary;
 #endif
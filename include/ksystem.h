@@ -80,9 +80,16 @@ public:
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
     static bool useLargeAddressSpace;
     static bool useSingleMemOffset;
+    static U32 btTranslationThreads;
+    static bool btShadowStack;
+    static U32 btCodeCacheSize; // MB, 0 means unlimited
+    static U32 btHotThreshold; // times a block is interpreted before it is translated, 0 means translate everything
+    static bool btSubPageCodeWrites; // a write to a page with code only throws away the code that overlaps it
+    static U32 btTraceThreshold; // times a jump between 2 chunks is taken before they are translated again as one, 0 means never
 #endif
 #ifdef BOXEDWINE_MULTI_THREADED
     static U32 cpuAffinityCountForApp;
+    static bool spinBackoff; // guest threads that spin give up their host core, see CPU::spinWait
 #endif
     static U32 pollRate;
     static bool showWindowImmediately;
@@ -148,7 +148,7 @@ public:
 private:
     void clearFutexes();
 
-#ifdef BOXEDWINE_BINARY_TRANSLATOR
+#ifdef BOXEDWINE_MULTI_THREADED
     THREAD_LOCAL
 #endif
     static KThread* runningThread;
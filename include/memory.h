@@ -79,6 +79,9 @@ class CPU;
 class DecodedOp;
 class DecodedBlock;
 class BtCodeChunk;
+class BtCPU;
+class BtSharedCodeFile;
+class NormalCPU;
 
 typedef void (OPCALL *OpCallback)(CPU* cpu, DecodedOp* op);
 
@@ -132,11 +135,46 @@ public:
     void setPage(U32 index, Page* page);
     inline Page* getPage(U32 index) {return this->mmu[index];}
 
+#ifdef BOXEDWINE_MULTI_THREADED
+    THREAD_LOCAL static Page** currentMMU;
+    THREAD_LOCAL static U8** currentMMUReadPtr;
+    THREAD_LOCAL static U8** currentMMUWritePtr;
+#else
     static Page** currentMMU;
     static U8** currentMMUReadPtr;
     static U8** currentMMUWritePtr;
 #endif
 
+    // guards replacing pages in mmu and the code cache, the normal core's blocks and links live in the code pages
+    BOXEDWINE_MUTEX pageMutex;
+
+#ifdef BOXEDWINE_MULTI_THREADED
+    // Blocks and pages that are removed while other threads are running can't be freed right away, another thread
+    // might be in the middle of the block or of a read through the old page.  Each one bumps codeEpoch and is freed
+    // once every thread in codeThreads has started a new block with an epoch at least that new, see reclaimRetiredCode.
+    // A thread waiting in a syscall is still in its block, so it holds back everything retired after it went in.
+    class RetiredCode {
+    public:
+        RetiredCode(DecodedBlock* block, Page* page, U64 epoch) : block(block), page(page), epoch(epoch) {}
+        DecodedBlock* block;
+        Page* page;
+        U64 epoch;
+    };
+    std::list<RetiredCode> retiredCode;
+    std::list<NormalCPU*> codeThreads;
+    U64 codeEpoch;
+    U64 retiredCodeCount;
+    U64 reclaimedCodeCount;
+
+    void addCodeThread(NormalCPU* cpu);
+    void removeCodeThread(NormalCPU* cpu);
+    // must hold pageMutex
+    void retireBlock(DecodedBlock* block);
+    void retirePage(Page* page);
+    void reclaimRetiredCode();
+#endif
+#endif
+
 #ifdef BOXEDWINE_DYNAMIC
     std::vector<void*> dynamicExecutableMemory;
     U32 dynamicExecutableMemoryPos;
@@ -190,13 +228,152 @@ private:
 #define EXECUTABLE_MAX_SIZE_POWER 22
 #define EXECUTABLE_SIZES 16
 
-    std::unordered_map<U32, std::shared_ptr< std::list< std::shared_ptr<BtCodeChunk> > >> codeChunksByHostPage;
     std::unordered_map<U32, std::shared_ptr< std::list< std::shared_ptr<BtCodeChunk> > >> codeChunksByEmulationPage;
 
+    // Host address -> chunk lookups come from the exception handler, so they can't take a lock or allocate.  Every
+    // block from allocExecutable64kBlock is only ever split into slots of one size and a chunk always starts at the
+    // start of its slot, so finding the block with a binary search is enough to index straight into its slots.
+    //
+    // The sorted block list is never changed once published, adding a block publishes a copy and retires the old one
+    // the same way freed code is retired, so a thread in generated code can keep reading whichever one it loaded.
+    class ExecutableBlock {
+    public:
+        U8* memory;
+        U32 size;
+        U32 slotShift;
+        std::atomic<BtCodeChunk*>* slots;
+    };
+    class ExecutableBlockIndex {
+    public:
+        U32 count;
+        U64 epoch; // set once retired
+        ExecutableBlock blocks[1];
+    };
+    std::atomic<ExecutableBlockIndex*> executableBlockIndex;
+    std::list<ExecutableBlockIndex*> retiredExecutableBlockIndexes;
+
+    void addExecutableBlock(U8* memory, U32 size, U32 slotShift);
+    const ExecutableBlock* findExecutableBlock(void* address);
+    std::atomic<BtCodeChunk*>* findExecutableSlot(void* address);
+    void freeExecutableBlockIndexes();
+
     std::list<void*> freeExecutableMemory[EXECUTABLE_SIZES];
+
+    // Executable memory that has been freed can't be handed out again right away, another thread might still be
+    // running the old code or be about to return to it from a call into the host.  Each free bumps
+    // executableMemoryEpoch, the block is reused once every thread in codeThreads has been seen at a safe point with
+    // an epoch at least that new, see reclaimExecutableMemory
+    class RetiredExecutableMemory {
+    public:
+        RetiredExecutableMemory(void* memory, U32 size, U64 epoch, const std::shared_ptr<BtCodeChunk>& chunk, bool canReuse) : memory(memory), size(size), epoch(epoch), chunk(chunk), canReuse(canReuse) {}
+        void* memory;
+        U32 size;
+        U64 epoch;
+        // kept alive so that a lookup by host address that raced with the release never sees a deleted chunk, evicted
+        // chunks also keep their code intact and findable by host address until reclaimed
+        std::shared_ptr<BtCodeChunk> chunk;
+        bool canReuse;
+    };
+    std::list<RetiredExecutableMemory> retiredExecutableMemory;
+    std::list<BtCPU*> codeThreads;
+
+    // Code is released while pageMutex is held (mmap/mprotect clearing a code page), but the translator takes
+    // pageMutex while it holds executableMemoryMutex.  So retireExecutableMemory never takes executableMemoryMutex, it
+    // pushes the memory here and it is moved to retiredExecutableMemory, with its epoch, by
+    // drainPendingExecutableMemory the next time executableMemoryMutex is held.  Taking the epoch later than the
+    // release only delays the reuse.
+    class PendingExecutableMemory {
+    public:
+        PendingExecutableMemory(void* memory, U32 size, const std::shared_ptr<BtCodeChunk>& chunk, bool canReuse) : memory(memory), size(size), chunk(chunk), canReuse(canReuse), next(NULL) {}
+        void* memory;
+        U32 size;
+        std::shared_ptr<BtCodeChunk> chunk;
+        bool canReuse;
+        PendingExecutableMemory* next;
+    };
+    std::atomic<PendingExecutableMemory*> pendingExecutableMemory;
+    void drainPendingExecutableMemory();
+
+    // chunks in the order they were made live, used as the clock for evictExecutableMemory
+    std::list<std::weak_ptr<BtCodeChunk>> codeChunkClock;
+    size_t codeChunkClockPruneSize;
+
+    // pages privately mapped from a file, each one holds a reference to the file's shared translations, see
+    // BtCodeCache.  It has its own lock since it is looked up while translating, which can't take pageMutex.
+    class SharedCodePage {
+    public:
+        std::shared_ptr<BtSharedCodeFile> file;
+        U64 offset; // into the file
+    };
+    std::unordered_map<U32, SharedCodePage> sharedCodePages; // by emulated page
+    BOXEDWINE_MUTEX sharedCodePagesMutex;
+
+    void removeCodeChunkHostMapping(const std::shared_ptr<BtCodeChunk>& chunk);
+
+    // Pages that mix code and data would otherwise throw away all of their code on every data write.  codeRegions has
+    // a bit for each CODE_REGION_SIZE bytes of the page that might have translated code, a bit is set when a chunk is
+    // added and cleared once a write to the region finds that its code is gone.  A page that takes more than
+    // MAX_CODE_PAGE_DATA_WRITE_COUNT data write faults in a second faults too often to be worth it, from then on it goes
+    // back to throwing away all of its code on a write, which eventually makes it dynamic.
+#define CODE_REGION_SHIFT 6
+#define CODE_REGION_SIZE (1 << CODE_REGION_SHIFT)
+#define MAX_CODE_PAGE_DATA_WRITE_COUNT 0x100
+    class CodePageWrites {
+    public:
+        CodePageWrites() : codeRegions(0), dataWriteCount(0), dataWriteTime(0) {}
+        U64 codeRegions;
+        U32 dataWriteCount;
+        U64 dataWriteTime; // when dataWriteCount started counting
+    };
+    std::unordered_map<U32, CodePageWrites> codePageWrites; // by emulated page
+    U64 findCodeRegions(U32 page);
+    // the chunks that overlap address to address+len-1, in no particular order
+    void getCodeChunksInRange(U32 address, U32 len, std::vector<std::shared_ptr<BtCodeChunk>>& chunks);
+    void addCodeRegions(U64* regions, U32 page, U32 address, U32 len);
 public:
+    U64 executableMemoryEpoch;
+    // Anything that holds on to host code addresses outside of the chunk links, like the x64 shadow return stack,
+    // compares this to know if they are still valid.  [0] is the generation << 32, [1] is the negative of that so that
+    // generated code can compare with lea.  Only releasing code of this Memory moves it.
+    U64 codeGeneration[2];
+    // must be called after translated code of this Memory has been freed
+    void codeReleased();
+    std::atomic<U64> liveExecutableMemorySize; // bytes handed out by allocateExcutableMemory and not freed yet
+    U64 retiredExecutableMemoryCount;
+    U64 reclaimedExecutableMemoryCount;
+    U64 evictedCodeChunkCount;
+    // all processes together
+    static std::atomic<U64> allLiveExecutableMemorySize;
+    static U64 peakLiveExecutableMemorySize;
+
+    // file can be NULL to clear the pages
+    void setSharedCodeFile(U32 page, U32 pageCount, const std::shared_ptr<BtSharedCodeFile>& file, U64 offset);
+    // returns NULL unless every page from address to address+len-1 is mapped from the same run of the same file,
+    // fileOffset is set to where address is in the file
+    std::shared_ptr<BtSharedCodeFile> getSharedCodeFile(U32 address, U32 len, U64* fileOffset);
+
+    void addCodeThread(BtCPU* cpu);
+    void removeCodeThread(BtCPU* cpu);
+    void reclaimExecutableMemory();
+    bool isCodeCacheOverLimit();
+    // releases chunks that haven't been used recently until the code cache is back under KSystem::btCodeCacheSize,
+    // the calling thread must not be in the middle of generated code, other than at its codePin
+    void evictExecutableMemory();
+    // lock free, it can be called with pageMutex held
+    void retireExecutableMemory(void* hostMemory, U32 size, const std::shared_ptr<BtCodeChunk>& chunk, bool canReuse = true);
     std::shared_ptr<BtCodeChunk> getCodeChunkContainingHostAddress(void* hostAddress);
+    // lock free and safe to call from the exception handler of a thread that is in generated code
+    BtCodeChunk* findCodeChunkContainingHostAddress(void* hostAddress);
     void clearHostCodeForWriting(U32 nativePage, U32 count);
+    // used instead of clearHostCodeForWriting with KSystem::btSubPageCodeWrites, only throws away the code that
+    // overlaps the bytes being written.  Returns true if some of the pages still have code and must stay read-only, see
+    // allowCodePageWrite.  fault is true if the write faulted, a fault that misses the code counts against the page.
+    bool clearHostCodeOverlapping(U32 address, U32 len, bool fault);
+    // lets the caller write to read-only code pages until updatePagePermission is called for them
+    void allowCodePageWrite(U32 address, U32 len);
+    U64 getCodeRegions(U32 page);
+    U64 codePageDataWriteCount; // writes to a read-only code page that missed its code
+    U64 codePageCodeWriteCount; // writes to a read-only code page that threw away some of its code
     bool clearCodePageReadOnly(U32 nativePage);
     void makeCodePageReadOnly(U32 nativePage);
     void reserveNativeMemory();
@@ -205,12 +382,13 @@ public:
 
     std::shared_ptr<BtCodeChunk> getCodeChunkContainingEip(U32 eip);
     void addCodeChunk(const std::shared_ptr<BtCodeChunk>& chunk);
-    void removeCodeChunk(const std::shared_ptr<BtCodeChunk>& chunk);
+    void removeCodeChunk(const std::shared_ptr<BtCodeChunk>& chunk, bool keepHostMapping = false);
     void makeNativePageDynamic(U32 nativePage);
     void* getExistingHostAddress(U32 eip);
     void* allocateExcutableMemory(U32 size, U32* allocatedSize);
-    void freeExcutableMemory(void* hostMemory, U32 size);
+    void freeExcutableMemory(void* hostMemory, U32 size, bool canReuse = true, const std::shared_ptr<BtCodeChunk>& chunk = nullptr);
     void executableMemoryReleased();
+    // lock free, see findCodeChunkContainingHostAddress
     bool isAddressExecutable(void* address);
 
     void allocNativeMemory(U32 page, U32 pageCount, U32 flags);
@@ -178,11 +178,12 @@ void platformHandler(int sig, siginfo_t* info, void* vcontext) {
     if (armCpu->exceptionIp == 0) {
         kpanic("oops jumps to 0");
     }
-    if (cpu->thread->memory->isAddressExecutable((void*)armCpu->exceptionIp)) {
-        unsigned char* hostAddress = (unsigned char*)armCpu->exceptionIp;
-        std::shared_ptr<BtCodeChunk> chunk = cpu->thread->memory->getCodeChunkContainingHostAddress(hostAddress);
-        if (chunk && chunk->getEipLen()) { // during start up eip is already set
-            cpu->eip.u32 = chunk->getEipThatContainsHostAddress(hostAddress, NULL, NULL) - cpu->seg[CS].address;
+    // this is a signal handler, so only the lock free lookup is used here
+    BtCodeChunk* chunk = cpu->thread->memory->findCodeChunkContainingHostAddress((void*)armCpu->exceptionIp);
+    if (chunk && chunk->getEipLen()) { // during start up eip is already set
+        U32 eip = chunk->getEipThatContainsHostAddress((void*)armCpu->exceptionIp, NULL, NULL);
+        if (eip) {
+            cpu->eip.u32 = eip - cpu->seg[CS].address;
         }
     }
     context->CONTEXT_PC = (U64)cpu->thread->process->runSignalAddress;
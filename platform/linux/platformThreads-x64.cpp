@@ -4,6 +4,7 @@
 
 #include "ksignal.h"
 #include "../../source/emulation/cpu/x64/x64CPU.h"
+#include "../../source/emulation/cpu/binaryTranslation/btInterpreter.h"
 
 #ifdef __MACH__
 #define __USE_GNU
@@ -289,6 +290,12 @@ void platformHandler(int sig, siginfo_t* info, void* vcontext) {
     }
     ucontext_t* context = (ucontext_t*)vcontext;
     BtCPU* cpu = (BtCPU*)currentThread->cpu;
+    if (cpu->interpreter && cpu->interpreter->isRunning()) {
+        // skip the red zone and align the stack like a call would have
+        context->CONTEXT_RSP = ((context->CONTEXT_RSP - 256) & ~(U64)0xf) - 8;
+        context->CONTEXT_RIP = (U64)BtInterpreter::hostFault;
+        return;
+    }
     if (cpu != (BtCPU*)context->CONTEXT_R13) {
         return;
     }
@@ -310,11 +317,12 @@ void platformHandler(int sig, siginfo_t* info, void* vcontext) {
     x64Cpu->destEip = (U32)context->CONTEXT_R9;
     x64Cpu->regPage = context->CONTEXT_R8;
     x64Cpu->regOffset = context->CONTEXT_R9;
-    if (cpu->thread->memory->isAddressExecutable((void*)context->CONTEXT_RIP)) {
-        unsigned char* hostAddress = (unsigned char*)context->CONTEXT_RIP;
-        std::shared_ptr<BtCodeChunk> chunk = cpu->thread->memory->getCodeChunkContainingHostAddress(hostAddress);
-        if (chunk && chunk->getEipLen()) { // during start up eip is already set
-            cpu->eip.u32 = chunk->getEipThatContainsHostAddress(hostAddress, NULL, NULL) - cpu->seg[CS].address;
+    // this is a signal handler, so only the lock free lookup is used here
+    BtCodeChunk* chunk = cpu->thread->memory->findCodeChunkContainingHostAddress((void*)context->CONTEXT_RIP);
+    if (chunk && chunk->getEipLen()) { // during start up eip is already set
+        U32 eip = chunk->getEipThatContainsHostAddress((void*)context->CONTEXT_RIP, NULL, NULL);
+        if (eip) {
+            cpu->eip.u32 = eip - cpu->seg[CS].address;
         }
     }
     context->CONTEXT_RIP = (U64)cpu->thread->process->runSignalAddress;
@@ -2,12 +2,12 @@
 
 #ifdef BOXEDWINE_MULTI_THREADED
 
-#include "../../source/emulation/cpu/binaryTranslation/btCpu.h"
 #include <signal.h>
 #include <pthread.h>
 
 U32 platformThreadCount = 0;
 
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
 void platformHandler(int sig, siginfo_t* info, void* vcontext);
 
 #ifdef __MACH__
@@ -42,6 +42,11 @@ void initHandlers() {
 #endif
     }
 }
+#else
+// the normal core doesn't use host exceptions, memory access goes through the soft mmu
+void initHandlers() {
+}
+#endif
 
 #ifdef __TEST
 void initThreadForTesting() {
@@ -52,13 +57,12 @@ void initThreadForTesting() {
 void* platformThreadProc(void* param) {
     initHandlers();
     KThread* thread = (KThread*)param;
-    BtCPU* cpu = (BtCPU*)thread->cpu;
-    cpu->startThread();
+    thread->cpu->startThread();
     return 0;
 }
 
 void scheduleThread(KThread* thread) {
-    BtCPU* cpu = (BtCPU*)thread->cpu;
+    CPU* cpu = thread->cpu;
     pthread_t threadId;
     platformThreadCount++; // need to increment before returning, otherwise if this is 0 the code will assume Wine exited
 #ifdef __MACH__
@@ -4,6 +4,7 @@
 #include "../source/emulation/cpu/normal/normalCPU.h"
 #include "ksignal.h"
 #include "../source/emulation/cpu/x64/x64CPU.h"
+#include "../source/emulation/cpu/binaryTranslation/btInterpreter.h"
 
 #ifdef BOXEDWINE_MULTI_THREADED
 
@@ -119,6 +120,12 @@ LONG WINAPI seh_filter(struct _EXCEPTION_POINTERS *ep) {
         ep->ContextRecord->EFlags&=~AC;
         return EXCEPTION_CONTINUE_EXECUTION;
     }
+    if (cpu->interpreter && cpu->interpreter->isRunning()) {
+        // align the stack like a call would have
+        ep->ContextRecord->Rsp = ((ep->ContextRecord->Rsp - 256) & ~(U64)0xf) - 8;
+        ep->ContextRecord->Rip = (U64)BtInterpreter::hostFault;
+        return EXCEPTION_CONTINUE_EXECUTION;
+    }
     if (cpu!=(BtCPU*)ep->ContextRecord->R13) {
         return EXCEPTION_CONTINUE_SEARCH;
     }	
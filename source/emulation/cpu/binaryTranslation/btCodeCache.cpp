@@ -0,0 +1,575 @@
+#include "boxedwine.h"
+
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+
+#include "btCodeCache.h"
+#include "btCpu.h"
+#include "btData.h"
+#include "crc.h"
+#include "../common/lazyFlags.h"
+#ifdef BOXEDWINE_X64
+#include "../x64/x64CPU.h"
+#endif
+
+#define BT_CODE_CACHE_FILE_NAME "bt.cache"
+#define BT_CODE_CACHE_MAGIC 0x43544257 // WBTC
+#define BT_CODE_CACHE_ENTRY_MAGIC 0x594e5445 // ENTY
+// bump this when a change to the translator changes the code it generates
+#define BT_CODE_CACHE_VERSION 4
+
+#define BT_CODE_CACHE_OPTION_LARGE_ADDRESS_SPACE 0x01
+#define BT_CODE_CACHE_OPTION_SINGLE_MEM_OFFSET 0x02
+#define BT_CODE_CACHE_OPTION_BMI2 0x04
+#define BT_CODE_CACHE_OPTION_SPIN_BACKOFF 0x08
+#define BT_CODE_CACHE_OPTION_SHADOW_STACK 0x10
+#define BT_CODE_CACHE_OPTION_TRACES 0x20
+
+#define BT_CODE_CACHE_PROCESS_EMULATE_FPU 0x40 // the lower 6 bits are hasSetSeg
+
+class BtCodeCacheHeader {
+public:
+    U32 magic;
+    U32 version;
+    U32 options;
+    U32 reserved;
+    U64 buildId;
+};
+
+class BtCodeCacheEntry {
+public:
+    U32 eip;
+    U32 eipLen;
+    U32 guestCrc;
+    U32 processFlags;
+    std::vector<U32> instructionOffsets; // from eip
+    std::vector<U32> instructionBufferPos;
+    std::vector<U8> buffer;
+    std::vector<U32> hostAddressRelocations; // the 64-bit values at these positions in buffer are relative to getAnchor()
+    std::vector<TodoJump> todoJump;
+    std::vector<BtColdCode> coldCode;
+
+    void write(std::vector<U8>& out);
+    bool read(const U8* p, U32 len);
+};
+
+static std::unordered_map<U32, std::vector<std::shared_ptr<BtCodeCacheEntry>>> entries;
+static BOXEDWINE_MUTEX entriesMutex;
+
+// by node path, guards the entries of every BtSharedCodeFile too
+static std::unordered_map<BString, std::weak_ptr<BtSharedCodeFile>> sharedFiles;
+static BOXEDWINE_MUTEX sharedFilesMutex;
+
+FILE* BtCodeCache::file;
+std::atomic<U32> BtCodeCache::loadedCount;
+std::atomic<U32> BtCodeCache::savedCount;
+std::atomic<U32> BtCodeCache::translatedCount;
+std::atomic<U64> BtCodeCache::loadTime;
+std::atomic<U64> BtCodeCache::translateTime;
+std::atomic<U32> BtCodeCache::sharedCount;
+std::atomic<U64> BtCodeCache::sharedSize;
+
+static void btCodeCacheAnchor() {
+}
+
+// host addresses are saved relative to this so that they are still good if the OS loads Boxedwine at a different address
+static U64 getAnchor() {
+    return (U64)(void*)btCodeCacheAnchor;
+}
+
+// There isn't a portable way to find our own exe, so this uses the build time of this file along with the distance
+// from here to code and data in other files.  Just about any rebuild of the translator will move those.
+static U64 getBuildId() {
+    const char* buildTime = __DATE__ " " __TIME__;
+    U64 result = crc32b((unsigned char*)buildTime, (int)strlen(buildTime));
+    result = (result << 32) ^ ((U64)(void*)ksyscall - getAnchor());
+    result ^= ((U64)parity_lookup - getAnchor()) << 16;
+    return result;
+}
+
+static U32 getOptions() {
+    U32 result = 0;
+    if (KSystem::useLargeAddressSpace) {
+        result |= BT_CODE_CACHE_OPTION_LARGE_ADDRESS_SPACE;
+    }
+    if (KSystem::useSingleMemOffset) {
+        result |= BT_CODE_CACHE_OPTION_SINGLE_MEM_OFFSET;
+    }
+#ifdef BOXEDWINE_X64
+    if (x64CPU::hasBMI2) {
+        result |= BT_CODE_CACHE_OPTION_BMI2;
+    }
+#endif
+    if (KSystem::spinBackoff) {
+        result |= BT_CODE_CACHE_OPTION_SPIN_BACKOFF;
+    }
+    if (KSystem::btShadowStack) {
+        result |= BT_CODE_CACHE_OPTION_SHADOW_STACK;
+    }
+    // the threshold itself only lives in the links, not in the code
+    if (KSystem::btTraceThreshold) {
+        result |= BT_CODE_CACHE_OPTION_TRACES;
+    }
+    return result;
+}
+
+static U32 getGuestCrc(U32 address, U32 len) {
+    std::vector<U8> bytes(len);
+    memcopyToNative(address, bytes.data(), len);
+    return crc32b(bytes.data(), (int)len);
+}
+
+static void write32(std::vector<U8>& out, U32 value) {
+    out.push_back((U8)value);
+    out.push_back((U8)(value >> 8));
+    out.push_back((U8)(value >> 16));
+    out.push_back((U8)(value >> 24));
+}
+
+class BtCodeCacheReader {
+public:
+    BtCodeCacheReader(const U8* p, U32 len) : p(p), len(len), pos(0) {}
+
+    bool read32(U32& value) {
+        if (pos + 4 > len) {
+            return false;
+        }
+        value = p[pos] | ((U32)p[pos + 1] << 8) | ((U32)p[pos + 2] << 16) | ((U32)p[pos + 3] << 24);
+        pos += 4;
+        return true;
+    }
+    // count is 64-bit so that callers can multiply a count they read without it wrapping
+    bool read32Array(std::vector<U32>& values, U64 count) {
+        if (count > (len - pos) / 4) {
+            return false;
+        }
+        values.resize(count);
+        for (U32 i = 0; i < count; i++) {
+            read32(values[i]);
+        }
+        return true;
+    }
+    bool read(std::vector<U8>& values, U32 count) {
+        if (count > len - pos) {
+            return false;
+        }
+        values.assign(p + pos, p + pos + count);
+        pos += count;
+        return true;
+    }
+
+    const U8* p;
+    U32 len;
+    U32 pos;
+};
+
+void BtCodeCacheEntry::write(std::vector<U8>& out) {
+    write32(out, eip);
+    write32(out, eipLen);
+    write32(out, guestCrc);
+    write32(out, processFlags);
+    write32(out, (U32)instructionOffsets.size());
+    for (U32 i = 0; i < instructionOffsets.size(); i++) {
+        write32(out, instructionOffsets[i]);
+        write32(out, instructionBufferPos[i]);
+    }
+    write32(out, (U32)buffer.size());
+    out.insert(out.end(), buffer.begin(), buffer.end());
+    write32(out, (U32)hostAddressRelocations.size());
+    for (auto& pos : hostAddressRelocations) {
+        write32(out, pos);
+    }
+    write32(out, (U32)todoJump.size());
+    for (auto& todo : todoJump) {
+        write32(out, todo.eip);
+        write32(out, todo.bufferPos);
+        write32(out, todo.opIndex);
+        write32(out, todo.offsetSize | (todo.sameChunk ? 0x100 : 0));
+    }
+    write32(out, (U32)coldCode.size());
+    for (auto& cold : coldCode) {
+        write32(out, cold.instructionIndex);
+        write32(out, cold.hostOffset);
+    }
+}
+
+bool BtCodeCacheEntry::read(const U8* p, U32 len) {
+    BtCodeCacheReader reader(p, len);
+    U32 count = 0;
+
+    if (!reader.read32(eip) || !reader.read32(eipLen) || !reader.read32(guestCrc) || !reader.read32(processFlags) || !reader.read32(count)) {
+        return false;
+    }
+    std::vector<U32> instructions;
+    if (!count || !reader.read32Array(instructions, (U64)count * 2)) {
+        return false;
+    }
+    for (U32 i = 0; i < count; i++) {
+        instructionOffsets.push_back(instructions[i * 2]);
+        instructionBufferPos.push_back(instructions[i * 2 + 1]);
+    }
+    if (!reader.read32(count) || !reader.read(buffer, count)) {
+        return false;
+    }
+    if (!reader.read32(count) || !reader.read32Array(hostAddressRelocations, count)) {
+        return false;
+    }
+    std::vector<U32> todo;
+    if (!reader.read32(count) || !reader.read32Array(todo, (U64)count * 4)) {
+        return false;
+    }
+    for (U32 i = 0; i < count; i++) {
+        todoJump.push_back(TodoJump(todo[i * 4], todo[i * 4 + 1], (U8)todo[i * 4 + 3], (todo[i * 4 + 3] & 0x100) != 0, todo[i * 4 + 2]));
+    }
+    std::vector<U32> cold;
+    if (!reader.read32(count) || !reader.read32Array(cold, (U64)count * 2)) {
+        return false;
+    }
+    for (U32 i = 0; i < count; i++) {
+        coldCode.push_back(BtColdCode(cold[i * 2], cold[i * 2 + 1]));
+    }
+
+    // the record crc already caught corruption, this just makes sure a bad translator version can't write outside the chunk
+    for (U32 i = 0; i < instructionOffsets.size(); i++) {
+        if (instructionOffsets[i] >= eipLen || instructionBufferPos[i] > buffer.size()) {
+            return false;
+        }
+    }
+    for (auto& pos : hostAddressRelocations) {
+        if ((U64)pos + 8 > buffer.size()) {
+            return false;
+        }
+    }
+    for (auto& t : todoJump) {
+        if ((U64)t.bufferPos + t.offsetSize > buffer.size()) {
+            return false;
+        }
+    }
+    for (U32 i = 0; i < coldCode.size(); i++) {
+        if (coldCode[i].instructionIndex >= instructionOffsets.size() || coldCode[i].hostOffset >= buffer.size() || (i && coldCode[i].hostOffset <= coldCode[i - 1].hostOffset)) {
+            return false;
+        }
+    }
+    return reader.pos == len;
+}
+
+bool BtCodeCache::open(BString dir) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(entriesMutex);
+    if (file) {
+        return true;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(dir.c_str(), ec);
+    BString path = dir ^ BT_CODE_CACHE_FILE_NAME;
+
+    file = fopen(path.c_str(), "r+b");
+    if (file && !readEntries(file)) {
+        klog("BT code cache %s was created by a different build or with different options, starting over", path.c_str());
+        fclose(file);
+        file = NULL;
+        entries.clear();
+    }
+    if (!file) {
+        file = fopen(path.c_str(), "w+b");
+        if (!file) {
+            klog("could not open the BT code cache: %s", path.c_str());
+            return false;
+        }
+        BtCodeCacheHeader header;
+        header.magic = BT_CODE_CACHE_MAGIC;
+        header.version = BT_CODE_CACHE_VERSION;
+        header.options = getOptions();
+        header.reserved = 0;
+        header.buildId = getBuildId();
+        fwrite(&header, sizeof(header), 1, file);
+        fflush(file);
+    }
+    U32 count = 0;
+    for (auto& it : entries) {
+        count += (U32)it.second.size();
+    }
+    klog("BT code cache %s: %d chunks", path.c_str(), count);
+    loadedCount = 0;
+    savedCount = 0;
+    translatedCount = 0;
+    loadTime = 0;
+    translateTime = 0;
+    return true;
+}
+
+// leaves the file positioned after the last good entry, a partially written entry from a crash will be written over
+bool BtCodeCache::readEntries(FILE* f) {
+    BtCodeCacheHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != BT_CODE_CACHE_MAGIC || header.version != BT_CODE_CACHE_VERSION || header.options != getOptions() || header.buildId != getBuildId()) {
+        return false;
+    }
+    long goodPos = ftell(f);
+    std::vector<U8> payload;
+    while (true) {
+        U32 recordHeader[3]; // magic, len, crc
+        if (fread(recordHeader, sizeof(recordHeader), 1, f) != 1 || recordHeader[0] != BT_CODE_CACHE_ENTRY_MAGIC) {
+            break;
+        }
+        payload.resize(recordHeader[1]);
+        if (!recordHeader[1] || fread(payload.data(), recordHeader[1], 1, f) != 1 || crc32b(payload.data(), (int)recordHeader[1]) != recordHeader[2]) {
+            break;
+        }
+        std::shared_ptr<BtCodeCacheEntry> entry = std::make_shared<BtCodeCacheEntry>();
+        if (!entry->read(payload.data(), recordHeader[1])) {
+            break;
+        }
+        entries[entry->eip].push_back(entry);
+        goodPos = ftell(f);
+    }
+    fseek(f, goodPos, SEEK_SET);
+    return true;
+}
+
+void BtCodeCache::close() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(entriesMutex);
+    if (!file) {
+        return;
+    }
+    klog("BT code cache: loaded %d chunks in %d ms, translated %d chunks in %d ms, saved %d chunks", loadedCount.load(), (U32)(loadTime / 1000), translatedCount.load(), (U32)(translateTime / 1000), savedCount.load());
+    fclose(file);
+    file = NULL;
+    entries.clear();
+}
+
+U32 BtCodeCache::getProcessFlags(BtCPU* cpu) {
+    U32 result = 0;
+    for (U32 i = 0; i < 6; i++) {
+        if (cpu->thread->process->hasSetSeg[i]) {
+            result |= 1 << i;
+        }
+    }
+    if (cpu->thread->process->emulateFPU) {
+        result |= BT_CODE_CACHE_PROCESS_EMULATE_FPU;
+    }
+    return result;
+}
+
+// read only pages are a good stand in for code that was mapped from a file, there is no point in saving code the
+// guest generated at runtime
+bool BtCodeCache::canCache(BtCPU* cpu, U32 ip, U32 len) {
+    Memory* memory = cpu->thread->memory;
+
+    if (!len || !cpu->isBig() || cpu->seg[CS].address || !memory->isValidReadAddress(ip, len)) {
+        return false;
+    }
+    U32 startPage = ip >> K_PAGE_SHIFT;
+    U32 endPage = (ip + len - 1) >> K_PAGE_SHIFT;
+    for (U32 page = startPage; page <= endPage; page++) {
+        if (memory->getPageFlags(page) & PAGE_WRITE) {
+            return false;
+        }
+        if (memory->dynamicCodePageUpdateCount[memory->getNativePage(page)] == MAX_DYNAMIC_CODE_PAGE_COUNT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<BtCodeCacheEntry> BtCodeCache::findSaved(BtCPU* cpu, U32 ip) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(entriesMutex);
+    if (!file) {
+        return NULL;
+    }
+    auto it = entries.find(ip);
+    if (it == entries.end()) {
+        return NULL;
+    }
+    U32 processFlags = getProcessFlags(cpu);
+    for (auto& entry : it->second) {
+        if (entry->processFlags == processFlags && canCache(cpu, ip, entry->eipLen) && getGuestCrc(ip, entry->eipLen) == entry->guestCrc) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+std::shared_ptr<BtCodeCacheEntry> BtCodeCache::findShared(BtCPU* cpu, U32 ip) {
+    Memory* memory = cpu->thread->memory;
+    U64 offset = 0;
+    std::shared_ptr<BtSharedCodeFile> sharedFile = memory->getSharedCodeFile(ip, 1, &offset);
+    if (!sharedFile) {
+        return NULL;
+    }
+    std::vector<std::shared_ptr<BtCodeCacheEntry>> candidates;
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(sharedFilesMutex);
+        auto it = sharedFile->entries.find(offset);
+        if (it == sharedFile->entries.end()) {
+            return NULL;
+        }
+        candidates = it->second;
+    }
+    U32 processFlags = getProcessFlags(cpu);
+    for (auto& entry : candidates) {
+        // every page of the chunk has to come from the same place in the same file, the crc catches a private page
+        // that this process or the one that translated it wrote to
+        if (entry->eip == ip && entry->processFlags == processFlags && canCache(cpu, ip, entry->eipLen) && memory->getSharedCodeFile(ip, entry->eipLen, &offset) == sharedFile && getGuestCrc(ip, entry->eipLen) == entry->guestCrc) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+bool BtCodeCache::load(BtCPU* cpu, U32 ip, const std::shared_ptr<BtData>& data) {
+    std::shared_ptr<BtCodeCacheEntry> found = findShared(cpu, ip);
+    bool shared = found != NULL;
+    if (!found) {
+        found = findSaved(cpu, ip);
+    }
+    if (!found || !loadEntry(cpu, ip, found, data)) {
+        return false;
+    }
+    if (shared) {
+        sharedCount++;
+    } else {
+        loadedCount++;
+        share(cpu, found);
+    }
+    return true;
+}
+
+bool BtCodeCache::loadEntry(BtCPU* cpu, U32 ip, const std::shared_ptr<BtCodeCacheEntry>& found, const std::shared_ptr<BtData>& data) {
+    // translateData would have stopped at code that is already translated and a single instruction might have
+    // been retranslated to handle a memory offset, either way the cached chunk is not what we would translate now
+    Memory* memory = cpu->thread->memory;
+    for (auto& offset : found->instructionOffsets) {
+        if (memory->getExistingHostAddress(ip + offset) || memory->doesInstructionNeedMemoryOffset(ip + offset)) {
+            return false;
+        }
+    }
+    data->startOfDataIp = ip;
+    data->ip = ip + found->eipLen;
+    for (U32 i = 0; i < found->instructionOffsets.size(); i++) {
+        data->mapAddress(ip + found->instructionOffsets[i], found->instructionBufferPos[i]);
+    }
+    for (auto& b : found->buffer) {
+        data->write8(b);
+    }
+    U64 anchor = getAnchor();
+    for (auto& pos : found->hostAddressRelocations) {
+        U64 offset;
+        memcpy(&offset, data->buffer + pos, 8);
+        data->write64Buffer(data->buffer + pos, anchor + offset);
+        data->hostAddressRelocations.push_back(pos);
+    }
+    data->todoJump = found->todoJump;
+    data->coldCode = found->coldCode;
+    return true;
+}
+
+std::shared_ptr<BtCodeCacheEntry> BtCodeCache::createEntry(BtCPU* cpu, BtData* data) {
+    if (data->dynamic || !data->ipAddressCount) {
+        return NULL;
+    }
+    U32 ip = data->startOfDataIp;
+    U32 len = data->ip - data->startOfDataIp;
+    if (!canCache(cpu, ip, len)) {
+        return NULL;
+    }
+    Memory* memory = cpu->thread->memory;
+    for (U32 i = 0; i < data->ipAddressCount; i++) {
+        if (memory->doesInstructionNeedMemoryOffset(data->ipAddress[i])) {
+            return NULL;
+        }
+    }
+
+    std::shared_ptr<BtCodeCacheEntry> entry = std::make_shared<BtCodeCacheEntry>();
+    entry->eip = ip;
+    entry->eipLen = len;
+    entry->guestCrc = getGuestCrc(ip, len);
+    entry->processFlags = getProcessFlags(cpu);
+    for (U32 i = 0; i < data->ipAddressCount; i++) {
+        entry->instructionOffsets.push_back(data->ipAddress[i] - ip);
+        entry->instructionBufferPos.push_back(data->ipAddressBufferPos[i]);
+    }
+    entry->buffer.assign(data->buffer, data->buffer + data->bufferPos);
+    U64 anchor = getAnchor();
+    for (auto& pos : data->hostAddressRelocations) {
+        U64 value;
+        memcpy(&value, entry->buffer.data() + pos, 8);
+        data->write64Buffer(entry->buffer.data() + pos, value - anchor);
+    }
+    entry->hostAddressRelocations = data->hostAddressRelocations;
+    entry->todoJump = data->todoJump;
+    entry->coldCode = data->coldCode;
+    return entry;
+}
+
+void BtCodeCache::share(BtCPU* cpu, const std::shared_ptr<BtCodeCacheEntry>& entry) {
+    U64 offset = 0;
+    std::shared_ptr<BtSharedCodeFile> sharedFile = cpu->thread->memory->getSharedCodeFile(entry->eip, entry->eipLen, &offset);
+    if (!sharedFile) {
+        return;
+    }
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(sharedFilesMutex);
+    std::vector<std::shared_ptr<BtCodeCacheEntry>>& existing = sharedFile->entries[offset];
+    for (auto& e : existing) {
+        if (e->eip == entry->eip && e->eipLen == entry->eipLen && e->guestCrc == entry->guestCrc && e->processFlags == entry->processFlags) {
+            return;
+        }
+    }
+    existing.push_back(entry);
+    sharedFile->size += entry->buffer.size();
+    sharedSize += entry->buffer.size();
+}
+
+std::shared_ptr<BtSharedCodeFile> BtCodeCache::getSharedFile(BString path) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(sharedFilesMutex);
+    std::shared_ptr<BtSharedCodeFile> result = sharedFiles[path].lock();
+    if (!result) {
+        result = std::make_shared<BtSharedCodeFile>(path);
+        sharedFiles[path] = result;
+    }
+    return result;
+}
+
+// the weak_ptr left in sharedFiles is replaced the next time the file is mapped
+BtSharedCodeFile::~BtSharedCodeFile() {
+    BtCodeCache::sharedSize -= this->size;
+}
+
+void BtCodeCache::logSharing() {
+    klog("BT code sharing: translated %d chunks in %d ms, %d chunks were already translated by another process, %d KB of translations are shared, the code cache of all processes peaked at %d KB", translatedCount.load(), (U32)(translateTime / 1000), sharedCount.load(), (U32)(sharedSize >> 10), (U32)(Memory::peakLiveExecutableMemorySize >> 10));
+}
+
+void BtCodeCache::save(BtCPU* cpu, BtData* data) {
+    U64 offset = 0;
+    if (!file && !cpu->thread->memory->getSharedCodeFile(data->startOfDataIp, 1, &offset)) {
+        return;
+    }
+    std::shared_ptr<BtCodeCacheEntry> entry = createEntry(cpu, data);
+    if (!entry) {
+        return;
+    }
+    share(cpu, entry);
+    if (!file) {
+        return;
+    }
+    U32 ip = entry->eip;
+
+    std::vector<U8> payload;
+    entry->write(payload);
+    U32 recordHeader[3] = { BT_CODE_CACHE_ENTRY_MAGIC, (U32)payload.size(), crc32b(payload.data(), (int)payload.size()) };
+
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(entriesMutex);
+    if (!file) {
+        return;
+    }
+    std::vector<std::shared_ptr<BtCodeCacheEntry>>& existing = entries[ip];
+    for (auto& e : existing) {
+        if (e->eipLen == entry->eipLen && e->guestCrc == entry->guestCrc && e->processFlags == entry->processFlags) {
+            return;
+        }
+    }
+    fwrite(recordHeader, sizeof(recordHeader), 1, file);
+    fwrite(payload.data(), payload.size(), 1, file);
+    fflush(file);
+    existing.push_back(entry);
+    savedCount++;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef __BT_CODE_CACHE_H__
+#define __BT_CODE_CACHE_H__
+
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+
+class BtCPU;
+class BtData;
+class BtCodeCacheEntry;
+
+// The translations of one file that are shared by every process that maps it, see BtCodeCache::getSharedFile.  Each
+// page mapped from the file holds a reference, so its translations are thrown away once no process maps it anymore.
+class BtSharedCodeFile {
+public:
+    BtSharedCodeFile(BString path) : path(path), size(0) {}
+    ~BtSharedCodeFile();
+
+    const BString path;
+    // by the file offset of the first instruction, the eip is still checked since code is only the same when the
+    // file is mapped at the same address
+    std::unordered_map<U64, std::vector<std::shared_ptr<BtCodeCacheEntry>>> entries;
+    U64 size; // bytes of translated code held by entries
+};
+
+// Saves translated chunks to disk so that the next run of Boxedwine doesn't have to translate the same code again.
+//
+// A chunk is looked up by its start eip and only reused if a crc of the guest bytes it was translated from still
+// matches, along with the process state that changes how code is generated (segments that have been set, fpu
+// emulation).  The file header records the translator version, the options that affect code generation and an id
+// for the Boxedwine build, the whole file is thrown away if any of them don't match.
+//
+// Only code on pages the guest can't write to is saved, in practice that is the code mapped from exe and dll files.
+// Host addresses the code calls into are stored relative to this binary and relocated when loaded.  Links to other
+// chunks are saved unresolved and go through BtCPU::link like any other translation.
+//
+// The same chunks are also shared in memory between processes without a cache file.  Wine starts several processes
+// that all map libc, ntdll, kernel32 and so on at the same address, a chunk on a page mapped from a file is found by
+// the file and offset and only has to be translated by the first process that runs it.  Each process still commits
+// its own copy of the code, its links are patched in place and it is freed and evicted with the rest of the process.
+class BtCodeCache {
+public:
+    static bool open(BString dir);
+    static void close();
+    static bool isOpen() { return file != NULL; }
+    // logs how much was translated vs shared by all the processes of this run
+    static void logSharing();
+
+    // fills in data as if translateData had been called for ip, returns false if nothing usable is cached
+    static bool load(BtCPU* cpu, U32 ip, const std::shared_ptr<BtData>& data);
+    static void save(BtCPU* cpu, BtData* data);
+
+    // returns the shared translations for a file, creating it if no process maps the file yet
+    static std::shared_ptr<BtSharedCodeFile> getSharedFile(BString path);
+
+    // updated by every thread that translates
+    static std::atomic<U32> loadedCount;
+    static std::atomic<U32> savedCount;
+    static std::atomic<U32> translatedCount;
+    static std::atomic<U64> loadTime; // microseconds
+    static std::atomic<U64> translateTime; // microseconds
+    static std::atomic<U32> sharedCount; // chunks that were translated by another process
+    static std::atomic<U64> sharedSize; // bytes of translated code held by all BtSharedCodeFile's
+
+private:
+    static bool canCache(BtCPU* cpu, U32 ip, U32 len);
+    static U32 getProcessFlags(BtCPU* cpu);
+    static bool readEntries(FILE* f);
+    static std::shared_ptr<BtCodeCacheEntry> findSaved(BtCPU* cpu, U32 ip);
+    static std::shared_ptr<BtCodeCacheEntry> findShared(BtCPU* cpu, U32 ip);
+    static std::shared_ptr<BtCodeCacheEntry> createEntry(BtCPU* cpu, BtData* data);
+    static bool loadEntry(BtCPU* cpu, U32 ip, const std::shared_ptr<BtCodeCacheEntry>& entry, const std::shared_ptr<BtData>& data);
+    static void share(BtCPU* cpu, const std::shared_ptr<BtCodeCacheEntry>& entry);
+
+    static FILE* file;
+};
+
+#endif
+
+#endif
@@ -5,15 +5,19 @@
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
 
 BtCodeChunk::BtCodeChunk(U32 instructionCount, U32* eipInstructionAddress, U32* hostInstructionIndex, U8* hostInstructionBuffer, U32 hostInstructionBufferLen, U32 eip, U32 eipLen, bool dynamic) {
-    CPU* cpu = KThread::currentThread()->cpu;
+    BtCPU* cpu = BtCPU::currentTranslator();
     this->instructionCount = instructionCount;
     this->emulatedAddress = eip + cpu->seg[CS].address;
     this->emulatedLen = eipLen;
+    this->validLen = eipLen;
     this->hostAddress = cpu->thread->memory->allocateExcutableMemory(hostInstructionBufferLen + 4, &this->hostAddressSize); // +4 for a guard
     this->hostLen = hostInstructionBufferLen;
     this->emulatedInstructionLen = new U8[instructionCount];
     this->hostInstructionLen = new U32[instructionCount];
     this->dynamic = dynamic;
+    this->stub = false;
+    this->evicted = false;
+    this->referenced = true;
 
     Platform::writeCodeToMemory(this->hostAddress, this->hostAddressSize, [this]() {
         memset(this->hostAddress, 0xce, this->hostAddressSize);
@@ -38,7 +42,7 @@ BtCodeChunk::BtCodeChunk(U32 instructionCount, U32* eipInstructionAddress, U32*
 }
 
 void BtCodeChunk::makeLive() {
-    CPU* cpu = KThread::currentThread()->cpu;
+    BtCPU* cpu = BtCPU::currentTranslator();
     U32 eip = this->emulatedAddress;
     U8* host = (U8*)this->hostAddress;
 
@@ -66,7 +70,7 @@ void BtCodeChunk::makeLive() {
     this->clearInstructionCache((U8*)this->hostAddress, this->hostLen);
 }
 
-void BtCodeChunk::detachFromHost(Memory* memory) {
+void BtCodeChunk::detachFromHost(Memory* memory, bool keepHostMapping) {
     U32 eip = this->emulatedAddress;
     KThread* thread = KThread::currentThread();
     std::shared_ptr<KProcess> process;
@@ -85,16 +89,30 @@ void BtCodeChunk::detachFromHost(Memory* memory) {
         }
         eip += this->emulatedInstructionLen[i];
     }
-    memory->removeCodeChunk(shared_from_this());
+    memory->removeCodeChunk(shared_from_this(), keepHostMapping);
 }
 
 void BtCodeChunk::release(Memory* memory) {
     this->detachFromHost(memory);
+    this->retargetLinksFrom();
     this->internalDealloc();
 }
 
-void BtCodeChunk::internalDealloc() {
-    KThread::currentThread()->memory->freeExcutableMemory(this->hostAddress, this->hostAddressSize);
+void BtCodeChunk::evict(Memory* memory) {
+    // the host mapping stays so that the exception handler can still map a host address in this chunk to an eip
+    this->detachFromHost(memory, true);
+    this->retargetLinksFrom();
+    this->evicted = true;
+    memory->retireExecutableMemory(this->hostAddress, this->hostAddressSize, shared_from_this());
+    memory->codeReleased();
+}
+
+void BtCodeChunk::releaseRetired() {
+    for (auto& link : this->linksTo) {
+        if (link->direct) {
+            link->fromHostOffset = NULL;
+        }
+    }
     this->hostAddress = NULL;
     delete[] this->emulatedInstructionLen;
     this->emulatedInstructionLen = NULL;
@@ -102,14 +120,64 @@ void BtCodeChunk::internalDealloc() {
     this->hostInstructionLen = NULL;
 }
 
+// Jumps from other chunks that go through a link slot are pointed at code that will translate cpu->eip again, this
+// chunk's memory will be reused for other code
+void BtCodeChunk::retargetLinksFrom() {
+    KThread* thread = KThread::currentThread();
+    void* reTranslate = (thread && thread->process) ? thread->process->reTranslateLinkAddress : NULL;
+
+    if (reTranslate) {
+        for (auto& link : this->linksFrom) {
+            if (!link->direct) {
+                ATOMIC_WRITE64((U64*)&link->toHostInstruction, (U64)reTranslate);
+            }
+        }
+    }
+}
+
+bool BtCodeChunk::canReuseHostMemory() {
+    KThread* thread = KThread::currentThread();
+    bool canRetarget = thread && thread->process && thread->process->reTranslateLinkAddress;
+
+    for (auto& link : this->linksFrom) {
+        if (link->direct || !canRetarget) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BtCodeChunk::internalDealloc() {
+    // a direct link from this chunk will not be patched anymore, its memory might be used by other code soon
+    for (auto& link : this->linksTo) {
+        if (link->direct) {
+            link->fromHostOffset = NULL;
+        }
+    }
+    // the exception handler of another thread might have just found this chunk by its host address, so the
+    // instruction tables stay until Memory calls releaseRetired
+    void* hostAddress = this->hostAddress;
+    Memory* memory = KThread::currentThread()->memory;
+    this->hostAddress = NULL;
+    memory->freeExcutableMemory(hostAddress, this->hostAddressSize, this->canReuseHostMemory(), shared_from_this());
+    memory->codeReleased();
+}
+
 U32 BtCodeChunk::getEipThatContainsHostAddress(void* address, void** startOfHostInstruction, U32* index) {
     if (this->containsHostAddress(address)) {
         U8* p = (U8*)this->hostAddress;
         U32 result = this->emulatedAddress;
+        U32 hostOffset = (U32)((U8*)address - p);
+        U32 coldIndex = this->instructionCount;
 
+        // cold code is reported as the start of the instruction it belongs to
+        if (!this->coldCode.empty() && hostOffset >= this->coldCode[0].hostOffset) {
+            auto it = std::upper_bound(this->coldCode.begin(), this->coldCode.end(), hostOffset, [](U32 offset, const BtColdCode& cold) {return offset < cold.hostOffset; });
+            coldIndex = (it - 1)->instructionIndex;
+        }
         for (unsigned int i = 0; i < this->instructionCount; i++) {
             U32 len = this->hostInstructionLen[i];
-            if (address >= p && address < p + len) {
+            if (i == coldIndex || (address >= p && address < p + len)) {
                 if (startOfHostInstruction) {
                     *startOfHostInstruction = p;
                 }
@@ -160,17 +228,38 @@ std::shared_ptr<BtCodeChunkLink> BtCodeChunk::addLinkFrom(std::shared_ptr<BtCode
 
 void BtCodeChunk::releaseAndRetranslate() {
     // remove this chunk and its mappings from being used (since it is about to be replaced)
-    BtCPU* cpu = (BtCPU*)KThread::currentThread()->cpu;
+    BtCPU* cpu = BtCPU::currentTranslator();
+    if (this->evicted) {
+        // already replaced, callers look up the eip again
+        return;
+    }
     detachFromHost(cpu->thread->memory);
 
     std::shared_ptr<BtCodeChunk> chunk = cpu->translateChunk(this->emulatedAddress - cpu->seg[CS].address);
     cpu->makePendingCodePagesReadOnly();
+    moveLinksFromTo(chunk);
+    chunk->makeLive();
+
+    this->internalDealloc(); // don't call dealloc() because the new chunk occupies the memory cache and we don't want to mess with it
+}
+
+// links to an eip that chunk doesn't start an instruction at are pointed at code that will look up cpu->eip again
+void BtCodeChunk::moveLinksFromTo(std::shared_ptr<BtCodeChunk>& chunk) {
+    BtCPU* cpu = BtCPU::currentTranslator();
+    void* reTranslate = cpu->thread->process->reTranslateLinkAddress;
     for (auto& link : this->linksFrom) {
         U64 destHost = (U64)chunk->getHostFromEip(link->toEip);
 
-        if (destHost) {
+        if (!destHost) {
+            if (!link->direct && reTranslate) {
+                ATOMIC_WRITE64((U64*)&link->toHostInstruction, (U64)reTranslate);
+            }
+        } else {
             chunk->linksFrom.push_back(link);
             if (link->direct) {
+                if (!link->fromHostOffset) {
+                    continue;
+                }
                 U32 fromInstructionIndex;
                 std::shared_ptr<BtCodeChunk> fromChunk = cpu->thread->memory->getCodeChunkContainingHostAddress(link->fromHostOffset);
                 void* srcHostInstruction = NULL;
@@ -183,9 +272,6 @@ void BtCodeChunk::releaseAndRetranslate() {
             }
         }
     };
-    chunk->makeLive();
-
-    this->internalDealloc(); // don't call dealloc() because the new chunk occupies the memory cache and we don't want to mess with it
 }
 
 void BtCodeChunk::clearInstructionCache(U8* hostAddress, U32 len) {
@@ -198,6 +284,9 @@ void BtCodeChunk::invalidateStartingAt(U32 eipAddress) {
     BtCPU* cpu = (BtCPU*)KThread::currentThread()->cpu;
     U32 currentEip = (cpu->isBig() ? cpu->eip.u32 : cpu->eip.u16) + KThread::currentThread()->cpu->seg[CS].address;
     U32 eip = this->getStartOfInstructionByEip(eipAddress, &host, &eipIndex);
+    if (!host) {
+        return; // no instructions, like the helper chunks the cpu allocates at cs:0
+    }
     // make sure we won't invalidate the current instruction, *2 just to be sure 
     // getStartOfInstructionByEip doesn't roll back to the current instruction
     if (currentEip >= eip && currentEip < this->emulatedAddress + this->emulatedLen) {
@@ -208,11 +297,37 @@ void BtCodeChunk::invalidateStartingAt(U32 eipAddress) {
         }
         eip = this->getStartOfInstructionByEip(eip + this->emulatedInstructionLen[eipIndex], &host, &eipIndex);
     }
-    U32 remainingLen = this->hostLen - (U32)(host - (U8*)this->hostAddress);
+    this->validLen = std::min(this->validLen, eip - this->emulatedAddress);
+    // the cold code of the instructions before eipIndex can still be running
+    U32 hotLen = this->coldCode.empty() ? this->hostLen : this->coldCode[0].hostOffset;
+    U32 remainingLen = hotLen - (U32)(host - (U8*)this->hostAddress);
     Platform::writeCodeToMemory(host, remainingLen, [host, remainingLen] {
         memset(host, 0xce, remainingLen);
         });
     this->clearInstructionCache(host, remainingLen);
+    for (auto& cold : this->coldCode) {
+        if (cold.instructionIndex >= eipIndex) {
+            U8* coldHost = (U8*)this->hostAddress + cold.hostOffset;
+            U32 coldLen = this->hostLen - cold.hostOffset;
+            Platform::writeCodeToMemory(coldHost, coldLen, [coldHost, coldLen] {
+                memset(coldHost, 0xce, coldLen);
+                });
+            this->clearInstructionCache(coldHost, coldLen);
+            break;
+        }
+    }
+}
+
+bool BtCodeChunk::getColdCode(U32 index, U8** host, U32* len) {
+    for (U32 i = 0; i < this->coldCode.size(); i++) {
+        if (this->coldCode[i].instructionIndex == index) {
+            U32 end = (i + 1 < this->coldCode.size()) ? this->coldCode[i + 1].hostOffset : this->hostLen;
+            *host = (U8*)this->hostAddress + this->coldCode[i].hostOffset;
+            *len = end - this->coldCode[i].hostOffset;
+            return true;
+        }
+    }
+    return false;
 }
 
 bool BtCodeChunk::containsEip(U32 eip, U32 len) {
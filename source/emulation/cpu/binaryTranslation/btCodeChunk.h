@@ -5,7 +5,7 @@
 
 class BtCodeChunkLink {
 public:
-    BtCodeChunkLink(void* fromHostOffset, U32 toEip, void* toHostInstruction, bool direct) : fromHostOffset(fromHostOffset), toEip(toEip), toHostInstruction(toHostInstruction), direct(direct) {}
+    BtCodeChunkLink(void* fromHostOffset, U32 toEip, void* toHostInstruction, bool direct) : fromHostOffset(fromHostOffset), toEip(toEip), toHostInstruction(toHostInstruction), direct(direct), traceCount(KSystem::btTraceThreshold) {}
     // will point to an address in the middle of the instruction
     void* fromHostOffset;
 
@@ -13,6 +13,18 @@ public:
     U32 toEip;
     void* toHostInstruction;
     bool direct;
+    // counted down by the code that jumps through toHostInstruction, BtCPU::formTrace is called when it reaches 0
+    U32 traceCount;
+};
+
+// Code for an instruction that rarely runs, like an exception exit, is placed after the chunk's last instruction
+// so that it doesn't sit between hot instructions.  hostOffset is from the start of the chunk (or of BtData::coldBuffer
+// while translating) and the code runs until the next BtColdCode or the end of the chunk.
+class BtColdCode {
+public:
+    BtColdCode(U32 instructionIndex, U32 hostOffset) : instructionIndex(instructionIndex), hostOffset(hostOffset) {}
+    U32 instructionIndex;
+    U32 hostOffset;
 };
 
 class BtCPU;
@@ -25,6 +37,20 @@ public:
 
     void release(Memory* memory);
     void releaseAndRetranslate();
+    // points the links that jump into this chunk at the same eip in chunk
+    void moveLinksFromTo(std::shared_ptr<BtCodeChunk>& chunk);
+    // like release but leaves the host code alone, Memory hands the code back with releaseRetired once no thread can
+    // still be running it
+    void evict(Memory* memory);
+    // called by Memory once no thread can still be running or looking up this chunk's code
+    void releaseRetired();
+    bool isEvicted() { return this->evicted; }
+    bool canEvict() { return !this->stub && !this->dynamic && this->instructionCount && this->emulatedLen; }
+    // false once released or evicted
+    bool isLive() { return this->hostAddress && !this->evicted; }
+    // used by Memory::evictExecutableMemory to approximate LRU
+    void markReferenced() { this->referenced = true; }
+    bool testAndClearReferenced() { bool result = this->referenced; this->referenced = false; return result; }
     void invalidateStartingAt(U32 eipAddress);
     void makeLive();
 
@@ -42,16 +68,29 @@ public:
     void* getHostFromEip(U32 eip) { U8* result = NULL; if (this->getStartOfInstructionByEip(eip, &result, NULL) == eip) { return result; } else { return 0; } }
     U32 getEip() { return emulatedAddress; }
     U32 getEipLen() { return emulatedLen; }
+    // the emulated bytes from the start of the chunk that invalidateStartingAt hasn't thrown away
+    U32 getValidEipLen() { return validLen; }
     bool isDynamicAware() { return this->dynamic; }
+    // link() points jumps to code that hasn't been translated yet at a small stub that will translate it
+    bool isStub() { return this->stub; }
+    void markAsStub() { this->stub = true; }
     U32 getStartOfInstructionByEip(U32 eip, U8** hostAddress, U32* index);
+
+    // coldCode must be sorted by hostOffset, BtData::commit sets it before the chunk is live
+    void setColdCode(const std::vector<BtColdCode>& coldCode) { this->coldCode = coldCode; }
+    // returns false if the instruction at index doesn't have any cold code
+    bool getColdCode(U32 index, U8** hostAddress, U32* len);
     
 protected:
-    void detachFromHost(Memory* memory);
+    void detachFromHost(Memory* memory, bool keepHostMapping = false);
     void internalDealloc();
+    void retargetLinksFrom();
+    bool canReuseHostMemory();
     virtual void clearInstructionCache(U8* hostAddress, U32 len);
 
     U32 emulatedAddress;
     U32 emulatedLen;
+    U32 validLen;
     U8* emulatedInstructionLen; // must be 15 or less per op
 
     void* hostAddress;
@@ -60,11 +99,15 @@ protected:
     U32* hostInstructionLen;
 
     U32 instructionCount;
+    std::vector<BtColdCode> coldCode;
 
     std::list<std::shared_ptr<BtCodeChunkLink>> linksTo;
     std::list<std::shared_ptr<BtCodeChunkLink>> linksFrom;
 
     bool dynamic; // will include a check of the original vs current code bytes to make sure it is still valid at a per instruction level
+    bool stub;
+    bool evicted;
+    bool referenced;
 };
 
 #endif
@@ -4,11 +4,32 @@
 #include "btCpu.h"
 #include "../../hardmmu/hard_memory.h"
 
-BtCodeMemoryWrite::BtCodeMemoryWrite(BtCPU* cpu, U32 address, U32 len) : cpu(cpu) {
+BtCodeMemoryWrite::BtCodeMemoryWrite(BtCPU* cpu, U32 address, U32 len) : cpu(cpu), writableAddress(0), writableLen(0) {
     this->invalidateCode(address, len);
 }
 
-BtCodeMemoryWrite::BtCodeMemoryWrite(BtCPU* cpu) : cpu(cpu) {
+BtCodeMemoryWrite::BtCodeMemoryWrite(BtCPU* cpu) : cpu(cpu), writableAddress(0), writableLen(0) {
+}
+
+BtCodeMemoryWrite::~BtCodeMemoryWrite() {
+    restoreCodePages();
+}
+
+void BtCodeMemoryWrite::restoreCodePages() {
+    if (!this->writableLen) {
+        return;
+    }
+    Memory* memory = this->cpu->thread->memory;
+    U32 pageStart = memory->getNativePage(this->writableAddress >> K_PAGE_SHIFT);
+    U32 pageStop = memory->getNativePage((this->writableAddress + this->writableLen - 1) >> K_PAGE_SHIFT);
+
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(memory->executableMemoryMutex);
+    for (U32 page = pageStart; page <= pageStop; page++) {
+        if (memory->nativeFlags[page] & NATIVE_FLAG_CODEPAGE_READONLY) {
+            memory->updatePagePermission(memory->getEmulatedPage(page), K_NATIVE_PAGES_PER_PAGE);
+        }
+    }
+    this->writableLen = 0;
 }
 
 void BtCodeMemoryWrite::invalidateStringWriteToDi(bool repeat, U32 size) {
@@ -29,14 +50,29 @@ void BtCodeMemoryWrite::invalidateStringWriteToDi(bool repeat, U32 size) {
     invalidateCode(addressStart, addressLen);
 }
 
+bool BtCodeMemoryWrite::canWriteAroundCode(KThread* thread) {
+    return KSystem::btSubPageCodeWrites && thread->process->getThreadCount() <= 1;
+}
+
 void BtCodeMemoryWrite::invalidateCode(U32 addressStart, U32 addressLen) {
     U32 pageStart = this->cpu->thread->memory->getNativePage(addressStart >> K_PAGE_SHIFT);
     U32 pageStop = this->cpu->thread->memory->getNativePage((addressStart + addressLen - 1) >> K_PAGE_SHIFT);
 
     for (U32 page = pageStart; page <= pageStop; page++) {
         if (cpu->thread->memory->nativeFlags[page] & NATIVE_FLAG_CODEPAGE_READONLY) {
+            // only this thread could start another one, so the answer holds until the write is done.  It is checked
+            // before executableMemoryMutex so that the process's threads lock is never taken while holding it
+            bool writeAroundCode = canWriteAroundCode(this->cpu->thread);
             BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(cpu->thread->memory->executableMemoryMutex);
-            this->cpu->thread->memory->clearHostCodeForWriting(pageStart, pageStop - pageStart + 1);
+            if (!writeAroundCode) {
+                this->cpu->thread->memory->clearHostCodeForWriting(pageStart, pageStop - pageStart + 1);
+            } else if (this->cpu->thread->memory->clearHostCodeOverlapping(addressStart, addressLen, false)) {
+                // the pages still have code that wasn't written to, they stay read-only except while this write happens
+                restoreCodePages();
+                this->cpu->thread->memory->allowCodePageWrite(addressStart, addressLen);
+                this->writableAddress = addressStart;
+                this->writableLen = addressLen;
+            }
             return;
         }
     }    
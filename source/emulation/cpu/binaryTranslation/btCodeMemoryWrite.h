@@ -9,11 +9,21 @@ class BtCodeMemoryWrite {
 public:
     BtCodeMemoryWrite(BtCPU* cpu);
     BtCodeMemoryWrite(BtCPU* cpu, U32 address, U32 len);
+    ~BtCodeMemoryWrite();
 
+    // the range can be written until this object goes away, even if its pages still have code and are read-only
     void invalidateCode(U32 address, U32 len);
     void invalidateStringWriteToDi(bool repeat, U32 size);
+
+    // A page that still has code is only made writable for the length of one write if no other thread can run.  Another
+    // thread's store to the page while it is writable wouldn't fault, so its code would never be invalidated.
+    static bool canWriteAroundCode(KThread* thread);
 private:
+    void restoreCodePages();
+
     BtCPU* cpu;
+    U32 writableAddress;
+    U32 writableLen;
 };
 #endif
 #endif
\ No newline at end of file
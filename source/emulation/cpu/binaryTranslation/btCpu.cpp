@@ -2,6 +2,10 @@
 #include "btCodeChunk.h"
 #include "btCpu.h"
 #include "btData.h"
+#include "btCodeCache.h"
+#include "btTranslationWorkers.h"
+#include "btInterpreter.h"
+#include "btCodeMemoryWrite.h"
 #include "ksignal.h"
 #include "knativethread.h"
 #include "knativesystem.h"
@@ -11,17 +15,61 @@
 
 typedef void (*StartCPU)();
 
+U32 BtCPU::tracesFormed;
+
+BtCPU::~BtCPU() {
+    if (this->interpreter) {
+        delete this->interpreter;
+    }
+    if (this->codeMemory) {
+        this->codeMemory->removeCodeThread(this);
+    }
+}
+
+void BtCPU::enterGeneratedCode() {
+    Memory* memory = this->thread->memory;
+    if (this->codeMemory != memory) {
+        if (this->codeMemory) {
+            this->codeMemory->removeCodeThread(this);
+        }
+        memory->addCodeThread(this);
+    }
+    // nothing retired before this point can be reached through the mappings or link slots anymore
+    this->codePin = 0;
+    this->codeEpoch = *this->codeEpochSource;
+}
+
+void BtCPU::leaveGeneratedCode() {
+    this->codeEpoch = BT_CODE_EPOCH_OUTSIDE;
+    this->codePin = 0;
+    if (this->codeMemory && this->codeMemory->isCodeCacheOverLimit()) {
+        this->codeMemory->evictExecutableMemory();
+    }
+}
+
 void BtCPU::run() {
     while (true) {
         this->memOffset = this->thread->process->memory->id;
         this->exitToStartThreadLoop = 0;
+        this->exitToInterpreter = false;
         if (setjmp(this->runBlockJump) == 0) {
+            if (this->interpreter && KSystem::btHotThreshold) {
+                this->interpreter->run();
+                if (!this->thread->memory->getExistingHostAddress(this->getEipAddress())) {
+                    this->translateEip(this->eip.u32);
+                }
+            }
             StartCPU start = (StartCPU)this->init();
+            this->enterGeneratedCode();
             start();
 #ifdef __TEST
-            return;
+            if (!this->exitToInterpreter) {
+                this->leaveGeneratedCode();
+                return;
+            }
 #endif
         }
+        this->leaveGeneratedCode();
         if (this->thread->terminating) {
             break;
         }
@@ -48,7 +96,41 @@ void BtCPU::run() {
 }
 
 std::shared_ptr<BtCodeChunk> BtCPU::translateChunk(U32 ip) {
-    std::shared_ptr<BtData> firstPass = createData();
+    // even without a cache file, code mapped from a file might have been translated by another process
+    if (!this->canCacheTranslations()) {
+        return translateChunkInternal(ip);
+    }
+    U64 startTime = KSystem::getMicroCounter();
+    std::shared_ptr<BtData> cached = createData();
+    if (BtCodeCache::load(this, ip, cached)) {
+        std::shared_ptr<BtCodeChunk> chunk = cached->commit(false);
+        link(cached, chunk);
+        BtCodeCache::loadTime += KSystem::getMicroCounter() - startTime;
+        return chunk;
+    }
+    std::shared_ptr<BtCodeChunk> chunk = translateChunkInternal(ip);
+    BtCodeCache::translatedCount++;
+    BtCodeCache::translateTime += KSystem::getMicroCounter() - startTime;
+    return chunk;
+}
+
+std::shared_ptr<BtCodeChunk> BtCPU::translateChunkInternal(U32 ip) {
+    std::shared_ptr<BtData> data = createData();
+    if (data->canTranslateInSinglePass()) {
+        data->ip = ip;
+        data->startOfDataIp = ip;
+        data->singlePass = true;
+        translateData(data);
+        data->resolveJumpRelocations();
+        std::shared_ptr<BtCodeChunk> chunk = data->commit(false);
+        link(data, chunk);
+        if (this->canCacheTranslations()) {
+            BtCodeCache::save(this, data.get());
+        }
+        return chunk;
+    }
+
+    std::shared_ptr<BtData> firstPass = data;
     firstPass->ip = ip;
     firstPass->startOfDataIp = ip;
     translateData(firstPass);
@@ -63,6 +145,9 @@ std::shared_ptr<BtCodeChunk> BtCPU::translateChunk(U32 ip) {
     if (failedJumpOpIndex == -1) {
         std::shared_ptr<BtCodeChunk> chunk = secondPass->commit(false);
         link(secondPass, chunk);
+        if (this->canCacheTranslations()) {
+            BtCodeCache::save(this, secondPass.get());
+        }
         return chunk;
     }
     else {
@@ -81,23 +166,32 @@ std::shared_ptr<BtCodeChunk> BtCPU::translateChunk(U32 ip) {
 
         std::shared_ptr<BtCodeChunk> chunk = secondPass->commit(false);
         link(secondPass, chunk);
+        if (this->canCacheTranslations()) {
+            BtCodeCache::save(this, secondPass.get());
+        }
         return chunk;
     }
 }
 
 U64 BtCPU::reTranslateChunk() {
+    U64 startTime = KSystem::getMicroCounter();
 #ifndef __TEST
     // only one thread at a time can update the host code pages and related date like opToAddressPages
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->thread->memory->executableMemoryMutex);
 #endif
-    std::shared_ptr<BtCodeChunk> chunk = this->thread->memory->getCodeChunkContainingEip(this->eip.u32 + this->seg[CS].address);
-    if (chunk) {
+    U32 address = this->eip.u32 + this->seg[CS].address;
+    std::shared_ptr<BtCodeChunk> chunk = this->thread->memory->getCodeChunkContainingEip(address);
+    // a translation worker might have replaced the stub with real code while this thread waited in the critical section above
+    bool translatedByWorker = chunk && !chunk->isStub() && chunk->getEip() == address && BtTranslationWorkers::isRunning();
+    if (chunk && !translatedByWorker) {
         chunk->releaseAndRetranslate();
     }
 
-    U64 result = (U64)this->thread->memory->getExistingHostAddress(this->eip.u32 + this->seg[CS].address);
+    U64 result = (U64)this->thread->memory->getExistingHostAddress(address);
     if (result == 0) {
         result = (U64)this->translateEip(this->eip.u32);
+    } else {
+        addTranslationStall(startTime);
     }
     if (result == 0) {
         kpanic("BtCPU::reTranslateChunk failed to translate code in exception");
@@ -105,7 +199,72 @@ U64 BtCPU::reTranslateChunk() {
     return result;
 }
 
+// longest run of emulated code formTrace will put in one chunk
+#define BT_MAX_TRACE_LEN K_PAGE_SIZE
+
+static bool canJoinTrace(const std::shared_ptr<BtCodeChunk>& chunk) {
+    return chunk && chunk->isLive() && chunk->canEvict() && chunk->getValidEipLen() == chunk->getEipLen();
+}
+
+// Chunks end at the first jmp, so a loop whose body jumps over some code, or that was first entered in the middle,
+// ends up split over 2 chunks with every iteration going through the links between them.  When a link gets hot and
+// the chunk it is in and the chunk it jumps to sit next to each other, both are translated again as one chunk.  Jmps
+// in between are followed, so the jumps between the two halves stay in the chunk and the old chunks are evicted.
+// Jumps that leave the new chunk use links like any other chunk.
+//
+// A link that can't form a trace, for example because one of the chunks ends with a call, is left alone, its count
+// wrapped around and won't reach 0 again for a long time.
+U64 BtCPU::formTrace(BtCodeChunkLink* hotLink) {
+#ifndef __TEST
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->thread->memory->executableMemoryMutex);
+#endif
+    Memory* memory = this->thread->memory;
+    std::shared_ptr<BtCodeChunk> from = memory->getCodeChunkContainingHostAddress(hotLink->fromHostOffset);
+    std::shared_ptr<BtCodeChunk> to = memory->getCodeChunkContainingEip(hotLink->toEip);
+
+    if (!this->isBig() || from == to || !canJoinTrace(from) || !canJoinTrace(to) || from->getEipLen() + to->getEipLen() > BT_MAX_TRACE_LEN) {
+        return (U64)hotLink->toHostInstruction;
+    }
+    U32 start;
+    U32 end;
+    if (from->getEip() + from->getEipLen() == to->getEip()) {
+        start = from->getEip();
+        end = to->getEip() + to->getEipLen();
+    } else if (to->getEip() + to->getEipLen() == from->getEip()) {
+        start = to->getEip();
+        end = from->getEip() + from->getEipLen();
+    } else {
+        return (U64)hotLink->toHostInstruction;
+    }
+    std::shared_ptr<BtData> data = createData();
+    if (!data->canTranslateInSinglePass()) {
+        return (U64)hotLink->toHostInstruction;
+    }
+    data->ip = start - this->seg[CS].address;
+    data->startOfDataIp = data->ip;
+    data->traceEndIp = end - this->seg[CS].address;
+    data->singlePass = true;
+    translateData(data);
+    if (data->ip < data->traceEndIp || data->dynamic) {
+        // stopped at something other than a jmp in the middle
+        return (U64)hotLink->toHostInstruction;
+    }
+    data->resolveJumpRelocations();
+
+    from->evict(memory);
+    to->evict(memory);
+    std::shared_ptr<BtCodeChunk> chunk = data->commit(false);
+    link(data, chunk);
+    makePendingCodePagesReadOnly();
+    from->moveLinksFromTo(chunk);
+    to->moveLinksFromTo(chunk);
+    chunk->makeLive();
+    tracesFormed++;
+    return (U64)memory->getExistingHostAddress(this->eip.u32 + this->seg[CS].address);
+}
+
 U64 BtCPU::handleChangedUnpatchedCode(U64 rip) {
+    U64 startTime = KSystem::getMicroCounter();
 #ifndef __TEST
     // only one thread at a time can update the host code pages and related date like opToAddressPages
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->thread->memory->executableMemoryMutex);
@@ -114,6 +273,12 @@ U64 BtCPU::handleChangedUnpatchedCode(U64 rip) {
     unsigned char* hostAddress = (unsigned char*)rip;
     std::shared_ptr<BtCodeChunk> chunk = this->thread->memory->getCodeChunkContainingHostAddress(hostAddress);
     if (!chunk) {
+        // a translation worker replaced the stub while this thread waited in the critical section above
+        void* host = this->thread->memory->getExistingHostAddress(this->eip.u32 + this->seg[CS].address);
+        if (host) {
+            addTranslationStall(startTime);
+            return (U64)host;
+        }
         kpanic("BtCPU::handleChangedUnpatchedCode: could not find chunk");
     }
     U32 startOfEip = chunk->getEipThatContainsHostAddress(hostAddress, NULL, NULL);
@@ -123,6 +288,8 @@ U64 BtCPU::handleChangedUnpatchedCode(U64 rip) {
     U64 result = (U64)this->thread->memory->getExistingHostAddress(startOfEip);
     if (result == 0) {
         result = (U64)this->translateEip(startOfEip - this->seg[CS].address);
+    } else {
+        addTranslationStall(startTime);
     }
     if (result == 0) {
         kpanic("BtCPU::handleChangedUnpatchedCode failed to translate code in exception");
@@ -187,13 +354,76 @@ void* BtCPU::translateEipInternal(U32 ip) {
 }
 
 void* BtCPU::translateEip(U32 ip) {
+    U64 startTime = KSystem::getMicroCounter();
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->thread->memory->executableMemoryMutex);
 
     void* result = translateEipInternal(ip);
     makePendingCodePagesReadOnly();
+    addTranslationStall(startTime);
     return result;
 }
 
+void BtCPU::addTranslationStall(U64 startTime) {
+    this->translationStallTime += KSystem::getMicroCounter() - startTime;
+    this->translationCount++;
+}
+
+// The translation workers only look at code that can be read without faulting and that doesn't live on a page
+// that needs per instruction dynamic checks
+bool BtCPU::canTranslateSpeculatively(U32 address) {
+    Memory* memory = this->thread->memory;
+    if (!memory->isValidReadAddress(address, K_MAX_X86_OP_LEN)) {
+        return false;
+    }
+    U32 startPage = memory->getNativePage(address >> K_PAGE_SHIFT);
+    U32 endPage = memory->getNativePage((address + K_MAX_X86_OP_LEN - 1) >> K_PAGE_SHIFT);
+    for (U32 i = startPage; i <= endPage; i++) {
+        if (memory->dynamicCodePageUpdateCount[i] == MAX_DYNAMIC_CODE_PAGE_COUNT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BtCPU::translateSpeculatively(U32 ip) {
+    Memory* memory = this->thread->memory;
+    bool result = false;
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(memory->executableMemoryMutex);
+    {
+        // the guest can't unmap the code while it is being read
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(memory->pageMutex);
+
+        // the workers only know the eip, so stick to flat 32-bit code where the eip is also the address
+        if (!this->isBig() || this->seg[CS].address || !canTranslateSpeculatively(ip)) {
+            return false;
+        }
+        void* host = memory->getExistingHostAddress(ip);
+        if (!host) {
+            std::shared_ptr<BtCodeChunk> chunk = this->translateChunk(ip);
+            chunk->makeLive();
+            result = true;
+        } else {
+            std::shared_ptr<BtCodeChunk> chunk = memory->getCodeChunkContainingHostAddress(host);
+            if (chunk && chunk->isStub()) {
+                // if another thread is about to run the stub, it will find the new code the same way it does when
+                // a guest thread replaces a chunk, see the 0xcd handling in handleIllegalInstruction
+                chunk->releaseAndRetranslate();
+                result = true;
+            }
+        }
+        makePendingCodePagesReadOnly();
+    }
+    return result;
+}
+
+BtCPU* BtCPU::currentTranslator() {
+    BtCPU* cpu = BtTranslationWorkers::getWorkerCPU();
+    if (cpu) {
+        return cpu;
+    }
+    return (BtCPU*)KThread::currentThread()->cpu;
+}
+
 void BtCPU::makePendingCodePagesReadOnly() {
     for (int i = 0; i < (int)this->pendingCodePages.size(); i++) {
         // the chunk could cross a page and be a mix of dynamic and non dynamic code
@@ -296,7 +526,7 @@ U64 BtCPU::handleAccessException(U64 ip, U64 address, bool readAddress) {
     U32 inst = *((U32*)ip);
 
     if (inst == largeAddressJumpInstruction && this->thread->memory->isValidReadAddress((U32)this->destEip, 1)) { // useLargeAddressSpace = true
-        return (U64)this->translateEip((U32)this->destEip - this->seg[CS].address);
+        return this->translateOrInterpretEip((U32)this->destEip - this->seg[CS].address);
     }
     else if ((inst == pageJumpInstruction || inst == pageOffsetJumpInstruction) && (this->regPage || this->regOffset)) { // if these constants change, update handleMissingCode too     
         return this->handleMissingCode((U32)this->regPage, (U32)this->regOffset); // useLargeAddressSpace = false
@@ -355,6 +585,9 @@ void BtCPU::startThread() {
         this->jmpBuf = &jmpBuf;
         this->run();
     }
+    if (BtTranslationWorkers::isRunning()) {
+        klog("thread %d stalled %d ms for %d translations", thread->id, (U32)(this->translationStallTime / 1000), this->translationCount);
+    }
     std::shared_ptr<KProcess> process = thread->process;
     process->deleteThread(thread);
 
@@ -365,18 +598,6 @@ void BtCPU::startThread() {
     }
 }
 
-// called from another thread
-void BtCPU::wakeThreadIfWaiting() {
-    BoxedWineCondition* cond = thread->waitingCond;
-
-    // wait up the thread if it is waiting
-    if (cond) {
-        cond->lock();
-        cond->signal();
-        cond->unlock();
-    }
-}
-
 DecodedBlock* BtCPU::getNextBlock() {
     return NULL;
 }
@@ -417,8 +638,16 @@ U64 BtCPU::getIpFromEip() {
 }
 
 U64 BtCPU::handleMissingCode(U32 page, U32 offset) {
-    this->eip.u32 = ((page << K_PAGE_SHIFT) | offset) - this->seg[CS].address;
-    return (U64)this->translateEip(this->eip.u32);
+    return this->translateOrInterpretEip(((page << K_PAGE_SHIFT) | offset) - this->seg[CS].address);
+}
+
+U64 BtCPU::translateOrInterpretEip(U32 ip) {
+    this->eip.u32 = ip;
+    if (this->interpreter && !this->thread->memory->getExistingHostAddress(this->getEipAddress()) && this->interpreter->shouldInterpret(this->getEipAddress())) {
+        this->exitToInterpreter = true;
+        return (U64)this->returnToLoopAddress;
+    }
+    return (U64)this->translateEip(ip);
 }
 
 bool BtCPU::handleStringOp(DecodedOp* op) {
@@ -430,7 +659,11 @@ bool BtCPU::handleStringOp(DecodedOp* op) {
 // 1) This function will clear the page of all cached code
 // 2) Mark all the old cached code with "0xce" so that if the program tries to run it again, it will re-compile it
 // 3) NATIVE_FLAG_CODEPAGE_READONLY will be removed
+//
+// With KSystem::btSubPageCodeWrites only the code that overlaps the write is cleared, see Memory::clearHostCodeOverlapping
 U64 BtCPU::handleCodePatch(U64 rip, U32 address) {
+    // checked before executableMemoryMutex so that the process's threads lock is never taken while holding it
+    bool writeAroundCode = BtCodeMemoryWrite::canWriteAroundCode(this->thread);
 #ifndef __TEST
     // only one thread at a time can update the host code pages and related date like opToAddressPages
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->thread->memory->executableMemoryMutex);
@@ -472,6 +705,12 @@ U64 BtCPU::handleCodePatch(U64 rip, U32 address) {
                 addressStart = (this->isBig() ? THIS_EDI : THIS_DI) + this->seg[ES].address + (instructionInfo[op->inst].writeMemWidth / 8) - len;
             }
         }
+        // if the page still has code that the write missed, it stays read-only and the write is run here instead of
+        // letting it fault again.  The normal core's write goes through BtCodeMemoryWrite like any other host write.
+        if (writeAroundCode && (!memory->clearHostCodeOverlapping(addressStart, len, true) || BtInterpreter::runSingleOp(this))) {
+            op->dealloc(true);
+            return getIpFromEip();
+        }
         U32 startPage = addressStart >> K_PAGE_SHIFT;
         U32 endPage = (addressStart + len - 1) >> K_PAGE_SHIFT;
         memory->clearHostCodeForWriting(memory->getNativePage(startPage), memory->getNativePage(endPage - startPage) + 1);
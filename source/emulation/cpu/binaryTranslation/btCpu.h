@@ -3,11 +3,14 @@
 
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
 class BtData;
+class BtInterpreter;
+class BtCodeChunkLink;
+
+#define BT_CODE_EPOCH_OUTSIDE 0xFFFFFFFFFFFFFFFFl // BtCPU::codeEpoch while the thread isn't running generated code
 
 class BtCPU : public CPU {
 public:
-    BtCPU() : nativeHandle(0), 
-        exceptionAddress(0), 
+    BtCPU() : exceptionAddress(0), 
         inException(false), 
         exceptionReadAddress(false), 
         returnHostAddress(0), 
@@ -17,15 +20,25 @@ public:
         eipToHostInstructionAddressSpaceMapping(NULL),
         returnToLoopAddress(NULL),
         memOffset(0),
-        exitToStartThreadLoop(0) {}
+        exitToStartThreadLoop(0),
+        exitToInterpreter(false),
+        interpreter(NULL),
+        translationStallTime(0),
+        translationCount(0),
+        codeEpoch(BT_CODE_EPOCH_OUTSIDE),
+        codePin(0),
+        codeEpochSource(NULL),
+        codeGeneration(NULL),
+        codeMemory(NULL) {}
+    virtual ~BtCPU();
 
     // from CPU
     virtual void run();
     virtual DecodedBlock* getNextBlock();
 
     virtual void* init() = 0; // called from run
+    virtual void startThread();
 
-    U64 nativeHandle;
     U64 exceptionAddress;
     bool inException;
     bool exceptionReadAddress;
@@ -37,12 +50,31 @@ public:
     void* returnToLoopAddress;
     U64 memOffset;
     int exitToStartThreadLoop; // this will be checked after a syscall, if set to 1 then then x64CPU.returnToLoopAddress will be called
+    bool exitToInterpreter; // translated code returned to run() because it jumped to code that BtInterpreter will run
+    BtInterpreter* interpreter; // NULL if the backend doesn't support running cold code in the interpreter
 
     std::vector<U32> pendingCodePages;
+
+    // time this thread spent waiting on code to be translated, including waiting for another thread to finish translating
+    U64 translationStallTime; // microseconds
+    U32 translationCount;
+
+    // Memory::reclaimExecutableMemory will not reuse host code retired after codeEpoch.  The generated code updates
+    // codeEpoch from *codeEpochSource before calling into the host for a syscall and sets codePin to an address in the
+    // chunk it will return to, since that chunk might be released while the syscall runs
+    volatile U64 codeEpoch;
+    volatile U64 codePin;
+    U64* codeEpochSource;
+    U64* codeGeneration; // Memory::codeGeneration of codeMemory
+    Memory* codeMemory; // the Memory this thread is registered with in Memory::addCodeThread
+    void enterGeneratedCode();
+    void leaveGeneratedCode();
     
     jmp_buf* jmpBuf;
 
     std::shared_ptr<BtCodeChunk> translateChunk(U32 ip);
+    // true if the backend records its host addresses in BtData::hostAddressRelocations so BtCodeCache can save its code
+    virtual bool canCacheTranslations() { return false; }
     virtual void translateData(const std::shared_ptr<BtData>& data, const std::shared_ptr<BtData>& firstPass = nullptr) = 0;
     virtual void link(const std::shared_ptr<BtData>& data, std::shared_ptr<BtCodeChunk>& fromChunk, U32 offsetIntoChunk = 0) = 0;
     void* translateEipInternal(U32 ip);
@@ -51,22 +83,32 @@ public:
 #endif
 
     U64 reTranslateChunk();
+    // called by translated code once hotLink has been taken KSystem::btTraceThreshold times, cpu->eip is its target.
+    // Returns the host address to continue at.
+    U64 formTrace(BtCodeChunkLink* hotLink);
     U64 handleChangedUnpatchedCode(U64 rip);
     U64 handleIllegalInstruction(U64 ip);
     U64 handleMissingCode(U32 page, U32 offset);
+    // for a jump from translated code to ip that has no translation, returns returnToLoopAddress if ip is still cold
+    U64 translateOrInterpretEip(U32 ip);
     U64 handleCodePatch(U64 rip, U32 address);
     U64 handleAccessException(U64 ip, U64 address, bool readAddress); // returns new ip, if 0 then don't set ip, but continue execution
     virtual bool handleStringOp(DecodedOp* op);
     DecodedOp* getOp(U32 eip, bool existing);
     void* translateEip(U32 ip);
+    bool translateSpeculatively(U32 ip); // called from BtTranslationWorkers, returns true if new code was translated
+    // the cpu translating on this host thread, a translation worker has its own copy of the guest thread's cpu state
+    // so that it never reads the cpu the guest thread is running on
+    static BtCPU* currentTranslator();
+    bool canTranslateSpeculatively(U32 address);
     void markCodePageReadOnly(BtData* data);
     void makePendingCodePagesReadOnly();
     U64 startException(U64 address, bool readAddress);
     U64 handleFpuException(int code);
-    void startThread();
-    void wakeThreadIfWaiting();    
     S32 preLinkCheck(BtData* data); // returns the index of the jump that failed
 
+    static U32 tracesFormed; // number of chunk pairs formTrace translated again as one chunk
+
     // used by handleAccessException
     U32 destEip;
     U64 regPage;
@@ -77,6 +119,8 @@ public:
     U32 pageOffsetJumpInstruction;
 protected:
     U64 getIpFromEip();
+    void addTranslationStall(U64 startTime);
+    std::shared_ptr<BtCodeChunk> translateChunkInternal(U32 ip);
     virtual std::shared_ptr<BtData> createData() = 0;
 };
 #endif
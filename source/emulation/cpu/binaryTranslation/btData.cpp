@@ -9,6 +9,7 @@ BtData::BtData() {
     this->ipAddress = this->ipAddressBuffer;
     this->ipAddressBufferPos = this->ipAddressBufferPosBuffer;
     this->ipAddressCount = 0;
+    this->ipAddressSorted = true;
     this->ipAddressBufferSize = sizeof(this->ipAddressBuffer) / sizeof(this->ipAddressBuffer[0]);
 
     this->buffer = this->bufferInternal;
@@ -20,16 +21,30 @@ BtData::BtData() {
     this->startOfOpIp = 0;
     this->calculatedEipLen = 0;
     this->stopAfterInstruction = -1;
+    this->traceEndIp = 0;
+    this->singlePass = false;
     this->dynamic = false;
     this->useSingleMemOffset = true;
     this->decodedOp = nullptr;
     this->currentBlock = nullptr;
+    this->coldBuffer = NULL;
+    this->coldBufferSize = 0;
+    this->coldBufferPos = 0;
+    this->inColdCode = false;
+    this->coldTodoJumpCount = 0;
+    this->coldJumpRelocationCount = 0;
 }
 
 BtData::~BtData() {
+    if (this->inColdCode) {
+        swapColdBuffer();
+    }
     if (this->buffer != this->bufferInternal) {
         delete[] this->buffer;
     }
+    if (this->coldBuffer) {
+        delete[] this->coldBuffer;
+    }
     if (this->ipAddress != this->ipAddressBuffer) {
         delete[] this->ipAddress;
     }
@@ -98,6 +113,59 @@ void BtData::write16Buffer(U8* buffer, U16 value) {
 
 }
 
+void BtData::swapColdBuffer() {
+    std::swap(this->buffer, this->coldBuffer);
+    std::swap(this->bufferSize, this->coldBufferSize);
+    std::swap(this->bufferPos, this->coldBufferPos);
+    std::swap(this->hostAddressRelocations, this->coldHostAddressRelocations);
+}
+
+void BtData::beginColdCode() {
+    if (this->inColdCode) {
+        kpanic("BtData::beginColdCode cold code can not be nested");
+    }
+    if (!this->coldBuffer) {
+        this->coldBufferSize = sizeof(this->bufferInternal);
+        this->coldBuffer = new U8[this->coldBufferSize];
+    }
+    // an instruction's cold code is kept together so that it can be retranslated by itself
+    U32 instructionIndex = this->ipAddressCount ? this->ipAddressCount - 1 : 0;
+    if (this->coldCode.empty() || this->coldCode.back().instructionIndex != instructionIndex) {
+        this->coldCode.push_back(BtColdCode(instructionIndex, this->coldBufferPos));
+    }
+    this->coldTodoJumpCount = (U32)this->todoJump.size();
+    this->coldJumpRelocationCount = (U32)this->jumpRelocations.size();
+    swapColdBuffer();
+    this->inColdCode = true;
+}
+
+void BtData::endColdCode() {
+    if (!this->inColdCode) {
+        kpanic("BtData::endColdCode was not in cold code");
+    }
+    if (this->todoJump.size() != this->coldTodoJumpCount || this->jumpRelocations.size() != this->coldJumpRelocationCount) {
+        kpanic("BtData::endColdCode cold code can not jump to other instructions");
+    }
+    swapColdBuffer();
+    this->inColdCode = false;
+}
+
+U32 BtData::placeColdCode() {
+    U32 result = this->bufferPos;
+    for (U32 i = 0; i < this->coldBufferPos; i++) {
+        write8(this->coldBuffer[i]);
+    }
+    for (auto& pos : this->coldHostAddressRelocations) {
+        this->hostAddressRelocations.push_back(result + pos);
+    }
+    for (auto& cold : this->coldCode) {
+        cold.hostOffset += result;
+    }
+    this->coldHostAddressRelocations.clear();
+    this->coldBufferPos = 0;
+    return result;
+}
+
 U8 BtData::calculateEipLen(U32 eip) {
     for (U32 i = 0; i < this->ipAddressCount; i++) {
         if (this->ipAddress[i] == eip) {
@@ -110,6 +178,23 @@ U8 BtData::calculateEipLen(U32 eip) {
     return 0;
 }
 
+S32 BtData::getBufferPos(U32 address) {
+    if (this->ipAddressSorted) {
+        U32* end = this->ipAddress + this->ipAddressCount;
+        U32* found = std::lower_bound(this->ipAddress, end, address);
+        if (found != end && *found == address) {
+            return (S32)this->ipAddressBufferPos[found - this->ipAddress];
+        }
+        return -1;
+    }
+    for (U32 i = 0; i < this->ipAddressCount; i++) {
+        if (this->ipAddress[i] == address) {
+            return (S32)this->ipAddressBufferPos[i];
+        }
+    }
+    return -1;
+}
+
 void BtData::mapAddress(U32 ip, U32 bufferPos) {
     if (this->ipAddressCount >= this->ipAddressBufferSize) {
         U32* ipAddressOld = this->ipAddress;
@@ -129,12 +214,18 @@ void BtData::mapAddress(U32 ip, U32 bufferPos) {
             delete[] ipAddressBufferPosOld;
         }
     }
+    if (this->ipAddressCount && ip < this->ipAddress[this->ipAddressCount - 1]) {
+        this->ipAddressSorted = false;
+    }
     this->ipAddress[this->ipAddressCount] = ip;
     this->ipAddressBufferPos[this->ipAddressCount++] = bufferPos;
 }
 
 std::shared_ptr<BtCodeChunk> BtData::commit(bool makeLive) {
     std::shared_ptr<BtCodeChunk> chunk = createChunk(this->ipAddressCount, this->ipAddress, this->ipAddressBufferPos, this->buffer, this->bufferPos, this->startOfDataIp, this->ip - this->startOfDataIp, this->dynamic);
+    if (!this->coldCode.empty()) {
+        chunk->setColdCode(this->coldCode);
+    }
     if (makeLive) {
         chunk->makeLive();
     }
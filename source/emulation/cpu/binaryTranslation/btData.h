@@ -1,6 +1,7 @@
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
 
 #include "btCpu.h"
+#include "btCodeChunk.h"
 
 class TodoJump {
 public:
@@ -13,6 +14,16 @@ public:
     U32 opIndex;
 };
 
+// A jump to eip emitted by a single pass translation with its 32-bit offset at bufferPos left for
+// BtData::resolveJumpRelocations, it isn't known if eip will be part of the chunk until the whole chunk is translated
+class BtJumpRelocation {
+public:
+    BtJumpRelocation(U32 eip, U32 bufferPos, bool conditional) : eip(eip), bufferPos(bufferPos), conditional(conditional) {}
+    U32 eip;
+    U32 bufferPos;
+    bool conditional; // a jcc doesn't set cpu->eip before the jump like jumpTo does
+};
+
 class BtData {
 public:
     BtData();
@@ -30,6 +41,7 @@ public:
     U32* ipAddress;
     U32* ipAddressBufferPos;
     U32 ipAddressCount;
+    bool ipAddressSorted; // false if 16-bit code wrapped around
     U32 ipAddressBufferSize;
     U32 ipAddressBuffer[64];
     U32 ipAddressBufferPosBuffer[64];
@@ -39,13 +51,29 @@ public:
     U8 bufferInternal[256];
 
     std::vector<TodoJump> todoJump;
+    std::vector<U32> hostAddressRelocations; // positions in buffer of 64-bit host addresses, used by BtCodeCache
+    std::vector<BtJumpRelocation> jumpRelocations;
     S32 stopAfterInstruction;
+    // BtCPU::formTrace translates everything before traceEndIp even if it already has code, jumps included
+    U32 traceEndIp;
+    bool singlePass;
+
+    // Code written between beginColdCode and endColdCode goes to coldBuffer, placeColdCode appends it to buffer once
+    // the chunk is translated.  Cold code can't contain links or jump relocations and the backend is responsible for
+    // the jumps from buffer to coldBuffer
+    U8* coldBuffer;
+    U32 coldBufferSize;
+    U32 coldBufferPos;
+    std::vector<U32> coldHostAddressRelocations; // like hostAddressRelocations, but positions in coldBuffer
+    std::vector<BtColdCode> coldCode; // hostOffset is a position in coldBuffer until placeColdCode moves it to buffer
 
     DecodedOp* decodedOp;
     DecodedBlock* currentBlock;
 
     void mapAddress(U32 ip, U32 bufferPos);
     U8 calculateEipLen(U32 eip);
+    // returns the position in buffer of the instruction that starts at address or -1 if it isn't in this data
+    S32 getBufferPos(U32 address);
 
     void write8(U8 data);
     void write16(U16 data);
@@ -55,10 +83,30 @@ public:
     void write32Buffer(U8* buffer, U32 value);
     void write16Buffer(U8* buffer, U16 value);
 
+    void beginColdCode();
+    void endColdCode();
+    bool isInColdCode() { return this->inColdCode; }
+    // returns the position in buffer where the cold code starts
+    U32 placeColdCode();
+
     virtual void jumpTo(U32 eip) = 0;
     virtual void resetForNewOp() = 0;
     virtual void translateInstruction() = 0;
+
+    // Backends that can emit all their jumps as BtJumpRelocation translate a chunk in one pass, the others translate
+    // it once to find out how long it is and then again knowing which jumps stay in the chunk
+    virtual bool canTranslateInSinglePass() { return false; }
+    // called once the whole chunk is translated, jumps that left the chunk get a link after the last instruction
+    virtual void resolveJumpRelocations() {}
+    // true if the op that set done was a jmp to a constant eip, a trace can keep going after it
+    virtual bool isDirectJmp() { return false; }
 protected:
+    void swapColdBuffer();
+
+    bool inColdCode;
+    U32 coldTodoJumpCount;
+    U32 coldJumpRelocationCount;
+
     virtual std::shared_ptr<BtCodeChunk> createChunk(U32 instructionCount, U32* eipInstructionAddress, U32* hostInstructionIndex, U8* hostInstructionBuffer, U32 hostInstructionBufferLen, U32 eip, U32 eipLen, bool dynamic) = 0;
 };
 
@@ -0,0 +1,308 @@
+#include "boxedwine.h"
+
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+
+#include "btInterpreter.h"
+#include "btCpu.h"
+#include "../normal/normalCPU.h"
+#include "../common/lazyFlags.h"
+#include "../../hardmmu/hard_memory.h"
+#ifdef BOXEDWINE_X64
+#include <immintrin.h>
+#endif
+
+U32 BtInterpreter::blockCount;
+U32 BtInterpreter::promotedCount;
+U32 BtInterpreter::faultCount;
+
+// The normal ops ask DecodedBlock::currentBlock for the next block when they branch, every block run here already
+// points to this one so they never call BtCPU::getNextBlock.  Every thread shares it, nothing ever changes it once the
+// links point back to itself.
+static DecodedBlock nextBlock;
+
+static U8 fetchByte(U32* eip) {
+    return readb((*eip)++);
+}
+
+// ops that must run in translated code
+static bool canInterpret(DecodedOp* op) {
+    if (op->inst == Done) {
+        return true;
+    }
+    if (op->lock || instructionInfo[op->inst].throwsException) {
+        return false;
+    }
+    // fpu, mmx and sse ops are after these, they use state that lives in the host registers
+    if (op->inst >= FADD_ST0_STj && op->inst <= FISTP_QWORD_INTEGER) {
+        return false;
+    }
+    if (op->inst >= PunpcklbwMmx) {
+        return false;
+    }
+    switch (op->inst) {
+    case XchgE8R8: // implicitly locked
+    case XchgE16R16:
+    case XchgE32R32:
+    case ArplReg:
+    case ArplMem:
+    case ArplReg32:
+    case ArplMem32:
+    case Insb:
+    case Insw:
+    case Insd:
+    case Outsb:
+    case Outsw:
+    case Outsd:
+    case Invalid:
+    case Int3:
+    case Int80:
+    case Int98:
+    case Int99:
+    case Int9A:
+    case IntIb:
+    case IntO:
+    case Iret:
+    case Iret32:
+    case ICEBP:
+    case Hlt:
+    case Cli:
+    case Sti:
+    case Rdtsc:
+    case CPUID:
+        return false;
+    default:
+        break;
+    }
+    if (op->inst >= InAlIb && op->inst <= OutDxEax) {
+        return false;
+    }
+    if (op->inst >= LarR16R16 && op->inst <= LslR32E32) {
+        return false;
+    }
+    if (op->inst >= SLDTReg && op->inst <= INVLPG) {
+        return false;
+    }
+    return true;
+}
+
+BtInterpreter::BtInterpreter(BtCPU* cpu) : cpu(cpu), memory(NULL), decoding(NULL), blockAddress(0), running(false) {
+    nextBlock.next1 = &nextBlock;
+    nextBlock.next2 = &nextBlock;
+}
+
+BtInterpreter::~BtInterpreter() {
+    clear();
+}
+
+void BtInterpreter::clear() {
+    for (auto& it : this->blocks) {
+        freeDecodedBlock(it.second);
+        delete it.second;
+    }
+    this->blocks.clear();
+}
+
+void BtInterpreter::freeDecodedBlock(Block* b) {
+    if (b->block) {
+        if (b->block->op) {
+            b->block->op->dealloc(true);
+        }
+        delete b->block;
+        b->block = NULL;
+    }
+    b->code.clear();
+    b->code.shrink_to_fit();
+}
+
+bool BtInterpreter::shouldInterpret(U32 address) {
+    if (!KSystem::btHotThreshold || !this->cpu->isBig()) {
+        return false;
+    }
+    if (this->memory != this->cpu->thread->memory) {
+        return true; // run() will throw away the blocks from before the exec
+    }
+    auto it = this->blocks.find(address);
+    return it == this->blocks.end() || !it->second->hot;
+}
+
+bool BtInterpreter::isCodeUnchanged(Block* b, U32 address) {
+    U32 len = (U32)b->code.size();
+    U32 firstLen = K_PAGE_SIZE - (address & K_PAGE_MASK);
+
+    if (firstLen >= len) {
+        return !memcmp(getNativeAddress(this->memory, address), b->code.data(), len);
+    }
+    return !memcmp(getNativeAddress(this->memory, address), b->code.data(), firstLen) && !memcmp(getNativeAddress(this->memory, address + firstLen), b->code.data() + firstLen, len - firstLen);
+}
+
+// returns false if the first op can't be interpreted
+bool BtInterpreter::decode(Block* b, U32 address) {
+    DecodedBlock* block = new DecodedBlock();
+    this->decoding = block; // if reading the code faults, hostFault will free it
+    decodeBlock(fetchByte, address, true, 0, K_PAGE_SIZE, 0, block);
+    this->decoding = NULL;
+
+    DecodedOp* op = block->op;
+    DecodedOp* prev = NULL;
+    while (op) {
+        if (!canInterpret(op)) {
+            if (!prev) {
+                op->dealloc(true);
+                delete block;
+                return false;
+            }
+            // stop in front of it, the next call to run() will see that it can't be interpreted and translate it
+            if (op->next) {
+                op->next->dealloc(true);
+                op->next = NULL;
+            }
+            op->inst = Done;
+            op->len = 0;
+        }
+        op->pfn = NormalCPU::getFunctionForOp(op);
+        prev = op;
+        op = op->next;
+    }
+    U32 len = 0;
+    for (op = block->op; op; op = op->next) {
+        len += op->len;
+    }
+    block->address = address;
+    block->next1 = &nextBlock;
+    block->next2 = &nextBlock;
+    b->block = block;
+    b->code.resize(len);
+    for (U32 i = 0; i < len; i++) {
+        b->code[i] = readb(address + i);
+    }
+    return true;
+}
+
+BtInterpreter::Block* BtInterpreter::findBlock(U32 address) {
+    auto it = this->blocks.find(address);
+
+    if (it == this->blocks.end()) {
+        Block* b = new Block();
+        this->blocks[address] = b;
+        return b;
+    }
+    return it->second;
+}
+
+void BtInterpreter::setHot(U32 address) {
+    Block* b = findBlock(address);
+    b->hot = true;
+    freeDecodedBlock(b);
+}
+
+BtInterpreter::Block* BtInterpreter::getBlock(U32 address) {
+    Block* b = findBlock(address);
+
+    if (b->hot || (b->block && isCodeUnchanged(b, address))) {
+        return b;
+    }
+    freeDecodedBlock(b);
+    if (!decode(b, address)) {
+        b->hot = true;
+    }
+    return b;
+}
+
+void BtInterpreter::run() {
+    if (!KSystem::btHotThreshold || !this->cpu->isBig()) {
+        return;
+    }
+    if (this->memory != this->cpu->thread->memory) {
+        // exec
+        clear();
+        this->memory = this->cpu->thread->memory;
+    }
+#ifdef BOXEDWINE_X64
+    // the guest's fpu and sse state is in the host registers, it must survive the C code below
+    ALIGN(U8 fpuState[512], 16);
+    _fxsave64(fpuState);
+#endif
+    this->cpu->lazyFlags = FLAGS_NONE;
+    this->cpu->df = 1 - ((this->cpu->flags & DF) >> 9);
+    this->running = true;
+
+    if (setjmp(this->faultJump) == 0) {
+        while (true) {
+            U32 address = this->cpu->eip.u32 + this->cpu->seg[CS].address;
+            if (this->memory->getExistingHostAddress(address)) {
+                break;
+            }
+            this->blockAddress = address;
+            Block* b = getBlock(address);
+            if (b->hot) {
+                break;
+            }
+            b->count++;
+            if (b->count >= KSystem::btHotThreshold) {
+                setHot(address);
+                promotedCount++;
+                break;
+            }
+            DecodedBlock::currentBlock = b->block;
+            b->block->op->pfn(this->cpu, b->block->op);
+            blockCount++;
+        }
+    } else {
+        // leave the op that faulted to translated code
+        if (this->decoding) {
+            if (this->decoding->op) {
+                this->decoding->op->dealloc(true);
+            }
+            delete this->decoding;
+            this->decoding = NULL;
+        }
+        // the block will probably fault again, so translate all of it, not just from the op that faulted
+        setHot(this->blockAddress);
+        setHot(this->cpu->eip.u32 + this->cpu->seg[CS].address);
+        faultCount++;
+    }
+    this->running = false;
+    this->cpu->fillFlags();
+#ifdef BOXEDWINE_X64
+    _fxrstor64(fpuState);
+#endif
+}
+
+void BtInterpreter::hostFault() {
+    BtCPU* cpu = (BtCPU*)KThread::currentThread()->cpu;
+    longjmp(cpu->interpreter->faultJump, 1);
+}
+
+bool BtInterpreter::runSingleOp(BtCPU* cpu) {
+    DecodedBlock block;
+    decodeBlock(fetchByte, cpu->getEipAddress(), cpu->isBig(), 1, 0, 0, &block);
+    DecodedOp* op = block.op;
+    bool result = op->inst != Done && !instructionInfo[op->inst].branch && canInterpret(op);
+
+    if (result) {
+        op->next = DecodedOp::alloc();
+        op->next->inst = Done;
+        op->next->len = 0;
+        op->pfn = NormalCPU::getFunctionForOp(op);
+        op->next->pfn = NormalCPU::getFunctionForOp(op->next);
+        block.address = cpu->getEipAddress();
+        block.next1 = &nextBlock;
+        block.next2 = &nextBlock;
+        DecodedBlock::currentBlock = &block;
+        cpu->lazyFlags = FLAGS_NONE;
+        cpu->df = 1 - ((cpu->flags & DF) >> 9);
+        op->pfn(cpu, op);
+        cpu->fillFlags();
+    }
+    op->dealloc(true);
+    return result;
+}
+
+void BtInterpreter::leaveIfRunning(CPU* cpu) {
+    BtCPU* btCpu = (BtCPU*)cpu;
+    if (btCpu->interpreter && btCpu->interpreter->running) {
+        hostFault();
+    }
+}
+
+#endif
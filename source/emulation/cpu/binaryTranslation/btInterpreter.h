@@ -0,0 +1,73 @@
+#ifndef __BT_INTERPRETER_H__
+#define __BT_INTERPRETER_H__
+
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+
+class BtCPU;
+
+// Runs code that hasn't been translated yet with the normal core's ops.  Most of the code a program runs, like its
+// start up, only runs a few times and decoding it is a lot cheaper than translating it.  A block is only handed to
+// BtCPU::translateChunk once it has been run KSystem::btHotThreshold times.
+//
+// BtCPU::run calls run() before entering translated code and translated code that jumps to an eip without a
+// translation returns to BtCPU::run if shouldInterpret() says the eip is still cold.
+//
+// Only flat 32-bit integer code is interpreted, a block is cut short at the first op that isn't, for example fpu/mmx/sse
+// ops (their state lives in the host registers while translated code runs), ops that can raise an exception, system
+// calls and locked ops (other threads might be running translated code).  The guest memory isn't checked before it is
+// used, if an op causes a host fault the platform handler calls hostFault() and the op is run again in translated code,
+// which already knows how to handle things like growing the stack or raising a guest signal.
+class BtInterpreter {
+public:
+    BtInterpreter(BtCPU* cpu);
+    ~BtInterpreter();
+
+    // runs blocks until the cpu reaches an eip that is translated, hot or can't be interpreted
+    void run();
+    // true if a jump from translated code to address, which doesn't have a translation, should return to BtCPU::run
+    bool shouldInterpret(U32 address);
+    bool isRunning() { return this->running; }
+    // forgets every block and how many times it ran
+    void clear();
+
+    // called instead of the code that caused a host fault while running, doesn't return
+    static void hostFault();
+    // for the memory functions that would kpanic instead of faulting, doesn't return if this thread is interpreting
+    static void leaveIfRunning(CPU* cpu);
+    // runs the op at eip with the normal core, used for a write that faulted on a page that has to stay read-only.
+    // Returns false without running it if it isn't an op that can be interpreted or if it branches.
+    static bool runSingleOp(BtCPU* cpu);
+
+    static U32 blockCount; // number of blocks that were run
+    static U32 promotedCount; // number of blocks that were handed to the translator after becoming hot
+    static U32 faultCount; // number of blocks that were handed to the translator because of a host fault
+
+private:
+    class Block {
+    public:
+        Block() : block(NULL), count(0), hot(false) {}
+        DecodedBlock* block;
+        std::vector<U8> code; // the guest bytes the block was decoded from
+        U32 count;
+        bool hot;
+    };
+
+    Block* findBlock(U32 address);
+    Block* getBlock(U32 address);
+    void setHot(U32 address);
+    bool decode(Block* b, U32 address);
+    bool isCodeUnchanged(Block* b, U32 address);
+    void freeDecodedBlock(Block* b);
+
+    BtCPU* cpu;
+    Memory* memory;
+    std::unordered_map<U32, Block*> blocks;
+    DecodedBlock* decoding;
+    U32 blockAddress; // start of the block being run
+    bool running;
+    jmp_buf faultJump;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,174 @@
+#include "boxedwine.h"
+
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+
+#include "btTranslationWorkers.h"
+#include "btCpu.h"
+#include "knativethread.h"
+
+// if the guest links faster than the workers can keep up, the guest thread will probably get to the code first
+// anyway, so there is no point in growing the queue
+#define MAX_QUEUED_TRANSLATIONS 4096
+
+// the parts of the guest thread's cpu that the translator reads, the guest thread keeps running and changes its own
+// cpu while the request waits
+class BtTranslationRequest {
+public:
+    BtTranslationRequest(KThread* thread, U32 eip, U32 big, const Seg& cs) : thread(thread), eip(eip), big(big), cs(cs) {}
+
+    KThread* thread;
+    U32 eip;
+    U32 big;
+    Seg cs;
+};
+
+static std::deque<BtTranslationRequest> requests;
+static std::vector<KNativeThread*> workers;
+static std::vector<KThread*> workerActiveThreads; // which guest thread each worker is currently translating for
+static U32 threadsWaitingOnWorkers;
+static bool workersDone;
+static BOXEDWINE_CONDITION requestsCond(B("BtTranslationWorkers::requestsCond"));
+static THREAD_LOCAL bool isTranslationWorker;
+static THREAD_LOCAL BtCPU* workerCPU;
+
+bool BtTranslationWorkers::running;
+U32 BtTranslationWorkers::translatedCount;
+U32 BtTranslationWorkers::droppedCount;
+
+void BtTranslationWorkers::start(U32 threadCount) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(requestsCond);
+    if (running || !threadCount) {
+        return;
+    }
+    workersDone = false;
+    workerActiveThreads.resize(threadCount, NULL);
+    for (U32 i = 0; i < threadCount; i++) {
+        workers.push_back(KNativeThread::createAndStartThread(workerThread, B("BtTranslationWorker"), (void*)(size_t)i));
+    }
+    running = true;
+}
+
+void BtTranslationWorkers::stop() {
+    std::vector<KNativeThread*> stopping;
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(requestsCond);
+        if (!running) {
+            return;
+        }
+        running = false;
+        workersDone = true;
+        requests.clear();
+        stopping.swap(workers);
+        BOXEDWINE_CONDITION_SIGNAL_ALL(requestsCond);
+    }
+    for (auto& worker : stopping) {
+        worker->wait();
+        delete worker;
+    }
+    workerActiveThreads.clear();
+}
+
+bool BtTranslationWorkers::isWorkerThread() {
+    return isTranslationWorker;
+}
+
+BtCPU* BtTranslationWorkers::getWorkerCPU() {
+    return workerCPU;
+}
+
+void BtTranslationWorkers::add(KThread* thread, U32 eip) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(requestsCond);
+    if (!running) {
+        return;
+    }
+    if (requests.size() >= MAX_QUEUED_TRANSLATIONS) {
+        droppedCount++;
+        return;
+    }
+    requests.push_back(BtTranslationRequest(thread, eip, thread->cpu->big, thread->cpu->seg[CS]));
+    if (threadsWaitingOnWorkers) {
+        // a single signal might wake up removeThread instead of a worker
+        BOXEDWINE_CONDITION_SIGNAL_ALL(requestsCond);
+    } else {
+        BOXEDWINE_CONDITION_SIGNAL(requestsCond);
+    }
+}
+
+void BtTranslationWorkers::removeThread(KThread* thread) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(requestsCond);
+    if (!running) {
+        return;
+    }
+    for (auto it = requests.begin(); it != requests.end();) {
+        if (it->thread == thread) {
+            it = requests.erase(it);
+        } else {
+            it++;
+        }
+    }
+    threadsWaitingOnWorkers++;
+    while (std::find(workerActiveThreads.begin(), workerActiveThreads.end(), thread) != workerActiveThreads.end()) {
+        BOXEDWINE_CONDITION_WAIT(requestsCond);
+    }
+    threadsWaitingOnWorkers--;
+}
+
+void BtTranslationWorkers::waitUntilIdle() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(requestsCond);
+    threadsWaitingOnWorkers++;
+    while (running && (!requests.empty() || std::find_if(workerActiveThreads.begin(), workerActiveThreads.end(), [](KThread* thread) {return thread != NULL; }) != workerActiveThreads.end())) {
+        BOXEDWINE_CONDITION_WAIT(requestsCond);
+    }
+    threadsWaitingOnWorkers--;
+}
+
+int BtTranslationWorkers::workerThread(void* data) {
+    U32 index = (U32)(size_t)data;
+    // translates with its own cpu, the guest thread's cpu is only read by the guest thread, see add
+    BtCPU* cpu = (BtCPU*)CPU::allocCPU();
+
+    isTranslationWorker = true;
+    while (true) {
+        KThread* thread = NULL;
+        U32 eip = 0;
+        {
+            BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(requestsCond);
+            while (!workersDone && requests.empty()) {
+                BOXEDWINE_CONDITION_WAIT(requestsCond);
+            }
+            if (workersDone) {
+                break;
+            }
+            const BtTranslationRequest& request = requests.front();
+            thread = request.thread;
+            eip = request.eip;
+            cpu->thread = thread;
+            cpu->big = request.big;
+            cpu->seg[CS] = request.cs;
+            requests.pop_front();
+            workerActiveThreads[index] = thread;
+        }
+        bool translated = false;
+        {
+            // the translator, like the rest of the emulator, expects to be running as the thread that owns the code
+            ChangeThread changeThread(thread);
+            workerCPU = cpu;
+            translated = cpu->translateSpeculatively(eip);
+            workerCPU = NULL;
+        }
+        {
+            BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(requestsCond);
+            workerActiveThreads[index] = NULL;
+            if (translated) {
+                translatedCount++;
+            }
+            if (threadsWaitingOnWorkers) {
+                BOXEDWINE_CONDITION_SIGNAL_ALL(requestsCond);
+            }
+        }
+    }
+    delete cpu;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef __BT_TRANSLATION_WORKERS_H__
+#define __BT_TRANSLATION_WORKERS_H__
+
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+
+class BtCPU;
+
+// A pool of threads that translate the targets of direct jumps and calls before the guest thread gets to them.
+//
+// When a chunk is linked to an eip that hasn't been translated yet, the link points to a stub and the eip is
+// queued here.  A worker will translate it and patch the stub so that the guest thread never stalls on it.  If
+// the guest thread gets there first, it translates the code itself, just like it does when the workers are off.
+class BtTranslationWorkers {
+public:
+    static void start(U32 threadCount);
+    static void stop();
+    static bool isRunning() { return running; }
+    static bool isWorkerThread();
+    // NULL unless this is a worker in the middle of a translation
+    static BtCPU* getWorkerCPU();
+
+    // called by the guest thread itself, so its cpu state can be copied for the worker without a lock
+    static void add(KThread* thread, U32 eip);
+
+    // drops any queued work for this thread and waits for a worker that is translating for it to finish
+    static void removeThread(KThread* thread);
+
+    // blocks until the queue is empty and no worker is busy, used by the unit tests
+    static void waitUntilIdle();
+
+    static U32 translatedCount;
+    static U32 droppedCount;
+
+private:
+    static int workerThread(void* data);
+
+    static bool running;
+};
+
+#endif
+
+#endif
@@ -18,6 +18,7 @@
 
 #include "boxedwine.h"
 #include "common_sse.h"
+#include "common_sse_native.h"
 #include <math.h>
 
 void common_addpsXmm(CPU* cpu, U32 r1, U32 r2) {
@@ -18,6 +18,7 @@
 
 #include "boxedwine.h"
 #include "common_sse.h"
+#include "common_sse_native.h"
 #include <math.h>
 
 #define TO_PD simde_mm_castps_pd
@@ -1305,6 +1306,11 @@ void common_shufpdXmmE128(CPU* cpu, U32 reg, U32 address, U8 imm) {
 }
 
 void common_pause(CPU* cpu) {
+#ifdef BOXEDWINE_MULTI_THREADED
+    if (KSystem::spinBackoff && --cpu->spinCountdown == 0) {
+        cpu->spinWait();
+    }
+#endif
 }
 
 void common_pavgbXmmXmm(CPU* cpu, U32 r1, U32 r2) {
@@ -0,0 +1,283 @@
+#ifndef __COMMON_SSE_NATIVE_H__
+#define __COMMON_SSE_NATIVE_H__
+
+// When BOXEDWINE_SSE_NATIVE is defined on a x86_64 host, the simde calls used by
+// common_sse.cpp and common_sse2.cpp are redirected to the host intrinsics.  SSE2 is part
+// of x86_64 so there is nothing to check at runtime, a 32-bit host isn't guaranteed to have
+// it so it always uses simde's portable code.
+//
+// SIMDE_SSE2_NO_NATIVE is still needed, it keeps simde's types in the portable layout that
+// these wrappers load from and store to.
+//
+// The xmm registers are still kept in simde's portable layout so that the rest of the
+// code can keep using .u64[]/.f32[] etc, each wrapper just moves the values in and out
+// of host registers.
+//
+// Only instructions whose host results are identical to simde's portable results are
+// redirected.  MXCSR is not emulated (it always reads back as 0x1F80) and Boxedwine never
+// changes the host MXCSR, so rounding, denormals and NaN propagation match.  rcp/rsqrt are
+// not redirected since the host approximations differ from simde's exact divide.
+#if defined(BOXEDWINE_SSE_NATIVE) && (defined(__x86_64__) || defined(_M_X64))
+#include <emmintrin.h>
+
+#define SSE_NATIVE_PS(v) _mm_loadu_ps((const float*)&(v))
+#define SSE_NATIVE_PD(v) _mm_loadu_pd((const double*)&(v))
+#define SSE_NATIVE_SI128(v) _mm_loadu_si128((const __m128i*)&(v))
+
+#define SSE_NATIVE_PS_2(name) \
+static inline simde__m128 native_mm_##name(simde__m128 a, simde__m128 b) { \
+    simde__m128 result; \
+    _mm_storeu_ps((float*)&result, _mm_##name(SSE_NATIVE_PS(a), SSE_NATIVE_PS(b))); \
+    return result; \
+}
+
+#define SSE_NATIVE_PS_1(name) \
+static inline simde__m128 native_mm_##name(simde__m128 a) { \
+    simde__m128 result; \
+    _mm_storeu_ps((float*)&result, _mm_##name(SSE_NATIVE_PS(a))); \
+    return result; \
+}
+
+#define SSE_NATIVE_PD_2(name) \
+static inline simde__m128d native_mm_##name(simde__m128d a, simde__m128d b) { \
+    simde__m128d result; \
+    _mm_storeu_pd((double*)&result, _mm_##name(SSE_NATIVE_PD(a), SSE_NATIVE_PD(b))); \
+    return result; \
+}
+
+#define SSE_NATIVE_PD_1(name) \
+static inline simde__m128d native_mm_##name(simde__m128d a) { \
+    simde__m128d result; \
+    _mm_storeu_pd((double*)&result, _mm_##name(SSE_NATIVE_PD(a))); \
+    return result; \
+}
+
+#define SSE_NATIVE_SI128_2(name) \
+static inline simde__m128i native_mm_##name(simde__m128i a, simde__m128i b) { \
+    simde__m128i result; \
+    _mm_storeu_si128((__m128i*)&result, _mm_##name(SSE_NATIVE_SI128(a), SSE_NATIVE_SI128(b))); \
+    return result; \
+}
+
+// SSE
+SSE_NATIVE_PS_2(add_ps)
+SSE_NATIVE_PS_2(add_ss)
+SSE_NATIVE_PS_2(sub_ps)
+SSE_NATIVE_PS_2(sub_ss)
+SSE_NATIVE_PS_2(mul_ps)
+SSE_NATIVE_PS_2(mul_ss)
+SSE_NATIVE_PS_2(div_ps)
+SSE_NATIVE_PS_2(div_ss)
+SSE_NATIVE_PS_2(min_ps)
+SSE_NATIVE_PS_2(min_ss)
+SSE_NATIVE_PS_2(max_ps)
+SSE_NATIVE_PS_2(max_ss)
+SSE_NATIVE_PS_1(sqrt_ps)
+SSE_NATIVE_PS_1(sqrt_ss)
+SSE_NATIVE_PS_2(and_ps)
+SSE_NATIVE_PS_2(andnot_ps)
+SSE_NATIVE_PS_2(or_ps)
+SSE_NATIVE_PS_2(xor_ps)
+SSE_NATIVE_PS_2(unpacklo_ps)
+SSE_NATIVE_PS_2(unpackhi_ps)
+SSE_NATIVE_PS_2(cmpeq_ps)
+SSE_NATIVE_PS_2(cmplt_ps)
+SSE_NATIVE_PS_2(cmple_ps)
+SSE_NATIVE_PS_2(cmpunord_ps)
+SSE_NATIVE_PS_2(cmpneq_ps)
+SSE_NATIVE_PS_2(cmpnlt_ps)
+SSE_NATIVE_PS_2(cmpnle_ps)
+SSE_NATIVE_PS_2(cmpord_ps)
+
+#define simde_mm_add_ps native_mm_add_ps
+#define simde_mm_add_ss native_mm_add_ss
+#define simde_mm_sub_ps native_mm_sub_ps
+#define simde_mm_sub_ss native_mm_sub_ss
+#define simde_mm_mul_ps native_mm_mul_ps
+#define simde_mm_mul_ss native_mm_mul_ss
+#define simde_mm_div_ps native_mm_div_ps
+#define simde_mm_div_ss native_mm_div_ss
+#define simde_mm_min_ps native_mm_min_ps
+#define simde_mm_min_ss native_mm_min_ss
+#define simde_mm_max_ps native_mm_max_ps
+#define simde_mm_max_ss native_mm_max_ss
+#define simde_mm_sqrt_ps native_mm_sqrt_ps
+#define simde_mm_sqrt_ss native_mm_sqrt_ss
+#define simde_mm_and_ps native_mm_and_ps
+#define simde_mm_andnot_ps native_mm_andnot_ps
+#define simde_mm_or_ps native_mm_or_ps
+#define simde_mm_xor_ps native_mm_xor_ps
+#define simde_mm_unpacklo_ps native_mm_unpacklo_ps
+#define simde_mm_unpackhi_ps native_mm_unpackhi_ps
+#define simde_mm_cmpeq_ps native_mm_cmpeq_ps
+#define simde_mm_cmplt_ps native_mm_cmplt_ps
+#define simde_mm_cmple_ps native_mm_cmple_ps
+#define simde_mm_cmpunord_ps native_mm_cmpunord_ps
+#define simde_mm_cmpneq_ps native_mm_cmpneq_ps
+#define simde_mm_cmpnlt_ps native_mm_cmpnlt_ps
+#define simde_mm_cmpnle_ps native_mm_cmpnle_ps
+#define simde_mm_cmpord_ps native_mm_cmpord_ps
+
+// SSE2 floating point
+SSE_NATIVE_PD_2(add_pd)
+SSE_NATIVE_PD_2(add_sd)
+SSE_NATIVE_PD_2(sub_pd)
+SSE_NATIVE_PD_2(sub_sd)
+SSE_NATIVE_PD_2(mul_pd)
+SSE_NATIVE_PD_2(mul_sd)
+SSE_NATIVE_PD_2(div_pd)
+SSE_NATIVE_PD_2(div_sd)
+SSE_NATIVE_PD_2(min_pd)
+SSE_NATIVE_PD_2(min_sd)
+SSE_NATIVE_PD_2(max_pd)
+SSE_NATIVE_PD_2(max_sd)
+SSE_NATIVE_PD_1(sqrt_pd)
+SSE_NATIVE_PD_2(sqrt_sd)
+SSE_NATIVE_PD_2(and_pd)
+SSE_NATIVE_PD_2(andnot_pd)
+SSE_NATIVE_PD_2(or_pd)
+SSE_NATIVE_PD_2(xor_pd)
+SSE_NATIVE_PD_2(unpacklo_pd)
+SSE_NATIVE_PD_2(unpackhi_pd)
+SSE_NATIVE_PD_2(cmpeq_pd)
+SSE_NATIVE_PD_2(cmplt_pd)
+SSE_NATIVE_PD_2(cmple_pd)
+SSE_NATIVE_PD_2(cmpunord_pd)
+SSE_NATIVE_PD_2(cmpneq_pd)
+SSE_NATIVE_PD_2(cmpnlt_pd)
+SSE_NATIVE_PD_2(cmpnle_pd)
+SSE_NATIVE_PD_2(cmpord_pd)
+
+#define simde_mm_add_pd native_mm_add_pd
+#define simde_mm_add_sd native_mm_add_sd
+#define simde_mm_sub_pd native_mm_sub_pd
+#define simde_mm_sub_sd native_mm_sub_sd
+#define simde_mm_mul_pd native_mm_mul_pd
+#define simde_mm_mul_sd native_mm_mul_sd
+#define simde_mm_div_pd native_mm_div_pd
+#define simde_mm_div_sd native_mm_div_sd
+#define simde_mm_min_pd native_mm_min_pd
+#define simde_mm_min_sd native_mm_min_sd
+#define simde_mm_max_pd native_mm_max_pd
+#define simde_mm_max_sd native_mm_max_sd
+#define simde_mm_sqrt_pd native_mm_sqrt_pd
+#define simde_mm_sqrt_sd native_mm_sqrt_sd
+#define simde_mm_and_pd native_mm_and_pd
+#define simde_mm_andnot_pd native_mm_andnot_pd
+#define simde_mm_or_pd native_mm_or_pd
+#define simde_mm_xor_pd native_mm_xor_pd
+#define simde_mm_unpacklo_pd native_mm_unpacklo_pd
+#define simde_mm_unpackhi_pd native_mm_unpackhi_pd
+#define simde_mm_cmpeq_pd native_mm_cmpeq_pd
+#define simde_mm_cmplt_pd native_mm_cmplt_pd
+#define simde_mm_cmple_pd native_mm_cmple_pd
+#define simde_mm_cmpunord_pd native_mm_cmpunord_pd
+#define simde_mm_cmpneq_pd native_mm_cmpneq_pd
+#define simde_mm_cmpnlt_pd native_mm_cmpnlt_pd
+#define simde_mm_cmpnle_pd native_mm_cmpnle_pd
+#define simde_mm_cmpord_pd native_mm_cmpord_pd
+
+// SSE2 integer
+SSE_NATIVE_SI128_2(add_epi8)
+SSE_NATIVE_SI128_2(add_epi16)
+SSE_NATIVE_SI128_2(add_epi32)
+SSE_NATIVE_SI128_2(add_epi64)
+SSE_NATIVE_SI128_2(adds_epi8)
+SSE_NATIVE_SI128_2(adds_epi16)
+SSE_NATIVE_SI128_2(adds_epu8)
+SSE_NATIVE_SI128_2(adds_epu16)
+SSE_NATIVE_SI128_2(sub_epi8)
+SSE_NATIVE_SI128_2(sub_epi16)
+SSE_NATIVE_SI128_2(sub_epi32)
+SSE_NATIVE_SI128_2(sub_epi64)
+SSE_NATIVE_SI128_2(subs_epi8)
+SSE_NATIVE_SI128_2(subs_epi16)
+SSE_NATIVE_SI128_2(subs_epu8)
+SSE_NATIVE_SI128_2(subs_epu16)
+SSE_NATIVE_SI128_2(mullo_epi16)
+SSE_NATIVE_SI128_2(mulhi_epi16)
+SSE_NATIVE_SI128_2(mulhi_epu16)
+SSE_NATIVE_SI128_2(mul_epu32)
+SSE_NATIVE_SI128_2(madd_epi16)
+SSE_NATIVE_SI128_2(avg_epu8)
+SSE_NATIVE_SI128_2(avg_epu16)
+SSE_NATIVE_SI128_2(sad_epu8)
+SSE_NATIVE_SI128_2(min_epu8)
+SSE_NATIVE_SI128_2(min_epi16)
+SSE_NATIVE_SI128_2(max_epu8)
+SSE_NATIVE_SI128_2(max_epi16)
+SSE_NATIVE_SI128_2(and_si128)
+SSE_NATIVE_SI128_2(andnot_si128)
+SSE_NATIVE_SI128_2(or_si128)
+SSE_NATIVE_SI128_2(xor_si128)
+SSE_NATIVE_SI128_2(cmpeq_epi8)
+SSE_NATIVE_SI128_2(cmpeq_epi16)
+SSE_NATIVE_SI128_2(cmpeq_epi32)
+SSE_NATIVE_SI128_2(cmpgt_epi8)
+SSE_NATIVE_SI128_2(cmpgt_epi16)
+SSE_NATIVE_SI128_2(cmpgt_epi32)
+SSE_NATIVE_SI128_2(packs_epi16)
+SSE_NATIVE_SI128_2(packs_epi32)
+SSE_NATIVE_SI128_2(packus_epi16)
+SSE_NATIVE_SI128_2(unpacklo_epi8)
+SSE_NATIVE_SI128_2(unpacklo_epi16)
+SSE_NATIVE_SI128_2(unpacklo_epi32)
+SSE_NATIVE_SI128_2(unpacklo_epi64)
+SSE_NATIVE_SI128_2(unpackhi_epi8)
+SSE_NATIVE_SI128_2(unpackhi_epi16)
+SSE_NATIVE_SI128_2(unpackhi_epi32)
+SSE_NATIVE_SI128_2(unpackhi_epi64)
+
+#define simde_mm_add_epi8 native_mm_add_epi8
+#define simde_mm_add_epi16 native_mm_add_epi16
+#define simde_mm_add_epi32 native_mm_add_epi32
+#define simde_mm_add_epi64 native_mm_add_epi64
+#define simde_mm_adds_epi8 native_mm_adds_epi8
+#define simde_mm_adds_epi16 native_mm_adds_epi16
+#define simde_mm_adds_epu8 native_mm_adds_epu8
+#define simde_mm_adds_epu16 native_mm_adds_epu16
+#define simde_mm_sub_epi8 native_mm_sub_epi8
+#define simde_mm_sub_epi16 native_mm_sub_epi16
+#define simde_mm_sub_epi32 native_mm_sub_epi32
+#define simde_mm_sub_epi64 native_mm_sub_epi64
+#define simde_mm_subs_epi8 native_mm_subs_epi8
+#define simde_mm_subs_epi16 native_mm_subs_epi16
+#define simde_mm_subs_epu8 native_mm_subs_epu8
+#define simde_mm_subs_epu16 native_mm_subs_epu16
+#define simde_mm_mullo_epi16 native_mm_mullo_epi16
+#define simde_mm_mulhi_epi16 native_mm_mulhi_epi16
+#define simde_mm_mulhi_epu16 native_mm_mulhi_epu16
+#define simde_mm_mul_epu32 native_mm_mul_epu32
+#define simde_mm_madd_epi16 native_mm_madd_epi16
+#define simde_mm_avg_epu8 native_mm_avg_epu8
+#define simde_mm_avg_epu16 native_mm_avg_epu16
+#define simde_mm_sad_epu8 native_mm_sad_epu8
+#define simde_mm_min_epu8 native_mm_min_epu8
+#define simde_mm_min_epi16 native_mm_min_epi16
+#define simde_mm_max_epu8 native_mm_max_epu8
+#define simde_mm_max_epi16 native_mm_max_epi16
+#define simde_mm_and_si128 native_mm_and_si128
+#define simde_mm_andnot_si128 native_mm_andnot_si128
+#define simde_mm_or_si128 native_mm_or_si128
+#define simde_mm_xor_si128 native_mm_xor_si128
+#define simde_mm_cmpeq_epi8 native_mm_cmpeq_epi8
+#define simde_mm_cmpeq_epi16 native_mm_cmpeq_epi16
+#define simde_mm_cmpeq_epi32 native_mm_cmpeq_epi32
+#define simde_mm_cmpgt_epi8 native_mm_cmpgt_epi8
+#define simde_mm_cmpgt_epi16 native_mm_cmpgt_epi16
+#define simde_mm_cmpgt_epi32 native_mm_cmpgt_epi32
+#define simde_mm_packs_epi16 native_mm_packs_epi16
+#define simde_mm_packs_epi32 native_mm_packs_epi32
+#define simde_mm_packus_epi16 native_mm_packus_epi16
+#define simde_mm_unpacklo_epi8 native_mm_unpacklo_epi8
+#define simde_mm_unpacklo_epi16 native_mm_unpacklo_epi16
+#define simde_mm_unpacklo_epi32 native_mm_unpacklo_epi32
+#define simde_mm_unpacklo_epi64 native_mm_unpacklo_epi64
+#define simde_mm_unpackhi_epi8 native_mm_unpackhi_epi8
+#define simde_mm_unpackhi_epi16 native_mm_unpackhi_epi16
+#define simde_mm_unpackhi_epi32 native_mm_unpackhi_epi32
+#define simde_mm_unpackhi_epi64 native_mm_unpackhi_epi64
+
+#endif
+
+#endif
@@ -3,6 +3,7 @@
 #include "ksignal.h"
 #include "bufferaccess.h"
 #include "kstat.h"
+#include <thread>
 
 
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
@@ -37,6 +38,9 @@ CPU::CPU() {
     this->reset();
 
     this->logFile = NULL;//fopen("good.txt", "w");
+#ifdef BOXEDWINE_MULTI_THREADED
+    this->nativeHandle = 0;
+#endif
 }
 
 void CPU::setSeg(U32 index, U32 address, U32 value) {
@@ -83,7 +87,7 @@ void CPU::reset() {
         this->xmm[i].pi.u64[0] = 0;
         this->xmm[i].pi.u64[1] = 0;
     }
-    this->lazyFlags = 0;
+    this->lazyFlags = FLAGS_NONE;
     this->setIsBig(1);
     this->df = 1;
     this->seg[CS].value = 0xF; // index 1, LDT, rpl=3
@@ -99,8 +103,52 @@ void CPU::reset() {
     this->stackMask = 0xFFFFFFFF;
     this->nextBlock = NULL;
     this->delayedFreeBlock = NULL;
+    this->spinCountdown = CPU_SPIN_COUNT;
+    this->spinLevel = 0;
+    this->spinTime = 0;
 }
 
+#ifdef BOXEDWINE_MULTI_THREADED
+std::atomic<U64> CPU::spinSleepCount;
+#endif
+
+#ifdef BOXEDWINE_MULTI_THREADED
+void CPU::spinWait() {
+    this->spinCountdown = CPU_SPIN_COUNT;
+    U64 now = KSystem::getMicroCounter();
+    if (now - this->spinTime > CPU_SPIN_RESET_TIME) {
+        // the thread did something else since it last spun
+        this->spinLevel = 0;
+    } else if (this->spinLevel < CPU_SPIN_YIELDS + 8) { // far enough for CPU_SPIN_MAX_SLEEP
+        this->spinLevel++;
+    }
+    if (this->spinLevel < CPU_SPIN_YIELDS) {
+        std::this_thread::yield();
+    } else {
+        U32 sleep = CPU_SPIN_MIN_SLEEP << (this->spinLevel - CPU_SPIN_YIELDS);
+        if (sleep > CPU_SPIN_MAX_SLEEP) {
+            sleep = CPU_SPIN_MAX_SLEEP;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(sleep));
+        spinSleepCount++;
+    }
+    this->spinTime = KSystem::getMicroCounter();
+}
+#endif
+
+#ifdef BOXEDWINE_MULTI_THREADED
+void CPU::wakeThreadIfWaiting() {
+    BoxedWineCondition* cond = thread->waitingCond;
+
+    // wait up the thread if it is waiting
+    if (cond) {
+        cond->lock();
+        cond->signal();
+        cond->unlock();
+    }
+}
+#endif
+
 void CPU::call(U32 big, U32 selector, U32 offset, U32 oldEip) {
      if (this->flags & VM) {
         U32 esp = THIS_ESP; //  // don't set ESP until we are done with memory Writes / push so that we are reentrant
@@ -796,10 +844,10 @@ void CPU::fillFlagsNoCFOF() {
     if (this->lazyFlags!=FLAGS_NONE) {
         int newFlags = this->flags & ~(CF|AF|OF|SF|ZF|PF);
         
-        if (this->lazyFlags->getAF(this)) newFlags |= AF;
-        if (this->lazyFlags->getZF(this)) newFlags |= ZF;
-        if (this->lazyFlags->getPF(this)) newFlags |= PF;
-        if (this->lazyFlags->getSF(this)) newFlags |= SF;
+        if (this->getAF()) newFlags |= AF;
+        if (this->getZF()) newFlags |= ZF;
+        if (this->getPF()) newFlags |= PF;
+        if (this->getSF()) newFlags |= SF;
         this->flags = newFlags;
         this->lazyFlags = FLAGS_NONE;		 
     }
@@ -809,12 +857,12 @@ void CPU::fillFlags() {
     if (this->lazyFlags!=FLAGS_NONE) {
         int newFlags = this->flags & ~(CF|AF|OF|SF|ZF|PF);
              
-        if (this->lazyFlags->getAF(this)) newFlags |= AF;
-        if (this->lazyFlags->getZF(this)) newFlags |= ZF;
-        if (this->lazyFlags->getPF(this)) newFlags |= PF;
-        if (this->lazyFlags->getSF(this)) newFlags |= SF;
-        if (this->lazyFlags->getCF(this)) newFlags |= CF;
-        if (this->lazyFlags->getOF(this)) newFlags |= OF;
+        if (this->getAF()) newFlags |= AF;
+        if (this->getZF()) newFlags |= ZF;
+        if (this->getPF()) newFlags |= PF;
+        if (this->getSF()) newFlags |= SF;
+        if (this->getCF()) newFlags |= CF;
+        if (this->getOF()) newFlags |= OF;
         this->flags = newFlags;
         this->lazyFlags = FLAGS_NONE;	
     }
@@ -824,11 +872,11 @@ void CPU::fillFlagsNoCF() {
     if (this->lazyFlags!=FLAGS_NONE) {
         int newFlags = this->flags & ~(CF|AF|OF|SF|ZF|PF);
         
-        if (this->lazyFlags->getAF(this)) newFlags |= AF;
-        if (this->lazyFlags->getZF(this)) newFlags |= ZF;
-        if (this->lazyFlags->getPF(this)) newFlags |= PF;
-        if (this->lazyFlags->getSF(this)) newFlags |= SF;
-        if (this->lazyFlags->getOF(this)) newFlags |= OF;
+        if (this->getAF()) newFlags |= AF;
+        if (this->getZF()) newFlags |= ZF;
+        if (this->getPF()) newFlags |= PF;
+        if (this->getSF()) newFlags |= SF;
+        if (this->getOF()) newFlags |= OF;
         this->flags = newFlags;
         this->lazyFlags = FLAGS_NONE;		 
     }
@@ -838,11 +886,11 @@ void CPU::fillFlagsNoZF() {
     if (this->lazyFlags!=FLAGS_NONE) {
         int newFlags = this->flags & ~(CF|AF|OF|SF|ZF|PF);
         
-        if (this->lazyFlags->getAF(this)) newFlags |= AF;
-        if (this->lazyFlags->getCF(this)) newFlags |= CF;
-        if (this->lazyFlags->getPF(this)) newFlags |= PF;
-        if (this->lazyFlags->getSF(this)) newFlags |= SF;
-        if (this->lazyFlags->getOF(this)) newFlags |= OF;
+        if (this->getAF()) newFlags |= AF;
+        if (this->getCF()) newFlags |= CF;
+        if (this->getPF()) newFlags |= PF;
+        if (this->getSF()) newFlags |= SF;
+        if (this->getOF()) newFlags |= OF;
         this->flags = newFlags;
         this->lazyFlags = FLAGS_NONE;		 
     }
@@ -852,40 +900,16 @@ void CPU::fillFlagsNoOF() {
     if (this->lazyFlags!=FLAGS_NONE) {
         int newFlags = this->flags & ~(CF|AF|OF|SF|ZF|PF);
         
-        if (this->lazyFlags->getAF(this)) newFlags |= AF;
-        if (this->lazyFlags->getZF(this)) newFlags |= ZF;
-        if (this->lazyFlags->getPF(this)) newFlags |= PF;
-        if (this->lazyFlags->getSF(this)) newFlags |= SF;
-        if (this->lazyFlags->getCF(this)) newFlags |= CF;
+        if (this->getAF()) newFlags |= AF;
+        if (this->getZF()) newFlags |= ZF;
+        if (this->getPF()) newFlags |= PF;
+        if (this->getSF()) newFlags |= SF;
+        if (this->getCF()) newFlags |= CF;
         this->lazyFlags = FLAGS_NONE;		 
         this->flags = newFlags;
     }
 }
 
-bool CPU::getCF() {
-    return this->lazyFlags->getCF(this) != 0;
-}
-
-bool CPU::getSF() {
-    return this->lazyFlags->getSF(this) != 0;
-}
-
-bool CPU::getZF() {
-    return this->lazyFlags->getZF(this) != 0;
-}
-
-bool CPU::getOF() {
-    return this->lazyFlags->getOF(this) != 0;
-}
-
-bool CPU::getAF() {
-    return this->lazyFlags->getAF(this) != 0;
-}
-
-bool CPU::getPF() {
-    return this->lazyFlags->getPF(this) != 0;
-}
-
 void CPU::setCF(U32 value) {
 #ifdef _DEBUG
     if (this->lazyFlags!=FLAGS_NONE) {
@@ -930,7 +954,6 @@ void CPU::setZF(U32 value) {
         this->flags|=ZF;
 }
 
-extern U8 parity_lookup[256] ;
 void CPU::setPFonValue(U32 value) {
 #ifdef _DEBUG
     if (this->lazyFlags!=FLAGS_NONE) {
@@ -224,6 +224,17 @@ union SSE {
     simde__m128i pi;
 };
 
+// With KSystem::spinBackoff, guest spin loops call CPU::spinWait every CPU_SPIN_COUNT times around, so do pause and
+// sched_yield.  Without it pause does nothing and sched_yield only yields, like they always have.  A thread that
+// calls it again within CPU_SPIN_RESET_TIME is still spinning, it yields its host core for the first CPU_SPIN_YIELDS
+// calls and then sleeps for twice as long each time, from CPU_SPIN_MIN_SLEEP up to CPU_SPIN_MAX_SLEEP.  The most it
+// sleeps is also how late it can be to see the memory it is waiting on change.
+#define CPU_SPIN_COUNT 1024
+#define CPU_SPIN_RESET_TIME 10000 // microseconds
+#define CPU_SPIN_YIELDS 16
+#define CPU_SPIN_MIN_SLEEP 50 // microseconds
+#define CPU_SPIN_MAX_SLEEP 500 // microseconds
+
 class CPU {
 public:
     static CPU* allocCPU();
@@ -246,13 +257,16 @@ public:
     Reg  dst;
     Reg  dst2;
     Reg  result;
-    LazyFlags const * lazyFlags;
+    LazyFlags   lazyFlags;
     U32	        df;
     U32         oldCF;
     FPU         fpu;
     U64		    instructionCount;
     U32         blockInstructionCount;
     bool        yield;
+    U32         spinCountdown; // counted down by spin loops, see spinWait
+    U32         spinLevel;
+    U64         spinTime; // when spinWait last returned
     U32         cpl;    
     U32 cr0;
     U32 stackNotMask;
@@ -326,13 +340,32 @@ public:
     U32 writeCrx(U32 which, U32 value);
     void resetMMX();
     bool isMMXinUse();
+#ifdef BOXEDWINE_MULTI_THREADED
+    // called by a thread that is spinning when KSystem::spinBackoff is set, it gives up the host core for longer the
+    // longer it spins
+    void spinWait();
+    static std::atomic<U64> spinSleepCount;
+#endif
 
     U32 getEipAddress();
 
     virtual void run()=0;
     virtual DecodedBlock* getNextBlock() = 0;
+    // for blocks that end in an indirect jmp/call or a ret, a cpu that can predict where those go overrides these
+    virtual DecodedBlock* getNextIndirectBlock() {return this->getNextBlock();}
+    virtual DecodedBlock* getNextReturnBlock() {return this->getNextBlock();}
+    virtual void pushReturn(U32 returnEip) {}
     virtual void restart() {}
     virtual void setSeg(U32 index, U32 address, U32 value);
+#ifdef BOXEDWINE_MULTI_THREADED
+    virtual void startThread() = 0; // runs the thread on the calling host thread until it exits
+    void wakeThreadIfWaiting(); // called from another thread
+    // called around a blocking wait in a syscall
+    virtual void beforeWait() {}
+    virtual void afterWait() {}
+
+    U64 nativeHandle;
+#endif
 
     bool isBig() {return this->big!=0;}
     virtual void setIsBig(U32 value);
@@ -342,6 +375,53 @@ protected:
     U32 big;
 };
 
+// ZF, SF and PF only depend on the result so they are worked out the same way for every instruction.  CF and OF are
+// inlined for sub/cmp, the usual thing a jcc follows, everything else goes through the switch in lazyFlags.cpp
+inline bool CPU::getCF() {
+    if (this->lazyFlags == FLAGS_SUB32) {
+        return this->dst.u32 < this->src.u32;
+    }
+    if (this->lazyFlags == FLAGS_NONE) {
+        return (this->flags & CF) != 0;
+    }
+    return lazyFlagsGetCF(this) != 0;
+}
+
+inline bool CPU::getSF() {
+    if (this->lazyFlags == FLAGS_NONE) {
+        return (this->flags & SF) != 0;
+    }
+    return (this->result.u32 & lazyFlagsSignBit[this->lazyFlags]) != 0;
+}
+
+inline bool CPU::getZF() {
+    if (this->lazyFlags == FLAGS_NONE) {
+        return (this->flags & ZF) != 0;
+    }
+    return (this->result.u32 & lazyFlagsResultMask[this->lazyFlags]) == 0;
+}
+
+inline bool CPU::getOF() {
+    if (this->lazyFlags == FLAGS_SUB32) {
+        return (((this->dst.u32 ^ this->src.u32) & (this->dst.u32 ^ this->result.u32)) & 0x80000000) != 0;
+    }
+    if (this->lazyFlags == FLAGS_NONE) {
+        return (this->flags & OF) != 0;
+    }
+    return lazyFlagsGetOF(this) != 0;
+}
+
+inline bool CPU::getAF() {
+    return lazyFlagsGetAF(this) != 0;
+}
+
+inline bool CPU::getPF() {
+    if (this->lazyFlags == FLAGS_NONE) {
+        return (this->flags & PF) != 0;
+    }
+    return parity_lookup[this->result.u8] != 0;
+}
+
 void common_prepareException(CPU* cpu, int code, int error);
 
 // until I can figure out how to call cpp function directly from asm
@@ -0,0 +1,141 @@
+INIT_CPU(AddR8R8, addr8r8_noflags)
+INIT_CPU(AddE8R8, adde8r8_noflags)
+INIT_CPU(AddR8E8, addr8e8_noflags)
+INIT_CPU(AddR8I8, add8_reg_noflags)
+INIT_CPU(AddE8I8, add8_mem_noflags)
+INIT_CPU(AddR16R16, addr16r16_noflags)
+INIT_CPU(AddE16R16, adde16r16_noflags)
+INIT_CPU(AddR16E16, addr16e16_noflags)
+INIT_CPU(AddR16I16, add16_reg_noflags)
+INIT_CPU(AddE16I16, add16_mem_noflags)
+INIT_CPU(AddR32R32, addr32r32_noflags)
+INIT_CPU(AddE32R32, adde32r32_noflags)
+INIT_CPU(AddR32E32, addr32e32_noflags)
+INIT_CPU(AddR32I32, add32_reg_noflags)
+INIT_CPU(AddE32I32, add32_mem_noflags)
+INIT_CPU(OrR8R8, orr8r8_noflags)
+INIT_CPU(OrE8R8, ore8r8_noflags)
+INIT_CPU(OrR8E8, orr8e8_noflags)
+INIT_CPU(OrR8I8, or8_reg_noflags)
+INIT_CPU(OrE8I8, or8_mem_noflags)
+INIT_CPU(OrR16R16, orr16r16_noflags)
+INIT_CPU(OrE16R16, ore16r16_noflags)
+INIT_CPU(OrR16E16, orr16e16_noflags)
+INIT_CPU(OrR16I16, or16_reg_noflags)
+INIT_CPU(OrE16I16, or16_mem_noflags)
+INIT_CPU(OrR32R32, orr32r32_noflags)
+INIT_CPU(OrE32R32, ore32r32_noflags)
+INIT_CPU(OrR32E32, orr32e32_noflags)
+INIT_CPU(OrR32I32, or32_reg_noflags)
+INIT_CPU(OrE32I32, or32_mem_noflags)
+INIT_CPU(AdcR8R8, adcr8r8_noflags)
+INIT_CPU(AdcE8R8, adce8r8_noflags)
+INIT_CPU(AdcR8E8, adcr8e8_noflags)
+INIT_CPU(AdcR8I8, adc8_reg_noflags)
+INIT_CPU(AdcE8I8, adc8_mem_noflags)
+INIT_CPU(AdcR16R16, adcr16r16_noflags)
+INIT_CPU(AdcE16R16, adce16r16_noflags)
+INIT_CPU(AdcR16E16, adcr16e16_noflags)
+INIT_CPU(AdcR16I16, adc16_reg_noflags)
+INIT_CPU(AdcE16I16, adc16_mem_noflags)
+INIT_CPU(AdcR32R32, adcr32r32_noflags)
+INIT_CPU(AdcE32R32, adce32r32_noflags)
+INIT_CPU(AdcR32E32, adcr32e32_noflags)
+INIT_CPU(AdcR32I32, adc32_reg_noflags)
+INIT_CPU(AdcE32I32, adc32_mem_noflags)
+INIT_CPU(SbbR8R8, sbbr8r8_noflags)
+INIT_CPU(SbbE8R8, sbbe8r8_noflags)
+INIT_CPU(SbbR8E8, sbbr8e8_noflags)
+INIT_CPU(SbbR8I8, sbb8_reg_noflags)
+INIT_CPU(SbbE8I8, sbb8_mem_noflags)
+INIT_CPU(SbbR16R16, sbbr16r16_noflags)
+INIT_CPU(SbbE16R16, sbbe16r16_noflags)
+INIT_CPU(SbbR16E16, sbbr16e16_noflags)
+INIT_CPU(SbbR16I16, sbb16_reg_noflags)
+INIT_CPU(SbbE16I16, sbb16_mem_noflags)
+INIT_CPU(SbbR32R32, sbbr32r32_noflags)
+INIT_CPU(SbbE32R32, sbbe32r32_noflags)
+INIT_CPU(SbbR32E32, sbbr32e32_noflags)
+INIT_CPU(SbbR32I32, sbb32_reg_noflags)
+INIT_CPU(SbbE32I32, sbb32_mem_noflags)
+INIT_CPU(AndR8R8, andr8r8_noflags)
+INIT_CPU(AndE8R8, ande8r8_noflags)
+INIT_CPU(AndR8E8, andr8e8_noflags)
+INIT_CPU(AndR8I8, and8_reg_noflags)
+INIT_CPU(AndE8I8, and8_mem_noflags)
+INIT_CPU(AndR16R16, andr16r16_noflags)
+INIT_CPU(AndE16R16, ande16r16_noflags)
+INIT_CPU(AndR16E16, andr16e16_noflags)
+INIT_CPU(AndR16I16, and16_reg_noflags)
+INIT_CPU(AndE16I16, and16_mem_noflags)
+INIT_CPU(AndR32R32, andr32r32_noflags)
+INIT_CPU(AndE32R32, ande32r32_noflags)
+INIT_CPU(AndR32E32, andr32e32_noflags)
+INIT_CPU(AndR32I32, and32_reg_noflags)
+INIT_CPU(AndE32I32, and32_mem_noflags)
+INIT_CPU(SubR8R8, subr8r8_noflags)
+INIT_CPU(SubE8R8, sube8r8_noflags)
+INIT_CPU(SubR8E8, subr8e8_noflags)
+INIT_CPU(SubR8I8, sub8_reg_noflags)
+INIT_CPU(SubE8I8, sub8_mem_noflags)
+INIT_CPU(SubR16R16, subr16r16_noflags)
+INIT_CPU(SubE16R16, sube16r16_noflags)
+INIT_CPU(SubR16E16, subr16e16_noflags)
+INIT_CPU(SubR16I16, sub16_reg_noflags)
+INIT_CPU(SubE16I16, sub16_mem_noflags)
+INIT_CPU(SubR32R32, subr32r32_noflags)
+INIT_CPU(SubE32R32, sube32r32_noflags)
+INIT_CPU(SubR32E32, subr32e32_noflags)
+INIT_CPU(SubR32I32, sub32_reg_noflags)
+INIT_CPU(SubE32I32, sub32_mem_noflags)
+INIT_CPU(XorR8R8, xorr8r8_noflags)
+INIT_CPU(XorE8R8, xore8r8_noflags)
+INIT_CPU(XorR8E8, xorr8e8_noflags)
+INIT_CPU(XorR8I8, xor8_reg_noflags)
+INIT_CPU(XorE8I8, xor8_mem_noflags)
+INIT_CPU(XorR16R16, xorr16r16_noflags)
+INIT_CPU(XorE16R16, xore16r16_noflags)
+INIT_CPU(XorR16E16, xorr16e16_noflags)
+INIT_CPU(XorR16I16, xor16_reg_noflags)
+INIT_CPU(XorE16I16, xor16_mem_noflags)
+INIT_CPU(XorR32R32, xorr32r32_noflags)
+INIT_CPU(XorE32R32, xore32r32_noflags)
+INIT_CPU(XorR32E32, xorr32e32_noflags)
+INIT_CPU(XorR32I32, xor32_reg_noflags)
+INIT_CPU(XorE32I32, xor32_mem_noflags)
+INIT_CPU(NegR8, negr8_noflags)
+INIT_CPU(NegE8, nege8_noflags)
+INIT_CPU(NegR16, negr16_noflags)
+INIT_CPU(NegE16, nege16_noflags)
+INIT_CPU(NegR32, negr32_noflags)
+INIT_CPU(NegE32, nege32_noflags)
+INIT_CPU(IncR8, inc8_reg_noflags)
+INIT_CPU(IncE8, inc8_mem32_noflags)
+INIT_CPU(IncR16, inc16_reg_noflags)
+INIT_CPU(IncE16, inc16_mem32_noflags)
+INIT_CPU(IncR32, inc32_reg_noflags)
+INIT_CPU(IncE32, inc32_mem32_noflags)
+INIT_CPU(DecR8, dec8_reg_noflags)
+INIT_CPU(DecE8, dec8_mem32_noflags)
+INIT_CPU(DecR16, dec16_reg_noflags)
+INIT_CPU(DecE16, dec16_mem32_noflags)
+INIT_CPU(DecR32, dec32_reg_noflags)
+INIT_CPU(DecE32, dec32_mem32_noflags)
+INIT_CPU(ShlR8I8, shl8_reg_op_noflags)
+INIT_CPU(ShlE8I8, shl8_mem_op_noflags)
+INIT_CPU(ShlR16I8, shl16_reg_op_noflags)
+INIT_CPU(ShlE16I8, shl16_mem_op_noflags)
+INIT_CPU(ShlR32I8, shl32_reg_op_noflags)
+INIT_CPU(ShlE32I8, shl32_mem_op_noflags)
+INIT_CPU(ShrR8I8, shr8_reg_op_noflags)
+INIT_CPU(ShrE8I8, shr8_mem_op_noflags)
+INIT_CPU(ShrR16I8, shr16_reg_op_noflags)
+INIT_CPU(ShrE16I8, shr16_mem_op_noflags)
+INIT_CPU(ShrR32I8, shr32_reg_op_noflags)
+INIT_CPU(ShrE32I8, shr32_mem_op_noflags)
+INIT_CPU(SarR8I8, sar8_reg_op_noflags)
+INIT_CPU(SarE8I8, sar8_mem_op_noflags)
+INIT_CPU(SarR16I8, sar16_reg_op_noflags)
+INIT_CPU(SarE16I8, sar16_mem_op_noflags)
+INIT_CPU(SarR32I8, sar32_reg_op_noflags)
+INIT_CPU(SarE32I8, sar32_mem_op_noflags)
@@ -150,6 +150,7 @@ void FPU::SetCW(U16 word) {
     this->cw = word;
     this->cw_mask_all = word | 0x3f;
     this->round = ((word >> 10) & 3);
+    this->precision = ((word >> 8) & 3);
 
 #ifdef LOG_FPU
     const char* r;
@@ -204,24 +205,78 @@ void FPU::FCLEX() {
     this->sw &= 0x7f00;            //should clear exceptions
 }
 
-void FPU::PUSH(double in) {
-    this->top = (this->top - 1) & 7;
-    //actually check if empty
-    this->tags[this->top] = TAG_Valid;
-    this->regs[this->top].d = in;
-    this->isIntegerLoaded[this->top] = 0;
+// Rounds the exact value d + err to a 24-bit significand with the control word's rounding mode.  d is the host's
+// round to nearest double of the exact value and err only needs to have the sign of what was lost, it can't move
+// the exact value across a 24-bit rounding point by itself, but it decides ties and values just off the 24-bit grid.
+// The exponent keeps the double's range like the x87 keeps its extended range.
+double FPU::roundTo24BitSignificand(double d, double err) {
+    struct FPU_Reg r;
+    r.d = d;
+    if ((r.l & 0x7ff0000000000000ULL) == 0x7ff0000000000000ULL) {
+        return d; // inf and nan
+    }
+    U64 lost = r.l & 0x1fffffffULL;
+    if (lost == 0 && err == 0) {
+        return d;
+    }
+    bool negative = (r.l >> 63) != 0;
+    bool errAway = (err > 0) != negative; // err makes the magnitude bigger
+    bool away; // round the magnitude away from zero instead of towards it
+
+    switch (this->round) {
+    case ROUND_Nearest:
+        if (lost == 0x10000000ULL) {
+            away = (err == 0) ? ((r.l >> 29) & 1) != 0 : errAway;
+        } else {
+            away = lost > 0x10000000ULL;
+        }
+        break;
+    case ROUND_Down:
+        away = negative;
+        break;
+    case ROUND_Up:
+        away = !negative;
+        break;
+    default: // ROUND_Chop
+        away = false;
+        break;
+    }
+    r.l &= ~0x1fffffffULL;
+    if (lost == 0) {
+        // d is already on the 24-bit grid, the exact value is just above or below it
+        if (errAway && away) {
+            r.l += 0x20000000ULL;
+        } else if (!errAway && !away && this->round != ROUND_Nearest) {
+            r.l -= 0x20000000ULL; // a borrow out of the significand correctly drops the exponent
+        }
+    } else if (away) {
+        r.l += 0x20000000ULL; // a carry out of the significand correctly bumps the exponent
+    }
+    return r.d;
 }
 
-void FPU::PREP_PUSH() {
-    this->top = (this->top - 1) & 7;
-    this->tags[this->top] = TAG_Valid;
-    this->isIntegerLoaded[this->top] = 0;
+// TwoSum gives the exact error of a + b
+double FPU::add24(double a, double b) {
+    double d = a + b;
+    double t = d - a;
+    return roundTo24BitSignificand(d, (a - (d - t)) + (b - t));
+}
+
+double FPU::mul24(double a, double b) {
+    double d = a * b;
+    return roundTo24BitSignificand(d, fma(a, b, -d));
+}
+
+// a - d * b is exact, its sign and b's tell which side of d the exact quotient is
+double FPU::div24(double a, double b) {
+    double d = a / b;
+    double r = fma(-d, b, a);
+    return roundTo24BitSignificand(d, (b < 0) ? -r : r);
 }
 
-void FPU::FPOP() {
-    this->tags[this->top] = TAG_Empty;
-    //maybe set zero in it as well
-    this->top = ((this->top + 1) & 7);
+double FPU::sqrt24(double a) {
+    double d = sqrt(a);
+    return roundTo24BitSignificand(d, fma(-d, d, a));
 }
 
 double FPU::FROUND(double in) {
@@ -308,32 +363,11 @@ void FPU::ST80(U32 reg, U64* pLow, U64* pHigh) {
     *pHigh = (U16)(((sign80 << 15) | (exp80final)));
 }
 
-void FPU::FLD_F32(U32 value, int store_to) {
-    struct FPU_Float f;
-    f.i = value;
-    this->regs[store_to].d = f.f;
-    this->isIntegerLoaded[store_to] = 0;
-}
-
-void FPU::FLD_F64(U64 value, int store_to) {
-    this->regs[store_to].l = value;
-}
-
 void FPU::FLD_F80(U64 low, S16 high) {
     this->regs[this->top].d = FLD80(low, high);
     this->isIntegerLoaded[this->top] = 0;
 }
 
-void FPU::FLD_I16(S16 value, int store_to) {
-    this->regs[store_to].d = value;
-    this->isIntegerLoaded[store_to] = 0;
-}
-
-void FPU::FLD_I32(S32 value, int store_to) {
-    this->regs[store_to].d = value;
-    this->isIntegerLoaded[store_to] = 0;
-}
-
 void FPU::FLD_I64(S64 value, int store_to) {
     this->regs[store_to].d = (double)value;
     this->loadedInteger[store_to] = value;
@@ -459,56 +493,6 @@ void FPU::FBST(CPU* cpu, U32 addr) {
     writeb(addr+9,p); 
 }
 
-void FPU::FADD(int op1, int op2) {
-    this->regs[op1].d += this->regs[op2].d;
-    this->isIntegerLoaded[op1] = 0;
-    //flags and such :)
-}
-
-void FPU::FDIV(int st, int other) {
-    this->regs[st].d = this->regs[st].d / this->regs[other].d;
-    this->isIntegerLoaded[st] = 0;
-    //flags and such :)
-}
-
-void FPU::FDIVR(int st, int other) {
-    this->regs[st].d = this->regs[other].d / this->regs[st].d;
-    this->isIntegerLoaded[st] = 0;
-    // flags and such :)
-}
-
-void FPU::FMUL(int st, int other) {
-    this->regs[st].d *= this->regs[other].d;
-    this->isIntegerLoaded[st] = 0;
-    //flags and such :)
-}
-
-void FPU::FSUB(int st, int other) {
-    this->regs[st].d = this->regs[st].d - this->regs[other].d;
-    this->isIntegerLoaded[st] = 0;
-    //flags and such :)
-}
-
-void FPU::FSUBR(int st, int other) {
-    this->regs[st].d = this->regs[other].d - this->regs[st].d;
-    this->isIntegerLoaded[st] = 0;
-    //flags and such :)
-}
-
-void FPU::FXCH(int st, int other) {
-    int tag = this->tags[other];
-    struct FPU_Reg reg = this->regs[other];
-    this->tags[other] = this->tags[st];
-    this->regs[other] = this->regs[st];
-    this->tags[st] = tag;
-    this->regs[st] = reg;
-}
-
-void FPU::FST(int st, int other) {
-    this->tags[other] = this->tags[st];
-    this->regs[other] = this->regs[st];
-}
-
 static void setFlags(CPU* cpu, int newFlags) {
     cpu->lazyFlags = FLAGS_NONE;
     cpu->flags &= ~FMASK_TEST;
@@ -673,7 +657,11 @@ void FPU::FYL2XP1() {
 }
 
 void FPU::FSQRT() {
-    this->regs[this->top].d = sqrt(this->regs[this->top].d);
+    if (this->precision == PRECISION_24) {
+        this->regs[this->top].d = sqrt24(this->regs[this->top].d);
+    } else {
+        this->regs[this->top].d = sqrt(this->regs[this->top].d);
+    }
     this->isIntegerLoaded[this->top] = 0;
     //flags and such :)
 }
@@ -903,34 +891,6 @@ void FPU::FLDZ() {
 }
 
 
-void FPU::FADD_EA() {
-    FADD(this->top, 8);
-}
-
-void FPU::FMUL_EA() {
-    FMUL(this->top, 8);
-}
-
-void FPU::FSUB_EA() {
-    FSUB(this->top, 8);
-}
-
-void FPU::FSUBR_EA() {
-    FSUBR(this->top, 8);
-}
-
-void FPU::FDIV_EA() {
-    FDIV(this->top, 8);
-}
-
-void FPU::FDIVR_EA() {
-    FDIVR(this->top, 8);
-}
-
-void FPU::FCOM_EA() {
-    FCOM(this->top, 8);
-}
-
 void FPU::FLDCW(CPU* cpu, U32 addr) {
     U32 temp = readw(addr);
     SetCW(temp);
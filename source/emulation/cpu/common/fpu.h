@@ -40,6 +40,11 @@ struct FPU_Reg {
 #define TAG_Zero 1
 #define TAG_Empty 2
 
+// precision control field of the control word
+#define PRECISION_24 0
+#define PRECISION_53 2
+#define PRECISION_64 3
+
 // binary translator assumes FPU->regs will be at offset 0
 class FPU {
 public:
@@ -141,6 +146,19 @@ public:
     void setReg(U32 index, double value);
     inline U32 GetTop() {return this->top;}
 
+    // The stack is kept in host doubles, which is exact for the 53-bit precision control
+    // that Windows uses by default.  When a program selects 24-bit precision (Direct3D does
+    // unless told not to), the exact result is rounded once to a 24-bit significand using
+    // the control word's rounding mode.  64-bit precision is still approximated with doubles.
+    inline double roundedAdd(double a, double b) {return (this->precision == PRECISION_24) ? add24(a, b) : a + b;}
+    inline double roundedMul(double a, double b) {return (this->precision == PRECISION_24) ? mul24(a, b) : a * b;}
+    inline double roundedDiv(double a, double b) {return (this->precision == PRECISION_24) ? div24(a, b) : a / b;}
+    double add24(double a, double b);
+    double mul24(double a, double b);
+    double div24(double a, double b);
+    double sqrt24(double a);
+    double roundTo24BitSignificand(double d, double err);
+
     int GetTag();
     void LOG_STACK();
 
@@ -154,6 +172,131 @@ public:
     U32 sw;
     U32 top;
     U32 round;
+    U32 precision;
 };
 
+// The common stack and arithmetic ops are inline since the cores call them for almost every x87 instruction
+
+inline void FPU::PUSH(double in) {
+    this->top = (this->top - 1) & 7;
+    //actually check if empty
+    this->tags[this->top] = TAG_Valid;
+    this->regs[this->top].d = in;
+    this->isIntegerLoaded[this->top] = 0;
+}
+
+inline void FPU::PREP_PUSH() {
+    this->top = (this->top - 1) & 7;
+    this->tags[this->top] = TAG_Valid;
+    this->isIntegerLoaded[this->top] = 0;
+}
+
+inline void FPU::FPOP() {
+    this->tags[this->top] = TAG_Empty;
+    //maybe set zero in it as well
+    this->top = ((this->top + 1) & 7);
+}
+
+inline void FPU::FLD_F32(U32 value, int store_to) {
+    union {
+        float f;
+        U32 i;
+    } f;
+    f.i = value;
+    this->regs[store_to].d = f.f;
+    this->isIntegerLoaded[store_to] = 0;
+}
+
+inline void FPU::FLD_F64(U64 value, int store_to) {
+    this->regs[store_to].l = value;
+}
+
+inline void FPU::FLD_I16(S16 value, int store_to) {
+    this->regs[store_to].d = value;
+    this->isIntegerLoaded[store_to] = 0;
+}
+
+inline void FPU::FLD_I32(S32 value, int store_to) {
+    this->regs[store_to].d = value;
+    this->isIntegerLoaded[store_to] = 0;
+}
+
+inline void FPU::FADD(int op1, int op2) {
+    this->regs[op1].d = roundedAdd(this->regs[op1].d, this->regs[op2].d);
+    this->isIntegerLoaded[op1] = 0;
+    //flags and such :)
+}
+
+inline void FPU::FDIV(int st, int other) {
+    this->regs[st].d = roundedDiv(this->regs[st].d, this->regs[other].d);
+    this->isIntegerLoaded[st] = 0;
+    //flags and such :)
+}
+
+inline void FPU::FDIVR(int st, int other) {
+    this->regs[st].d = roundedDiv(this->regs[other].d, this->regs[st].d);
+    this->isIntegerLoaded[st] = 0;
+    // flags and such :)
+}
+
+inline void FPU::FMUL(int st, int other) {
+    this->regs[st].d = roundedMul(this->regs[st].d, this->regs[other].d);
+    this->isIntegerLoaded[st] = 0;
+    //flags and such :)
+}
+
+inline void FPU::FSUB(int st, int other) {
+    this->regs[st].d = roundedAdd(this->regs[st].d, -this->regs[other].d);
+    this->isIntegerLoaded[st] = 0;
+    //flags and such :)
+}
+
+inline void FPU::FSUBR(int st, int other) {
+    this->regs[st].d = roundedAdd(this->regs[other].d, -this->regs[st].d);
+    this->isIntegerLoaded[st] = 0;
+    //flags and such :)
+}
+
+inline void FPU::FXCH(int st, int other) {
+    int tag = this->tags[other];
+    struct FPU_Reg reg = this->regs[other];
+    this->tags[other] = this->tags[st];
+    this->regs[other] = this->regs[st];
+    this->tags[st] = tag;
+    this->regs[st] = reg;
+}
+
+inline void FPU::FST(int st, int other) {
+    this->tags[other] = this->tags[st];
+    this->regs[other] = this->regs[st];
+}
+
+inline void FPU::FADD_EA() {
+    FADD(this->top, 8);
+}
+
+inline void FPU::FMUL_EA() {
+    FMUL(this->top, 8);
+}
+
+inline void FPU::FSUB_EA() {
+    FSUB(this->top, 8);
+}
+
+inline void FPU::FSUBR_EA() {
+    FSUBR(this->top, 8);
+}
+
+inline void FPU::FDIV_EA() {
+    FDIV(this->top, 8);
+}
+
+inline void FPU::FDIVR_EA() {
+    FDIVR(this->top, 8);
+}
+
+inline void FPU::FCOM_EA() {
+    FCOM(this->top, 8);
+}
+
 #endif
\ No newline at end of file
@@ -3,73 +3,82 @@
 
 class CPU;
 
-class LazyFlags {
-public:
-    LazyFlags(U32 width) : width(width) {}
-    virtual U32 getCF(CPU* cpu) const=0; // will always return 0 or 1, optimizations count on this
-    virtual U32 getSF(CPU* cpu) const=0;
-    virtual U32 getZF(CPU* cpu) const=0;
-    virtual U32 getOF(CPU* cpu) const=0;
-    virtual U32 getAF(CPU* cpu) const=0;
-    virtual U32 getPF(CPU* cpu) const=0;
-    U32 width;
+// Which instruction last set the flags.  The instruction stores its operands in cpu->src, cpu->dst, cpu->result and
+// cpu->oldCF and the flags are only worked out from them when they are read, see CPU::getCF and friends.  0 isn't a
+// valid value so that the code generators can use it to mean unknown.
+typedef U32 LazyFlags;
+
+enum {
+    FLAGS_NONE = 1, // cpu->flags is up to date
+    FLAGS_ADD8,
+    FLAGS_ADD16,
+    FLAGS_ADD32,
+    FLAGS_OR8, // CF, OF and AF are always 0
+    FLAGS_OR16,
+    FLAGS_OR32,
+    FLAGS_ADC8,
+    FLAGS_ADC16,
+    FLAGS_ADC32,
+    FLAGS_SBB8,
+    FLAGS_SBB16,
+    FLAGS_SBB32,
+    FLAGS_SUB8,
+    FLAGS_SUB16,
+    FLAGS_SUB32,
+    FLAGS_INC8,
+    FLAGS_INC16,
+    FLAGS_INC32,
+    FLAGS_DEC8,
+    FLAGS_DEC16,
+    FLAGS_DEC32,
+    FLAGS_SHL8,
+    FLAGS_SHL16,
+    FLAGS_SHL32,
+    FLAGS_SHR8,
+    FLAGS_SHR16,
+    FLAGS_SHR32,
+    FLAGS_SHR8_1,
+    FLAGS_SHR16_1,
+    FLAGS_SHR32_1,
+    FLAGS_SHR8_N1,
+    FLAGS_SHR16_N1,
+    FLAGS_SHR32_N1,
+    FLAGS_SAR8,
+    FLAGS_SAR16,
+    FLAGS_SAR32,
+    FLAGS_DSHL16,
+    FLAGS_DSHL32,
+    FLAGS_DSHR16,
+    FLAGS_DSHR32,
+    FLAGS_NEG8,
+    FLAGS_NEG16,
+    FLAGS_NEG32,
+    FLAGS_COUNT,
+
+    FLAGS_AND8 = FLAGS_OR8,
+    FLAGS_AND16 = FLAGS_OR16,
+    FLAGS_AND32 = FLAGS_OR32,
+    FLAGS_XOR8 = FLAGS_OR8,
+    FLAGS_XOR16 = FLAGS_OR16,
+    FLAGS_XOR32 = FLAGS_OR32,
+    FLAGS_TEST8 = FLAGS_OR8,
+    FLAGS_TEST16 = FLAGS_OR16,
+    FLAGS_TEST32 = FLAGS_OR32,
+    FLAGS_CMP8 = FLAGS_SUB8,
+    FLAGS_CMP16 = FLAGS_SUB16,
+    FLAGS_CMP32 = FLAGS_SUB32
 };
 
-extern const LazyFlags* FLAGS_NONE;
-extern const LazyFlags* FLAGS_ADD8;
-extern const LazyFlags* FLAGS_ADD16;
-extern const LazyFlags* FLAGS_ADD32;
-extern const LazyFlags* FLAGS_OR8;
-extern const LazyFlags* FLAGS_OR16;
-extern const LazyFlags* FLAGS_OR32;
-extern const LazyFlags* FLAGS_ADC8;
-extern const LazyFlags* FLAGS_ADC16;
-extern const LazyFlags* FLAGS_ADC32;
-extern const LazyFlags* FLAGS_SBB8;
-extern const LazyFlags* FLAGS_SBB16;
-extern const LazyFlags* FLAGS_SBB32;
-extern const LazyFlags* FLAGS_AND8;
-extern const LazyFlags* FLAGS_AND16;
-extern const LazyFlags* FLAGS_AND32;
-extern const LazyFlags* FLAGS_SUB8;
-extern const LazyFlags* FLAGS_SUB16;
-extern const LazyFlags* FLAGS_SUB32;
-extern const LazyFlags* FLAGS_XOR8;
-extern const LazyFlags* FLAGS_XOR16;
-extern const LazyFlags* FLAGS_XOR32;
-extern const LazyFlags* FLAGS_INC8;
-extern const LazyFlags* FLAGS_INC16;
-extern const LazyFlags* FLAGS_INC32;
-extern const LazyFlags* FLAGS_DEC8;
-extern const LazyFlags* FLAGS_DEC16;
-extern const LazyFlags* FLAGS_DEC32;
-extern const LazyFlags* FLAGS_SHL8;
-extern const LazyFlags* FLAGS_SHL16;
-extern const LazyFlags* FLAGS_SHL32;
-extern const LazyFlags* FLAGS_SHR8;
-extern const LazyFlags* FLAGS_SHR16;
-extern const LazyFlags* FLAGS_SHR32;
-extern const LazyFlags* FLAGS_SHR8_1;
-extern const LazyFlags* FLAGS_SHR16_1;
-extern const LazyFlags* FLAGS_SHR32_1;
-extern const LazyFlags* FLAGS_SHR8_N1;
-extern const LazyFlags* FLAGS_SHR16_N1;
-extern const LazyFlags* FLAGS_SHR32_N1;
-extern const LazyFlags* FLAGS_SAR8;
-extern const LazyFlags* FLAGS_SAR16;
-extern const LazyFlags* FLAGS_SAR32;
-extern const LazyFlags* FLAGS_CMP8;
-extern const LazyFlags* FLAGS_CMP16;
-extern const LazyFlags* FLAGS_CMP32;
-extern const LazyFlags* FLAGS_TEST8;
-extern const LazyFlags* FLAGS_TEST16;
-extern const LazyFlags* FLAGS_TEST32;
-extern const LazyFlags* FLAGS_DSHL16;
-extern const LazyFlags* FLAGS_DSHL32;
-extern const LazyFlags* FLAGS_DSHR16;
-extern const LazyFlags* FLAGS_DSHR32;
-extern const LazyFlags* FLAGS_NEG8;
-extern const LazyFlags* FLAGS_NEG16;
-extern const LazyFlags* FLAGS_NEG32;
+// indexed by LazyFlags, the bits of cpu->result.u32 that the instruction wrote and its sign bit, both are 0 for
+// FLAGS_NONE
+extern const U32 lazyFlagsResultMask[FLAGS_COUNT];
+extern const U32 lazyFlagsSignBit[FLAGS_COUNT];
+
+// the slow paths of CPU::getCF, CPU::getOF and CPU::getAF, they handle every LazyFlags value
+U32 lazyFlagsGetCF(CPU* cpu); // will always return 0 or 1, optimizations count on this
+U32 lazyFlagsGetOF(CPU* cpu);
+U32 lazyFlagsGetAF(CPU* cpu);
+
+extern U8 parity_lookup[256];
 
 #endif
\ No newline at end of file
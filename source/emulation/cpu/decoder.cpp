@@ -6038,6 +6038,22 @@ bool DecodedOp::needsToSetFlags() {
     return DecodedOp::getNeededFlags(DecodedBlock::currentBlock, this, needsToSet)!=0;
 }
 
+// same as DecodedOp::getNeededFlags except the first op of the block is checked too
+static U32 getNeededFlagsFromBlockStart(DecodedBlock* block, U32 flags, U32 depth) {
+    DecodedOp* op = block->op;
+    U32 result = instructionInfo[op->inst].flagsUsed & flags;
+
+    if (!(instructionInfo[op->inst].flagsSets & MAYBE)) {
+        flags &= ~ instructionInfo[op->inst].flagsSets;
+        flags &= ~ instructionInfo[op->inst].flagsUndefined;
+    }
+    flags &= ~result;
+    if (flags) {
+        result |= DecodedOp::getNeededFlags(block, op, flags, depth);
+    }
+    return result;
+}
+
 U32 DecodedOp::getNeededFlags(DecodedBlock* block, DecodedOp* op, U32 flags, U32 depth) {
     DecodedOp* n = op->next;
     DecodedOp* lastOp = op;
@@ -6045,11 +6061,13 @@ U32 DecodedOp::getNeededFlags(DecodedBlock* block, DecodedOp* op, U32 flags, U32
     while (n && flags) {
         if (instructionInfo[n->inst].flagsUsed & flags) {
             U32 result = instructionInfo[n->inst].flagsUsed & flags;
-            flags &= ~ instructionInfo[n->inst].flagsSets;
-            flags &= ~ instructionInfo[n->inst].flagsUndefined;
+            if (!(instructionInfo[n->inst].flagsSets & MAYBE)) {
+                flags &= ~ instructionInfo[n->inst].flagsSets;
+                flags &= ~ instructionInfo[n->inst].flagsUndefined;
+            }
             flags &= ~result;
-            if (flags && op->next) {
-                result |= DecodedOp::getNeededFlags(block, op->next, flags, depth);
+            if (flags) {
+                result |= DecodedOp::getNeededFlags(block, n, flags, depth);
             }
             return result;
         }
@@ -6063,14 +6081,14 @@ U32 DecodedOp::getNeededFlags(DecodedBlock* block, DecodedOp* op, U32 flags, U32
     if (flags && (instructionInfo[lastOp->inst].branch & DECODE_BRANCH_1) && depth>0) {
         // :TODO: maybe decode the missing branch?
         if (block->next1 && (block->next2 || !(instructionInfo[lastOp->inst].branch & DECODE_BRANCH_2))) {
-            U32 needsToSet1 = DecodedOp::getNeededFlags(block->next1, block->next1->op, flags, depth-1);          
+            U32 needsToSet1 = getNeededFlagsFromBlockStart(block->next1, flags, depth-1);          
 
             U32 needsToSet2 = 0;
             if ((instructionInfo[lastOp->inst].branch & DECODE_BRANCH_2)) {
                 needsToSet2 = flags;
                 // :TODO: maybe decode the missing branch?
                 if (block->next2) {
-                    needsToSet2 = (DecodedOp::getNeededFlags(block->next2, block->next2->op, flags, depth-1));
+                    needsToSet2 = getNeededFlagsFromBlockStart(block->next2, flags, depth-1);
                 }
             }
             flags = needsToSet1 | needsToSet2;
@@ -6080,8 +6098,10 @@ U32 DecodedOp::getNeededFlags(DecodedBlock* block, DecodedOp* op, U32 flags, U32
 }
 
 static DecodedBlockFromNode* freeFromNodes;
+static BOXEDWINE_MUTEX freeFromNodesMutex;
 DecodedBlockFromNode* DecodedBlockFromNode::alloc() {
     DecodedBlockFromNode* result;
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(freeFromNodesMutex);
 
     if (freeFromNodes) {
         result = freeFromNodes;
@@ -6102,6 +6122,7 @@ DecodedBlockFromNode* DecodedBlockFromNode::alloc() {
     return result;
 }
 void DecodedBlockFromNode::dealloc() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(freeFromNodesMutex);
     this->next = freeFromNodes;
     this->block = NULL;
     freeFromNodes = this;
@@ -6152,6 +6173,9 @@ void DecodedBlock::removeReferenceFrom(DecodedBlock* block) {
 	}
 }
 
+#ifdef BOXEDWINE_MULTI_THREADED
+THREAD_LOCAL
+#endif
 DecodedBlock* DecodedBlock::currentBlock;
 
 void decodeBlock(pfnFetchByte fetchByte, U32 eip, bool isBig, U32 maxInstructions, U32 maxLen, U32 stopIfThrowsException, DecodedBlock* block) {
@@ -5,13 +5,13 @@
 
 class DynamicData {
 public:
-    DynamicData() : cpu(NULL), skipToOp(NULL), block(NULL), skipEipUpdateLen(0), done(false), currentLazyFlags(NULL) {}
+    DynamicData() : cpu(NULL), skipToOp(NULL), block(NULL), skipEipUpdateLen(0), done(false), currentLazyFlags(0) {}
     CPU* cpu;
     DecodedOp* skipToOp;
     DecodedBlock* block;
     U32 skipEipUpdateLen;
     bool done;
-    const LazyFlags* currentLazyFlags;
+    LazyFlags currentLazyFlags;
 };
 
 typedef void (*pfnDynamicOp)(DynamicData* data, DecodedOp* op);
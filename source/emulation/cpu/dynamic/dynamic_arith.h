@@ -429,7 +429,7 @@ void dynamic_negr8(DynamicData* data, DecodedOp* op) {
         instReg('-', DYN_DEST, DYN_8bit);
         movToCpuFromReg(CPU_OFFSET_OF(result.u8), DYN_DEST, DYN_8bit, false);
         movToCpuFromReg(OFFSET_REG8(op->reg), DYN_DEST, DYN_8bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_NEG8);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_NEG8);
         data->currentLazyFlags=FLAGS_NEG8;
     }
     INCREMENT_EIP(data, op);
@@ -443,7 +443,7 @@ void dynamic_nege8(DynamicData* data, DecodedOp* op) {
         instReg('-', DYN_CALL_RESULT, DYN_8bit);
         movToCpuFromReg(CPU_OFFSET_OF(result.u8), DYN_CALL_RESULT, DYN_8bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_8bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_NEG8);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_NEG8);
         data->currentLazyFlags=FLAGS_NEG8;
     }
     INCREMENT_EIP(data, op);
@@ -456,7 +456,7 @@ void dynamic_negr16(DynamicData* data, DecodedOp* op) {
         instReg('-', DYN_DEST, DYN_16bit);
         movToCpuFromReg(CPU_OFFSET_OF(result.u16), DYN_DEST, DYN_16bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u16), DYN_DEST, DYN_16bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_NEG16);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_NEG16);
         data->currentLazyFlags=FLAGS_NEG16;
     }
     INCREMENT_EIP(data, op);
@@ -470,7 +470,7 @@ void dynamic_nege16(DynamicData* data, DecodedOp* op) {
         instReg('-', DYN_CALL_RESULT, DYN_16bit);
         movToCpuFromReg(CPU_OFFSET_OF(result.u16), DYN_CALL_RESULT, DYN_16bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_16bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_NEG16);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_NEG16);
         data->currentLazyFlags=FLAGS_NEG16;
     }
     INCREMENT_EIP(data, op);
@@ -483,7 +483,7 @@ void dynamic_negr32(DynamicData* data, DecodedOp* op) {
         instReg('-', DYN_DEST, DYN_32bit);
         movToCpuFromReg(CPU_OFFSET_OF(result.u32), DYN_DEST, DYN_32bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u32), DYN_DEST, DYN_32bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_NEG32);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_NEG32);
         data->currentLazyFlags=FLAGS_NEG32;
     }
     INCREMENT_EIP(data, op);
@@ -497,7 +497,7 @@ void dynamic_nege32(DynamicData* data, DecodedOp* op) {
         instReg('-', DYN_CALL_RESULT, DYN_32bit);
         movToCpuFromReg(CPU_OFFSET_OF(result.u32), DYN_CALL_RESULT, DYN_32bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_32bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_NEG32);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_NEG32);
         data->currentLazyFlags=FLAGS_NEG32;
     }
     INCREMENT_EIP(data, op);
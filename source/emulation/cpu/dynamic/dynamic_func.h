@@ -72,7 +72,7 @@ U32 cpuOffsetSrc(DynWidth width) {
 }
 void dynamic_getCF(DynamicData* data);
 
-void dynamic_arith(DynamicData* data, DecodedOp* op, DynArg src, DynArg dst, DynWidth width, char inst, bool cf, bool store, const LazyFlags* flags) {
+void dynamic_arith(DynamicData* data, DecodedOp* op, DynArg src, DynArg dst, DynWidth width, char inst, bool cf, bool store, LazyFlags flags) {
     bool isJump = op->next->inst == JumpZ || op->next->inst == JumpNZ;
     bool isSet = op->next->inst == SetZ_E8 || op->next->inst == SetZ_R8 || op->next->inst == SetNZ_E8 || op->next->inst == SetNZ_R8;
     bool needResultReg = isJump || isSet;
@@ -305,7 +305,7 @@ void dynamic_arith(DynamicData* data, DecodedOp* op, DynArg src, DynArg dst, Dyn
                 }
             }
         }
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)flags);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, flags);
         data->currentLazyFlags = flags;
     }
 
@@ -344,7 +344,7 @@ void dynamic_arith(DynamicData* data, DecodedOp* op, DynArg src, DynArg dst, Dyn
     }
 }
 
-void genCF(const LazyFlags* flags, DynReg reg) {
+void genCF(LazyFlags flags, DynReg reg) {
     if (reg==DYN_SRC || reg == DYN_DEST) {
         kpanic("genCF expects reg not to be DYN_SRC or DYN_DEST");
     }
@@ -639,7 +639,7 @@ void genCF(const LazyFlags* flags, DynReg reg) {
     }
 }
 
-void genOF(const LazyFlags* flags, DynReg reg) {
+void genOF(LazyFlags flags, DynReg reg) {
     if (reg == DYN_SRC || reg == DYN_DEST) {
         kpanic("genOF expects reg not to be DYN_SRC or DYN_DEST");
     }
@@ -872,18 +872,18 @@ void genOF(const LazyFlags* flags, DynReg reg) {
     }
 }
 
-DynWidth getWidthOfCondition(const LazyFlags* flags) {
-    if (flags->width==32)
+DynWidth getWidthOfCondition(LazyFlags flags) {
+    if (lazyFlagsResultMask[flags]==0xffffffff)
         return DYN_32bit;
-    if (flags->width==16)
+    if (lazyFlagsResultMask[flags]==0xffff)
         return DYN_16bit;
-    if (flags->width==8)
+    if (lazyFlagsResultMask[flags]==0xff)
         return DYN_8bit;
-    kpanic("getWidthOfCondition: invalid flag width: %d", flags->width);
+    kpanic("getWidthOfCondition: invalid flags: %d", flags);
     return DYN_32bit;
 }
 
-void genNZ(const LazyFlags* flags, DynReg reg) {
+void genNZ(LazyFlags flags, DynReg reg) {
     DynWidth width = getWidthOfCondition(flags);
     if (width==DYN_32bit) {
         movToRegFromCpu(reg, CPU_OFFSET_OF(result.u32), DYN_32bit);
@@ -898,7 +898,7 @@ void genNZ(const LazyFlags* flags, DynReg reg) {
     }
 }
 
-void genZ(const LazyFlags* flags, DynReg reg) {
+void genZ(LazyFlags flags, DynReg reg) {
     DynWidth width = getWidthOfCondition(flags);
     if (width==DYN_32bit) {
         movToRegFromCpu(reg, CPU_OFFSET_OF(result.u32), DYN_32bit);
@@ -914,7 +914,7 @@ void genZ(const LazyFlags* flags, DynReg reg) {
     }
 }
 
-void genS(const LazyFlags* flags, DynReg reg) {
+void genS(LazyFlags flags, DynReg reg) {
     DynWidth width = getWidthOfCondition(flags);
     if (width==DYN_32bit) {
         movToRegFromCpu(reg, CPU_OFFSET_OF(result.u32), DYN_32bit);
@@ -80,7 +80,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
         // add ax, [DYN_CPU_REG+cpu->reg[op->rm].u16]
         if (op->rm != 8) {
             DynReg tmp = getUnsavedTmpReg();
-            loadFromCpuOffset16(tmp, offsetof(CPU, reg[op->rm].u16));
+            loadFromCpuOffset16(tmp, CPU_OFFSET_OF(reg[op->rm].u16));
             addRegs32(reg, tmp);
             clearRegUsed(tmp);
         }
@@ -88,7 +88,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
         // add ax, [cpu->reg[op->sibIndex].u16]
         if (op->sibIndex != 8) {
             DynReg tmp = getUnsavedTmpReg();
-            loadFromCpuOffset16(tmp, offsetof(CPU, reg[op->sibIndex].u16));
+            loadFromCpuOffset16(tmp, CPU_OFFSET_OF(reg[op->sibIndex].u16));
             addRegs32(reg, tmp);
             clearRegUsed(tmp);
         }
@@ -100,7 +100,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
         if (op->base < 6) {
             // add eax, [cpu->seg[op->base].address]
             DynReg tmp = getUnsavedTmpReg();
-            loadFromCpuOffset32(tmp, offsetof(CPU, seg[op->base].address));
+            loadFromCpuOffset32(tmp, CPU_OFFSET_OF(seg[op->base].address));
             addRegs32(reg, tmp);
             clearRegUsed(tmp);
         }
@@ -110,7 +110,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
 
         if (op->sibIndex != 8) {
             initiallized = true;
-            loadFromCpuOffset32(reg, offsetof(CPU, reg[op->sibIndex].u32));
+            loadFromCpuOffset32(reg, CPU_OFFSET_OF(reg[op->sibIndex].u32));
             if (op->sibScale) {
                 shiftLeft32(reg, op->sibScale);
             }
@@ -119,7 +119,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
             if (op->base < 6 && KThread::currentThread()->process->hasSetSeg[op->base]) {
                 // add eax, [cpu->seg[op->base].address]
                 DynReg tmp = getUnsavedTmpReg();
-                loadFromCpuOffset32(tmp, offsetof(CPU, seg[op->base].address));
+                loadFromCpuOffset32(tmp, CPU_OFFSET_OF(seg[op->base].address));
                 addRegs32(reg, tmp);
                 clearRegUsed(tmp);
             }
@@ -127,17 +127,17 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
             // seg[6] is always 0
             if (op->base < 6 && KThread::currentThread()->process->hasSetSeg[op->base]) {
                 initiallized = true;
-                loadFromCpuOffset32(reg, offsetof(CPU, seg[op->base].address));
+                loadFromCpuOffset32(reg, CPU_OFFSET_OF(seg[op->base].address));
             }
         }
         // add eax, [cpu->reg[op->rm].u32]
         if (op->rm != 8) {
             if (!initiallized) {
                 initiallized = true;
-                loadFromCpuOffset32(reg, offsetof(CPU, reg[op->rm].u32));
+                loadFromCpuOffset32(reg, CPU_OFFSET_OF(reg[op->rm].u32));
             } else {
                 DynReg tmp = getUnsavedTmpReg();
-                loadFromCpuOffset32(tmp, offsetof(CPU, reg[op->rm].u32));
+                loadFromCpuOffset32(tmp, CPU_OFFSET_OF(reg[op->rm].u32));
                 addRegs32(reg, tmp);
                 clearRegUsed(tmp);
             }
@@ -277,7 +277,10 @@ void movFromMem(DynWidth width, DynReg addressReg, bool doneWithAddressReg) {
     }
     setRegUsed(DYN_CALL_RESULT);
 #else
-    // :TODO: inline
+#ifdef DYN_HAS_SOFT_MMU_FAST_PATH
+    // the backend inlines the page pointer lookup, the call below is only taken when that misses
+    U32 donePos = softMmuReadFastPath(width, addressReg);
+#endif
     if (width == DYN_16bit) {
         callHostFunction((void*)readw, true, 1, addressReg, DYN_PARAM_REG_32, doneWithAddressReg);
     } else if (width == DYN_32bit) {
@@ -285,6 +288,9 @@ void movFromMem(DynWidth width, DynReg addressReg, bool doneWithAddressReg) {
     } else {
         callHostFunction((void*)readb, true, 1, addressReg, DYN_PARAM_REG_32, doneWithAddressReg);
     }
+#ifdef DYN_HAS_SOFT_MMU_FAST_PATH
+    writeJumpAmount(donePos, outBufferPos);
+#endif
 #endif
     if (doneWithAddressReg) {
         clearRegUsed(addressReg);
@@ -466,7 +472,9 @@ void movToMem(DynReg addressReg, DynWidth width, U32 value, DynCallParamType par
         clearRegUsed(regToWrite);
     }
 #else
-    // :TODO: inline?
+#ifdef DYN_HAS_SOFT_MMU_FAST_PATH
+    U32 donePos = softMmuWriteFastPath(addressReg, width, value, paramType);
+#endif
     if (width == DYN_16bit) {
         callHostFunction((void*)writew, false, 2, addressReg, DYN_PARAM_REG_32, false, value, paramType, doneWithValueReg);
     } else if (width == DYN_32bit) {
@@ -474,6 +482,9 @@ void movToMem(DynReg addressReg, DynWidth width, U32 value, DynCallParamType par
     } else {
         callHostFunction((void*)writeb, false, 2, addressReg, DYN_PARAM_REG_32, false, value, paramType, doneWithValueReg);
     }
+#ifdef DYN_HAS_SOFT_MMU_FAST_PATH
+    writeJumpAmount(donePos, outBufferPos);
+#endif
 #endif
 }
 
@@ -1019,7 +1030,7 @@ void OPCALL firstDynamicOp(CPU* cpu, DecodedOp* op) {
         }
         U8* begin = (U8*)mem + memory->dynamicExecutableMemoryPos;
 
-        Platform::writeCodeToMemory(begin, outBufferPos, [begin, outBuffer, outBufferPos] {
+        Platform::writeCodeToMemory(begin, outBufferPos, [begin] {
             memcpy(begin, outBuffer, outBufferPos);
             });
 
@@ -8,7 +8,7 @@ void dynamic_inc8_reg(DynamicData* data, DecodedOp* op) {
         instRegImm('+', DYN_DEST, DYN_8bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u8), DYN_DEST, DYN_8bit, false);
         movToCpuFromReg(OFFSET_REG8(op->reg), DYN_DEST, DYN_8bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_INC8);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_INC8);
         data->currentLazyFlags=FLAGS_INC8;
     }
     INCREMENT_EIP(data, op);
@@ -25,7 +25,7 @@ void dynamic_inc8_mem32(DynamicData* data, DecodedOp* op) {
         instRegImm('+', DYN_CALL_RESULT, DYN_8bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u8), DYN_CALL_RESULT, DYN_8bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_8bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_INC8);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_INC8);
         data->currentLazyFlags=FLAGS_INC8;
     }
     INCREMENT_EIP(data, op);
@@ -40,7 +40,7 @@ void dynamic_inc16_reg(DynamicData* data, DecodedOp* op) {
         instRegImm('+', DYN_DEST, DYN_16bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u16), DYN_DEST, DYN_16bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u16), DYN_DEST, DYN_16bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_INC16);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_INC16);
         data->currentLazyFlags=FLAGS_INC16;
     }
     INCREMENT_EIP(data, op);
@@ -57,7 +57,7 @@ void dynamic_inc16_mem32(DynamicData* data, DecodedOp* op) {
         instRegImm('+', DYN_CALL_RESULT, DYN_16bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u16), DYN_CALL_RESULT, DYN_16bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_16bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_INC16);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_INC16);
         data->currentLazyFlags=FLAGS_INC16;
     }
     INCREMENT_EIP(data, op);
@@ -72,7 +72,7 @@ void dynamic_inc32_reg(DynamicData* data, DecodedOp* op) {
         instRegImm('+', DYN_DEST, DYN_32bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u32), DYN_DEST, DYN_32bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u32), DYN_DEST, DYN_32bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_INC32);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_INC32);
         data->currentLazyFlags=FLAGS_INC32;
     }
     INCREMENT_EIP(data, op);
@@ -89,7 +89,7 @@ void dynamic_inc32_mem32(DynamicData* data, DecodedOp* op) {
         instRegImm('+', DYN_CALL_RESULT, DYN_32bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u32), DYN_CALL_RESULT, DYN_32bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_32bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_INC32);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_INC32);
         data->currentLazyFlags=FLAGS_INC32;
     }
     INCREMENT_EIP(data, op);
@@ -104,7 +104,7 @@ void dynamic_dec8_reg(DynamicData* data, DecodedOp* op) {
         instRegImm('-', DYN_DEST, DYN_8bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u8), DYN_DEST, DYN_8bit, false);
         movToCpuFromReg(OFFSET_REG8(op->reg), DYN_DEST, DYN_8bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_DEC8);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_DEC8);
         data->currentLazyFlags=FLAGS_DEC8;
     }
     INCREMENT_EIP(data, op);
@@ -121,7 +121,7 @@ void dynamic_dec8_mem32(DynamicData* data, DecodedOp* op) {
         instRegImm('-', DYN_CALL_RESULT, DYN_8bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u8), DYN_CALL_RESULT, DYN_8bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_8bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_DEC8);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_DEC8);
         data->currentLazyFlags=FLAGS_DEC8;
     }
     INCREMENT_EIP(data, op);
@@ -136,7 +136,7 @@ void dynamic_dec16_reg(DynamicData* data, DecodedOp* op) {
         instRegImm('-', DYN_DEST, DYN_16bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u16), DYN_DEST, DYN_16bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u16), DYN_DEST, DYN_16bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_DEC16);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_DEC16);
         data->currentLazyFlags=FLAGS_DEC16;
     }
     INCREMENT_EIP(data, op);
@@ -153,7 +153,7 @@ void dynamic_dec16_mem32(DynamicData* data, DecodedOp* op) {
         instRegImm('-', DYN_CALL_RESULT, DYN_16bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u16), DYN_CALL_RESULT, DYN_16bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_16bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_DEC16);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_DEC16);
         data->currentLazyFlags=FLAGS_DEC16;
     }
     INCREMENT_EIP(data, op);
@@ -168,7 +168,7 @@ void dynamic_dec32_reg(DynamicData* data, DecodedOp* op) {
         instRegImm('-', DYN_DEST, DYN_32bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u32), DYN_DEST, DYN_32bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u32), DYN_DEST, DYN_32bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_DEC32);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_DEC32);
         data->currentLazyFlags=FLAGS_DEC32;
     }
     INCREMENT_EIP(data, op);
@@ -185,7 +185,7 @@ void dynamic_dec32_mem32(DynamicData* data, DecodedOp* op) {
         instRegImm('-', DYN_CALL_RESULT, DYN_32bit, 1);
         movToCpuFromReg(CPU_OFFSET_OF(result.u32), DYN_CALL_RESULT, DYN_32bit, false);
         movToMemFromReg(DYN_ADDRESS, DYN_CALL_RESULT, DYN_32bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_DEC32);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_DEC32);
         data->currentLazyFlags=FLAGS_DEC32;
     }
     INCREMENT_EIP(data, op);
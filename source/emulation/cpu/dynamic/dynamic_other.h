@@ -507,7 +507,7 @@ void dynamic_xaddr8r8(DynamicData* data, DecodedOp* op) {
         movToCpuFromReg(CPU_OFFSET_OF(result.u8), DYN_SRC, DYN_8bit, false);
         movToCpuFromReg(OFFSET_REG8(op->reg), DYN_DEST, DYN_8bit, true);
         movToCpuFromReg(OFFSET_REG8(op->rm), DYN_SRC, DYN_8bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_ADD8);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_ADD8);
     }
     INCREMENT_EIP(data, op);
 }
@@ -529,7 +529,7 @@ void dynamic_xaddr8e8(DynamicData* data, DecodedOp* op) {
         movToCpuFromReg(CPU_OFFSET_OF(result.u8), DYN_SRC, DYN_8bit, false);
         movToCpuFromReg(OFFSET_REG8(op->reg), DYN_CALL_RESULT, DYN_8bit, true);
         movToMemFromReg(DYN_ADDRESS, DYN_SRC, DYN_8bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_ADD8);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_ADD8);
     }
     INCREMENT_EIP(data, op);
 }
@@ -548,7 +548,7 @@ void dynamic_xaddr16r16(DynamicData* data, DecodedOp* op) {
         movToCpuFromReg(CPU_OFFSET_OF(result.u16), DYN_SRC, DYN_16bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u16), DYN_DEST, DYN_16bit, true);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->rm].u16), DYN_SRC, DYN_16bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_ADD16);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_ADD16);
     }
     INCREMENT_EIP(data, op);
 }
@@ -570,7 +570,7 @@ void dynamic_xaddr16e16(DynamicData* data, DecodedOp* op) {
         movToCpuFromReg(CPU_OFFSET_OF(result.u16), DYN_SRC, DYN_16bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u16), DYN_CALL_RESULT, DYN_16bit, true);
         movToMemFromReg(DYN_ADDRESS, DYN_SRC, DYN_16bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_ADD16);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_ADD16);
     }
     INCREMENT_EIP(data, op);
 }
@@ -588,7 +588,7 @@ void dynamic_xaddr32r32(DynamicData* data, DecodedOp* op) {
         movToCpuFromReg(CPU_OFFSET_OF(result.u32), DYN_SRC, DYN_32bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u32), DYN_DEST, DYN_32bit, true);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->rm].u32), DYN_SRC, DYN_32bit, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_ADD32);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_ADD32);
     }
     INCREMENT_EIP(data, op);
 }
@@ -609,7 +609,7 @@ void dynamic_xaddr32e32(DynamicData* data, DecodedOp* op) {
         movToCpuFromReg(CPU_OFFSET_OF(result.u32), DYN_SRC, DYN_32bit, false);
         movToCpuFromReg(CPU_OFFSET_OF(reg[op->reg].u32), DYN_CALL_RESULT, DYN_32bit, true);
         movToMemFromReg(DYN_ADDRESS, DYN_SRC, DYN_32bit, true, true);
-        movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_ADD32);
+        movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_ADD32);
     }
     INCREMENT_EIP(data, op);
 }
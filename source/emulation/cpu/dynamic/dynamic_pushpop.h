@@ -143,14 +143,14 @@ void dynamic_push32imm(DynamicData* data, DecodedOp* op) {
     INCREMENT_EIP(data, op);
 }
 void dynamic_popf16(DynamicData* data, DecodedOp* op) {
-    movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_NONE);
+    movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_NONE);
     callHostFunction((void*)common_pop16, true, 1, 0, DYN_PARAM_CPU, false);
     callHostFunction((void*)common_setFlags, false, 3, 0, DYN_PARAM_CPU, false, DYN_CALL_RESULT, DYN_PARAM_REG_16, true, FMASK_ALL & 0xFFFF, DYN_PARAM_CONST_16, false);
     data->currentLazyFlags=FLAGS_NONE;
     INCREMENT_EIP(data, op);
 }
 void dynamic_popf32(DynamicData* data, DecodedOp* op) {
-    movToCpuPtr(CPU_OFFSET_OF(lazyFlags), (DYN_PTR_SIZE)FLAGS_NONE);
+    movToCpu(CPU_OFFSET_OF(lazyFlags), DYN_32bit, FLAGS_NONE);
     callHostFunction((void*)common_pop32, true, 1, 0, DYN_PARAM_CPU, false);
     callHostFunction((void*)common_setFlags, false, 3, 0, DYN_PARAM_CPU, false, DYN_CALL_RESULT, DYN_PARAM_REG_32, true, FMASK_ALL, DYN_PARAM_CONST_32, false);
     data->currentLazyFlags=FLAGS_NONE;
@@ -6,6 +6,10 @@
 #include "../x32/x32CPU.h"
 #include "../armv7/armv7CPU.h"
 #include "../armv8/armv8CPU.h"
+#include "../x64dynamic/x64dynamicCPU.h"
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+#include "knativesystem.h"
+#endif
 
 #ifdef _DEBUG
 #define START_OP(cpu, op) op->log(cpu)
@@ -14,8 +18,15 @@
 #endif
 #define NEXT() cpu->eip.u32+=op->len; op->next->pfn(cpu, op->next)
 #define NEXT_DONE() cpu->nextBlock = cpu->getNextBlock();
-#define NEXT_BRANCH1() cpu->eip.u32+=op->len; if (!DecodedBlock::currentBlock->next1) {DecodedBlock::currentBlock->next1 = cpu->getNextBlock(); DecodedBlock::currentBlock->next1->addReferenceFrom(DecodedBlock::currentBlock);} cpu->nextBlock = DecodedBlock::currentBlock->next1
-#define NEXT_BRANCH2() cpu->eip.u32+=op->len; if (!DecodedBlock::currentBlock->next2) {DecodedBlock::currentBlock->next2 = cpu->getNextBlock(); DecodedBlock::currentBlock->next2->addReferenceFrom(DecodedBlock::currentBlock);} cpu->nextBlock = DecodedBlock::currentBlock->next2
+#define NEXT_INDIRECT() cpu->nextBlock = cpu->getNextIndirectBlock();
+#define NEXT_RETURN() cpu->nextBlock = cpu->getNextReturnBlock();
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+#define NEXT_BRANCH1() cpu->eip.u32+=op->len; cpu->nextBlock = DecodedBlock::currentBlock->next1; if (!cpu->nextBlock) {NormalCPU::linkNextBlock(cpu, &DecodedBlock::currentBlock->next1);}
+#define NEXT_BRANCH2() cpu->eip.u32+=op->len; cpu->nextBlock = DecodedBlock::currentBlock->next2; if (!cpu->nextBlock) {NormalCPU::linkNextBlock(cpu, &DecodedBlock::currentBlock->next2);}
+#else
+#define NEXT_BRANCH1() cpu->eip.u32+=op->len; if (!DecodedBlock::currentBlock->next1) {DecodedBlock::currentBlock->next1 = cpu->getNextBlock(); DecodedBlock::currentBlock->next1->addReferenceFrom(DecodedBlock::currentBlock); NormalCPU::linksChanged(DecodedBlock::currentBlock);} cpu->nextBlock = DecodedBlock::currentBlock->next1
+#define NEXT_BRANCH2() cpu->eip.u32+=op->len; if (!DecodedBlock::currentBlock->next2) {DecodedBlock::currentBlock->next2 = cpu->getNextBlock(); DecodedBlock::currentBlock->next2->addReferenceFrom(DecodedBlock::currentBlock); NormalCPU::linksChanged(DecodedBlock::currentBlock);} cpu->nextBlock = DecodedBlock::currentBlock->next2
+#endif
 
 #include "instructions.h"
 #include "normal_arith.h"
@@ -36,8 +47,15 @@
 #include "normal_other.h"
 #include "normal_jump.h"
 #include "normal_move.h"
+#include "normal_noflags.h"
+#include "normal_fused.h"
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+#include "normal_lock.h"
+#endif
 
 static OpCallback normalOps[NUMBER_OF_OPS];
+// same as normalOps but won't calculate flags, only valid when nothing reads the flags before they are set again
+static OpCallback normalOpsNoFlags[NUMBER_OF_OPS];
 static U32 normalOpsInitialized;
 
 void OPCALL normal_sidt(CPU* cpu, DecodedOp* op) {
@@ -65,6 +83,10 @@ static void initNormalOps() {
 #include "../common/cpu_init_sse2.h"
 #include "../common/cpu_init_fpu.h"
 #undef INIT_CPU    
+
+#define INIT_CPU(e, f) normalOpsNoFlags[e] = normal_##f;
+#include "../common/cpu_init_noflags.h"
+#undef INIT_CPU
     
     normalOps[SLDTReg] = 0; 
     normalOps[SLDTE16] = 0;
@@ -86,6 +108,9 @@ static void initNormalOps() {
     normalOps[LMSW] = 0;
     normalOps[INVLPG] = 0;
     normalOps[Callback] = 0;
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    initNormalLockedOps();
+#endif
 }
 
 OpCallback NormalCPU::getFunctionForOp(DecodedOp* op) {
@@ -93,15 +118,121 @@ OpCallback NormalCPU::getFunctionForOp(DecodedOp* op) {
     return normalOps[op->inst];
 }
 
-NormalCPU::NormalCPU() {   
+bool NormalCPU::useFlagLiveness = true;
+
+// Switches each op to its flag free version if none of the flags it sets are read before they are set again.
+// DecodedOp::getNeededFlags follows next1/next2 if they are linked, otherwise every flag still set at the end of
+// the block is assumed to be needed.  When next1/next2 change, linksChanged must be called since the result depends
+// on them.
+void NormalCPU::optimizeFlags(DecodedBlock* block) {
+    initNormalOps();
+
+    for (DecodedOp* op = block->op; op; op = op->next) {
+        if (normalOpsNoFlags[op->inst] && (op->pfn == normalOps[op->inst] || op->pfn == normalOpsNoFlags[op->inst])) {
+            if (useFlagLiveness && !DecodedOp::getNeededFlags(block, op, instructionInfo[op->inst].flagsSets & FMASK_TEST)) {
+                op->pfn = normalOpsNoFlags[op->inst];
+            } else {
+                op->pfn = normalOps[op->inst];
+            }
+        }
+    }
+}
+
+bool NormalCPU::useFusion = true;
+NormalFusionStats NormalCPU::fusionStats;
+
+static bool isUnmodifiedOp(DecodedOp* op) {
+    return op->pfn == normalOps[op->inst] || op->pfn == normalOpsNoFlags[op->inst];
+}
+
+static S32 getFusedJumpSource(U32 inst) {
+    switch (inst) {
+    case CmpR32R32: return FUSED_CMPR32R32;
+    case CmpE32R32: return FUSED_CMPE32R32;
+    case CmpR32E32: return FUSED_CMPR32E32;
+    case CmpR32I32: return FUSED_CMPR32I32;
+    case CmpE32I32: return FUSED_CMPE32I32;
+    case TestR32R32: return FUSED_TESTR32R32;
+    case TestR32I32: return FUSED_TESTR32I32;
+    default: return -1;
+    }
+}
+
+// Replaces the pfn of the first op of common pairs/runs with a handler that runs the whole group, this saves
+// the indirect dispatch for the rest of the group and for cmp/test + jcc the lazy flag lookup.  The fused ops
+// stay in the list so the block still knows its length and instruction count.
+void NormalCPU::fuseOps(DecodedBlock* block) {
+    if (!useFusion) {
+        return;
+    }
     initNormalOps();
+
+    DecodedOp* op = block->op;
+    while (op && op->next) {
+        DecodedOp* next = op->next;
+
+        if (!isUnmodifiedOp(op) || !isUnmodifiedOp(next)) {
+            op = next;
+            continue;
+        }
+        S32 source = getFusedJumpSource(op->inst);
+        if (source >= 0 && next->inst >= JumpO && next->inst <= JumpNLE && normalFusedJumps[source][next->inst - JumpO]) {
+            op->pfn = normalFusedJumps[source][next->inst - JumpO];
+            fusionStats.cmpJcc++;
+            fusionStats.opsFused++;
+            op = next->next;
+        } else if (op->inst == MovR32R32 && next->inst == AddR32I32 && next->reg == op->reg) {
+            op->pfn = normal_fused_movr32r32_add32_reg;
+            fusionStats.movAdd++;
+            fusionStats.opsFused++;
+            op = next->next;
+        } else if (op->inst == MovR32R32 && next->inst == AddR32R32 && next->reg == op->reg && next->rm != op->reg) {
+            op->pfn = normal_fused_movr32r32_addr32r32;
+            fusionStats.movAdd++;
+            fusionStats.opsFused++;
+            op = next->next;
+        } else if ((op->inst == PushR32 || op->inst == Push32) && (next->inst == PushR32 || next->inst == Push32)) {
+            U32 count = 1;
+            while (next && (next->inst == PushR32 || next->inst == Push32) && isUnmodifiedOp(next)) {
+                count++;
+                next = next->next;
+            }
+            op->pfn = normal_fused_push32_run;
+            op->disp = count;
+            fusionStats.pushRuns++;
+            fusionStats.opsFused += count - 1;
+            op = next;
+        } else {
+            op = next;
+        }
+    }
+}
+
+NormalCPU::NormalCPU() : returnStackPos(0) {   
+    initNormalOps();
+    memset(this->returnStack, 0, sizeof(this->returnStack));
+    memset(&this->indirectStats, 0, sizeof(this->indirectStats));
 #ifdef BOXEDWINE_DYNAMIC
     this->firstOp = firstDynamicOp;
 #else
     this->firstOp = NULL;
 #endif
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    this->codeEpoch = 0;
+    this->codePin = NULL;
+    this->codeEpochSource = NULL;
+    this->codeMemory = NULL;
+#endif
 }
 
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+NormalCPU::~NormalCPU() {
+    if (this->codeMemory) {
+        this->codeMemory->removeCodeThread(this);
+    }
+}
+#endif
+
 U8 fetchByte(U32 *eip) {
     if (*eip - KThread::currentThread()->cpu->seg[CS].address == 0xFFFF && !KThread::currentThread()->cpu->isBig()) {
         kpanic("eip wrapped around.");
@@ -109,6 +240,8 @@ U8 fetchByte(U32 *eip) {
     return readb((*eip)++);
 }
 
+#define NORMAL_INDIRECT_TARGETS 4
+
 class NormalBlock : public DecodedBlock {
 public:
     static NormalBlock* alloc();
@@ -120,7 +253,28 @@ public:
 
     void run(CPU* cpu);
 
+    void setLink(DecodedBlock** link, DecodedBlock* block);
+    void unlink(DecodedBlock* block);
+    // getNeededFlags looks 2 blocks ahead, so the blocks that link to this one depend on its next1/next2 too
+    void optimizeFlagsAfterLinkChange();
+
+    // the last few blocks the indirect jmp/call or ret at the end of this block went to
+    DecodedBlock* indirectTargets[NORMAL_INDIRECT_TARGETS];
+    U32 nextIndirectTarget;
+    // the block after the call at the end of this block, set the first time a ret goes there
+    DecodedBlock* returnBlock;
+
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    void release();
+
+    Memory* memory; // the code cache this block was added to
+    // set once it has been removed from the code cache and unlinked, another thread might still be running it
+    volatile bool retired;
+#endif
+
 private:
+    bool isLinkedTo(DecodedBlock* block);
+
     void init();
     NormalBlock* next;
 };
@@ -129,6 +283,17 @@ NormalBlock::NormalBlock() {
     this->init();
 }
 
+void NormalBlock::optimizeFlagsAfterLinkChange() {
+    NormalCPU::optimizeFlags(this);
+    for (DecodedBlockFromNode* from = this->referencedFrom; from; from = from->next) {
+        NormalCPU::optimizeFlags(from->block);
+    }
+}
+
+void NormalCPU::linksChanged(DecodedBlock* block) {
+    ((NormalBlock*)block)->optimizeFlagsAfterLinkChange();
+}
+
 void NormalBlock::run(CPU* cpu) {
 #ifdef _DEBUG
     if (this==NULL || this->op==NULL || this->op->pfn==NULL) {
@@ -141,6 +306,7 @@ void NormalBlock::run(CPU* cpu) {
 }
 
 static NormalBlock* freeBlocks;
+static BOXEDWINE_MUTEX freeBlocksMutex;
 
 void NormalBlock::init() {
     this->next = 0;
@@ -151,9 +317,69 @@ void NormalBlock::init() {
     this->next1 = NULL;
     this->next2 = NULL;
     this->referencedFrom = NULL;
+    memset(this->indirectTargets, 0, sizeof(this->indirectTargets));
+    this->nextIndirectTarget = 0;
+    this->returnBlock = NULL;
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    this->memory = NULL;
+    this->retired = false;
+#endif
+}
+
+bool NormalBlock::isLinkedTo(DecodedBlock* block) {
+    if (this->next1 == block || this->next2 == block || this->returnBlock == block) {
+        return true;
+    }
+    for (U32 i = 0; i < NORMAL_INDIRECT_TARGETS; i++) {
+        if (this->indirectTargets[i] == block) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// removeReferenceFrom drops every reference from this block, so it is only called once nothing in this block links to
+// the old block anymore
+void NormalBlock::setLink(DecodedBlock** link, DecodedBlock* block) {
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    // another thread might be linking this block too or retiring either of them
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(KThread::currentThread()->memory->pageMutex);
+    if (this->retired || ((NormalBlock*)block)->retired) {
+        return;
+    }
+#endif
+    bool alreadyLinked = this->isLinkedTo(block);
+    DecodedBlock* old = *link;
+
+    *link = block;
+    if (old && !this->isLinkedTo(old)) {
+        old->removeReferenceFrom(this);
+    }
+    if (!alreadyLinked) {
+        block->addReferenceFrom(this);
+    }
+}
+
+// block is being freed
+void NormalBlock::unlink(DecodedBlock* block) {
+    if (this->next1 == block) {
+        this->next1 = NULL;
+    }
+    if (this->next2 == block) {
+        this->next2 = NULL;
+    }
+    if (this->returnBlock == block) {
+        this->returnBlock = NULL;
+    }
+    for (U32 i = 0; i < NORMAL_INDIRECT_TARGETS; i++) {
+        if (this->indirectTargets[i] == block) {
+            this->indirectTargets[i] = NULL;
+        }
+    }
 }
 
 void NormalBlock::clearCache() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(freeBlocksMutex);
     while (freeBlocks) {
         NormalBlock* next = freeBlocks->next;
         delete freeBlocks;
@@ -163,6 +389,7 @@ void NormalBlock::clearCache() {
 
 NormalBlock* NormalBlock::alloc() {
     NormalBlock* result;
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(freeBlocksMutex);
 
     if (freeBlocks) {
         result = freeBlocks;
@@ -174,7 +401,26 @@ NormalBlock* NormalBlock::alloc() {
     }    
 }
 
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+void NormalBlock::release() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(freeBlocksMutex);
+    this->op->dealloc(true);
+    this->next = freeBlocks;
+    this->op = NULL;
+    freeBlocks = this;
+}
+
+void NormalCPU::freeRetiredBlock(DecodedBlock* block) {
+    ((NormalBlock*)block)->release();
+}
+#endif
+
 void NormalBlock::dealloc(bool delayed) {
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    // Other threads might be running this block, so it is only unlinked here, while holding pageMutex.  It is freed
+    // once they have all moved on, see Memory::reclaimRetiredCode
+    this->retired = true;
+#else
     KThread* thread = KThread::currentThread();
     if (thread) {
         CPU* cpu = thread->cpu;
@@ -197,6 +443,7 @@ void NormalBlock::dealloc(bool delayed) {
         this->op = NULL;
         freeBlocks = this;
     }
+#endif
     if (this->next1) {
         this->next1->removeReferenceFrom(this);
         this->next1 = NULL;
@@ -205,19 +452,36 @@ void NormalBlock::dealloc(bool delayed) {
         this->next2->removeReferenceFrom(this);
         this->next2 = NULL;
     }
+    if (this->returnBlock) {
+        this->returnBlock->removeReferenceFrom(this);
+        this->returnBlock = NULL;
+    }
+    for (U32 i = 0; i < NORMAL_INDIRECT_TARGETS; i++) {
+        if (this->indirectTargets[i]) {
+            this->indirectTargets[i]->removeReferenceFrom(this);
+            this->indirectTargets[i] = NULL;
+        }
+    }
+    // invalidates the callers on every cpu's return stack
+    NormalCPU::blocksFreed++;
     DecodedBlockFromNode* from = this->referencedFrom;
     while (from) {
         DecodedBlockFromNode* n = from->next;
-        if (from->block->next1 == this) {
-            from->block->next1 = NULL;
-        }
-        if (from->block->next2 == this) {
-            from->block->next2 = NULL;
-        }
+        ((NormalBlock*)from->block)->unlink(this);
+        // the flags that were dropped might be needed by whatever gets linked next
+        NormalCPU::linksChanged(from->block);
         from->dealloc();
         from = n;
     }
     this->referencedFrom = NULL;
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    // must come after it is unlinked, a thread that sees the new epoch must not be able to find this block
+    if (this->memory) {
+        this->memory->retireBlock(this);
+    } else {
+        this->release(); // never added to a code cache, so no other thread has seen it
+    }
+#endif
 }
 
 DecodedBlock* NormalCPU::getBlockForInspectionButNotUsed(U32 address, bool big) {
@@ -227,11 +491,15 @@ DecodedBlock* NormalCPU::getBlockForInspectionButNotUsed(U32 address, bool big)
     return block;
 }
 
+U32 NormalCPU::getNextBlockAddress() {
+    return (this->big?this->eip.u32:this->eip.u16) + this->seg[CS].address;
+}
+
 DecodedBlock* NormalCPU::getNextBlock() {
     if (!this->thread->process) // exit was called, don't need to pre-cache the next block
         return NULL;
 
-    U32 startIp = (this->big?this->eip.u32:this->eip.u16) + this->seg[CS].address;
+    U32 startIp = this->getNextBlockAddress();
     DecodedBlock* block = this->thread->memory->getCodeBlock(startIp);
 
     if (!block) {
@@ -243,9 +511,29 @@ DecodedBlock* NormalCPU::getNextBlock() {
         while (op) {
             if (!op->pfn) // callback will be set by decoder
                 op->pfn = normalOps[op->inst];
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+            if (getLockedOp(op))
+                op->pfn = getLockedOp(op);
+#endif
             op = op->next;
         }
+        fuseOps(block);
+        optimizeFlags(block);
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+        {
+            BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->thread->memory->pageMutex);
+            DecodedBlock* existing = this->thread->memory->getCodeBlock(startIp);
+            if (existing) {
+                // another thread decoded the same block at the same time
+                ((NormalBlock*)block)->release();
+                return existing;
+            }
+            ((NormalBlock*)block)->memory = this->thread->memory;
+            this->thread->memory->addCodeBlock(startIp, block);
+        }
+#else
         this->thread->memory->addCodeBlock(startIp, block);
+#endif
         if (this->firstOp) {
             op = DecodedOp::alloc();
             op->inst = Custom1;
@@ -257,7 +545,184 @@ DecodedBlock* NormalCPU::getNextBlock() {
     return block;
 }
 
+bool NormalCPU::useIndirectPrediction = true;
+std::atomic<U32> NormalCPU::blocksFreed;
+
+// Most indirect jumps and calls only ever go to one or two places, so the block they end remembers the last few blocks
+// it went to.  The code cache lookup in getNextBlock is only done when none of those match.
+DecodedBlock* NormalCPU::getNextIndirectBlock() {
+    if (!useIndirectPrediction || !this->thread->process) {
+        return this->getNextBlock();
+    }
+    NormalBlock* block = (NormalBlock*)DecodedBlock::currentBlock;
+    U32 address = this->getNextBlockAddress();
+
+    for (U32 i = 0; i < NORMAL_INDIRECT_TARGETS; i++) {
+        DecodedBlock* target = block->indirectTargets[i];
+        if (target && target->address == address) {
+            indirectStats.targetHits++;
+            return target;
+        }
+    }
+    indirectStats.targetMisses++;
+    DecodedBlock* result = this->getNextBlock();
+    block->setLink(&block->indirectTargets[block->nextIndirectTarget], result);
+    block->nextIndirectTarget = (block->nextIndirectTarget + 1) % NORMAL_INDIRECT_TARGETS;
+    return result;
+}
+
+void NormalCPU::pushReturn(U32 returnEip) {
+    if (!useIndirectPrediction) {
+        return;
+    }
+    NormalReturnPrediction& prediction = this->returnStack[this->returnStackPos];
+    prediction.address = returnEip + this->seg[CS].address;
+    prediction.caller = DecodedBlock::currentBlock;
+    prediction.blocksFreed = blocksFreed;
+    this->returnStackPos = (this->returnStackPos + 1) % NORMAL_RETURN_STACK_SIZE;
+}
+
+// If the ret goes back to where the last call said it would, the block after the call is linked to the block that made
+// the call, the same way a direct jump is linked with next1.  Anything else, like a longjmp or a ret that was used as a
+// jmp, falls back to the targets this block has seen.
+DecodedBlock* NormalCPU::getNextReturnBlock() {
+    if (!useIndirectPrediction || !this->thread->process) {
+        return this->getNextBlock();
+    }
+    this->returnStackPos = (this->returnStackPos + NORMAL_RETURN_STACK_SIZE - 1) % NORMAL_RETURN_STACK_SIZE;
+    NormalReturnPrediction& prediction = this->returnStack[this->returnStackPos];
+    NormalBlock* caller = (NormalBlock*)prediction.caller;
+    U32 address = this->getNextBlockAddress();
+
+    prediction.caller = NULL;
+    if (caller && prediction.address == address && prediction.blocksFreed == blocksFreed) {
+        if (caller->returnBlock && caller->returnBlock->address == address) {
+            indirectStats.returnHits++;
+            return caller->returnBlock;
+        }
+        indirectStats.returnMisses++;
+        DecodedBlock* result = this->getNextBlock();
+        caller->setLink(&caller->returnBlock, result);
+        return result;
+    }
+    indirectStats.returnMisses++;
+    return this->getNextIndirectBlock();
+}
+
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+// the retired list is only worth walking once it has built up a bit, it can't shrink until every thread has moved on
+#define NORMAL_RECLAIM_THRESHOLD 64
+#define NORMAL_CODE_EPOCH_WAITING 0xFFFFFFFFFFFFFFFFl
+
+void NormalCPU::linkNextBlock(CPU* cpu, DecodedBlock** link) {
+    NormalBlock* from = (NormalBlock*)DecodedBlock::currentBlock;
+    DecodedBlock* block = cpu->getNextBlock();
+
+    if (block) {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(cpu->thread->memory->pageMutex);
+        if (!*link) {
+            from->setLink(link, block);
+            if (*link == block) {
+                linksChanged(from);
+            }
+        }
+    }
+    cpu->nextBlock = block;
+}
+
+void NormalCPU::beforeWait() {
+    this->codePin = DecodedBlock::currentBlock;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    this->codeEpoch = NORMAL_CODE_EPOCH_WAITING;
+}
+
+void NormalCPU::afterWait() {
+    if (this->codeEpochSource) {
+        this->codeEpoch = *this->codeEpochSource;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+extern U32 platformThreadCount;
+
+void NormalCPU::startThread() {
+    KThread* thread = this->thread;
+    KThread::setCurrentThread(thread);
+
+    while (!thread->terminating) {
+        if (setjmp(this->runBlockJump) == 0) {
+            do {
+                this->run();
+            } while (!thread->terminating);
+        } else {
+            this->nextBlock = NULL;
+        }
+    }
+    if (this->codeMemory) {
+        this->codeMemory->removeCodeThread(this);
+    }
+    std::shared_ptr<KProcess> process = thread->process;
+    process->deleteThread(thread);
+
+    platformThreadCount--;
+    if (platformThreadCount == 0) {
+        KSystem::shutingDown = true;
+        KNativeSystem::postQuit();
+    }
+}
+
+void terminateOtherThread(const std::shared_ptr<KProcess>& process, U32 threadId) {
+    KThread* thread = process->getThreadById(threadId);
+    if (thread) {
+        thread->terminating = true;
+        thread->cpu->wakeThreadIfWaiting();
+    }
+
+    while (true) {
+        BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(process->threadRemovedCondition);
+        if (!process->getThreadById(threadId)) {
+            break;
+        }
+        BOXEDWINE_CONDITION_WAIT_TIMEOUT(process->threadRemovedCondition, 1000);
+    }
+}
+
+void terminateCurrentThread(KThread* thread) {
+    thread->terminating = true;
+}
+
+void unscheduleThread(KThread* thread) {
+}
+#endif
+
 void NormalCPU::run() {    
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    Memory* memory = this->thread->memory;
+    if (this->codeMemory != memory) {
+        if (this->codeMemory) {
+            this->codeMemory->removeCodeThread(this);
+        }
+        memory->addCodeThread(this);
+    }
+    U64 epoch = *this->codeEpochSource;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Everything retired up to epoch has been unlinked, but nextBlock might have been picked up before that.  It won't
+    // be freed until codeEpoch moves past when it was retired, so it is still safe to look at here.
+    if (!this->nextBlock || ((NormalBlock*)this->nextBlock)->retired) {
+        this->nextBlock = this->getNextBlock();
+        if (!this->nextBlock) {
+            return;
+        }
+    }
+    if (this->codeEpoch != epoch) {
+        this->codeEpoch = epoch;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        this->codePin = NULL;
+        if (memory->retiredCodeCount - memory->reclaimedCodeCount >= NORMAL_RECLAIM_THRESHOLD) {
+            memory->reclaimRetiredCode();
+        }
+    }
+#endif
     DecodedBlock::currentBlock = this->nextBlock;
     DecodedBlock::currentBlock->run(this);    
 #ifdef _DEBUG
@@ -3,20 +3,86 @@
 
 #include "../common/cpu.h"
 
+// counted when blocks are decoded, not when they are run.  Threads decode blocks at the same time when each one has its
+// own host thread, copying it gives a snapshot of the counts.
+struct NormalFusionStats {
+    NormalFusionStats() : cmpJcc(0), movAdd(0), pushRuns(0), opsFused(0) {}
+    NormalFusionStats(const NormalFusionStats& s) : cmpJcc(s.cmpJcc.load()), movAdd(s.movAdd.load()), pushRuns(s.pushRuns.load()), opsFused(s.opsFused.load()) {}
+    std::atomic<U32> cmpJcc;
+    std::atomic<U32> movAdd;
+    std::atomic<U32> pushRuns;
+    std::atomic<U32> opsFused; // number of dispatches saved each time all of the fused groups are run once
+};
+
+// counted when a block that ends in an indirect jmp/call or a ret is run, each cpu keeps its own
+struct NormalIndirectStats {
+    U32 targetHits;
+    U32 targetMisses;
+    U32 returnHits;
+    U32 returnMisses;
+};
+
+#define NORMAL_RETURN_STACK_SIZE 16
+
+struct NormalReturnPrediction {
+    U32 address; // linear address the call will return to
+    DecodedBlock* caller;
+    U32 blocksFreed; // caller is only valid if no block has been freed since the call
+};
+
 class NormalCPU : public CPU {
 public:
     NormalCPU();
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    virtual ~NormalCPU();
+#endif
 
     static void clearCache();
 
     virtual void run();
     virtual DecodedBlock* getNextBlock();
+    virtual DecodedBlock* getNextIndirectBlock();
+    virtual DecodedBlock* getNextReturnBlock();
+    virtual void pushReturn(U32 returnEip);
 
     static OpCallback getFunctionForOp(DecodedOp* op);
 
     static DecodedBlock* getBlockForInspectionButNotUsed(U32 address, bool big);
+    static void optimizeFlags(DecodedBlock* block);
+    // call after next1/next2 of block change
+    static void linksChanged(DecodedBlock* block);
+    static bool useFlagLiveness;
+    static void fuseOps(DecodedBlock* block);
+    static bool useFusion;
+    static NormalFusionStats fusionStats;
+    static bool useIndirectPrediction;
+    static std::atomic<U32> blocksFreed;
+
+    NormalIndirectStats indirectStats;
 
     OpCallback firstOp;
+
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    virtual void startThread();
+    virtual void beforeWait();
+    virtual void afterWait();
+
+    // Memory::reclaimRetiredCode will not free blocks or pages retired after codeEpoch.  It is updated from
+    // *codeEpochSource each time a block starts and while waiting in a syscall codePin is the block it will return to.
+    volatile U64 codeEpoch;
+    DecodedBlock* volatile codePin;
+    U64* codeEpochSource;
+    Memory* codeMemory; // the Memory this thread is registered with in Memory::addCodeThread
+
+    // takes the memory's pageMutex, another thread might be linking the same block
+    static void linkNextBlock(CPU* cpu, DecodedBlock** link);
+    static void freeRetiredBlock(DecodedBlock* block);
+#endif
+private:
+    U32 getNextBlockAddress();
+
+    NormalReturnPrediction returnStack[NORMAL_RETURN_STACK_SIZE];
+    U32 returnStackPos;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (C) 2016  The BoxedWine Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// Handlers for pairs/runs of ops that NormalCPU::fuseOps combines into a single dispatch.  The first op of the
+// group gets one of these as its pfn, the other ops stay in the list so that eip, logging and exceptions still
+// work one instruction at a time.
+
+// cmp/test + jcc: the lazy flags are still recorded for later readers, but the jump is decided directly from the
+// operands instead of going through the lazy flags
+#define NORMAL_FUSED_JUMP(name, cc, width, dstValue, srcValue, calc, flags, cond) \
+void OPCALL normal_fused_##name##_jump##cc(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    cpu->dst.u##width = dstValue; \
+    cpu->src.u##width = srcValue; \
+    cpu->result.u##width = calc; \
+    cpu->lazyFlags = flags; \
+    cpu->eip.u32 += op->len; \
+    op = op->next; \
+    START_OP(cpu, op); \
+    if (cond) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();} \
+}
+
+#define NORMAL_FUSED_CMP(name, width, dstValue, srcValue) \
+NORMAL_FUSED_JUMP(name, B, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, cpu->dst.u##width < cpu->src.u##width) \
+NORMAL_FUSED_JUMP(name, NB, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, cpu->dst.u##width >= cpu->src.u##width) \
+NORMAL_FUSED_JUMP(name, Z, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, cpu->result.u##width == 0) \
+NORMAL_FUSED_JUMP(name, NZ, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, cpu->result.u##width != 0) \
+NORMAL_FUSED_JUMP(name, BE, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, cpu->dst.u##width <= cpu->src.u##width) \
+NORMAL_FUSED_JUMP(name, NBE, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, cpu->dst.u##width > cpu->src.u##width) \
+NORMAL_FUSED_JUMP(name, S, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, (S##width)cpu->result.u##width < 0) \
+NORMAL_FUSED_JUMP(name, NS, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, (S##width)cpu->result.u##width >= 0) \
+NORMAL_FUSED_JUMP(name, L, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, (S##width)cpu->dst.u##width < (S##width)cpu->src.u##width) \
+NORMAL_FUSED_JUMP(name, NL, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, (S##width)cpu->dst.u##width >= (S##width)cpu->src.u##width) \
+NORMAL_FUSED_JUMP(name, LE, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, (S##width)cpu->dst.u##width <= (S##width)cpu->src.u##width) \
+NORMAL_FUSED_JUMP(name, NLE, width, dstValue, srcValue, cpu->dst.u##width - cpu->src.u##width, FLAGS_CMP##width, (S##width)cpu->dst.u##width > (S##width)cpu->src.u##width)
+
+// test clears CF and OF, so B/NB are not worth fusing and BE/L/LE only look at ZF and SF
+#define NORMAL_FUSED_TEST(name, width, dstValue, srcValue) \
+NORMAL_FUSED_JUMP(name, Z, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, cpu->result.u##width == 0) \
+NORMAL_FUSED_JUMP(name, NZ, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, cpu->result.u##width != 0) \
+NORMAL_FUSED_JUMP(name, BE, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, cpu->result.u##width == 0) \
+NORMAL_FUSED_JUMP(name, NBE, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, cpu->result.u##width != 0) \
+NORMAL_FUSED_JUMP(name, S, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, (S##width)cpu->result.u##width < 0) \
+NORMAL_FUSED_JUMP(name, NS, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, (S##width)cpu->result.u##width >= 0) \
+NORMAL_FUSED_JUMP(name, L, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, (S##width)cpu->result.u##width < 0) \
+NORMAL_FUSED_JUMP(name, NL, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, (S##width)cpu->result.u##width >= 0) \
+NORMAL_FUSED_JUMP(name, LE, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, cpu->result.u##width == 0 || (S##width)cpu->result.u##width < 0) \
+NORMAL_FUSED_JUMP(name, NLE, width, dstValue, srcValue, cpu->dst.u##width & cpu->src.u##width, FLAGS_TEST##width, cpu->result.u##width != 0 && (S##width)cpu->result.u##width >= 0)
+
+NORMAL_FUSED_CMP(cmpr32r32, 32, cpu->reg[op->reg].u32, cpu->reg[op->rm].u32)
+NORMAL_FUSED_CMP(cmpe32r32, 32, readd(eaa(cpu, op)), cpu->reg[op->reg].u32)
+NORMAL_FUSED_CMP(cmpr32e32, 32, cpu->reg[op->reg].u32, readd(eaa(cpu, op)))
+NORMAL_FUSED_CMP(cmp32_reg, 32, cpu->reg[op->reg].u32, op->imm)
+NORMAL_FUSED_CMP(cmp32_mem, 32, readd(eaa(cpu, op)), op->imm)
+NORMAL_FUSED_TEST(testr32r32, 32, cpu->reg[op->reg].u32, cpu->reg[op->rm].u32)
+NORMAL_FUSED_TEST(test32_reg, 32, cpu->reg[op->reg].u32, op->imm)
+
+// mov reg, reg + add reg, imm/reg with the same destination, usually an address calculation
+void OPCALL normal_fused_movr32r32_add32_reg(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->dst.u32 = cpu->reg[op->rm].u32;
+    cpu->eip.u32 += op->len;
+    op = op->next;
+    START_OP(cpu, op);
+    cpu->src.u32 = op->imm;
+    cpu->result.u32 = cpu->dst.u32 + cpu->src.u32;
+    cpu->lazyFlags = FLAGS_ADD32;
+    cpu->reg[op->reg].u32 = cpu->result.u32;
+    NEXT();
+}
+void OPCALL normal_fused_movr32r32_addr32r32(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->dst.u32 = cpu->reg[op->rm].u32;
+    cpu->eip.u32 += op->len;
+    op = op->next;
+    START_OP(cpu, op);
+    cpu->src.u32 = cpu->reg[op->rm].u32;
+    cpu->result.u32 = cpu->dst.u32 + cpu->src.u32;
+    cpu->lazyFlags = FLAGS_ADD32;
+    cpu->reg[op->reg].u32 = cpu->result.u32;
+    NEXT();
+}
+
+// 2 or more push reg/push imm in a row, op->disp holds how many
+void OPCALL normal_fused_push32_run(CPU* cpu, DecodedOp* op) {
+    U32 count = op->disp;
+    while (true) {
+        START_OP(cpu, op);
+        cpu->push32(op->inst == PushR32 ? cpu->reg[op->reg].u32 : op->imm);
+        if (--count == 0) {
+            break;
+        }
+        cpu->eip.u32 += op->len;
+        op = op->next;
+    }
+    NEXT();
+}
+
+// indexed by [FusedJumpSource][jcc - JumpO], NULL if that pair is not fused
+enum FusedJumpSource {
+    FUSED_CMPR32R32,
+    FUSED_CMPE32R32,
+    FUSED_CMPR32E32,
+    FUSED_CMPR32I32,
+    FUSED_CMPE32I32,
+    FUSED_TESTR32R32,
+    FUSED_TESTR32I32,
+    FUSED_JUMP_SOURCE_COUNT
+};
+
+// in jcc order, JumpO through JumpNLE
+#define NORMAL_FUSED_CMP_JUMPS(name) {NULL, NULL, normal_fused_##name##_jumpB, normal_fused_##name##_jumpNB, normal_fused_##name##_jumpZ, normal_fused_##name##_jumpNZ, normal_fused_##name##_jumpBE, normal_fused_##name##_jumpNBE, normal_fused_##name##_jumpS, normal_fused_##name##_jumpNS, NULL, NULL, normal_fused_##name##_jumpL, normal_fused_##name##_jumpNL, normal_fused_##name##_jumpLE, normal_fused_##name##_jumpNLE}
+#define NORMAL_FUSED_TEST_JUMPS(name) {NULL, NULL, NULL, NULL, normal_fused_##name##_jumpZ, normal_fused_##name##_jumpNZ, normal_fused_##name##_jumpBE, normal_fused_##name##_jumpNBE, normal_fused_##name##_jumpS, normal_fused_##name##_jumpNS, NULL, NULL, normal_fused_##name##_jumpL, normal_fused_##name##_jumpNL, normal_fused_##name##_jumpLE, normal_fused_##name##_jumpNLE}
+
+static OpCallback normalFusedJumps[FUSED_JUMP_SOURCE_COUNT][16] = {
+    NORMAL_FUSED_CMP_JUMPS(cmpr32r32),
+    NORMAL_FUSED_CMP_JUMPS(cmpe32r32),
+    NORMAL_FUSED_CMP_JUMPS(cmpr32e32),
+    NORMAL_FUSED_CMP_JUMPS(cmp32_reg),
+    NORMAL_FUSED_CMP_JUMPS(cmp32_mem),
+    NORMAL_FUSED_TEST_JUMPS(testr32r32),
+    NORMAL_FUSED_TEST_JUMPS(test32_reg),
+};
@@ -0,0 +1,332 @@
+/*
+ *  Copyright (C) 2016  The BoxedWine Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// Handlers for lock prefixed read-modify-write instructions (and xchg with memory, which is always locked) when each
+// emulated thread runs on its own host thread.  The memory operand is updated with a host compare and swap so the
+// update can't be lost to another thread.  Operands that are not naturally aligned or that are not on a plain ram
+// page (code pages for example) take normalLockMutex instead, that only makes them atomic with respect to other
+// locked instructions but that is all a guest can count on for split locks anyway.
+//
+// The flags and registers are set exactly the way the unlocked op in normal_arith.h, normal_xchg.h, etc does.
+
+#include <atomic>
+
+static BOXEDWINE_MUTEX normalLockMutex;
+
+template <typename T>
+static inline std::atomic<T>* normal_lockHostAddress(U32 address) {
+    if (address & (sizeof(T) - 1)) {
+        return NULL;
+    }
+    U8* ram = Memory::currentMMUWritePtr[address >> K_PAGE_SHIFT];
+    if (ram) {
+        return (std::atomic<T>*)&ram[address & K_PAGE_MASK];
+    }
+    // will page in on demand and copy on write pages, code pages will return NULL
+    return (std::atomic<T>*)getPhysicalAddress(address, sizeof(T));
+}
+
+static inline void normal_lockRead(U32 address, U8& value) {value = readb(address);}
+static inline void normal_lockRead(U32 address, U16& value) {value = readw(address);}
+static inline void normal_lockRead(U32 address, U32& value) {value = readd(address);}
+static inline void normal_lockRead(U32 address, U64& value) {value = readq(address);}
+static inline void normal_lockWrite(U32 address, U8 value) {writeb(address, value);}
+static inline void normal_lockWrite(U32 address, U16 value) {writew(address, value);}
+static inline void normal_lockWrite(U32 address, U32 value) {writed(address, value);}
+static inline void normal_lockWrite(U32 address, U64 value) {writeq(address, value);}
+
+// calc(value, result) returns false if nothing should be written, it can be called more than once if another thread
+// changes the value.  The value that the result was calculated from is returned.
+template <typename T, typename F>
+static inline T normal_lockUpdate(U32 address, F calc) {
+    std::atomic<T>* p = normal_lockHostAddress<T>(address);
+    T value;
+    T result;
+
+    if (p) {
+        value = p->load();
+        while (calc(value, result) && !p->compare_exchange_weak(value, result)) {
+        }
+        return value;
+    }
+    if (!KThread::currentThread()->memory->isValidWriteAddress(address, sizeof(T))) {
+        // this will fault, don't hold the mutex when it jumps out
+        normal_lockRead(address, value);
+        if (calc(value, result)) {
+            normal_lockWrite(address, result);
+        }
+        return value;
+    }
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(normalLockMutex);
+    normal_lockRead(address, value);
+    if (calc(value, result)) {
+        normal_lockWrite(address, result);
+    }
+    return value;
+}
+
+#define NORMAL_LOCK_ARITH(name, width, srcValue, calc, flags, usesCF) \
+void OPCALL normal_##name(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U32 address = eaa(cpu, op); \
+    U##width s = srcValue; \
+    U32 c = 0; \
+    if (usesCF) { \
+        cpu->oldCF = cpu->getCF(); \
+        c = cpu->oldCF; \
+    } \
+    U##width d = normal_lockUpdate<U##width>(address, [s, c](U##width d, U##width& result) {result = (U##width)(calc); return true;}); \
+    cpu->dst.u##width = d; \
+    cpu->src.u##width = s; \
+    cpu->result.u##width = (U##width)(calc); \
+    cpu->lazyFlags = flags; \
+    NEXT(); \
+}
+
+#define NORMAL_LOCK_ARITH_ALL(name, calc, usesCF, FLAGS8, FLAGS16, FLAGS32) \
+NORMAL_LOCK_ARITH(name##e8r8, 8, *cpu->reg8[op->reg], calc, FLAGS8, usesCF) \
+NORMAL_LOCK_ARITH(name##8_mem, 8, (U8)op->imm, calc, FLAGS8, usesCF) \
+NORMAL_LOCK_ARITH(name##e16r16, 16, cpu->reg[op->reg].u16, calc, FLAGS16, usesCF) \
+NORMAL_LOCK_ARITH(name##16_mem, 16, (U16)op->imm, calc, FLAGS16, usesCF) \
+NORMAL_LOCK_ARITH(name##e32r32, 32, cpu->reg[op->reg].u32, calc, FLAGS32, usesCF) \
+NORMAL_LOCK_ARITH(name##32_mem, 32, op->imm, calc, FLAGS32, usesCF)
+
+NORMAL_LOCK_ARITH_ALL(lock_add, d + s, false, FLAGS_ADD8, FLAGS_ADD16, FLAGS_ADD32)
+NORMAL_LOCK_ARITH_ALL(lock_or, d | s, false, FLAGS_OR8, FLAGS_OR16, FLAGS_OR32)
+NORMAL_LOCK_ARITH_ALL(lock_adc, d + s + c, true, FLAGS_ADC8, FLAGS_ADC16, FLAGS_ADC32)
+NORMAL_LOCK_ARITH_ALL(lock_sbb, d - s - c, true, FLAGS_SBB8, FLAGS_SBB16, FLAGS_SBB32)
+NORMAL_LOCK_ARITH_ALL(lock_and, d & s, false, FLAGS_AND8, FLAGS_AND16, FLAGS_AND32)
+NORMAL_LOCK_ARITH_ALL(lock_sub, d - s, false, FLAGS_SUB8, FLAGS_SUB16, FLAGS_SUB32)
+NORMAL_LOCK_ARITH_ALL(lock_xor, d ^ s, false, FLAGS_XOR8, FLAGS_XOR16, FLAGS_XOR32)
+
+#define NORMAL_LOCK_INCDEC(name, width, calc, flags) \
+void OPCALL normal_##name(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U32 address = eaa(cpu, op); \
+    cpu->oldCF = cpu->getCF(); \
+    U##width d = normal_lockUpdate<U##width>(address, [](U##width d, U##width& result) {result = (U##width)(calc); return true;}); \
+    cpu->dst.u##width = d; \
+    cpu->result.u##width = (U##width)(calc); \
+    cpu->lazyFlags = flags; \
+    NEXT(); \
+}
+
+NORMAL_LOCK_INCDEC(lock_inc8_mem32, 8, d + 1, FLAGS_INC8)
+NORMAL_LOCK_INCDEC(lock_inc16_mem32, 16, d + 1, FLAGS_INC16)
+NORMAL_LOCK_INCDEC(lock_inc32_mem32, 32, d + 1, FLAGS_INC32)
+NORMAL_LOCK_INCDEC(lock_dec8_mem32, 8, d - 1, FLAGS_DEC8)
+NORMAL_LOCK_INCDEC(lock_dec16_mem32, 16, d - 1, FLAGS_DEC16)
+NORMAL_LOCK_INCDEC(lock_dec32_mem32, 32, d - 1, FLAGS_DEC32)
+
+#define NORMAL_LOCK_NOT(width) \
+void OPCALL normal_lock_note##width(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    normal_lockUpdate<U##width>(eaa(cpu, op), [](U##width d, U##width& result) {result = ~d; return true;}); \
+    NEXT(); \
+}
+
+NORMAL_LOCK_NOT(8)
+NORMAL_LOCK_NOT(16)
+NORMAL_LOCK_NOT(32)
+
+#define NORMAL_LOCK_NEG(width) \
+void OPCALL normal_lock_nege##width(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U##width s = normal_lockUpdate<U##width>(eaa(cpu, op), [](U##width d, U##width& result) {result = (U##width)(0 - d); return true;}); \
+    cpu->dst.u##width = 0; \
+    cpu->src.u##width = s; \
+    cpu->result.u##width = (U##width)(0 - s); \
+    cpu->lazyFlags = FLAGS_NEG##width; \
+    NEXT(); \
+}
+
+NORMAL_LOCK_NEG(8)
+NORMAL_LOCK_NEG(16)
+NORMAL_LOCK_NEG(32)
+
+#define NORMAL_LOCK_XCHG(width, reg) \
+void OPCALL normal_lock_xchge##width##r##width(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U##width s = reg; \
+    reg = normal_lockUpdate<U##width>(eaa(cpu, op), [s](U##width d, U##width& result) {result = s; return true;}); \
+    NEXT(); \
+}
+
+NORMAL_LOCK_XCHG(8, *cpu->reg8[op->reg])
+NORMAL_LOCK_XCHG(16, cpu->reg[op->reg].u16)
+NORMAL_LOCK_XCHG(32, cpu->reg[op->reg].u32)
+
+#define NORMAL_LOCK_XADD(width, reg) \
+void OPCALL normal_lock_xaddr##width##e##width(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U##width s = reg; \
+    U##width d = normal_lockUpdate<U##width>(eaa(cpu, op), [s](U##width d, U##width& result) {result = (U##width)(d + s); return true;}); \
+    cpu->src.u##width = s; \
+    cpu->dst.u##width = d; \
+    cpu->result.u##width = (U##width)(d + s); \
+    cpu->lazyFlags = FLAGS_ADD##width; \
+    reg = d; \
+    NEXT(); \
+}
+
+NORMAL_LOCK_XADD(8, *cpu->reg8[op->reg])
+NORMAL_LOCK_XADD(16, cpu->reg[op->reg].u16)
+NORMAL_LOCK_XADD(32, cpu->reg[op->reg].u32)
+
+#define NORMAL_LOCK_CMPXCHG(width, accumulator, reg) \
+void OPCALL normal_lock_cmpxchge##width##r##width(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U##width a = accumulator; \
+    U##width s = reg; \
+    U##width d = normal_lockUpdate<U##width>(eaa(cpu, op), [a, s](U##width d, U##width& result) {result = s; return d == a;}); \
+    cpu->dst.u##width = a; \
+    cpu->src.u##width = d; \
+    cpu->result.u##width = (U##width)(a - d); \
+    cpu->lazyFlags = FLAGS_CMP##width; \
+    if (a != d) { \
+        accumulator = d; \
+    } \
+    NEXT(); \
+}
+
+NORMAL_LOCK_CMPXCHG(8, AL, *cpu->reg8[op->reg])
+NORMAL_LOCK_CMPXCHG(16, AX, cpu->reg[op->reg].u16)
+NORMAL_LOCK_CMPXCHG(32, EAX, cpu->reg[op->reg].u32)
+
+void OPCALL normal_lock_cmpxchgg8b(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U64 a = ((U64)EDX) << 32 | EAX;
+    U64 s = ((U64)ECX) << 32 | EBX;
+    U64 d = normal_lockUpdate<U64>(eaa(cpu, op), [a, s](U64 d, U64& result) {result = s; return d == a;});
+    cpu->fillFlags();
+    if (a == d) {
+        cpu->addZF();
+    } else {
+        cpu->removeZF();
+        EDX = (U32)(d >> 32);
+        EAX = (U32)d;
+    }
+    NEXT();
+}
+
+// same address as eaa_bit in common_bit.cpp
+static inline U32 normal_lockBitAddress(CPU* cpu, DecodedOp* op, U32 offset) {
+    if (op->ea16) {
+        return cpu->seg[op->base].address + (U16)(cpu->reg[op->rm].u16 + (S16)cpu->reg[op->sibIndex].u16 + op->disp + offset);
+    }
+    return cpu->seg[op->base].address + cpu->reg[op->rm].u32 + (cpu->reg[op->sibIndex].u32 << op->sibScale) + op->disp + offset;
+}
+
+#define NORMAL_LOCK_BIT(name, calc) \
+void OPCALL normal_##name##e16r16(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U16 mask = 1 << (cpu->reg[op->reg].u16 & 15); \
+    U32 address = normal_lockBitAddress(cpu, op, (((S16)cpu->reg[op->reg].u16) >> 4) * 2); \
+    cpu->fillFlagsNoCF(); \
+    U16 value = normal_lockUpdate<U16>(address, [mask](U16 d, U16& result) {result = (U16)(calc); return true;}); \
+    cpu->setCF(value & mask); \
+    NEXT(); \
+} \
+void OPCALL normal_##name##e16(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U16 mask = (U16)op->imm; \
+    cpu->fillFlagsNoCF(); \
+    U16 value = normal_lockUpdate<U16>(eaa(cpu, op), [mask](U16 d, U16& result) {result = (U16)(calc); return true;}); \
+    cpu->setCF(value & mask); \
+    NEXT(); \
+} \
+void OPCALL normal_##name##e32r32(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U32 mask = 1 << (cpu->reg[op->reg].u32 & 31); \
+    U32 address = normal_lockBitAddress(cpu, op, (((S32)cpu->reg[op->reg].u32) >> 5) * 4); \
+    cpu->fillFlagsNoCF(); \
+    U32 value = normal_lockUpdate<U32>(address, [mask](U32 d, U32& result) {result = calc; return true;}); \
+    cpu->setCF(value & mask); \
+    NEXT(); \
+} \
+void OPCALL normal_##name##e32(CPU* cpu, DecodedOp* op) { \
+    START_OP(cpu, op); \
+    U32 mask = op->imm; \
+    cpu->fillFlagsNoCF(); \
+    U32 value = normal_lockUpdate<U32>(eaa(cpu, op), [mask](U32 d, U32& result) {result = calc; return true;}); \
+    cpu->setCF(value & mask); \
+    NEXT(); \
+}
+
+NORMAL_LOCK_BIT(lock_bts, d | mask)
+NORMAL_LOCK_BIT(lock_btr, d & ~mask)
+NORMAL_LOCK_BIT(lock_btc, d ^ mask)
+
+#define NORMAL_LOCK_ARITH_INIT(Name, name) \
+    normalLockedOps[Name##E8R8] = normal_##name##e8r8; \
+    normalLockedOps[Name##E8I8] = normal_##name##8_mem; \
+    normalLockedOps[Name##E16R16] = normal_##name##e16r16; \
+    normalLockedOps[Name##E16I16] = normal_##name##16_mem; \
+    normalLockedOps[Name##E32R32] = normal_##name##e32r32; \
+    normalLockedOps[Name##E32I32] = normal_##name##32_mem;
+
+#define NORMAL_LOCK_BIT_INIT(Name, name) \
+    normalLockedOps[Name##E16R16] = normal_##name##e16r16; \
+    normalLockedOps[Name##E16] = normal_##name##e16; \
+    normalLockedOps[Name##E32R32] = normal_##name##e32r32; \
+    normalLockedOps[Name##E32] = normal_##name##e32;
+
+static OpCallback normalLockedOps[NUMBER_OF_OPS];
+
+static void initNormalLockedOps() {
+    NORMAL_LOCK_ARITH_INIT(Add, lock_add)
+    NORMAL_LOCK_ARITH_INIT(Or, lock_or)
+    NORMAL_LOCK_ARITH_INIT(Adc, lock_adc)
+    NORMAL_LOCK_ARITH_INIT(Sbb, lock_sbb)
+    NORMAL_LOCK_ARITH_INIT(And, lock_and)
+    NORMAL_LOCK_ARITH_INIT(Sub, lock_sub)
+    NORMAL_LOCK_ARITH_INIT(Xor, lock_xor)
+    normalLockedOps[IncE8] = normal_lock_inc8_mem32;
+    normalLockedOps[IncE16] = normal_lock_inc16_mem32;
+    normalLockedOps[IncE32] = normal_lock_inc32_mem32;
+    normalLockedOps[DecE8] = normal_lock_dec8_mem32;
+    normalLockedOps[DecE16] = normal_lock_dec16_mem32;
+    normalLockedOps[DecE32] = normal_lock_dec32_mem32;
+    normalLockedOps[NotE8] = normal_lock_note8;
+    normalLockedOps[NotE16] = normal_lock_note16;
+    normalLockedOps[NotE32] = normal_lock_note32;
+    normalLockedOps[NegE8] = normal_lock_nege8;
+    normalLockedOps[NegE16] = normal_lock_nege16;
+    normalLockedOps[NegE32] = normal_lock_nege32;
+    normalLockedOps[XchgE8R8] = normal_lock_xchge8r8;
+    normalLockedOps[XchgE16R16] = normal_lock_xchge16r16;
+    normalLockedOps[XchgE32R32] = normal_lock_xchge32r32;
+    normalLockedOps[XaddR8E8] = normal_lock_xaddr8e8;
+    normalLockedOps[XaddR16E16] = normal_lock_xaddr16e16;
+    normalLockedOps[XaddR32E32] = normal_lock_xaddr32e32;
+    normalLockedOps[CmpXchgE8R8] = normal_lock_cmpxchge8r8;
+    normalLockedOps[CmpXchgE16R16] = normal_lock_cmpxchge16r16;
+    normalLockedOps[CmpXchgE32R32] = normal_lock_cmpxchge32r32;
+    normalLockedOps[CmpXchg8b] = normal_lock_cmpxchgg8b;
+    NORMAL_LOCK_BIT_INIT(Bts, lock_bts)
+    NORMAL_LOCK_BIT_INIT(Btr, lock_btr)
+    NORMAL_LOCK_BIT_INIT(Btc, lock_btc)
+}
+
+// xchg with a memory operand is locked even without the prefix
+static OpCallback getLockedOp(DecodedOp* op) {
+    if (op->lock || op->inst == XchgE8R8 || op->inst == XchgE16R16 || op->inst == XchgE32R32) {
+        return normalLockedOps[op->inst];
+    }
+    return NULL;
+}
@@ -0,0 +1,25 @@
+/*
+ *  Copyright (C) 2016  The BoxedWine Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "../decode_noflags.h"
+
+// the normal core versions of the ops in decode_noflags.h, NormalCPU::optimizeFlags switches an op to one of these
+// when nothing reads the flags it would set
+#define INIT_CPU(e, f) void OPCALL normal_##f(CPU* cpu, DecodedOp* op) { START_OP(cpu, op); f(cpu, op); NEXT(); }
+#include "../common/cpu_init_noflags.h"
+#undef INIT_CPU
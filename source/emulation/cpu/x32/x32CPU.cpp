@@ -13,8 +13,8 @@
 
 #define INCREMENT_EIP(x, y) incrementEip(x, y)
 
-#define OFFSET_REG8(x) (x>=4?offsetof(CPU, reg[x-4].h8):offsetof(CPU, reg[x].u8))
-#define CPU_OFFSET_OF(x) offsetof(CPU, x)
+#define CPU_OFFSET_OF(x) ((U32)(size_t)&(((CPU*)0)->x))
+#define OFFSET_REG8(x) (x>=4?CPU_OFFSET_OF(reg[x-4].h8):CPU_OFFSET_OF(reg[x].u8))
 
 // DynReg is a required type, but the values inside are local to this file
 // Used only these 4 because it is possible to use 8-bit calls with them, like add al, cl
@@ -247,7 +247,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
             outb(0x66);
             outb(0x03);
             outb(0x47 | (reg << 3));
-            outb(offsetof(CPU, reg[op->rm].u16));
+            outb(CPU_OFFSET_OF(reg[op->rm].u16));
         }
 
         // add ax, [cpu->reg[op->sibIndex].u16]
@@ -255,7 +255,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
             outb(0x66);
             outb(0x03);
             outb(0x47 | (reg << 3));
-            outb(offsetof(CPU, reg[op->sibIndex].u16));
+            outb(CPU_OFFSET_OF(reg[op->sibIndex].u16));
         }
 
         // seg[6] is always 0
@@ -263,7 +263,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
             // add eax, [cpu->seg[op->base].address]
             outb(0x03);
             outb(0x47 | (reg << 3));
-            outb(offsetof(CPU, seg[op->base].address));
+            outb(CPU_OFFSET_OF(seg[op->base].address));
         }
     } else {
         // cpu->seg[op->base].address + cpu->reg[op->rm].u32 + (cpu->reg[op->sibIndex].u32 << + op->sibScale) + op->disp
@@ -274,7 +274,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
             // mov eax, [cpu->reg[op->sibIndex].u32];
             outb(0x8b);
             outb(0x47 | (reg << 3));
-            outb(offsetof(CPU, reg[op->sibIndex].u32));
+            outb(CPU_OFFSET_OF(reg[op->sibIndex].u32));
 
             if (op->sibScale) {                
                 // shl eax, op->sibScale
@@ -292,7 +292,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
                 // add eax, [cpu->seg[op->base].address]
                 outb(0x03);
                 outb(0x47 | (reg << 3));
-                outb(offsetof(CPU, seg[op->base].address));
+                outb(CPU_OFFSET_OF(seg[op->base].address));
             }
         } else {
             // seg[6] is always 0
@@ -301,7 +301,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
                 // mov eax, [cpu->seg[op->base].address]
                 outb(0x8b);
                 outb(0x47 | (reg << 3));
-                outb(offsetof(CPU, seg[op->base].address));
+                outb(CPU_OFFSET_OF(seg[op->base].address));
             }
         }
         // add eax, [cpu->reg[op->rm].u32]
@@ -313,7 +313,7 @@ void calculateEaa(DecodedOp* op, DynReg reg) {
                 outb(0x03); // add
             }
             outb(0x47 | (reg << 3));
-            outb(offsetof(CPU, reg[op->rm].u32));
+            outb(CPU_OFFSET_OF(reg[op->rm].u32));
         }
 
         // add eax, op->disp 
@@ -673,11 +673,11 @@ void movFromMem(DynWidth width, DynReg addressReg, bool doneWithAddressReg) {
 
     // call read
     if (width == DYN_32bit) {
-        address = readd;
+        address = (void*)readd;
     } else if (width == DYN_16bit) {
-        address = readw;
+        address = (void*)readw;
     } else if (width == DYN_8bit) {
-        address = readb;
+        address = (void*)readb;
     } else {
         kpanic("unknown width in x32CPU::movFromMem %d", width);
     }
@@ -1055,11 +1055,11 @@ void movToMem(DynReg addressReg, DynWidth width, U32 value, DynCallParamType par
 
     // call write
     if (width == DYN_32bit) {
-        address = writed;        
+        address = (void*)writed;        
     } else if (width == DYN_16bit) {
-        address = writew;
+        address = (void*)writew;
     } else if (width == DYN_8bit) {
-        address = writeb;
+        address = (void*)writeb;
     } else {
         kpanic("unknown width in x32CPU::movToMem %d", width);
     }    
@@ -2018,7 +2018,7 @@ void incrementEip(DynamicData* data, U32 len) {
 
 void blockDone() {
     // cpu->nextBlock = cpu->getNextBlock();
-    callHostFunction(common_getNextBlock, true, 1, 0, DYN_PARAM_CPU, false);
+    callHostFunction((void*)common_getNextBlock, true, 1, 0, DYN_PARAM_CPU, false);
     movToCpuFromReg(offsetof(CPU, nextBlock), DYN_CALL_RESULT, DYN_32bit, true);
     outb(0x5f); // pop edi
     outb(0x5b); // pop ebx
@@ -2063,7 +2063,7 @@ void blockNext1() {
     U32 pos = outBufferPos;
     outb(0);
     
-    callHostFunction(updateNext1, true, 1, 0, DYN_PARAM_CPU);
+    callHostFunction((void*)updateNext1, true, 1, 0, DYN_PARAM_CPU);
 
     outBuffer[pos] = (U8)(outBufferPos-pos-1);
 
@@ -2109,7 +2109,7 @@ void blockNext2() {
     U32 pos = outBufferPos;
     outb(1);
     
-    callHostFunction(updateNext2, true, 1, 0, DYN_PARAM_CPU);
+    callHostFunction((void*)updateNext2, true, 1, 0, DYN_PARAM_CPU);
 
     outBuffer[pos] = (U8)(outBufferPos-pos-1);
 
@@ -2126,7 +2126,7 @@ void x32_onExitSignal(CPU* cpu) {
 
 void x32_callback(DynamicData* data, DecodedOp* op) {
     if (op->pfn == onExitSignal) {
-        callHostFunction(x32_onExitSignal, false, 1, 0, DYN_PARAM_CPU);
+        callHostFunction((void*)x32_onExitSignal, false, 1, 0, DYN_PARAM_CPU);
     } else {
         kpanic("x32CPU::x32_callback unhandled callback");
     }
@@ -2201,10 +2201,19 @@ void OPCALL firstDynamicOp(CPU* cpu, DecodedOp* op) {
         patch.clear();
         outb(0x53); // push ebx
         outb(0x57); // push edi , will hold cpu
+#ifdef BOXEDWINE_MSVC
         // on win32 ecx contains cpu
         // mov edi, ecx
         outb(0x89);
         outb(0xcf);
+#else
+        // OPCALL is cdecl here, so cpu is the first arg on the stack, after the return address and the 2 pushes
+        // mov edi, [esp+12]
+        outb(0x8b);
+        outb(0x7c);
+        outb(0x24);
+        outb(0x0c);
+#endif
         while (o) {
             memset(regUsed, 0, sizeof(regUsed));
 #ifndef __TEST
@@ -34,6 +34,8 @@
 #define CPU_OFFSET_FPU_STATE (U32)(offsetof(x64CPU, fpuState))
 #define CPU_OFFSET_RETURN_HOST_ADDRESS (U32)(offsetof(x64CPU, returnHostAddress))
 #define CPU_OFFSET_RETRANSLATE_CHUNK_ADDRESS (U32)(offsetof(x64CPU, reTranslateChunkAddress))
+#define CPU_OFFSET_FORM_TRACE_ADDRESS (U32)(offsetof(x64CPU, formTraceAddress))
+#define CPU_OFFSET_TRACE_LINK_SLOT (U32)(offsetof(x64CPU, traceLinkSlot))
 #define CPU_OFFSET_JMP_AND_TRANSLATE_IF_NECESSARY (U32)(offsetof(x64CPU, jmpAndTranslateIfNecessary))
 #define CPU_MEMOFFSET (U32)(offsetof(BtCPU, memOffsets))
 
@@ -260,6 +262,12 @@ void X64Asm::writeToRegFromValue(U8 reg, bool isRexReg, U64 value, U8 bytes) {
     }
 }
 
+// the address is recorded so that BtCodeCache can relocate it when the code is loaded by another run of Boxedwine
+void X64Asm::writeToRegFromHostAddress(U8 reg, bool isRexReg, const void* address) {
+    writeToRegFromValue(reg, isRexReg, (U64)address, 8);
+    this->hostAddressRelocations.push_back(this->bufferPos - 8);
+}
+
 void X64Asm::writeHostPlusTmp(U8 rm, bool checkG, bool isG8bit, bool isE8bit, U8 tmpReg, bool calculateHostAddress) {
     this->rex |= REX_BASE | REX_SIB_INDEX|REX_MOD_RM;    
     setRM(rm, checkG, false, isG8bit, isE8bit);
@@ -1527,7 +1535,13 @@ void X64Asm::minSyncRegsToHost() {
 #endif
 }
 
-void X64Asm::syncRegsFromHost(bool eipInR9) {    
+void X64Asm::syncRegsFromHost(bool eipInR9) {
+    syncRegsBeforeHostCall(SYNC_ALL, eipInR9);
+}
+
+void X64Asm::syncRegsBeforeHostCall(U32 reads, bool eipInR9) {
+    U32 regs = reads | SYNC_HOST_VOLATILE;
+
     if (eipInR9) {
 #ifdef _DEBUG
         writeToMemFromReg(1, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP_FROM, 4, false);
@@ -1536,14 +1550,15 @@ void X64Asm::syncRegsFromHost(bool eipInR9) {
     } else {
         writeToMemFromValue(this->startOfOpIp, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP, 4, false);
     }
-    writeToMemFromReg(0, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EAX, 4, false);
-    writeToMemFromReg(1, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_ECX, 4, false);
-    writeToMemFromReg(2, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EDX, 4, false);
-    writeToMemFromReg(3, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EBX, 4, false);
-    writeToMemFromReg(HOST_ESP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_ESP, 4, false);
-    writeToMemFromReg(5, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EBP, 4, false);
-    writeToMemFromReg(6, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_ESI, 4, false);
-    writeToMemFromReg(7, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EDI, 4, false);
+    for (U8 i = 0; i < 8; i++) {
+        if (regs & SYNC_REG(i)) {
+            if (i == 4) {
+                writeToMemFromReg(HOST_ESP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_ESP, 4, false);
+            } else {
+                writeToMemFromReg(i, false, HOST_CPU, true, -1, false, 0, (U32)(offsetof(CPU, reg[0].u32) + i * sizeof(Reg)), 4, false);
+            }
+        }
+    }
     U8 tmpReg = getTmpReg();
     pushNativeFlags();
     popNativeReg(tmpReg, true);
@@ -1561,27 +1576,28 @@ void X64Asm::syncRegsFromHost(bool eipInR9) {
 }
 
 void X64Asm::syncRegsToHost(S8 excludeReg) {
-    if (excludeReg!=0)
-        writeToRegFromMem(0, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EAX, 4, false);
-    if (excludeReg!=1)
-        writeToRegFromMem(1, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_ECX, 4, false);
-    if (excludeReg!=2)
-        writeToRegFromMem(2, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EDX, 4, false);
-    if (excludeReg!=3)
-        writeToRegFromMem(3, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EBX, 4, false);
-    if (excludeReg!=4)
-        writeToRegFromMem(HOST_ESP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_ESP, 4, false);
-    if (excludeReg!=5)
-        writeToRegFromMem(5, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EBP, 4, false);
-    if (excludeReg!=6)
-        writeToRegFromMem(6, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_ESI, 4, false);
-    if (excludeReg!=7)
-        writeToRegFromMem(7, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EDI, 4, false);
+    syncRegsAfterHostCall(SYNC_ALL, excludeReg);
+}
 
-    if (KSystem::useLargeAddressSpace) {
-        writeToRegFromMem(HOST_LARGE_ADDRESS_SPACE_MAPPING, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP_HOST_MAPPING, 8, false);
-    } else {
-        writeToRegFromMem(HOST_SMALL_ADDRESS_SPACE_SS, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_SS_ADDRESS, 4, false);
+void X64Asm::syncRegsAfterHostCall(U32 writes, S8 excludeReg) {
+    U32 regs = writes | SYNC_HOST_VOLATILE;
+
+    for (U8 i = 0; i < 8; i++) {
+        if ((regs & SYNC_REG(i)) && excludeReg != i) {
+            if (i == 4) {
+                writeToRegFromMem(HOST_ESP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_ESP, 4, false);
+            } else {
+                writeToRegFromMem(i, false, HOST_CPU, true, -1, false, 0, (U32)(offsetof(CPU, reg[0].u32) + i * sizeof(Reg)), 4, false);
+            }
+        }
+    }
+
+    if (regs & SYNC_SEGS) {
+        if (KSystem::useLargeAddressSpace) {
+            writeToRegFromMem(HOST_LARGE_ADDRESS_SPACE_MAPPING, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP_HOST_MAPPING, 8, false);
+        } else {
+            writeToRegFromMem(HOST_SMALL_ADDRESS_SPACE_SS, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_SS_ADDRESS, 4, false);
+        }
     }
     //writeToRegFromMem(HOST_DS, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_DS_ADDRESS, 4, false);
 
@@ -1625,7 +1641,7 @@ void X64Asm::callHost(void* pfn) {
     write8(0x74);
     U32 pos = this->bufferPos;
     write8(0);
-    writeToRegFromValue(tmp, true, (U64)badStack, 8);
+    writeToRegFromHostAddress(tmp, true, (void*)badStack);
     write8(REX_BASE | REX_64);
     write8(0x83);
     write8(0xEC);
@@ -1640,7 +1656,7 @@ void X64Asm::callHost(void* pfn) {
 
     write8(0xfc); // cld
 
-    writeToRegFromValue(tmp, true, (U64)pfn, 8);
+    writeToRegFromHostAddress(tmp, true, pfn);
 
 #ifdef BOXEDWINE_MSVC
     // part of the x64 windows ABI, shadow store
@@ -1671,21 +1687,37 @@ void X64Asm::callHost(void* pfn) {
     unlockParamReg(PARAM_4_REG, PARAM_4_REX);
 }
 
-void X64Asm::doIf(U8 reg, bool isRexReg, U32 equalsValue, std::function<void(void)> ifBlock, std::function<void(void)> elseBlock) {
+void X64Asm::cmpRegToValue(U8 reg, bool isRexReg, U32 value) {
     // cmp reg, value
     if (isRexReg)
         write8(REX_BASE | REX_MOD_RM);
-    if (equalsValue>255) {
+    if (value>255) {
         write8(0x81);
     } else {
         write8(0x83);
     }
     write8(0xf8 | reg);
-    if (equalsValue>255) {
-        write32(equalsValue);
+    if (value>255) {
+        write32(value);
     } else {
-        write8((U8)equalsValue);
+        write8((U8)value);
     }
+}
+
+void X64Asm::doIfCold(U8 reg, bool isRexReg, U32 equalsValue, std::function<void(void)> ifBlock, std::function<void(void)> elseBlock) {
+    if (!canUseColdCode()) {
+        doIf(reg, isRexReg, equalsValue, ifBlock, elseBlock);
+        return;
+    }
+    cmpRegToValue(reg, isRexReg, equalsValue);
+    jumpToColdCode(4); // jz
+    ifBlock();
+    endColdCode();
+    elseBlock();
+}
+
+void X64Asm::doIf(U8 reg, bool isRexReg, U32 equalsValue, std::function<void(void)> ifBlock, std::function<void(void)> elseBlock) {
+    cmpRegToValue(reg, isRexReg, equalsValue);
     // jz 
     write8(0x74);    
     U32 pos = this->bufferPos;
@@ -1742,7 +1774,7 @@ void X64Asm::popSeg(U8 seg, U8 bytes) {
 
     callHost((void*)common_setSegment);
     
-    doIf(0, false, 0, [this]() {
+    doIfCold(0, false, 0, [this]() {
         syncRegsToHost();
         doJmp(true);
     }, [this, bytes]() {
@@ -1773,7 +1805,7 @@ void X64Asm::setSeg(U8 seg, U8 rm) {
 
     callHost((void*)common_setSegment);
     
-    doIf(0, false, 0, [this]() {
+    doIfCold(0, false, 0, [this]() {
         syncRegsToHost();
         doJmp(true);
     }, [this]() {
@@ -1866,6 +1898,7 @@ void X64Asm::setPF_onAL(U8 flagReg) {
     write8(REX_BASE | REX_64 | REX_MOD_RM);
     write8(0xb8+tmpReg);
     write64((U64)parity_lookup);
+    this->hostAddressRelocations.push_back(this->bufferPos - 8);
     
     // or HOST_TMPb, byte ptr [HOST_TMP2]
     write8(REX_BASE | REX_MOD_REG | REX_MOD_RM);
@@ -2213,7 +2246,12 @@ void X64Asm::popA32() {
 }
 
 void X64Asm::jumpConditional(U8 condition, U32 eip) {    
-    if (this->stopAfterInstruction!=(S32)this->ipAddressCount && (this->calculatedEipLen==0 || (eip>=this->startOfDataIp && eip<this->startOfDataIp+this->calculatedEipLen))) {
+    if (this->singlePass) {
+        write8(0x0F);
+        write8(0x80+condition);
+        write32(0);
+        this->jumpRelocations.push_back(BtJumpRelocation(eip, this->bufferPos - 4, true));
+    } else if (this->stopAfterInstruction!=(S32)this->ipAddressCount && (this->calculatedEipLen==0 || (eip>=this->startOfDataIp && eip<this->startOfDataIp+this->calculatedEipLen))) {
         write8(0x0F);
         write8(0x80+condition);
         write32(0);
@@ -2237,30 +2275,103 @@ void X64Asm::jumpTo(U32 eip) {
 #endif
     // :TODO: is this necessary?  who uses it?
     this->writeToMemFromValue(eip, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP, 4, false);
-    if (this->stopAfterInstruction!=(S32)this->ipAddressCount && (this->calculatedEipLen==0 || (eip>=this->startOfDataIp && eip<this->startOfDataIp+this->calculatedEipLen))) {
+    if (this->singlePass) {
+        write8(0xE9);
+        write32(0);
+        this->jumpRelocations.push_back(BtJumpRelocation(eip, this->bufferPos - 4, false));
+    } else if (this->stopAfterInstruction!=(S32)this->ipAddressCount && (this->calculatedEipLen==0 || (eip>=this->startOfDataIp && eip<this->startOfDataIp+this->calculatedEipLen))) {
         write8(0xE9);
         write32(0);
         addTodoLinkJump(eip, 4, true);
     } else {
-        // when a chunk gets modified/replaced other chunks that point to it via this jump need to get updated
-        // it is not possible to modify the executable code directly in an atomic way, so instead of embedding
-        // where we will jump directly into the instruction, we will encode an instruction that reads the jump
-        // address from memory (data).  That memory location can be atomically updated.
-        if (0) {
-            // this can result in random crashes, but it gives about a 5% boost, maybe in the future I can figure out when to use it
-            write8(0xE9);
-            write32(0);
-            addTodoLinkJump(eip, 4, false);
-        } else {
-            writeToRegFromValue(HOST_TMP, true, 0x0101010101010101l, 8);
-            write8(0x41);
-            write8(0xff);
-            write8(0x20 | HOST_TMP);
-            addTodoLinkJump(eip, 8, false);
+        jumpThroughLink(eip);
+    }
+}
+
+void X64Asm::jumpThroughLink(U32 eip) {
+    // when a chunk gets modified/replaced other chunks that point to it via this jump need to get updated
+    // it is not possible to modify the executable code directly in an atomic way, so instead of embedding
+    // where we will jump directly into the instruction, we will encode an instruction that reads the jump
+    // address from memory (data).  That memory location can be atomically updated.
+    if (0) {
+        // this can result in random crashes, but it gives about a 5% boost, maybe in the future I can figure out when to use it
+        write8(0xE9);
+        write32(0);
+        addTodoLinkJump(eip, 4, false);
+    } else if (KSystem::btTraceThreshold && this->singlePass && !this->dynamic && this->cpu->isBig()) {
+        // counts down BtCodeChunkLink::traceCount, HOST_TMP will point to the link's toHostInstruction
+        writeToRegFromValue(HOST_TMP, true, 0x0101010101010101l, 8);
+        this->todoJump.push_back(TodoJump(eip, this->bufferPos - 8, 8, false, this->ipAddressCount));
+        pushNativeFlags();
+        // sub dword [HOST_TMP+disp8], 1
+        write8(REX_BASE | REX_MOD_RM);
+        write8(0x83);
+        write8(0x68 | HOST_TMP);
+        write8((U8)(offsetof(BtCodeChunkLink, traceCount) - offsetof(BtCodeChunkLink, toHostInstruction)));
+        write8(1);
+        // jz formTrace
+        write8(0x74);
+        U32 pos = this->bufferPos;
+        write8(0);
+        popNativeFlags();
+        write8(0x41);
+        write8(0xff);
+        write8(0x20 | HOST_TMP);
+        // formTrace:
+        this->buffer[pos] = (U8)(this->bufferPos - pos - 1);
+        popNativeFlags();
+        writeToMemFromReg(HOST_TMP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_TRACE_LINK_SLOT, 8, false);
+        writeToRegFromMem(HOST_TMP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_FORM_TRACE_ADDRESS, 8, false);
+        jmpNativeReg(HOST_TMP, true);
+    } else {
+        writeToRegFromValue(HOST_TMP, true, 0x0101010101010101l, 8);
+        write8(0x41);
+        write8(0xff);
+        write8(0x20 | HOST_TMP);
+        addTodoLinkJump(eip, 8, false);
+    }
+}
+
+// Jumps to instructions in this chunk go straight there.  The others go to a link after the last instruction, a jump
+// that isn't taken costs nothing extra that way and the instruction itself stays small.
+void X64Asm::resolveJumpRelocations() {
+    for (auto& relocation : this->jumpRelocations) {
+        U32 eip = relocation.eip;
+        if (!this->cpu->isBig()) {
+            eip = eip & 0xffff;
+        }
+        S32 target = getBufferPos(this->cpu->seg[CS].address + eip);
+        if (target < 0) {
+            target = (S32)this->bufferPos;
+            if (relocation.conditional) {
+                this->writeToMemFromValue(eip, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP, 4, false);
+            }
+            jumpThroughLink(eip);
         }
+        write32Buffer(this->buffer + relocation.bufferPos, (U32)(target - (S32)(relocation.bufferPos + 4)));
+    }
+    this->jumpRelocations.clear();
+    if (this->coldBufferPos) {
+        U32 coldStart = placeColdCode();
+        linkColdCode(this->buffer, this->buffer + coldStart);
     }
 }
 
+void X64Asm::jumpToColdCode(U8 condition) {
+    write8(0x0F);
+    write8(0x80 + condition);
+    write32(0);
+    this->coldJumps.push_back(X64ColdJump(this->bufferPos - 4, this->coldBufferPos));
+    beginColdCode();
+}
+
+void X64Asm::linkColdCode(U8* host, U8* coldHost) {
+    for (auto& jump : this->coldJumps) {
+        write32Buffer(this->buffer + jump.bufferPos, (U32)(coldHost + jump.coldPos - (host + jump.bufferPos + 4)));
+    }
+    this->coldJumps.clear();
+}
+
 void x64_changed(x64CPU* cpu) {
     kpanic("Self modifying code was not trapped");
 }
@@ -2463,6 +2574,17 @@ void X64Asm::internal_addDynamicCheck(U32 address, U32 len, U32 needsFlags, bool
         releaseTmpReg(tmpReg1);
         releaseTmpReg(tmpReg2);
     }
+    // restoring the flags before the retranslation trap is bigger than a jump to it
+    if (!panic && (saveAllFlags || saveLowBitFlags) && canUseColdCode()) {
+        jumpToColdCode(5); // jnz
+        popFlagsFromReg(tmpReg3, true, saveAllFlags);
+        write8(0xce); // will cause an exception that will retranslate this chunk
+        endColdCode();
+        if (missed) {
+            internal_addDynamicCheck(address + len, missed, needsFlags, panic, tmpReg3);
+        }
+        return;
+    }
     // jz amount, will jump over the code to retranslate since the original and current x86 code are the same
     U32 pos;
     if (!panic) {
@@ -2931,10 +3053,126 @@ void X64Asm::retn32(U32 bytes) {
     if (bytes) {
         addWithLea(HOST_ESP, true, HOST_ESP, true, -1, false, 0, bytes, 4);
     }
+    if (KSystem::btShadowStack && !this->cpu->thread->process->hasSetSeg[CS]) {
+        shadowStackPop(tmpReg, true);
+    }
     jmpReg(tmpReg, true, false);
     releaseTmpReg(tmpReg);
 }
 
+// The flags belong to the guest, so none of this can use an instruction that changes them, which is why the key is
+// stored negated and compared with lea + jrcxz
+//
+// The eip is sign extended in the key so that its negative fits in a 32-bit displacement, only 0x80000000 doesn't
+void X64Asm::shadowStackPush(U32 returnEip) {
+    if (!KSystem::btShadowStack || this->cpu->thread->process->hasSetSeg[CS] || returnEip == 0x80000000) {
+        return;
+    }
+    U8 indexReg = getTmpReg();
+    U8 tmpReg = getTmpReg();
+
+    // indexReg = cpu->shadowStackPos
+    zeroReg(indexReg, true, true);
+    writeToRegFromMem(indexReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_SHADOW_STACK_POS, 1, false);
+
+    // cpu->shadowStackKeys[indexReg] = -(generation << 32) - (S32)returnEip
+    // 
+    // the generation must be read before the host address below, if the code is released in between the key will be stale
+    writeToRegFromMem(tmpReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_CODE_GENERATION, 8, false);
+    writeToRegFromMem(tmpReg, true, tmpReg, true, -1, false, 0, 8, 8, false);
+    addWithLea(tmpReg, true, tmpReg, true, -1, false, 0, -(S32)returnEip, 8);
+    writeToMemFromReg(tmpReg, true, HOST_CPU, true, indexReg, true, 3, CPU_OFFSET_SHADOW_STACK_KEYS, 8, false);
+
+    // cpu->shadowStackHost[indexReg] = host address of returnEip, link() will point this at the same slot jumpTo uses
+    writeToRegFromValue(tmpReg, true, 0x0101010101010101l, 8);
+    this->todoJump.push_back(TodoJump(returnEip, this->bufferPos - 8, 8, false, this->ipAddressCount));
+    writeToRegFromMem(tmpReg, true, tmpReg, true, -1, false, 0, 0, 8, false);
+    writeToMemFromReg(tmpReg, true, HOST_CPU, true, indexReg, true, 3, CPU_OFFSET_SHADOW_STACK_HOST, 8, false);
+
+    // cpu->shadowStackPos++, the byte store wraps it
+    addWithLea(indexReg, true, indexReg, true, -1, false, 0, 1, 4);
+    writeToMemFromReg(indexReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_SHADOW_STACK_POS, 1, false);
+
+    releaseTmpReg(tmpReg);
+    releaseTmpReg(indexReg);
+}
+
+// if the top of the shadow stack matches the eip in eipReg this jumps directly to its host code, otherwise it falls
+// through so the caller can do the normal jump
+void X64Asm::shadowStackPop(U8 eipReg, bool isEipRegRex) {
+    U8 indexReg = getTmpReg();
+    U8 tmpReg = getTmpReg();
+    U8 hostReg = getTmpReg();
+
+    // indexReg = --cpu->shadowStackPos
+    zeroReg(indexReg, true, true);
+    writeToRegFromMem(indexReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_SHADOW_STACK_POS, 1, false);
+    addWithLea(indexReg, true, indexReg, true, -1, false, 0, 0xff, 4);
+    writeToMemFromReg(indexReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_SHADOW_STACK_POS, 1, false);
+    write8(REX_BASE | REX_MOD_REG | REX_MOD_RM); // movzx indexReg, indexReg8
+    write8(0x0f);
+    write8(0xb6);
+    write8(0xc0 | (indexReg << 3) | indexReg);
+
+    // tmpReg = (generation << 32) + (S32)eip + cpu->shadowStackKeys[indexReg], which is 0 on a match
+    writeCodeKeyToReg(tmpReg, eipReg, isEipRegRex, hostReg);
+    writeToRegFromMem(hostReg, true, HOST_CPU, true, indexReg, true, 3, CPU_OFFSET_SHADOW_STACK_KEYS, 8, false);
+    addWithLea(tmpReg, true, tmpReg, true, hostReg, true, 0, 0, 8);
+    writeToRegFromMem(hostReg, true, HOST_CPU, true, indexReg, true, 3, CPU_OFFSET_SHADOW_STACK_HOST, 8, false);
+
+    U32 missJump = ifRegIsZero(tmpReg);
+    incrementCpuCounter(CPU_OFFSET_SHADOW_STACK_HITS, tmpReg);
+    // a stub for the return eip will retranslate from cpu->eip
+    writeToMemFromReg(eipReg, isEipRegRex, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP, 4, false);
+    jmpNativeReg(hostReg, true);
+    endIf(missJump);
+
+    incrementCpuCounter(CPU_OFFSET_SHADOW_STACK_MISSES, tmpReg);
+
+    releaseTmpReg(hostReg);
+    releaseTmpReg(tmpReg);
+    releaseTmpReg(indexReg);
+}
+
+// keyReg = (generation << 32) + (S32)eip, tmpReg is trashed
+void X64Asm::writeCodeKeyToReg(U8 keyReg, U8 eipReg, bool isEipRegRex, U8 tmpReg) {
+    writeToRegFromMem(keyReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_CODE_GENERATION, 8, false);
+    writeToRegFromMem(keyReg, true, keyReg, true, -1, false, 0, 0, 8, false);
+    write8(REX_BASE | REX_64 | REX_MOD_REG | (isEipRegRex ? REX_MOD_RM : 0)); // movsxd tmpReg, eipReg
+    write8(0x63);
+    write8(0xc0 | (tmpReg << 3) | eipReg);
+    addWithLea(keyReg, true, keyReg, true, tmpReg, true, 0, 0, 8);
+}
+
+// The code emitted until the matching endIf only runs if the 64-bit rex reg is 0.  This doesn't change the flags,
+// jrcxz only looks at rcx, which holds the guest's ecx, so it is swapped out around the test
+U32 X64Asm::ifRegIsZero(U8 reg) {
+    U8 xchgRex = REX_BASE | REX_64 | REX_MOD_RM;
+    U8 xchgRm = 0xc0 | (1 << 3) | reg;
+    write8(xchgRex); write8(0x87); write8(xchgRm); // xchg rcx, reg
+    write8(0xe3); write8(5); // jrcxz over the next 2 instructions
+    write8(xchgRex); write8(0x87); write8(xchgRm);
+    U32 result = this->bufferPos;
+    write8(0xeb); write8(0); // jmp to endIf
+    write8(xchgRex); write8(0x87); write8(xchgRm);
+    return result;
+}
+
+void X64Asm::endIf(U32 pos) {
+    U32 len = this->bufferPos - pos - 2;
+    if (len > 127) {
+        kpanic("X64Asm::endIf block is too long");
+    }
+    this->buffer[pos + 1] = (U8)len;
+}
+
+// increments the 32-bit counter at cpu+offset without changing the flags
+void X64Asm::incrementCpuCounter(U32 offset, U8 tmpReg) {
+    writeToRegFromMem(tmpReg, true, HOST_CPU, true, -1, false, 0, offset, 4, false);
+    addWithLea(tmpReg, true, tmpReg, true, -1, false, 0, 1, 4);
+    writeToMemFromReg(tmpReg, true, HOST_CPU, true, -1, false, 0, offset, 4, false);
+}
+
 void X64Asm::retf(U32 big, U32 bytes) {
     syncRegsFromHost(); 
 
@@ -3013,8 +3251,154 @@ void X64Asm::logOp(U32 eip) {
     syncRegsToHost();
 }
 
+static void x64_spinWait(CPU* cpu) {
+    cpu->spinWait();
+}
+
+void X64Asm::spinCheck() {
+    pushNativeFlags();
+    // sub dword [HOST_CPU+CPU_OFFSET_SPIN_COUNTDOWN], 1
+    write8(REX_BASE | REX_MOD_RM);
+    write8(0x83);
+    write8(0xa8 | HOST_CPU);
+    write32(CPU_OFFSET_SPIN_COUNTDOWN);
+    write8(1);
+    // jnz done
+    write8(0x0f);
+    write8(0x85);
+    U32 pos = this->bufferPos;
+    write32(0);
+    popNativeFlags();
+
+    syncRegsFromHost();
+    lockParamReg(PARAM_1_REG, PARAM_1_REX);
+    writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
+    callHost((void*)x64_spinWait);
+    syncRegsToHost();
+
+    pushNativeFlags();
+    // done:
+    write32Buffer(this->buffer + pos, this->bufferPos - pos - 4);
+    popNativeFlags();
+}
+
+void X64Asm::pause() {
+    spinCheck();
+    write8(0xf3);
+    write8(0x90);
+}
+
+bool X64Asm::isSpinLoop(U32 eip) {
+    if (!this->cpu->isBig() || eip < this->startOfDataIp || eip >= this->startOfOpIp || this->startOfOpIp - eip > X64_SPIN_LOOP_MAX_LEN) {
+        return false;
+    }
+    THREAD_LOCAL static DecodedBlock* block;
+    if (!block) {
+        block = new DecodedBlock();
+    }
+    U32 ip = eip;
+    U32 addressRegs = 0;
+    U32 loadedRegs = 0;
+    bool readsMemory = false;
+    bool result = true;
+
+    while (result && ip < this->startOfOpIp) {
+        decodeBlock(fetchByte, ip + this->cpu->seg[CS].address, true, 1, K_PAGE_SIZE, 0, block);
+        DecodedOp* op = block->op;
+        bool memory = false;
+
+        if (op->lock || op->repZero || op->repNotZero || op->ea16) {
+            result = false;
+        } else {
+            switch (op->inst) {
+            case CmpR8R8: case CmpR16R16: case CmpR32R32:
+            case CmpR8I8: case CmpR16I16: case CmpR32I32:
+            case TestR8R8: case TestR16R16: case TestR32R32:
+            case TestR8I8: case TestR16I16: case TestR32I32:
+                break;
+            case CmpE8R8: case CmpE16R16: case CmpE32R32:
+            case CmpR8E8: case CmpR16E16: case CmpR32E32:
+            case CmpE8I8: case CmpE16I16: case CmpE32I32:
+            case TestE8R8: case TestE16R16: case TestE32R32:
+            case TestE8I8: case TestE16I16: case TestE32I32:
+                memory = true;
+                break;
+            case MovR8E8:
+                memory = true;
+                loadedRegs |= 1 << (op->reg & 3); // ah-bh are the high bytes of eax-ebx
+                break;
+            case MovR16E16: case MovR32E32:
+            case MovGwXzE8: case MovGwSxE8:
+            case MovGdXzE8: case MovGdXzE16: case MovGdSxE8: case MovGdSxE16:
+                memory = true;
+                loadedRegs |= 1 << op->reg;
+                break;
+            case MovAlOb: case MovAxOw: case MovEaxOd:
+                readsMemory = true;
+                loadedRegs |= 1;
+                break;
+            case JumpO: case JumpNO: case JumpB: case JumpNB: case JumpZ: case JumpNZ: case JumpBE: case JumpNBE:
+            case JumpS: case JumpNS: case JumpP: case JumpNP: case JumpL: case JumpNL: case JumpLE: case JumpNLE: {
+                // can only leave the loop
+                U32 target = ip + op->len + op->imm;
+                if (target >= eip && target <= this->startOfOpIp) {
+                    result = false;
+                }
+                break;
+            }
+            default:
+                result = false;
+                break;
+            }
+        }
+        if (memory) {
+            readsMemory = true;
+            if (op->rm != regZero) {
+                addressRegs |= 1 << op->rm;
+            }
+            if (op->sibIndex != regZero) {
+                addressRegs |= 1 << op->sibIndex;
+            }
+        }
+        ip += op->len;
+        op->dealloc(false);
+    }
+    // a loop that loads the address it reads next, like walking a list, can end without another thread
+    return result && ip == this->startOfOpIp && readsMemory && !(addressRegs & loadedRegs);
+}
+
+static void x64_syscall(CPU* cpu, U32 eipCount) {
+    Memory* memory = ((BtCPU*)cpu)->codeMemory;
+    // a safe point for eviction, this thread will only return to the chunk at its codePin
+    if (memory && memory->isCodeCacheOverLimit()) {
+        memory->evictExecutableMemory();
+    }
+    ksyscall(cpu, eipCount);
+}
+
+// cpu->codePin = rip, cpu->codeEpoch = *cpu->codeEpochSource
+//
+// tells Memory::reclaimExecutableMemory that this thread no longer holds on to any host code retired before now,
+// except the chunk it will return to
+void X64Asm::writeCodeEpoch() {
+    U8 tmpReg = getTmpReg();
+
+    // lea tmpReg, [rip], the pin must be written before the epoch
+    write8(REX_BASE | REX_64 | REX_MOD_REG);
+    write8(0x8d);
+    write8(0x05 | (tmpReg << 3));
+    write32(0);
+    writeToMemFromReg(tmpReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_CODE_PIN, 8, false);
+
+    writeToRegFromMem(tmpReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_CODE_EPOCH_SOURCE, 8, false);
+    writeToRegFromMem(tmpReg, true, tmpReg, true, -1, false, 0, 0, 8, false);
+    writeToMemFromReg(tmpReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_CODE_EPOCH, 8, false);
+    releaseTmpReg(tmpReg);
+}
+
 void X64Asm::syscall(U32 opLen) {
     syncRegsFromHost();     
+    writeCodeEpoch();
 
     // void ksyscall(cpu, op->len)
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
@@ -3023,12 +3407,12 @@ void X64Asm::syscall(U32 opLen) {
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
     writeToRegFromValue(PARAM_2_REG, PARAM_2_REX, opLen, 4); // opLen param
     
-    callHost((void*)ksyscall);
+    callHost((void*)x64_syscall);
     syncRegsToHost();
 	
 	U8 tmpReg = getTmpReg();
 	writeToRegFromMem(tmpReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EXIT_TO_START_LOOP, 4, false);
-	doIf(tmpReg, true, 1, [this]() {
+	doIfCold(tmpReg, true, 1, [this]() {
 		// jmp [HOST_CPU+returnToLoopAddress]
 		write8(0x41);
 		write8(0xff);
@@ -3202,7 +3586,7 @@ void X64Asm::loadSeg(U8 seg, U8 rm, bool b32) {
 
         callHost((void*)common_setSegment);
 
-        doIf(0, false, 0, [this]() {
+        doIfCold(0, false, 0, [this]() {
             syncRegsToHost();
             doJmp(true);
         }, [this, rm, b32]() {
@@ -3284,6 +3668,9 @@ void X64Asm::callE(bool big, U8 rm) {
     }
     writeToRegFromE(tmpReg, true, rm, (big?4:2));
     push(-1, false, this->ip, (big?4:2)); 
+    if (big) {
+        shadowStackPush(this->ip);
+    }
     jmpReg(tmpReg, true, false);
     releaseTmpReg(tmpReg);
 }
@@ -3365,7 +3752,7 @@ void X64Asm::callCallback(void* pfn) {
 }
 
 void X64Asm::lsl(bool big, U8 rm) {
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(SYNC_REG(G(rm))); 
 
     // call U32 common_lsl(CPU* cpu, U32 selector, U32 limit)
 
@@ -3406,11 +3793,11 @@ void X64Asm::lsl(bool big, U8 rm) {
         }
         releaseTmpReg(tmpReg);
     }
-    syncRegsToHost(G(rm));
+    syncRegsAfterHostCall(0, G(rm));
 }
 
 void X64Asm::lar(bool big, U8 rm) {
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(SYNC_REG(G(rm))); 
 
     // call U32 common_lar(CPU* cpu, U32 selector, U32 limit)
 
@@ -3451,11 +3838,11 @@ void X64Asm::lar(bool big, U8 rm) {
         }
         releaseTmpReg(tmpReg);
     }
-    syncRegsToHost(G(rm));
+    syncRegsAfterHostCall(0, G(rm));
 }
 
 void X64Asm::verw(U8 rm) {
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(0); 
 
     // call void common_verw(CPU* cpu, U32 selector)
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
@@ -3466,11 +3853,11 @@ void X64Asm::verw(U8 rm) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
             
     callHost((void*)common_verw);
-    syncRegsToHost();
+    syncRegsAfterHostCall(0);
 }
 
 void X64Asm::verr(U8 rm) {
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(0); 
 
     // call void common_verr(CPU* cpu, U32 selector)
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
@@ -3481,7 +3868,7 @@ void X64Asm::verr(U8 rm) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
             
     callHost((void*)common_verr);
-    syncRegsToHost();
+    syncRegsAfterHostCall(0);
 }
 
 static void x64_invalidOp(CPU* cpu, U32 op) {
@@ -3509,14 +3896,14 @@ static void x64_errorMsg(const char* msg) {
 void X64Asm::errorMsg(const char* msg) {
     //syncRegsFromHost(); 
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
-    writeToRegFromValue(PARAM_1_REG, PARAM_1_REX, (U64)msg, 8);
+    writeToRegFromHostAddress(PARAM_1_REG, PARAM_1_REX, msg);
     callHost((void*)x64_errorMsg);
     //syncRegsToHost();
     //doJmp();
 }
 
 void X64Asm::cpuid() {
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(SYNC_REG(0) | SYNC_REG(1)); 
 
     // calling convention RCX, RDX, R8, R9 for first 4 parameters
 
@@ -3525,7 +3912,7 @@ void X64Asm::cpuid() {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
             
     callHost((void*)common_cpuid);
-    syncRegsToHost();
+    syncRegsAfterHostCall(SYNC_REG(0) | SYNC_REG(1) | SYNC_REG(2) | SYNC_REG(3));
 }
 
 void X64Asm::setNativeFlags(U32 flags, U32 mask) {
@@ -3687,76 +4074,215 @@ void x64_string2Arg(x64CPU* cpu, pfnString2Arg pfn, U32 arg1, U32 arg2) {
     cpu->fillFlags();
 }
 
+#define X64_REP_MOVS 0
+#define X64_REP_STOS 1
+#define X64_REP_SCAS 2
+#define X64_REP_INFO(kind, size, ea16) ((kind) | ((size) << 8) | ((ea16) ? 0x10000 : 0))
+
+// host address of the guest range if it's plain committed memory the guest can access, string ops on anything else
+// (code pages, memory that isn't committed yet) go through readb/writeb
+static U8* x64_getStringHostAddress(Memory* memory, U32 address, bool write) {
+    U32 page = address >> K_PAGE_SHIFT;
+    U8 flags = memory->flags[page];
+    U8 nativeFlags = memory->nativeFlags[memory->getNativePage(page)];
+
+    if (!(flags & (write ? PAGE_WRITE : PAGE_READ)) || (nativeFlags & NATIVE_FLAG_CODEPAGE_READONLY)) {
+        return NULL;
+    }
+    if (!(flags & PAGE_MAPPED_HOST) && (!(flags & PAGE_ALLOCATED) || !(nativeFlags & NATIVE_FLAG_COMMITTED))) {
+        return NULL;
+    }
+    return (U8*)getNativeAddress(memory, address);
+}
+
+// Does as much of a DF=0 rep movs/stos/repne scasb as it can a page at a time directly on host memory.  The registers
+// are updated after each page, whatever is left is done an element at a time by the normal string function.  For
+// scas that is at least the last compare, so that it sets the flags.
+static void x64_repStringOnHost(x64CPU* cpu, U32 kind, U32 size, bool ea16, U32 base) {
+    Memory* memory = cpu->thread->memory;
+    U32 count = ea16 ? CX : ECX;
+    U32 di = ea16 ? DI : EDI;
+    U32 si = ea16 ? SI : ESI;
+
+    while (count) {
+        U32 dst = cpu->seg[ES].address + di;
+        U32 todo = (K_PAGE_SIZE - (dst & K_PAGE_MASK)) / size;
+        if (ea16) {
+            todo = std::min(todo, (0x10000 - di) / size);
+        }
+        if (kind == X64_REP_MOVS) {
+            U32 src = cpu->seg[base].address + si;
+            todo = std::min(todo, (K_PAGE_SIZE - (src & K_PAGE_MASK)) / size);
+            if (ea16) {
+                todo = std::min(todo, (0x10000 - si) / size);
+            }
+        } else if (kind == X64_REP_SCAS && todo >= count) {
+            todo = count - 1;
+        }
+        todo = std::min(todo, count);
+        if (!todo) {
+            break; // an element crosses a page or the 16-bit wrap
+        }
+        U8* hostDst = x64_getStringHostAddress(memory, dst, kind != X64_REP_SCAS);
+        if (!hostDst) {
+            break;
+        }
+        U32 len = todo * size;
+        bool stop = false;
+
+        if (kind == X64_REP_MOVS) {
+            U8* hostSrc = x64_getStringHostAddress(memory, cpu->seg[base].address + si, false);
+            // rep movs copies forward, a destination that overlaps just ahead of the source repeats the pattern
+            if (!hostSrc || (hostDst > hostSrc && hostDst < hostSrc + len)) {
+                break;
+            }
+            memmove(hostDst, hostSrc, len);
+            si += len;
+        } else if (kind == X64_REP_STOS) {
+            if (size == 1) {
+                memset(hostDst, AL, len);
+            } else if (size == 2) {
+                for (U32 i = 0; i < todo; i++) {
+                    ((U16*)hostDst)[i] = AX;
+                }
+            } else {
+                for (U32 i = 0; i < todo; i++) {
+                    ((U32*)hostDst)[i] = EAX;
+                }
+            }
+        } else {
+            U8* found = (U8*)memchr(hostDst, AL, len);
+            if (found) {
+                // scasb will stop on this one
+                todo = (U32)(found - hostDst);
+                len = todo;
+                stop = true;
+            }
+        }
+        di += len;
+        count -= todo;
+        if (ea16) {
+            DI = (U16)di;
+            SI = (U16)si;
+            CX = (U16)count;
+        } else {
+            EDI = di;
+            ESI = si;
+            ECX = count;
+        }
+        if (stop) {
+            break;
+        }
+    }
+}
+
+// rep movs/stos/scas, info is X64_REP_INFO and arg1 is what the string function takes after cpu, if anything
+void x64_repString(x64CPU* cpu, void* pfn, U32 arg1, U32 info) {
+    U32 kind = info & 0xff;
+    U32 size = (info >> 8) & 0xff;
+
+    if (cpu->flags & DF) {
+        cpu->df = -1;
+    } else {
+        cpu->df = 1;
+    }
+    BtCodeMemoryWrite w(cpu);
+    if (cpu->stringWritesToDi) {
+        w.invalidateStringWriteToDi(true, size);
+    }
+    if (cpu->df == 1 && (kind != X64_REP_SCAS || (size == 1 && !arg1))) {
+        x64_repStringOnHost(cpu, kind, size, (info & 0x10000) != 0, arg1);
+    }
+    if (kind == X64_REP_STOS) {
+        ((pfnStringNoArgs)pfn)(cpu);
+    } else {
+        ((pfnString1Arg)pfn)(cpu, arg1);
+    }
+    cpu->fillFlags();
+}
+
+// the string helpers can fault on guest memory, so every register is stored before the call but only the ones the
+// instruction changes are reloaded after it
 void X64Asm::stos(void* pfn, U32 size, bool repeat) {
     writeToMemFromValue(1, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_WRITES_DI, 4, false);
     writeToMemFromValue(repeat?1:0, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_REPEAT, 4, false);
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(SYNC_ALL_REGS);
 
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
-    writeToRegFromValue(PARAM_2_REG, PARAM_2_REX, (U64)pfn, 8);
+    writeToRegFromHostAddress(PARAM_2_REG, PARAM_2_REX, (void*)pfn);
 
-    lockParamReg(PARAM_3_REG, PARAM_3_REX);
-    writeToRegFromValue(PARAM_3_REG, PARAM_3_REX, size, 4);
+    if (repeat) {
+        lockParamReg(PARAM_3_REG, PARAM_3_REX);
+        writeToRegFromValue(PARAM_3_REG, PARAM_3_REX, 0, 4);
 
-    callHost((void*)x64_stringNoArgs);
-    syncRegsToHost();
+        lockParamReg(PARAM_4_REG, PARAM_4_REX);
+        writeToRegFromValue(PARAM_4_REG, PARAM_4_REX, X64_REP_INFO(X64_REP_STOS, size, this->ea16), 4);
+
+        callHost((void*)x64_repString);
+    } else {
+        lockParamReg(PARAM_3_REG, PARAM_3_REX);
+        writeToRegFromValue(PARAM_3_REG, PARAM_3_REX, size, 4);
+
+        callHost((void*)x64_stringNoArgs);
+    }
+    syncRegsAfterHostCall(SYNC_REG(1) | SYNC_REG(7));
 }
 
 void X64Asm::scas(void* pfn, U32 size, bool repeat, bool repeatZero) {
     writeToMemFromValue(0, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_WRITES_DI, 4, false);
     writeToMemFromValue(repeat?1:0, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_REPEAT, 4, false);
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(SYNC_ALL_REGS);
 
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
-    writeToRegFromValue(PARAM_2_REG, PARAM_2_REX, (U64)pfn, 8);
+    writeToRegFromHostAddress(PARAM_2_REG, PARAM_2_REX, (void*)pfn);
 
     lockParamReg(PARAM_3_REG, PARAM_3_REX);
     writeToRegFromValue(PARAM_3_REG, PARAM_3_REX, (U32)repeatZero?1:0, 4);
 
     lockParamReg(PARAM_4_REG, PARAM_4_REX);
-    writeToRegFromValue(PARAM_4_REG, PARAM_4_REX, size, 4);
+    writeToRegFromValue(PARAM_4_REG, PARAM_4_REX, repeat ? X64_REP_INFO(X64_REP_SCAS, size, this->ea16) : size, 4);
 
-    callHost((void*)x64_string1Arg);
-    syncRegsToHost();
+    callHost(repeat ? (void*)x64_repString : (void*)x64_string1Arg);
+    syncRegsAfterHostCall(SYNC_REG(1) | SYNC_REG(7));
 }
 
 void X64Asm::movs(void* pfn, U32 size, bool repeat, U32 base) {
     writeToMemFromValue(1, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_WRITES_DI, 4, false);
     writeToMemFromValue(repeat?1:0, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_REPEAT, 4, false);
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(SYNC_ALL_REGS);
 
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
-    writeToRegFromValue(PARAM_2_REG, PARAM_2_REX, (U64)pfn, 8);
+    writeToRegFromHostAddress(PARAM_2_REG, PARAM_2_REX, (void*)pfn);
 
     lockParamReg(PARAM_3_REG, PARAM_3_REX);
     writeToRegFromValue(PARAM_3_REG, PARAM_3_REX, base, 4);
 
     lockParamReg(PARAM_4_REG, PARAM_4_REX);
-    writeToRegFromValue(PARAM_4_REG, PARAM_4_REX, size, 4);
+    writeToRegFromValue(PARAM_4_REG, PARAM_4_REX, repeat ? X64_REP_INFO(X64_REP_MOVS, size, this->ea16) : size, 4);
 
-    callHost((void*)x64_string1Arg);
-    syncRegsToHost();
+    callHost(repeat ? (void*)x64_repString : (void*)x64_string1Arg);
+    syncRegsAfterHostCall(SYNC_REG(1) | SYNC_REG(6) | SYNC_REG(7));
 }
 
 void X64Asm::lods(void* pfn, U32 size, bool repeat, U32 base) {
     writeToMemFromValue(0, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_WRITES_DI, 4, false);
     writeToMemFromValue(repeat?1:0, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_REPEAT, 4, false);
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(SYNC_ALL_REGS);
 
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
-    writeToRegFromValue(PARAM_2_REG, PARAM_2_REX, (U64)pfn, 8);
+    writeToRegFromHostAddress(PARAM_2_REG, PARAM_2_REX, (void*)pfn);
 
     lockParamReg(PARAM_3_REG, PARAM_3_REX);
     writeToRegFromValue(PARAM_3_REG, PARAM_3_REX, base, 4);
@@ -3765,19 +4291,19 @@ void X64Asm::lods(void* pfn, U32 size, bool repeat, U32 base) {
     writeToRegFromValue(PARAM_4_REG, PARAM_4_REX, size, 4);
 
     callHost((void*)x64_string1Arg);
-    syncRegsToHost();
+    syncRegsAfterHostCall(SYNC_REG(0) | SYNC_REG(1) | SYNC_REG(6));
 }
 
 void X64Asm::cmps(void* pfn, U32 size, bool repeat, bool repeatZero, U32 base) {
     writeToMemFromValue(0, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_WRITES_DI, 4, false);
     writeToMemFromValue(repeat?1:0, HOST_CPU, true, -1, false, 0, CPU_OFFSET_STRING_REPEAT, 4, false);
-    syncRegsFromHost(); 
+    syncRegsBeforeHostCall(SYNC_ALL_REGS);
 
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
-    writeToRegFromValue(PARAM_2_REG, PARAM_2_REX, (U64)pfn, 8);
+    writeToRegFromHostAddress(PARAM_2_REG, PARAM_2_REX, (void*)pfn);
 
     lockParamReg(PARAM_3_REG, PARAM_3_REX);
     writeToRegFromValue(PARAM_3_REG, PARAM_3_REX, (U32)repeatZero?1:0, 4);
@@ -3786,7 +4312,7 @@ void X64Asm::cmps(void* pfn, U32 size, bool repeat, bool repeatZero, U32 base) {
     writeToRegFromValue(PARAM_4_REG, PARAM_4_REX, base|(size<<16), 4);
 
     callHost((void*)x64_string2Arg);
-    syncRegsToHost();
+    syncRegsAfterHostCall(SYNC_REG(1) | SYNC_REG(6) | SYNC_REG(7));
 }
 
 // :TODO: could be inlined
@@ -3805,7 +4331,7 @@ void X64Asm::bound16(U8 rm) {
 
     callHost((void*)common_bound16);
 
-    doIf(0, false, 0, [this]() {
+    doIfCold(0, false, 0, [this]() {
         syncRegsToHost();
         doJmp(true);
     }, [this]() {
@@ -3828,7 +4354,7 @@ void X64Asm::bound32(U8 rm) {
 
     callHost((void*)common_bound32);
 
-    doIf(0, false, 0, [this]() {
+    doIfCold(0, false, 0, [this]() {
         syncRegsToHost();
         doJmp(true);
     }, [this]() {
@@ -3849,7 +4375,7 @@ void X64Asm::movRdCrx(U32 which, U32 reg) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     callHost((void*)common_readCrx);
-    doIf(0, false, 0, [this]() {
+    doIfCold(0, false, 0, [this]() {
         syncRegsToHost();
         doJmp(true);
     }, [this]() {
@@ -3871,7 +4397,7 @@ void X64Asm::movCrxRd(U32 which, U32 reg) {
 
     callHost((void*)common_readCrx);
     releaseTmpReg(HOST_TMP2);
-    doIf(0, false, 0, [this]() {
+    doIfCold(0, false, 0, [this]() {
         syncRegsToHost();
         doJmp(true);
     }, [this]() {
@@ -3884,18 +4410,18 @@ void common_fpu_write_address(x64CPU* cpu, PFN_FPU_ADDRESS pfn, U32 address, U32
     pfn(cpu, address);
 }
 
-void X64Asm::callFpuNoArg(PFN_FPU pfn) {
-    syncRegsFromHost();
+void X64Asm::callFpuNoArg(PFN_FPU pfn, U32 writes) {
+    syncRegsBeforeHostCall(0);
 
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     callHost((void*)pfn);
-    syncRegsToHost();
+    syncRegsAfterHostCall(writes);
 }
 
 void X64Asm::callFpuWithAddress(PFN_FPU_ADDRESS pfn, U8 rm) {
-    syncRegsFromHost();
+    syncRegsBeforeHostCall(SYNC_ALL_REGS);
 
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
     getAddressInRegFromE(PARAM_2_REG, PARAM_2_REX, rm);
@@ -3904,28 +4430,28 @@ void X64Asm::callFpuWithAddress(PFN_FPU_ADDRESS pfn, U8 rm) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     callHost((void*)pfn);
-    syncRegsToHost();
+    syncRegsAfterHostCall(0);
 }
 
 void X64Asm::callFpuWithAddressWrite(PFN_FPU_ADDRESS pfn, U8 rm, U32 len) {
-    syncRegsFromHost();
+    syncRegsBeforeHostCall(SYNC_ALL_REGS);
     getAddressInRegFromE(PARAM_3_REG, PARAM_4_REX, rm);
 
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
-    writeToRegFromValue(PARAM_2_REG, PARAM_2_REX, (U64)pfn, 8);
+    writeToRegFromHostAddress(PARAM_2_REG, PARAM_2_REX, (void*)pfn);
 
     lockParamReg(PARAM_4_REG, PARAM_4_REX);
     writeToRegFromValue(PARAM_4_REG, PARAM_4_REX, len, 4);
 
     callHost((void*)common_fpu_write_address);
-    syncRegsToHost();
+    syncRegsAfterHostCall(0);
 }
 
 void X64Asm::callFpuWithArg(PFN_FPU_REG pfn, U32 arg) {
-    syncRegsFromHost();
+    syncRegsBeforeHostCall(0);
 
     lockParamReg(PARAM_2_REG, PARAM_2_REX);
     writeToRegFromValue(PARAM_2_REG, PARAM_2_REX, (U32)arg, 4);
@@ -3934,7 +4460,7 @@ void X64Asm::callFpuWithArg(PFN_FPU_REG pfn, U32 arg) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     callHost((void*)pfn);
-    syncRegsToHost();
+    syncRegsAfterHostCall(0);
 }
 
 void X64Asm::saveNativeState() {
@@ -3995,6 +4521,30 @@ void X64Asm::callRetranslateChunk() {
     jmpNativeReg(HOST_TMP, true);
 }
 
+// link slots are pointed here when the chunk they jumped to is released, the jump already wrote cpu->eip so this looks
+// it up the same way an indirect jump does
+void X64Asm::createCodeForReTranslateLink() {
+    writeToRegFromMem(HOST_TMP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP, 4, false);
+    jmpReg(HOST_TMP, true, true);
+}
+
+static void x64_formTrace() {
+    x64CPU* cpu = ((x64CPU*)KThread::currentThread()->cpu);
+    BtCodeChunkLink* link = (BtCodeChunkLink*)((U8*)cpu->traceLinkSlot - offsetof(BtCodeChunkLink, toHostInstruction));
+    cpu->returnHostAddress = cpu->formTrace(link);
+}
+
+// a link that got hot jumps here with its slot in cpu->traceLinkSlot, like a jump to another chunk cpu->eip was already
+// written
+void X64Asm::createCodeForFormTrace() {
+    writeToRegFromMem(HOST_TMP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP, 4, false);
+    syncRegsFromHost(true);
+    callHost((void*)x64_formTrace);
+    syncRegsToHost();
+    writeToRegFromMem(HOST_TMP, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_RETURN_HOST_ADDRESS, 8, false);
+    jmpNativeReg(HOST_TMP, true);
+}
+
 void X64Asm::createCodeForRetranslateChunk(bool includeSetupFromR9) {
     if (includeSetupFromR9) {
         syncRegsFromHost(true);
@@ -4009,7 +4559,7 @@ void X64Asm::createCodeForRetranslateChunk(bool includeSetupFromR9) {
 
 static void x64_jmpAndTranslateIfNecessary() {
     x64CPU* cpu = ((x64CPU*)KThread::currentThread()->cpu);
-    cpu->returnHostAddress = (U64)cpu->translateEip(cpu->eip.u32);
+    cpu->returnHostAddress = cpu->translateOrInterpretEip(cpu->eip.u32);
 }
 
 static void x64_jmpAndTranslateIfNecessaryAdjustForCS() {
@@ -4018,7 +4568,7 @@ static void x64_jmpAndTranslateIfNecessaryAdjustForCS() {
     if (!cpu->isBig()) {
         cpu->eip.u32 = cpu->eip.u32 & 0xFFFF;
     }
-    cpu->returnHostAddress = (U64)cpu->translateEip(cpu->eip.u32);
+    cpu->returnHostAddress = cpu->translateOrInterpretEip(cpu->eip.u32);
 }
 
 void X64Asm::createCodeForJmpAndTranslateIfNecessary(bool includeSetupFromR9) {
@@ -4309,7 +4859,7 @@ void X64Asm::fpu7(U8 rm) {
             case 3: callFpuWithArg(common_FST_STi_Pop, E(rm)); break;
             case 4:
                 if ((rm & 7)==0)
-                    callFpuNoArg(common_FNSTSW_AX);
+                    callFpuNoArg(common_FNSTSW_AX, SYNC_REG(0));
                 else {
                     invalidOp(this->inst);
                 }
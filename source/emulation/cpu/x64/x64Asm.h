@@ -35,11 +35,48 @@
 #define CPU_OFFSET_EIP_FROM (U32)(offsetof(x64CPU, fromEip))
 #define CPU_OFFSET_EXIT_TO_START_LOOP (U32)(offsetof(x64CPU, exitToStartThreadLoop))
 #define CPU_OFFSET_RETURN_ADDRESS (U32)(offsetof(x64CPU, returnToLoopAddress))
+#define CPU_OFFSET_SHADOW_STACK_KEYS (U32)(offsetof(x64CPU, shadowStackKeys))
+#define CPU_OFFSET_SHADOW_STACK_HOST (U32)(offsetof(x64CPU, shadowStackHost))
+#define CPU_OFFSET_SHADOW_STACK_POS (U32)(offsetof(x64CPU, shadowStackPos))
+#define CPU_OFFSET_SHADOW_STACK_HITS (U32)(offsetof(x64CPU, shadowStackHits))
+#define CPU_OFFSET_SHADOW_STACK_MISSES (U32)(offsetof(x64CPU, shadowStackMisses))
+#define CPU_OFFSET_CODE_GENERATION (U32)(offsetof(x64CPU, codeGeneration))
+#define CPU_OFFSET_CODE_EPOCH (U32)(offsetof(x64CPU, codeEpoch))
+#define CPU_OFFSET_CODE_PIN (U32)(offsetof(x64CPU, codePin))
+#define CPU_OFFSET_CODE_EPOCH_SOURCE (U32)(offsetof(x64CPU, codeEpochSource))
+#define CPU_OFFSET_SPIN_COUNTDOWN (U32)(offsetof(x64CPU, spinCountdown))
+
+// the most guest bytes a loop can be for isSpinLoop to look at it
+#define X64_SPIN_LOOP_MAX_LEN 32
+
+// The guest state a host function called from translated code reads and writes, see syncRegsBeforeHostCall.  Bits 0-7
+// are the general registers in encoding order.  eip and flags are always synced since the call clobbers rflags, so
+// is the native fpu/sse state when the fpu isn't emulated.
+#define SYNC_REG(r) (1 << (r))
+#define SYNC_ALL_REGS 0xff
+// segment addresses and the eip mapping, translated code keeps one of them in a host register
+#define SYNC_SEGS 0x100
+#define SYNC_ALL (SYNC_ALL_REGS | SYNC_SEGS)
+
+// Host registers the calling convention lets a called function trash, these are always synced around a call
+#ifdef BOXEDWINE_MSVC
+#define SYNC_HOST_VOLATILE (SYNC_REG(0) | SYNC_REG(1) | SYNC_REG(2) | SYNC_REG(4))
+#else
+#define SYNC_HOST_VOLATILE (SYNC_REG(0) | SYNC_REG(1) | SYNC_REG(2) | SYNC_REG(4) | SYNC_REG(6) | SYNC_REG(7))
+#endif
 
 typedef void (*PFN_FPU_REG)(CPU* cpu, U32 reg);
 typedef void (*PFN_FPU_ADDRESS)(CPU* cpu, U32 address);
 typedef void (*PFN_FPU)(CPU* cpu);
 
+// a jcc in the hot code with its 32-bit offset at bufferPos, it goes to coldPos in BtData::coldBuffer
+class X64ColdJump {
+public:
+    X64ColdJump(U32 bufferPos, U32 coldPos) : bufferPos(bufferPos), coldPos(coldPos) {}
+    U32 bufferPos;
+    U32 coldPos;
+};
+
 class X64Asm : public X64Data {
 public:  
     X64Asm(x64CPU* cpu);
@@ -53,6 +90,8 @@ public:
     void createCodeForRetranslateChunk(bool includeSetupFromR9=false);
     void createCodeForJmpAndTranslateIfNecessary(bool includeSetupFromR9 = false);
     void callRetranslateChunk();
+    void createCodeForReTranslateLink();
+    void createCodeForFormTrace();
 #ifdef BOXEDWINE_POSIX
     void createCodeForRunSignal();
 #endif
@@ -98,14 +137,37 @@ public:
     void loopz(U32 eip, bool ea16);
     void loopnz(U32 eip, bool ea16);
     virtual void jumpTo(U32 eip);
+    virtual bool canTranslateInSinglePass() { return true; }
+    virtual void resolveJumpRelocations();
+    // only a single pass translation places cold code after the chunk
+    bool canUseColdCode() { return this->singlePass; }
+    // jcc to the code written to the cold buffer until endColdCode is called.  Cold code must leave the instruction,
+    // there is no way back into the hot code.
+    void jumpToColdCode(U8 condition);
+    // points the cold jumps at the cold code, for an instruction that is written over an existing translation
+    void linkColdCode(U8* host, U8* coldHost);
+    // counts down CPU::spinCountdown and calls CPU::spinWait when it gets to 0, only used with KSystem::spinBackoff
+    void spinCheck();
+    void pause();
+    // true if the loop from eip back to this instruction only reads memory and compares it, so it can only end once
+    // another thread writes that memory
+    bool isSpinLoop(U32 eip);
+    std::vector<X64ColdJump> coldJumps;
     void jmp(bool big, U32 sel, U32 offset, U32 oldEip);
     void call(bool big, U32 sel, U32 offset, U32 oldEip);
     void retn16(U32 bytes);
     void retn32(U32 bytes);
+    void shadowStackPush(U32 returnEip);
+    void shadowStackPop(U8 eipReg, bool isEipRegRex);
+    void writeCodeKeyToReg(U8 keyReg, U8 eipReg, bool isEipRegRex, U8 tmpReg);
+    U32 ifRegIsZero(U8 reg);
+    void endIf(U32 pos);
+    void incrementCpuCounter(U32 offset, U8 tmpReg);
     void retf(U32 big, U32 bytes);
     void iret(U32 big, U32 oldEip);
     void signalIllegalInstruction(int code);
     void syscall(U32 opLen);
+    void writeCodeEpoch();
     void int98(U32 opLen);
     void int99(U32 opLen);
     void int9A(U32 opLen);
@@ -121,6 +183,7 @@ public:
     void bswapSp();
     void string32(bool hasSi, bool hasDi);
     void writeToRegFromValue(U8 reg, bool isRexReg, U64 value, U8 bytes);
+    void writeToRegFromHostAddress(U8 reg, bool isRexReg, const void* address);
     void enter(bool big, U32 bytes, U32 level);
     void leave(bool big);
     void callE(bool big, U8 rm);
@@ -196,10 +259,18 @@ private:
     void popReg(U8 reg, bool isRegRex, S8 bytes, bool commit);
     void syncRegsFromHost(bool eipInR9=false);
     void syncRegsToHost(S8 excludeReg=-1);
+    // Like syncRegsFromHost/syncRegsToHost, but only for what the called function reads or writes (SYNC_*), the
+    // rest stays in host registers across the call.  A function that can fault on guest memory must read
+    // SYNC_ALL_REGS, the signal it raises sees the registers in CPU
+    void syncRegsBeforeHostCall(U32 reads, bool eipInR9=false);
+    void syncRegsAfterHostCall(U32 writes, S8 excludeReg=-1);
     void minSyncRegsFromHost();
     void minSyncRegsToHost();
     void adjustStack(U8 tmpReg, S32 bytes);
+    void cmpRegToValue(U8 reg, bool isRexReg, U32 value);
     void doIf(U8 reg, bool isRexReg, U32 equalsValue, std::function<void(void)> ifBlock, std::function<void(void)> elseBlock);    
+    // like doIf, but ifBlock is cold code that must leave the instruction, like an exception exit
+    void doIfCold(U8 reg, bool isRexReg, U32 equalsValue, std::function<void(void)> ifBlock, std::function<void(void)> elseBlock);
     void setPF_onAL(U8 flagReg);
     void setZF_onAL(U8 flagReg);
     void setSF_onAL(U8 flagReg);
@@ -226,6 +297,7 @@ private:
     void setDisplacement8(U8 disp8);  
 
     void addTodoLinkJump(U32 eip, U32 size, bool sameChunk);       
+    void jumpThroughLink(U32 eip);
     void doLoop(U32 eip);
     void doLoop16(U8 inst, U32 eip);
     void jmpReg(U8 reg, bool isRex, bool mightNeedCS);
@@ -241,7 +313,7 @@ private:
     void popFlagsFromReg(U8 reg, bool isRexReg, bool includeOF);
     void xchange4(U8 reg1, bool isRexReg1, U8 reg2, bool isRexReg2);
 
-    void callFpuNoArg(PFN_FPU pfn);
+    void callFpuNoArg(PFN_FPU pfn, U32 writes=0);
     void callFpuWithAddress(PFN_FPU_ADDRESS pfn, U8 rm);
     void callFpuWithAddressWrite(PFN_FPU_ADDRESS pfn, U8 rm, U32 len);
     void callFpuWithArg(PFN_FPU_REG pfn, U32 arg);
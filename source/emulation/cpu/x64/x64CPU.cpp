@@ -6,6 +6,8 @@
 #include "x64Asm.h"
 #include "../../hardmmu/hard_memory.h"
 #include "x64CodeChunk.h"
+#include "../binaryTranslation/btTranslationWorkers.h"
+#include "../binaryTranslation/btInterpreter.h"
 
 CPU* CPU::allocCPU() {
     return new x64CPU();
@@ -15,11 +17,15 @@ CPU* CPU::allocCPU() {
 bool x64CPU::hasBMI2 = true;
 bool x64Intialized = false;
 
-x64CPU::x64CPU() {
+x64CPU::x64CPU() : shadowStackHits(0), shadowStackMisses(0), shadowStackPos(0) {
     if (!x64Intialized) {
         x64Intialized = true;
         x64CPU::hasBMI2 = platformHasBMI2();
     }
+    // the generation starts at 1 so a 0 key never matches
+    memset(shadowStackKeys, 0, sizeof(shadowStackKeys));
+    memset(shadowStackHost, 0, sizeof(shadowStackHost));
+    interpreter = new BtInterpreter(this);
     largeAddressJumpInstruction = 0xCE24FF43;
     pageJumpInstruction = 0x0A8B4566;
     pageOffsetJumpInstruction = 0xCA148B4F;
@@ -51,6 +57,12 @@ void* x64CPU::init() {
     }
 
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(memory->executableMemoryMutex);
+    // init is only called from BtCPU::run, this thread isn't running the previous start code anymore.  After an exec
+    // the chunk belonged to the previous memory which already freed it.
+    if (this->startChunk && memory->getCodeChunkContainingHostAddress(this->startChunk->getHostAddress()) == this->startChunk) {
+        this->startChunk->release(memory);
+    }
+    this->startChunk = nullptr;
     this->eipToHostInstructionAddressSpaceMapping = this->thread->memory->eipToHostInstructionAddressSpaceMapping;
     this->memOffsets = memory->memOffsets;
 
@@ -81,6 +93,7 @@ void* x64CPU::init() {
     data.doJmp(false);
     std::shared_ptr<BtCodeChunk> chunk = data.commit(true);
     result = chunk->getHostAddress();
+    this->startChunk = chunk;
     //link(&data, chunk);
     this->pendingCodePages.clear();    
     this->eipToHostInstructionPages = this->thread->memory->eipToHostInstructionPages;
@@ -109,6 +122,19 @@ void* x64CPU::init() {
         this->thread->process->reTranslateChunkAddressFromReg = chunk3->getHostAddress();
     }
     this->reTranslateChunkAddressFromReg = this->thread->process->reTranslateChunkAddressFromReg;
+    if (!this->thread->process->reTranslateLinkAddress) {
+        X64Asm translateData(this);
+        translateData.createCodeForReTranslateLink();
+        std::shared_ptr<BtCodeChunk> chunk3 = translateData.commit(true);
+        this->thread->process->reTranslateLinkAddress = chunk3->getHostAddress();
+    }
+    if (!this->thread->process->formTraceAddress) {
+        X64Asm translateData(this);
+        translateData.createCodeForFormTrace();
+        std::shared_ptr<BtCodeChunk> chunk3 = translateData.commit(true);
+        this->thread->process->formTraceAddress = chunk3->getHostAddress();
+    }
+    this->formTraceAddress = this->thread->process->formTraceAddress;
 #ifdef BOXEDWINE_BT_DEBUG_NO_EXCEPTIONS
     if (!this->thread->process->jmpAndTranslateIfNecessary) {
         X64Asm translateData(this);
@@ -151,6 +177,14 @@ void x64CPU::addReturnFromTest() {
 }
 #endif
 
+// the stub that link() just created will be replaced by a translation worker if it gets there before this thread does
+void x64CPU::addSpeculativeTranslation(U32 address) {
+    // workers don't queue the targets of what they translate, that would have them chase every path in the program
+    if (BtTranslationWorkers::isRunning() && !BtTranslationWorkers::isWorkerThread() && this->isBig() && !this->seg[CS].address) {
+        BtTranslationWorkers::add(this->thread, address);
+    }
+}
+
 void x64CPU::link(const std::shared_ptr<BtData>& data, std::shared_ptr<BtCodeChunk>& fromChunk, U32 offsetIntoChunk) {
     U32 i;
     if (!fromChunk) {
@@ -174,13 +208,16 @@ void x64CPU::link(const std::shared_ptr<BtData>& data, std::shared_ptr<BtCodeChu
                 U8 op = 0xce;
                 U32 hostIndex = 0;
                 std::shared_ptr<X64CodeChunk> chunk = std::make_shared<X64CodeChunk>(1, &eip, &hostIndex, &op, 1, eip-this->seg[CS].address, 1, false);
+                chunk->markAsStub();
                 chunk->makeLive();
                 toHostAddress = (U8*)chunk->getHostAddress();            
+                addSpeculativeTranslation(eip);
             }
             std::shared_ptr<BtCodeChunk> toChunk = this->thread->memory->getCodeChunkContainingHostAddress(toHostAddress);
             if (!toChunk) {
                 kpanic("x64CPU::link to chunk missing");
             }
+            toChunk->markReferenced();
             std::shared_ptr<BtCodeChunkLink> link = toChunk->addLinkFrom(fromChunk, eip, toHostAddress, offset, true);
             data->write32Buffer(offset, (U32)(toHostAddress - offset - 4));            
         } else if (size==8 && !data->todoJump[i].sameChunk) {
@@ -192,13 +229,16 @@ void x64CPU::link(const std::shared_ptr<BtData>& data, std::shared_ptr<BtCodeChu
                 returnData.callRetranslateChunk();
                 U32 hostIndex = 0;
                 std::shared_ptr<X64CodeChunk> chunk = std::make_shared<X64CodeChunk>(1, &eip, &hostIndex, returnData.buffer, returnData.bufferPos, eip - this->seg[CS].address, 1, false);
+                chunk->markAsStub();
                 chunk->makeLive();
                 toHostAddress = (U8*)chunk->getHostAddress();
+                addSpeculativeTranslation(eip);
             }
             std::shared_ptr<BtCodeChunk> toChunk = this->thread->memory->getCodeChunkContainingHostAddress(toHostAddress);
             if (!toChunk) {
                 kpanic("x64CPU::link to chunk missing");
             }
+            toChunk->markReferenced();
             std::shared_ptr<BtCodeChunkLink> link = toChunk->addLinkFrom(fromChunk, eip, toHostAddress, offset, false);
             data->write64Buffer(offset, (U64)&(link->toHostInstruction));
         } else {
@@ -208,6 +248,21 @@ void x64CPU::link(const std::shared_ptr<BtData>& data, std::shared_ptr<BtCodeChu
     markCodePageReadOnly(data.get());
 }
 
+static U8 fetchByte(U32* eip) {
+    return readb((*eip)++);
+}
+
+U32 x64CPU::getInstructionLen(U32 address) {
+    THREAD_LOCAL static DecodedBlock* block;
+    if (!block) {
+        block = new DecodedBlock();
+    }
+    decodeBlock(fetchByte, address, this->isBig(), 1, K_PAGE_SIZE, 0, block);
+    U32 result = block->op->len;
+    block->op->dealloc(false);
+    return result;
+}
+
 void x64CPU::translateData(const std::shared_ptr<BtData>& data, const std::shared_ptr<BtData>& firstPass) {
     U32 codePage = (data->ip+this->seg[CS].address) >> K_PAGE_SHIFT;
     U32 nativePage = this->thread->memory->getNativePage(codePage);
@@ -217,11 +272,25 @@ void x64CPU::translateData(const std::shared_ptr<BtData>& data, const std::share
     while (1) {  
         U32 address = this->seg[CS].address+data->ip;
         void* hostAddress = this->thread->memory->getExistingHostAddress(address);
-        if (hostAddress) {
+        if (hostAddress && data->ip >= data->traceEndIp) {
             data->jumpTo(data->ip);
             break;
         }
-        if (firstPass) {
+        if (data->ipAddressCount && BtTranslationWorkers::isWorkerThread() && !canTranslateSpeculatively(address)) {
+            // let the guest thread translate the rest if it ever gets here
+            data->jumpTo(data->ip);
+            break;
+        }
+        if (data->singlePass) {
+            // does this instruction spill into a dynamic page, only instructions that start near the end of a page
+            // need to be decoded to know
+            if (!data->dynamic && (address & K_PAGE_MASK) + K_MAX_X86_OP_LEN >= K_PAGE_SIZE) {
+                U32 nextPage = (address >> K_PAGE_SHIFT) + 1;
+                if (this->thread->memory->dynamicCodePageUpdateCount[this->thread->memory->getNativePage(nextPage)] == MAX_DYNAMIC_CODE_PAGE_COUNT && ((address + getInstructionLen(address)) >> K_PAGE_SHIFT) == nextPage) {
+                    data->dynamic = true;
+                }
+            }
+        } else if (firstPass) {
             U32 nextEipLen = firstPass->calculateEipLen(data->ip+this->seg[CS].address);
             U32 page = (data->ip+this->seg[CS].address+nextEipLen) >> K_PAGE_SHIFT;
 
@@ -247,7 +316,10 @@ void x64CPU::translateData(const std::shared_ptr<BtData>& data, const std::share
         data->mapAddress(address, data->bufferPos);
         data->translateInstruction();
         if (data->done) {
-            break;
+            if (data->ip >= data->traceEndIp || !data->isDirectJmp()) {
+                break;
+            }
+            data->done = false;
         }
         if (data->stopAfterInstruction!=-1 && (int)data->ipAddressCount==data->stopAfterInstruction) {
             break;
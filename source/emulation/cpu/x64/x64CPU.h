@@ -33,6 +33,19 @@ public:
 	U64 originalCpuRegs[16];
     void* reTranslateChunkAddress;
     void* reTranslateChunkAddressFromReg;
+    void* formTraceAddress;
+    void** traceLinkSlot; // toHostInstruction of the link that jumped to formTraceAddress
+    // the code init() returned last time, it is freed the next time init is called
+    std::shared_ptr<BtCodeChunk> startChunk;
+
+    // shadow return stack, a near call records the eip it will return to along with the host code for that eip so
+    // that ret can jump straight there instead of going through the eip lookup.  The index is a byte so that it
+    // wraps around without generated code having to change the flags.
+    U64 shadowStackKeys[256]; // -(Memory::codeGeneration[0] + return eip)
+    void* shadowStackHost[256];
+    U32 shadowStackHits;
+    U32 shadowStackMisses;
+    U8 shadowStackPos;
 #ifdef BOXEDWINE_BT_DEBUG_NO_EXCEPTIONS
     void* jmpAndTranslateIfNecessary;
 #endif
@@ -47,8 +60,10 @@ public:
 
     virtual void link(const std::shared_ptr<BtData>& data, std::shared_ptr<BtCodeChunk>& fromChunk, U32 offsetIntoChunk=0);    
     virtual void translateData(const std::shared_ptr<BtData>& data, const std::shared_ptr<BtData>& firstPass = nullptr);
+    U32 getInstructionLen(U32 address);
         
     virtual bool handleStringOp(DecodedOp* op);
+    virtual bool canCacheTranslations() { return true; }
 
     virtual void setSeg(U32 index, U32 address, U32 value);
 #ifdef __TEST
@@ -56,6 +71,7 @@ public:
 #endif    
 protected:
     virtual std::shared_ptr<BtData> createData();
+    void addSpeculativeTranslation(U32 address);
 };
 #endif
 #endif
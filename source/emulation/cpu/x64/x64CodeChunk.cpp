@@ -12,10 +12,23 @@ bool X64CodeChunk::retranslateSingleInstruction(BtCPU* btCPU, void* address) {
     data.ip = eip;
     data.startOfDataIp = eip;
     data.dynamic = this->dynamic;
+    // split like the chunk was so that the cold code can go where the old instruction's cold code is
+    data.singlePass = true;
     data.translateInstruction();
     U32 eipLen = data.ip - data.startOfOpIp;
     U32 hostLen = data.bufferPos;
-    if (eipLen == this->emulatedInstructionLen[index] && hostLen == this->hostInstructionLen[index]) {
+    U8* coldHost = NULL;
+    U32 coldLen = 0;
+    this->getColdCode(index, &coldHost, &coldLen);
+    // jumps would need to be linked, their offsets are still 0 in data.buffer
+    if (eipLen == this->emulatedInstructionLen[index] && hostLen == this->hostInstructionLen[index] && coldLen == data.coldBufferPos && data.todoJump.empty() && data.jumpRelocations.empty()) {
+        if (coldLen) {
+            data.linkColdCode((U8*)startofHostInstruction, coldHost);
+            // the cold code goes first, the new hot code jumps to it
+            Platform::writeCodeToMemory(coldHost, coldLen, [coldHost, &data, coldLen]() {
+                memcpy(coldHost, data.coldBuffer, coldLen);
+                });
+        }
         Platform::writeCodeToMemory(startofHostInstruction, hostLen, [startofHostInstruction, &data, hostLen]() {
             memcpy(startofHostInstruction, data.buffer, hostLen);
             });
@@ -49,6 +49,7 @@ public:
     U64 fetch64();
 
     virtual void resetForNewOp();
+    virtual bool isDirectJmp() { U32 jmp = this->inst & 0x1FF; return jmp == 0xE9 || jmp == 0xEB; }
 
     U32 op;
     U32 inst; // full op, like 0x200 while op would be 0x00
@@ -949,6 +949,9 @@ static U32 bound32(X64Asm* data) {
 // JO, JNO, JB, JNB, JZ, JNZ, JBE, JNBE, JS, JNS, JP, JNP, JL, JNL, JNLE
 static U32 jump8(X64Asm* data) {
     S8 offset = (S8)data->fetch8();
+    if (offset < 0 && KSystem::spinBackoff && data->isSpinLoop(data->ip + offset)) {
+        data->spinCheck();
+    }
     data->jumpConditional(data->op & 0xf, data->ip+offset);    
     return 0;
 }
@@ -1009,6 +1012,7 @@ static U32 callJd(X64Asm* data) {
     S32 offset = data->fetch32();
     U32 eip = data->ip+offset;    
     data->pushd(data->ip); // will return to next instruction
+    data->shadowStackPush(data->ip);
     data->jumpTo(eip);
     data->done = true;
     return 0;
@@ -1025,6 +1029,9 @@ static U32 jmpJw(X64Asm* data) {
 // JMP Jb
 static U32 jmpJb(X64Asm* data) {
     S8 offset = (S8)data->fetch8();
+    if (offset < 0 && KSystem::spinBackoff && data->isSpinLoop(data->ip + offset)) {
+        data->spinCheck();
+    }
     data->jumpTo(data->ip+offset);
     data->done = true;
     return 0;
@@ -1260,6 +1267,17 @@ static U32 keepSame(X64Asm* data) {
     return 0;
 }
 
+// NOP
+// PAUSE
+static U32 nop(X64Asm* data) {
+    if (data->repZeroPrefix && KSystem::spinBackoff) {
+        data->pause();
+    } else {
+        data->writeOp();
+    }
+    return 0;
+}
+
 static U32 rdtsc(X64Asm* data) {
 #ifdef LOG_OPS
     x64_writeToRegFromValue(data, 0, FALSE, 1, 4);
@@ -2425,7 +2443,7 @@ X64Decoder x64Decoder[1024] = {
     inst8RMimm8SafeG, inst16RMimm16SafeG, instruction82, inst16RMimm8SafeG, inst8RM, inst16RM, inst8RMGWritten, inst16RM,
     inst8RM, inst16RM, inst8RMGWritten, inst16RM, movEwSw, leaGw, movSwEw, popEw,
     // 90
-    keepSame, keepSame, keepSame, keepSame, xchgSpAx, keepSame, keepSame, keepSame,
+    nop, keepSame, keepSame, keepSame, xchgSpAx, keepSame, keepSame, keepSame,
     keepSame, keepSame, callAp, keepSame, pushFlags16, popFlags16, keepSame, keepSame,
     // A0
     movAlOb, movAxOw, movObAl, movOwAx, movsb, movsw, cmpsb, cmpsw,
@@ -2523,7 +2541,7 @@ X64Decoder x64Decoder[1024] = {
     inst8RMimm8SafeG, inst32RMimm32SafeG, instruction82, inst32RMimm8SafeG, inst8RM, inst32RM, inst8RMGWritten, inst32RM,
     inst8RM, inst32RM, inst8RMGWritten, inst32RM, movEdSw, leaGd, movSwEw, popEd,
     // 290
-    keepSame, keepSame, keepSame, keepSame, xchgEspEax, keepSame, keepSame, keepSame,
+    nop, keepSame, keepSame, keepSame, xchgEspEax, keepSame, keepSame, keepSame,
     keepSame, keepSame, callFar32, keepSame, pushFlags32, popFlags32, keepSame, keepSame,
     // 2a0
     movAlOb, movEaxOd, movObAl, movOdEax, movsb, movsd, cmpsb, cmpsd,
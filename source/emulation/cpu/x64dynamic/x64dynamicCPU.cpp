@@ -0,0 +1,1001 @@
+#include "boxedwine.h"
+#ifdef BOXEDWINE_DYNAMIC_X64
+
+#include "x64dynamicCPU.h"
+#include "../common/lazyFlags.h"
+#include "../dynamic/dynamic.h"
+
+// x86_64 host backend for the dynamic core.  It emits the primitives that dynamic_generic_base.h needs, the same way
+// the armv8 backend does, and inlines the soft mmu page pointer lookup that the x32 backend uses for memory access.
+
+/********************************************************/
+/* Following is required to be defined for dynamic code */
+/********************************************************/
+
+#define INCREMENT_EIP(data, op) incrementEip(data, op)
+
+// gcc won't take offsetof with an index that isn't a constant, the dynamic ops use it with the decoded register
+#define CPU_OFFSET_OF(x) ((U32)(size_t)&(((CPU*)0)->x))
+#define OFFSET_REG8(x) (x>=4?CPU_OFFSET_OF(reg[x-4].h8):CPU_OFFSET_OF(reg[x].u8))
+
+// per instruction, not per block.
+#define NUMBER_OF_REGS 16
+static bool regUsed[NUMBER_OF_REGS];
+
+void setRegUsed(U8 reg) {
+    regUsed[reg] = true;
+}
+
+void clearRegUsed(U8 reg) {
+    regUsed[reg] = false;
+}
+
+void resetRegsUsed() {
+    memset(regUsed, 0, sizeof(regUsed));
+}
+
+// DynReg is a required type, the values are the host register numbers
+enum DynReg {
+    DYN_RAX = 0,
+    DYN_RCX = 1,
+    DYN_RDX = 2,
+    DYN_RBX = 3,
+    DYN_RSP = 4,
+    DYN_RBP = 5,
+    DYN_RSI = 6,
+    DYN_RDI = 7,
+    DYN_R8 = 8,
+    DYN_R9 = 9,
+    DYN_R10 = 10,
+    DYN_R11 = 11,
+    DYN_R12 = 12,
+    DYN_R13 = 13,
+    DYN_R14 = 14,
+    DYN_R15 = 15,
+    DYN_NOT_SET=0xff
+};
+
+enum DynCondition {
+    DYN_EQUALS_ZERO,
+    DYN_NOT_EQUALS_ZERO
+};
+
+enum DynConditionEvaluate {
+    DYN_EQUALS,
+    DYN_NOT_EQUALS,
+    DYN_LESS_THAN_UNSIGNED,
+    DYN_LESS_THAN_EQUAL_UNSIGNED,
+    DYN_GREATER_THAN_EQUAL_UNSIGNED,
+    DYN_LESS_THAN_SIGNED,
+    DYN_LESS_THAN_EQUAL_SIGNED,
+};
+
+// does not have be saved across function calls
+#define DYN_CALL_RESULT DYN_RAX
+
+// r12-r14 are callee saved, so they don't need to be pushed around a call to a helper
+#define DYN_SRC DYN_R12
+#define DYN_DEST DYN_R13
+#define DYN_ADDRESS DYN_R14
+#define DYN_ANY DYN_DEST
+
+#define DYN_PTR_SIZE U64
+
+enum DynWidth {
+    DYN_8bit=0,
+    DYN_16bit,
+    DYN_32bit,
+    DYN_64bit
+};
+
+enum DynCallParamType {
+    DYN_PARAM_REG_8,
+    DYN_PARAM_REG_16,
+    DYN_PARAM_REG_32,
+    DYN_PARAM_CONST_8,
+    DYN_PARAM_CONST_16,
+    DYN_PARAM_CONST_32,
+    DYN_PARAM_CONST_PTR,
+    DYN_PARAM_ABSOLUTE_ADDRESS_8,
+    DYN_PARAM_ABSOLUTE_ADDRESS_16,
+    DYN_PARAM_ABSOLUTE_ADDRESS_32,
+    DYN_PARAM_CPU_ADDRESS_8,
+    DYN_PARAM_CPU_ADDRESS_16,
+    DYN_PARAM_CPU_ADDRESS_32,
+    DYN_PARAM_CPU,
+};
+
+enum DynConditional {
+    O,
+    NO,
+    B,
+    NB,
+    Z,
+    NZ,
+    BE,
+    NBE,
+    S,
+    NS,
+    P,
+    NP,
+    L,
+    NL,
+    LE,
+    NLE
+};
+
+#define Dyn_PtrSize DYN_64bit
+
+// helper, can be done with multiple other calls
+void movToCpuFromMem(U32 dstOffset, DynWidth dstWidth, DynReg addressReg, bool doneWithAddressReg, bool doneWithCallResult);
+void movToCpuFromCpu(U32 dstOffset, U32 srcOffset, DynWidth width, DynReg tmpReg, bool doneWithTmpReg);
+void calculateEaa(DecodedOp* op, DynReg reg);
+
+void byteSwapReg32(DynReg reg);
+
+// REG to REG
+void movToRegFromRegSignExtend(DynReg dst, DynWidth dstWidth, DynReg src, DynWidth srcWidth, bool doneWithSrcReg);
+void movToRegFromReg(DynReg dst, DynWidth dstWidth, DynReg src, DynWidth srcWidth, bool doneWithSrcReg);
+
+// to Reg
+void movToReg(DynReg reg, DynWidth width, U32 imm);
+
+// to CPU
+void movToCpuFromReg(U32 dstOffset, DynReg reg, DynWidth width, bool doneWithReg);
+void movToCpu(U32 dstOffset, DynWidth dstWidth, U32 imm);
+void movToCpuPtr(U32 dstOffset, DYN_PTR_SIZE imm);
+
+// from CPU
+void movToRegFromCpu(DynReg reg, U32 srcOffset, DynWidth width);
+
+// from Mem to DYN_CALL_RESULT
+void movFromMem(DynWidth width, DynReg addressReg, bool doneWithAddressReg);
+
+// to Mem
+void movToMemFromReg(DynReg addressReg, DynReg reg, DynWidth width, bool doneWithAddressReg, bool doneWithReg);
+void movToMemFromImm(DynReg addressReg, DynWidth width, U32 imm, bool doneWithAddressReg);
+
+// arith
+void instRegReg(char inst, DynReg reg, DynReg rm, DynWidth regWidth, bool doneWithRmReg);
+void instMemReg(char inst, DynReg addressReg, DynReg rm, DynWidth regWidth, bool doneWithAddressReg, bool doneWithRmReg);
+void instCPUReg(char inst, U32 dstOffset, DynReg rm, DynWidth regWidth, bool doneWithRmReg);
+
+void instRegImm(U32 inst, DynReg reg, DynWidth regWidth, U32 imm);
+void instMemImm(char inst, DynReg addressReg, DynWidth regWidth, U32 imm, bool doneWithAddressReg);
+void instCPUImm(char inst, U32 dstOffset, DynWidth regWidth, U32 imm);
+
+void instReg(char inst, DynReg reg, DynWidth regWidth);
+void instMem(char inst, DynReg addressReg, DynWidth regWidth, bool doneWithAddressReg);
+void instCPU(char inst, U32 dstOffset, DynWidth regWidth);
+
+// if conditions
+void startIf(DynReg reg, DynCondition condition, bool doneWithReg);
+void startElse();
+void endIf();
+void evaluateToReg(DynReg reg, DynWidth dstWidth, DynReg left, bool isRightConst, DynReg right, U32 rightConst, DynWidth regWidth, DynConditionEvaluate condition, bool doneWithLeftReg, bool doneWithRightReg);
+void setCPU(DynamicData* data, U32 offset, DynWidth regWidth, DynConditional condition);
+void setMem(DynamicData* data, DynReg addressReg, DynWidth regWidth, DynConditional condition, bool doneWithAddressReg);
+
+// call into emulator, like setFlags, getCF, etc
+void callHostFunction(void* address, bool hasReturn=false, U32 argCount=0, DYN_PTR_SIZE arg1=0, DynCallParamType arg1Type=DYN_PARAM_CONST_32, bool doneWithArg1=true, DYN_PTR_SIZE arg2=0, DynCallParamType arg2Type=DYN_PARAM_CONST_32, bool doneWithArg2=true, DYN_PTR_SIZE arg3=0, DynCallParamType arg3Type=DYN_PARAM_CONST_32, bool doneWithArg3=true, DYN_PTR_SIZE arg4=0, DynCallParamType arg4Type=DYN_PARAM_CONST_32, bool doneWithArg4=true, DYN_PTR_SIZE arg5=0, DynCallParamType arg5Type=DYN_PARAM_CONST_32, bool doneWithArg5=true);
+
+// set up the cpu to the correct next block
+
+// this is called for cases where we don't know ahead of time where the next block will be, so we need to look it up
+void blockDone();
+// next block is also set in common_other.cpp for loop instructions, so don't use this as a hook for something else
+void blockNext1();
+void blockNext2();
+
+/********************************************************/
+/* End required for dynamic code                        */
+/********************************************************/
+
+// referenced in macro above
+void incrementEip(DynamicData* data, DecodedOp* op);
+void incrementEip(DynamicData* data, U32 len);
+
+#include "../normal/instructions.h"
+#include "../common/common_arith.h"
+#include "../common/common_pushpop.h"
+#include "../dynamic/dynamic_func.h"
+#include "../dynamic/dynamic_arith.h"
+#include "../dynamic/dynamic_mov.h"
+#include "../dynamic/dynamic_incdec.h"
+#include "../dynamic/dynamic_jump.h"
+#include "../dynamic/dynamic_pushpop.h"
+#include "../dynamic/dynamic_strings.h"
+#include "../dynamic/dynamic_shift.h"
+#include "../dynamic/dynamic_conditions.h"
+#include "../dynamic/dynamic_setcc.h"
+#include "../dynamic/dynamic_xchg.h"
+#include "../dynamic/dynamic_bit.h"
+#include "../dynamic/dynamic_other.h"
+#include "../dynamic/dynamic_mmx.h"
+#include "../dynamic/dynamic_sse.h"
+#include "../dynamic/dynamic_sse2.h"
+#include "../dynamic/dynamic_fpu.h"
+
+static U8* outBuffer;
+static U32 outBufferSize;
+static U32 outBufferPos;
+
+static std::vector<U32> ifJump;
+
+// System V: rdi, rsi, rdx, rcx, r8 and r9 are used for params, rax for the return value
+// rbx, rbp and r12-r15 are callee saved
+//
+// rbx holds the CPU
+// rax is the call result
+// r12-r14 are src, dest and address
+// r8-r11 are tmp, they can't be in use when a helper is called
+// rcx is only used to hold the amount for a shift and for params
+
+#define REG_CPU DYN_RBX
+
+#define MIN_UNSAVED_REG 8
+#define MAX_UNSAVED_REG 11
+
+static const U8 paramRegs[] = {DYN_RDI, DYN_RSI, DYN_RDX, DYN_RCX, DYN_R8};
+
+DynReg getUnsavedTmpReg() {
+    for (int i = MIN_UNSAVED_REG; i <= MAX_UNSAVED_REG; i++) {
+        if (!regUsed[i]) {
+            setRegUsed(i);
+            return (DynReg)i;
+        }
+    }
+    kpanic("Could not find unused tmp reg");
+    return (DynReg)0;
+}
+
+void ensureBufferSize(U32 grow) {
+    if (!outBuffer) {
+        outBuffer = new U8[256];
+        outBufferSize = 256;
+    }
+    if (outBufferSize-outBufferPos<grow) {
+        U8* t =  new U8[outBufferSize*2];
+        memcpy(t, outBuffer, outBufferSize);
+        delete[] outBuffer;
+        outBuffer = t;
+        outBufferSize = outBufferSize*2;
+    }
+}
+
+void outb(U8 b) {
+    ensureBufferSize(1);
+    outBuffer[outBufferPos++]=b;
+}
+
+void outw(U16 w) {
+    outb((U8)w);
+    outb((U8)(w>>8));
+}
+
+void outd(U32 d) {
+    outb((U8)d);
+    outb((U8)(d>>8));
+    outb((U8)(d>>16));
+    outb((U8)(d>>24));
+}
+
+void outq(U64 q) {
+    outd((U32)q);
+    outd((U32)(q>>32));
+}
+
+// REX prefix for an instruction with two register operands, only written if it is needed.  spl, bpl, sil and dil need
+// a REX prefix to be used as 8-bit registers.
+static void rexRegReg(bool w, U8 reg, U8 rm, bool byteRegs) {
+    U8 rex = 0x40;
+    if (w)
+        rex |= 0x08;
+    if (reg & 8)
+        rex |= 0x04;
+    if (rm & 8)
+        rex |= 0x01;
+    if (rex != 0x40 || (byteRegs && (reg >= 4 || rm >= 4)))
+        outb(rex);
+}
+
+// REX prefix for an instruction with a register and a [base+offset] operand
+static void rexRegMem(bool w, U8 reg, U8 base, bool byteReg) {
+    U8 rex = 0x40;
+    if (w)
+        rex |= 0x08;
+    if (reg & 8)
+        rex |= 0x04;
+    if (base & 8)
+        rex |= 0x01;
+    if (rex != 0x40 || (byteReg && reg >= 4))
+        outb(rex);
+}
+
+static void modRegReg(U8 reg, U8 rm) {
+    outb(0xc0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+// [base+offset], rsp and r12 need a SIB byte as the base.  mod 00 is never used so rbp and r13 don't need a special case.
+static void modRegMem(U8 reg, U8 base, S32 offset) {
+    bool smallOffset = offset >= -128 && offset <= 127;
+    outb((smallOffset ? 0x40 : 0x80) | ((reg & 7) << 3) | (base & 7));
+    if ((base & 7) == 4) {
+        outb(0x24);
+    }
+    if (smallOffset) {
+        outb((U8)offset);
+    } else {
+        outd((U32)offset);
+    }
+}
+
+// op reg, rm
+static void instRegReg32(U8 op, U8 reg, U8 rm) {
+    rexRegReg(false, reg, rm, false);
+    outb(op);
+    modRegReg(reg, rm);
+}
+
+// op rm, imm where group is the /digit of the instruction
+static void instGroupImm32(U8 group, U8 rm, U32 value) {
+    S32 s = (S32)value;
+    rexRegReg(false, 0, rm, false);
+    if (s >= -128 && s <= 127) {
+        outb(0x83);
+        modRegReg(group, rm);
+        outb((U8)value);
+    } else {
+        outb(0x81);
+        modRegReg(group, rm);
+        outd(value);
+    }
+}
+
+void clearTop16(U8 reg) {
+    // movzx reg, reg16
+    rexRegReg(false, reg, reg, false);
+    outb(0x0f);
+    outb(0xb7);
+    modRegReg(reg, reg);
+}
+
+void loadConstPtr(U8 reg, U64 value) {
+    if (value <= 0xFFFFFFFF) {
+        // mov reg32, value (upper 32-bits are zero'd)
+        rexRegReg(false, 0, reg, false);
+        outb(0xb8 + (reg & 7));
+        outd((U32)value);
+    } else {
+        // mov reg64, value
+        rexRegReg(true, 0, reg, false);
+        outb(0xb8 + (reg & 7));
+        outq(value);
+    }
+}
+
+void loadConst32(U8 reg, U32 value) {
+    loadConstPtr(reg, value);
+}
+
+// loads are zero extended to 32-bits
+void readMem8(U8 dst, U8 base, U64 offset) {
+    // movzx dst, byte [base+offset]
+    rexRegMem(false, dst, base, false);
+    outb(0x0f);
+    outb(0xb6);
+    modRegMem(dst, base, (S32)offset);
+}
+
+void readMem16(U8 dst, U8 base, U64 offset) {
+    // movzx dst, word [base+offset]
+    rexRegMem(false, dst, base, false);
+    outb(0x0f);
+    outb(0xb7);
+    modRegMem(dst, base, (S32)offset);
+}
+
+void readMem32(U8 dst, U8 base, U64 offset) {
+    // mov dst, [base+offset]
+    rexRegMem(false, dst, base, false);
+    outb(0x8b);
+    modRegMem(dst, base, (S32)offset);
+}
+
+void readMem64(U8 dst, U8 base, U64 offset) {
+    // mov dst, [base+offset]
+    rexRegMem(true, dst, base, false);
+    outb(0x8b);
+    modRegMem(dst, base, (S32)offset);
+}
+
+void readMemPtr(U8 dst, U8 base, U64 offset) {
+    readMem64(dst, base, offset);
+}
+
+void writeMem8(U8 src, U8 base, U64 offset) {
+    // mov byte [base+offset], src
+    rexRegMem(false, src, base, true);
+    outb(0x88);
+    modRegMem(src, base, (S32)offset);
+}
+
+void writeMem16(U8 src, U8 base, U64 offset) {
+    // mov word [base+offset], src
+    outb(0x66);
+    rexRegMem(false, src, base, false);
+    outb(0x89);
+    modRegMem(src, base, (S32)offset);
+}
+
+void writeMem32(U8 src, U8 base, U64 offset) {
+    // mov [base+offset], src
+    rexRegMem(false, src, base, false);
+    outb(0x89);
+    modRegMem(src, base, (S32)offset);
+}
+
+void writeMem64(U8 src, U8 base, U64 offset) {
+    // mov [base+offset], src
+    rexRegMem(true, src, base, false);
+    outb(0x89);
+    modRegMem(src, base, (S32)offset);
+}
+
+void loadFromCpuOffset8(U8 reg, U32 offset) {
+    readMem8(reg, REG_CPU, offset);
+}
+
+void loadFromCpuOffset16(U8 reg, U32 offset) {
+    readMem16(reg, REG_CPU, offset);
+}
+
+void loadFromCpuOffset32(U8 reg, U32 offset) {
+    readMem32(reg, REG_CPU, offset);
+}
+
+void saveRegToCpuOffset8(U8 reg, U32 offset) {
+    writeMem8(reg, REG_CPU, offset);
+}
+
+void saveRegToCpuOffset16(U8 reg, U32 offset) {
+    writeMem16(reg, REG_CPU, offset);
+}
+
+void saveRegToCpuOffset32(U8 reg, U32 offset) {
+    writeMem32(reg, REG_CPU, offset);
+}
+
+void saveRegToCpuOffsetPtr(U8 reg, U32 offset) {
+    writeMem64(reg, REG_CPU, offset);
+}
+
+void saveValueToCpuOffset8(U8 value, U32 offset) {
+    // mov byte [cpu+offset], value
+    rexRegMem(false, 0, REG_CPU, false);
+    outb(0xc6);
+    modRegMem(0, REG_CPU, offset);
+    outb(value);
+}
+
+void saveValueToCpuOffset16(U16 value, U32 offset) {
+    // mov word [cpu+offset], value
+    outb(0x66);
+    rexRegMem(false, 0, REG_CPU, false);
+    outb(0xc7);
+    modRegMem(0, REG_CPU, offset);
+    outw(value);
+}
+
+void saveValueToCpuOffset32(U32 value, U32 offset) {
+    // mov dword [cpu+offset], value
+    rexRegMem(false, 0, REG_CPU, false);
+    outb(0xc7);
+    modRegMem(0, REG_CPU, offset);
+    outd(value);
+}
+
+void saveValueToCpuOffsetPtr(DYN_PTR_SIZE value, U32 offset) {
+    if ((S64)value == (S64)(S32)value) {
+        // mov qword [cpu+offset], value (sign extended)
+        rexRegMem(true, 0, REG_CPU, false);
+        outb(0xc7);
+        modRegMem(0, REG_CPU, offset);
+        outd((U32)value);
+    } else {
+        U8 tmp = getUnsavedTmpReg();
+        loadConstPtr(tmp, value);
+        saveRegToCpuOffsetPtr(tmp, offset);
+        clearRegUsed(tmp);
+    }
+}
+
+void addRegs32(U8 reg, U8 reg2) {
+    // add reg, reg2
+    instRegReg32(0x01, reg2, reg);
+}
+
+void addValue32(U8 reg, U32 value) {
+    instGroupImm32(0, reg, value);
+}
+
+void subRegs32(U8 reg, U8 reg2) {
+    // sub reg, reg2
+    instRegReg32(0x29, reg2, reg);
+}
+
+void subValue32(U8 reg, U32 value) {
+    instGroupImm32(5, reg, value);
+}
+
+void orRegs32(U8 reg, U8 reg2) {
+    // or reg, reg2
+    instRegReg32(0x09, reg2, reg);
+}
+
+void orValue32(U8 reg, U32 value) {
+    instGroupImm32(1, reg, value);
+}
+
+void xorRegs32(U8 reg, U8 reg2) {
+    // xor reg, reg2
+    instRegReg32(0x31, reg2, reg);
+}
+
+void xorValue32(U8 reg, U32 value) {
+    instGroupImm32(6, reg, value);
+}
+
+void andRegs32(U8 reg, U8 reg2) {
+    // and reg, reg2
+    instRegReg32(0x21, reg2, reg);
+}
+
+void andValue32(U8 reg, U32 value) {
+    instGroupImm32(4, reg, value);
+}
+
+void mov32(U8 dst, U8 src) {
+    // mov dst, src
+    instRegReg32(0x89, src, dst);
+}
+
+void andValue32(U8 dst, U8 src, U32 value) {
+    if (dst != src) {
+        mov32(dst, src);
+    }
+    andValue32(dst, value);
+}
+
+void negReg32(U8 reg) {
+    // neg reg
+    rexRegReg(false, 0, reg, false);
+    outb(0xf7);
+    modRegReg(3, reg);
+}
+
+void notReg32(U8 reg) {
+    // not reg
+    rexRegReg(false, 0, reg, false);
+    outb(0xf7);
+    modRegReg(2, reg);
+}
+
+void zeroReg32(U8 reg) {
+    // xor reg, reg
+    instRegReg32(0x31, reg, reg);
+}
+
+static void shift32(U8 group, U8 reg, U8 amount) {
+    rexRegReg(false, 0, reg, false);
+    if (amount == 1) {
+        outb(0xd1);
+        modRegReg(group, reg);
+    } else {
+        outb(0xc1);
+        modRegReg(group, reg);
+        outb(amount);
+    }
+}
+
+// x86 can only shift by cl, the generic code already masked the amount to 5 bits
+static void shift32WithReg(U8 group, U8 reg, U8 amount) {
+    if (amount != DYN_RCX) {
+        mov32(DYN_RCX, amount);
+    }
+    rexRegReg(false, 0, reg, false);
+    outb(0xd3);
+    modRegReg(group, reg);
+}
+
+void shiftLeft32(U8 reg, U8 amount) {
+    shift32(4, reg, amount);
+}
+
+void shiftLeft32WithReg(U8 reg, U8 amount) {
+    shift32WithReg(4, reg, amount);
+}
+
+void shiftRight32(U8 reg, U8 amount) {
+    shift32(5, reg, amount);
+}
+
+void shiftRight32WithReg(U8 reg, U8 amount) {
+    shift32WithReg(5, reg, amount);
+}
+
+void shiftRightSigned32(U8 reg, U8 amount) {
+    shift32(7, reg, amount);
+}
+
+void shiftRightSigned32WithReg(U8 reg, U8 amount) {
+    shift32WithReg(7, reg, amount);
+}
+
+void mov64(U8 dst, U8 src) {
+    // mov dst, src
+    rexRegReg(true, src, dst, false);
+    outb(0x89);
+    modRegReg(src, dst);
+}
+
+void movPtr(U8 dst, U8 src) {
+    mov64(dst, src);
+}
+
+static void movExtend(U8 op, U8 dst, U8 src, bool byteSrc) {
+    rexRegReg(false, dst, src, byteSrc);
+    outb(0x0f);
+    outb(op);
+    modRegReg(dst, src);
+}
+
+void mov32zx16(U8 dst, U8 src) {
+    // movzx dst, src16
+    movExtend(0xb7, dst, src, false);
+}
+
+void mov32zx8(U8 dst, U8 src) {
+    // movzx dst, src8
+    movExtend(0xb6, dst, src, true);
+}
+
+void mov32sx16(U8 dst, U8 src) {
+    // movsx dst, src16
+    movExtend(0xbf, dst, src, false);
+}
+
+void mov32sx8(U8 dst, U8 src) {
+    // movsx dst, src8
+    movExtend(0xbe, dst, src, true);
+}
+
+void cmpRegs32(U8 r1, U8 r2) {
+    // cmp r1, r2
+    instRegReg32(0x39, r2, r1);
+}
+
+void cmpRegValue32(U8 reg, U32 value) {
+    instGroupImm32(7, reg, value);
+}
+
+// jumps are always rel32, the returned position is where the amount will be written
+static U32 jump(U8 op) {
+    if (op != 0xe9) {
+        outb(0x0f);
+    }
+    outb(op);
+    U32 pos = outBufferPos;
+    outd(0);
+    return pos;
+}
+
+U32 jumpIfEqual() {
+    return jump(0x84); // jz
+}
+
+U32 jumpIfNotEqual() {
+    return jump(0x85); // jnz
+}
+
+U32 unconditionalJump() {
+    return jump(0xe9); // jmp
+}
+
+void writeJumpAmount(U32 pos, U32 toLocation) {
+    U32 amount = toLocation - (pos + 4);
+    outBuffer[pos] = (U8)amount;
+    outBuffer[pos + 1] = (U8)(amount >> 8);
+    outBuffer[pos + 2] = (U8)(amount >> 16);
+    outBuffer[pos + 3] = (U8)(amount >> 24);
+}
+
+void evaluateCondition(U8 reg, DynConditionEvaluate condition) {
+    U8 setcc = 0;
+
+    switch (condition) {
+    case DYN_EQUALS:
+        setcc = 0x94; // sete
+        break;
+    case DYN_NOT_EQUALS:
+        setcc = 0x95; // setne
+        break;
+    case DYN_LESS_THAN_UNSIGNED:
+        setcc = 0x92; // setb
+        break;
+    case DYN_LESS_THAN_EQUAL_UNSIGNED:
+        setcc = 0x96; // setbe
+        break;
+    case DYN_GREATER_THAN_EQUAL_UNSIGNED:
+        setcc = 0x93; // setae
+        break;
+    case DYN_LESS_THAN_SIGNED:
+        setcc = 0x9c; // setl
+        break;
+    case DYN_LESS_THAN_EQUAL_SIGNED:
+        setcc = 0x9e; // setle
+        break;
+    default:
+        kpanic("x64dynamic::evaluateCondition unknown condition %d", condition);
+    }
+    // setcc reg8
+    rexRegReg(false, 0, reg, true);
+    outb(0x0f);
+    outb(setcc);
+    modRegReg(0, reg);
+    mov32zx8(reg, reg);
+}
+
+void byteSwapReg32(DynReg reg) {
+    // bswap reg
+    rexRegReg(false, 0, reg, false);
+    outb(0x0f);
+    outb(0xc8 + (reg & 7));
+}
+
+static void pushReg(U8 reg) {
+    rexRegReg(false, 0, reg, false);
+    outb(0x50 + (reg & 7));
+}
+
+static void popReg(U8 reg) {
+    rexRegReg(false, 0, reg, false);
+    outb(0x58 + (reg & 7));
+}
+
+// with the return address that makes 6 pushes, so the stack is 16-byte aligned for calls
+static const U8 savedRegs[] = {DYN_RBX, DYN_R12, DYN_R13, DYN_R14, DYN_R15};
+
+void startBlock() {
+    for (U32 i = 0; i < sizeof(savedRegs); i++) {
+        pushReg(savedRegs[i]);
+    }
+    // the cpu is passed in rdi
+    movPtr(REG_CPU, DYN_RDI);
+}
+
+void endBlock() {
+    for (S32 i = sizeof(savedRegs) - 1; i >= 0; i--) {
+        popReg(savedRegs[i]);
+    }
+    outb(0xc3); // ret
+}
+
+// if ((address & 0xFFF) <= pageOffsetLimit) {
+//     U8* page = Memory::currentMMUReadPtr[address >> 12];
+//     if (page)
+//         <fast path>
+// }
+// <slow path>
+//
+// returns the jumps that go to the slow path, pos2 is 0 if there was no page offset check
+static void softMmuLookup(U8** table, U8 pageReg, U8 offsetReg, DynReg addressReg, DynWidth width, U32& pos1, U32& pos2) {
+    pos2 = 0;
+    if (width != DYN_8bit) {
+        mov32(offsetReg, addressReg);
+        andValue32(offsetReg, K_PAGE_MASK);
+        cmpRegValue32(offsetReg, width == DYN_16bit ? 0xFFF : 0xFFD);
+        pos2 = jump(0x83); // jae
+    }
+    // page = table[address >> 12]
+    mov32(offsetReg, addressReg);
+    shiftRight32(offsetReg, K_PAGE_SHIFT);
+    loadConstPtr(pageReg, (U64)table);
+    // mov page, [page+offset*8]
+    outb(0x48 | ((pageReg & 8) ? 0x04 : 0) | ((offsetReg & 8) ? 0x02 : 0) | ((pageReg & 8) ? 0x01 : 0));
+    outb(0x8b);
+    outb(0x04 | ((pageReg & 7) << 3));
+    outb(0xc0 | ((offsetReg & 7) << 3) | (pageReg & 7));
+    // test page, page
+    rexRegReg(true, pageReg, pageReg, false);
+    outb(0x85);
+    modRegReg(pageReg, pageReg);
+    pos1 = jumpIfEqual();
+
+    // page += address & 0xFFF
+    mov32(offsetReg, addressReg);
+    andValue32(offsetReg, K_PAGE_MASK);
+    rexRegReg(true, offsetReg, pageReg, false);
+    outb(0x01);
+    modRegReg(offsetReg, pageReg);
+}
+
+// the x32 backend inlines this the same way, only pages with a read pointer take the fast path
+U32 softMmuReadFastPath(DynWidth width, DynReg addressReg) {
+    U8 pageReg = getUnsavedTmpReg();
+    U8 offsetReg = getUnsavedTmpReg();
+    U32 pos1, pos2;
+
+    softMmuLookup(Memory::currentMMUReadPtr, pageReg, offsetReg, addressReg, width, pos1, pos2);
+    if (width == DYN_8bit) {
+        readMem8(DYN_CALL_RESULT, pageReg, 0);
+    } else if (width == DYN_16bit) {
+        readMem16(DYN_CALL_RESULT, pageReg, 0);
+    } else {
+        readMem32(DYN_CALL_RESULT, pageReg, 0);
+    }
+    clearRegUsed(pageReg);
+    clearRegUsed(offsetReg);
+    U32 result = unconditionalJump();
+    writeJumpAmount(pos1, outBufferPos);
+    if (pos2) {
+        writeJumpAmount(pos2, outBufferPos);
+    }
+    return result;
+}
+
+U32 softMmuWriteFastPath(DynReg addressReg, DynWidth width, U32 value, DynCallParamType paramType) {
+    U8 pageReg = getUnsavedTmpReg();
+    U8 offsetReg = getUnsavedTmpReg();
+    U32 pos1, pos2;
+
+    softMmuLookup(Memory::currentMMUWritePtr, pageReg, offsetReg, addressReg, width, pos1, pos2);
+    if (paramType == DYN_PARAM_REG_8 || paramType == DYN_PARAM_REG_16 || paramType == DYN_PARAM_REG_32) {
+        if (width == DYN_8bit) {
+            writeMem8(value, pageReg, 0);
+        } else if (width == DYN_16bit) {
+            writeMem16(value, pageReg, 0);
+        } else {
+            writeMem32(value, pageReg, 0);
+        }
+    } else {
+        if (width == DYN_8bit) {
+            rexRegMem(false, 0, pageReg, false);
+            outb(0xc6);
+            modRegMem(0, pageReg, 0);
+            outb((U8)value);
+        } else if (width == DYN_16bit) {
+            outb(0x66);
+            rexRegMem(false, 0, pageReg, false);
+            outb(0xc7);
+            modRegMem(0, pageReg, 0);
+            outw((U16)value);
+        } else {
+            rexRegMem(false, 0, pageReg, false);
+            outb(0xc7);
+            modRegMem(0, pageReg, 0);
+            outd(value);
+        }
+    }
+    clearRegUsed(pageReg);
+    clearRegUsed(offsetReg);
+    U32 result = unconditionalJump();
+    writeJumpAmount(pos1, outBufferPos);
+    if (pos2) {
+        writeJumpAmount(pos2, outBufferPos);
+    }
+    return result;
+}
+
+#define DYN_HAS_SOFT_MMU_FAST_PATH
+#include "../dynamic/dynamic_generic_base.h"
+
+static void setParam(U8 reg, DYN_PTR_SIZE arg, DynCallParamType argType) {
+    switch (argType) {
+    case DYN_PARAM_REG_8:
+        mov32zx8(reg, (U8)arg);
+        break;
+    case DYN_PARAM_REG_16:
+        mov32zx16(reg, (U8)arg);
+        break;
+    case DYN_PARAM_REG_32:
+        mov32(reg, (U8)arg);
+        break;
+    case DYN_PARAM_CPU:
+        movPtr(reg, REG_CPU);
+        break;
+    case DYN_PARAM_CONST_8:
+        loadConst32(reg, (U8)arg);
+        break;
+    case DYN_PARAM_CONST_16:
+        loadConst32(reg, (U16)arg);
+        break;
+    case DYN_PARAM_CONST_32:
+        loadConst32(reg, (U32)arg);
+        break;
+    case DYN_PARAM_CONST_PTR:
+        loadConstPtr(reg, arg);
+        break;
+    case DYN_PARAM_ABSOLUTE_ADDRESS_8:
+        loadConstPtr(reg, arg);
+        readMem8(reg, reg, 0);
+        break;
+    case DYN_PARAM_ABSOLUTE_ADDRESS_16:
+        loadConstPtr(reg, arg);
+        readMem16(reg, reg, 0);
+        break;
+    case DYN_PARAM_ABSOLUTE_ADDRESS_32:
+        loadConstPtr(reg, arg);
+        readMem32(reg, reg, 0);
+        break;
+    case DYN_PARAM_CPU_ADDRESS_8:
+        readMem8(reg, REG_CPU, arg);
+        break;
+    case DYN_PARAM_CPU_ADDRESS_16:
+        readMem16(reg, REG_CPU, arg);
+        break;
+    case DYN_PARAM_CPU_ADDRESS_32:
+        readMem32(reg, REG_CPU, arg);
+        break;
+    default:
+        kpanic("x64dynamic: unknown argType: %d", argType);
+        break;
+    }
+}
+
+void callHostFunction(void* address, bool hasReturn, U32 argCount, DYN_PTR_SIZE arg1, DynCallParamType arg1Type, bool doneWithArg1, DYN_PTR_SIZE arg2, DynCallParamType arg2Type, bool doneWithArg2, DYN_PTR_SIZE arg3, DynCallParamType arg3Type, bool doneWithArg3, DYN_PTR_SIZE arg4, DynCallParamType arg4Type, bool doneWithArg4, DYN_PTR_SIZE arg5, DynCallParamType arg5Type, bool doneWithArg5) {
+    DYN_PTR_SIZE args[] = {arg1, arg2, arg3, arg4, arg5};
+    DynCallParamType argTypes[] = {arg1Type, arg2Type, arg3Type, arg4Type, arg5Type};
+    bool doneWithArgs[] = {doneWithArg1, doneWithArg2, doneWithArg3, doneWithArg4, doneWithArg5};
+    bool regDone[NUMBER_OF_REGS] = { 0 };
+
+    for (U32 i = 0; i < argCount; i++) {
+        if (isParamTypeReg(argTypes[i])) {
+            if (args[i] >= NUMBER_OF_REGS) {
+                kpanic("x64dynamic::callHostFunction bad param %d: arg=%d argType=%d", i + 1, (U32)args[i], argTypes[i]);
+            }
+            // the params are only taken from regs that aren't used to pass params, so the order they are set in doesn't matter
+            for (U32 p = 0; p < sizeof(paramRegs); p++) {
+                if (args[i] == paramRegs[p]) {
+                    kpanic("x64dynamic::callHostFunction param %d is in a param reg: %d", i + 1, (U32)args[i]);
+                }
+            }
+            if (doneWithArgs[i]) {
+                regDone[args[i]] = true;
+            }
+        }
+    }
+    for (int i = MIN_UNSAVED_REG; i <= MAX_UNSAVED_REG; i++) {
+        if (regUsed[i] && !regDone[i]) {
+            kpanic("Unsaved reg in use while calling function");
+        }
+    }
+    // rax is the only other caller saved reg that can be in use, push it twice so that the stack stays aligned
+    bool saveResult = regUsed[DYN_CALL_RESULT] && !hasReturn && !regDone[DYN_CALL_RESULT];
+    if (saveResult) {
+        pushReg(DYN_CALL_RESULT);
+        pushReg(DYN_CALL_RESULT);
+    }
+    for (U32 i = 0; i < argCount; i++) {
+        setParam(paramRegs[i], args[i], argTypes[i]);
+    }
+    loadConstPtr(DYN_R11, (U64)address);
+    // call r11
+    rexRegReg(false, 0, DYN_R11, false);
+    outb(0xff);
+    modRegReg(2, DYN_R11);
+
+    if (saveResult) {
+        popReg(DYN_CALL_RESULT);
+        popReg(DYN_CALL_RESULT);
+    }
+    for (int i = 0; i < NUMBER_OF_REGS; i++) {
+        if (regDone[i]) {
+            clearRegUsed(i);
+        }
+    }
+    if (hasReturn) {
+        regUsed[DYN_CALL_RESULT] = true;
+    }
+}
+#endif
@@ -0,0 +1,8 @@
+#ifndef __X64DYNAMICCPU_H__
+#define __X64DYNAMICCPU_H__
+
+#ifdef BOXEDWINE_DYNAMIC_X64
+void OPCALL firstDynamicOp(CPU* cpu, DecodedOp* op);
+#endif
+
+#endif
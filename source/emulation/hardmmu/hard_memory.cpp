@@ -24,6 +24,18 @@
 #include "hard_memory.h"
 #include "../cpu/binaryTranslation/btCodeMemoryWrite.h"
 #include "../cpu/binaryTranslation/btCodeChunk.h"
+#include "../cpu/binaryTranslation/btCpu.h"
+#include "../cpu/binaryTranslation/btInterpreter.h"
+#include "../cpu/binaryTranslation/btCodeCache.h"
+
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+std::atomic<U64> Memory::allLiveExecutableMemorySize;
+U64 Memory::peakLiveExecutableMemorySize;
+
+// shared by all Memory's so that no two of them ever use the same generation
+static std::atomic<U64> lastCodeGeneration;
+static BOXEDWINE_MUTEX codeGenerationMutex;
+#endif
 
 Memory::Memory() : allocated(0), callbackPos(0) {
     memset(flags, 0, sizeof(flags));
@@ -41,6 +53,17 @@ Memory::Memory() : allocated(0), callbackPos(0) {
     this->eipToHostInstructionAddressSpaceMapping = NULL;
     memset(this->dynamicCodePageUpdateCount, 0, sizeof(this->dynamicCodePageUpdateCount));
     memset(this->committedEipPages, 0, sizeof(this->committedEipPages));
+    this->codeChunkClockPruneSize = 1024;
+    this->executableMemoryEpoch = 0;
+    this->liveExecutableMemorySize = 0;
+    this->retiredExecutableMemoryCount = 0;
+    this->reclaimedExecutableMemoryCount = 0;
+    this->evictedCodeChunkCount = 0;
+    this->codePageDataWriteCount = 0;
+    this->codePageCodeWriteCount = 0;
+    this->executableBlockIndex = NULL;
+    this->pendingExecutableMemory = NULL;
+    codeReleased();
 #endif    
     reserveNativeMemory();
 
@@ -60,6 +83,11 @@ Memory::~Memory() {
     if (this->eipToHostInstructionPages) {
         delete[] this->eipToHostInstructionPages;
     }
+    for (auto& cpu : this->codeThreads) {
+        cpu->codeMemory = NULL;
+        cpu->codeEpochSource = NULL;
+        cpu->codeGeneration = NULL;
+    }
 #endif
 }
 
@@ -113,11 +141,16 @@ void Memory::releaseNativeMemory() {
     memset(this->memOffsets, 0, sizeof(this->memOffsets));
     this->allocated = 0;
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->sharedCodePagesMutex);
+        this->sharedCodePages.clear();
+    }
     executableMemoryReleased();
     for (auto& p : this->allocatedExecutableMemory) {
         Platform::releaseNativeMemory(p.memory, p.size);
     }
     this->allocatedExecutableMemory.clear();
+    freeExecutableBlockIndexes();
     if (KSystem::useLargeAddressSpace) {
         Platform::releaseNativeMemory((char*)this->eipToHostInstructionAddressSpaceMapping, 0x800000000l);
         this->eipToHostInstructionAddressSpaceMapping = NULL;
@@ -143,12 +176,22 @@ void Memory::commitHostAddressSpaceMapping(U32 page, U32 pageCount, U64 defaultV
 void Memory::reset(U32 page, U32 pageCount) {
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(pageMutex);
     this->clearNeedsMemoryOffset(page, pageCount);
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    setSharedCodeFile(page, pageCount, NULL, 0);
+#endif
     freeNativeMemory(page, pageCount);        
 }
 
 void Memory::clone(Memory* from) {
     int i=0;    
 
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(from->sharedCodePagesMutex);
+        this->sharedCodePages = from->sharedCodePages;
+    }
+#endif
+
     for (i=0;i<0x100000;i++) {
         if (from->isPageAllocated(i)) {
             if (from->flags[i] & PAGE_MAPPED_HOST) {
@@ -230,6 +273,14 @@ void Memory::allocPages(U32 page, U32 pageCount, U8 permissions, FD fd, U64 offs
         this->clearCodePageFromCache(page + i);
     }
     this->clearNeedsMemoryOffset(page, pageCount);
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    // a shared mapping can be written by another process at any time, so only private mappings share translations
+    if (mappedFile && mappedFile->file && !(permissions & PAGE_SHARED)) {
+        setSharedCodeFile(page, pageCount, BtCodeCache::getSharedFile(mappedFile->file->openFile->node->path), offset);
+    } else {
+        setSharedCodeFile(page, pageCount, NULL, 0);
+    }
+#endif
     if ((permissions & PAGE_PERMISSION_MASK) || mappedFile) {
         if ((permissions & PAGE_SHARED) == 0) {
             allocNativeMemory(page, pageCount, permissions);
@@ -461,6 +512,7 @@ void writeb(U32 address, U8 value) {
     } else if ((flags & NATIVE_FLAG_COMMITTED) || (m->flags[page] & PAGE_MAPPED_HOST)) {
         *(U8*)getNativeAddress(KThread::currentThread()->memory, address) = value;
     } else {
+        BtInterpreter::leaveIfRunning(KThread::currentThread()->cpu);
         kpanic("writeb about to crash");
     }
 #else
@@ -496,6 +548,7 @@ void writew( U32 address, U16 value) {
     } else if (flags & NATIVE_FLAG_COMMITTED || (m->flags[page] & PAGE_MAPPED_HOST)) {
         *(U16*)getNativeAddress(KThread::currentThread()->memory, address) = value;
     } else {
+        BtInterpreter::leaveIfRunning(KThread::currentThread()->cpu);
         kpanic("writew about to crash");
     }
 #else
@@ -531,6 +584,7 @@ void writed(U32 address, U32 value) {
     } else if ((flags & NATIVE_FLAG_COMMITTED) || (m->flags[page] & PAGE_MAPPED_HOST)) {
         *(U32*)getNativeAddress(KThread::currentThread()->memory, address) = value;
     } else {
+        BtInterpreter::leaveIfRunning(KThread::currentThread()->cpu);
         kpanic("writed about to crash");
     }
 #else
@@ -555,6 +609,7 @@ void writeq(U32 address, U64 value) {
     } else if ((flags & NATIVE_FLAG_COMMITTED) || (m->flags[page] & PAGE_MAPPED_HOST)) {
         *(U64*)getNativeAddress(KThread::currentThread()->memory, address) = value;
     } else {
+        BtInterpreter::leaveIfRunning(KThread::currentThread()->cpu);
         kpanic("writeq about to crash");
     }
 #else
@@ -735,6 +790,14 @@ void Memory::clearCodePageFromCache(U32 page) {
             U64 offset = (U64)(page << K_PAGE_SHIFT) * sizeof(void*);
             U64* address64 = (U64*)((U8*)this->eipToHostInstructionAddressSpaceMapping + offset);
             for (U32 j = 0; j < K_PAGE_SIZE; j++, address64++) {
+                void* hostAddress = (void*)*address64;
+                // release the chunks like the small address space does, otherwise their executable memory is never freed
+                if (hostAddress && hostAddress != process->reTranslateChunkAddressFromReg && thread->memory == this) {
+                    std::shared_ptr<BtCodeChunk> chunk = this->getCodeChunkContainingHostAddress(hostAddress);
+                    if (chunk) {
+                        chunk->release(this);
+                    }
+                }
                 *address64 = (U64)process->reTranslateChunkAddressFromReg;
             }
         }
@@ -759,6 +822,7 @@ void Memory::clearCodePageFromCache(U32 page) {
     U32 nativePage = this->getNativePage(page);
     U32 startingPage = this->getEmulatedPage(nativePage);
     this->dynamicCodePageUpdateCount[nativePage] = 0;
+    this->codePageWrites.erase(page);
     if (this->eipToHostInstructionPages) {
         for (int i=0;i<K_NATIVE_PAGES_PER_PAGE;i++) {
             if (this->eipToHostInstructionPages[startingPage+i]) {
@@ -838,14 +902,9 @@ U8* getPhysicalWriteAddress(U32 address, U32 len) {
 
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
 // called when BtCodeChunk is being dealloc'd
-void Memory::removeCodeChunk(const std::shared_ptr<BtCodeChunk>& chunk) {
-    U32 hostPage = (U32)(((size_t)chunk->getHostAddress()) >> K_PAGE_SHIFT);
-    if (this->codeChunksByHostPage.count(hostPage)) {
-        std::shared_ptr< std::list<std::shared_ptr<BtCodeChunk>> > chunks = this->codeChunksByHostPage[hostPage];
-        chunks->remove(chunk);
-        if (chunks->size() == 0) {
-            this->codeChunksByHostPage.erase(hostPage);
-        }
+void Memory::removeCodeChunk(const std::shared_ptr<BtCodeChunk>& chunk, bool keepHostMapping) {
+    if (!keepHostMapping) {
+        removeCodeChunkHostMapping(chunk);
     }
 
     U32 emulationPage = (chunk->getEip()) >> K_PAGE_SHIFT;
@@ -858,29 +917,30 @@ void Memory::removeCodeChunk(const std::shared_ptr<BtCodeChunk>& chunk) {
     }
 }
 
+void Memory::removeCodeChunkHostMapping(const std::shared_ptr<BtCodeChunk>& chunk) {
+    std::atomic<BtCodeChunk*>* slot = findExecutableSlot(chunk->getHostAddress());
+    BtCodeChunk* expected = chunk.get();
+
+    // the slot might already belong to the chunk that replaced this one
+    if (slot) {
+        slot->compare_exchange_strong(expected, NULL);
+    }
+}
+
 // called when BtCodeChunk is being alloc'd
 void Memory::addCodeChunk(const std::shared_ptr<BtCodeChunk>& chunk) {
-    U32 hostPage = (U32)(((size_t)chunk->getHostAddress()) >> K_PAGE_SHIFT);
     U32 emulationPage = (chunk->getEip()) >> K_PAGE_SHIFT;
+    std::atomic<BtCodeChunk*>* slot = findExecutableSlot(chunk->getHostAddress());
+
+    if (!slot) {
+        kpanic("Memory::addCodeChunk host address was not allocated with allocateExcutableMemory");
+    }
 #ifdef _DEBUG
-    U32 lastPage = (U32)(((size_t)((U8*)chunk->getHostAddress() + chunk->getHostAddressLen())) >> K_PAGE_SHIFT);
-    for (U32 i=hostPage;i<=lastPage;i++) {
-        if (this->codeChunksByHostPage.count(hostPage)) {
-            std::shared_ptr< std::list<std::shared_ptr<BtCodeChunk>> > chunks = this->codeChunksByHostPage[hostPage];
-            for (auto& otherChunk : *chunks) {
-                if (otherChunk->containsHostAddress(chunk->getHostAddress())) {
-                    kpanic("Memory::addCodeChunk chunks can not overlap");
-                }
-            }
-        }
+    if (slot->load() && slot->load() != chunk.get()) {
+        kpanic("Memory::addCodeChunk chunks can not overlap");
     }
 #endif
-    std::shared_ptr< std::list<std::shared_ptr<BtCodeChunk>> > hostChunks = this->codeChunksByHostPage[hostPage];
-    if (!hostChunks) {
-        hostChunks = std::make_shared< std::list<std::shared_ptr<BtCodeChunk>> >();
-        this->codeChunksByHostPage[hostPage] = hostChunks;
-    }
-    hostChunks->push_back(chunk);
+    slot->store(chunk.get());
 
     std::shared_ptr< std::list<std::shared_ptr<BtCodeChunk>> > chunks = this->codeChunksByEmulationPage[emulationPage];
     if (!chunks) {
@@ -888,6 +948,25 @@ void Memory::addCodeChunk(const std::shared_ptr<BtCodeChunk>& chunk) {
         this->codeChunksByEmulationPage[emulationPage] = chunks;
     }
     chunks->push_back(chunk);
+
+    if (!chunk->isDynamicAware()) {
+        U32 address = chunk->getEip();
+        U32 len = chunk->getEipLen();
+        for (U32 page = address >> K_PAGE_SHIFT; len && page <= ((address + len - 1) >> K_PAGE_SHIFT); page++) {
+            addCodeRegions(&this->codePageWrites[page].codeRegions, page, address, len);
+        }
+    }
+
+    if (KSystem::btCodeCacheSize) {
+        if (this->codeChunkClock.size() >= this->codeChunkClockPruneSize) {
+            this->codeChunkClock.remove_if([](const std::weak_ptr<BtCodeChunk>& p) {
+                std::shared_ptr<BtCodeChunk> c = p.lock();
+                return !c || !c->isLive();
+                });
+            this->codeChunkClockPruneSize = std::max((size_t)1024, this->codeChunkClock.size() * 2);
+        }
+        this->codeChunkClock.push_back(chunk);
+    }
 }
 
 void Memory::makeNativePageDynamic(U32 nativePage) {
@@ -927,37 +1006,115 @@ void Memory::makeNativePageDynamic(U32 nativePage) {
     }
 }
 
-// only called during code patching, if this become a performance problem maybe we could just it up
-// like with soft_code_page
 std::shared_ptr<BtCodeChunk> Memory::getCodeChunkContainingHostAddress(void* hostAddress) {
-    U32 page = (U32)((size_t)hostAddress >> K_PAGE_SHIFT);
-    if (this->codeChunksByHostPage.count(page)) {
-        std::shared_ptr< std::list<std::shared_ptr<BtCodeChunk>> > chunks = this->codeChunksByHostPage[page];
-        for (auto& chunk : *chunks) {
-            if (chunk->containsHostAddress(hostAddress)) {
-                return chunk;
-            }
-        }
+    BtCodeChunk* chunk = findCodeChunkContainingHostAddress(hostAddress);
+    if (chunk) {
+        return chunk->shared_from_this();
     }
-    page--;
-    // look to see if a chunk that starts in a previous page contains this address
-    // chunks do not overlap, so find the first previous page with a chunk then
-    // check on the chunks in that page
-    while (page>0) {
-        if (this->codeChunksByHostPage.count(page)) {
-            std::shared_ptr< std::list<std::shared_ptr<BtCodeChunk>> > chunks = this->codeChunksByHostPage[page];
-            for (auto& chunk : *chunks) {
-                if (chunk->containsHostAddress(hostAddress)) {
-                    return chunk;
-                }
-            }
-            break;
+    return NULL;
+}
+
+BtCodeChunk* Memory::findCodeChunkContainingHostAddress(void* hostAddress) {
+    std::atomic<BtCodeChunk*>* slot = findExecutableSlot(hostAddress);
+    if (slot) {
+        BtCodeChunk* chunk = slot->load(std::memory_order_acquire);
+        // a chunk that is being released clears its host address before its slot
+        if (chunk && chunk->containsHostAddress(hostAddress)) {
+            return chunk;
         }
-        page--;
     }
     return NULL;
 }
 
+const Memory::ExecutableBlock* Memory::findExecutableBlock(void* address) {
+    ExecutableBlockIndex* index = this->executableBlockIndex.load(std::memory_order_acquire);
+    if (!index) {
+        return NULL;
+    }
+    U32 low = 0;
+    U32 high = index->count;
+
+    // the first block that starts after address, the one before it is the only one that can contain it
+    while (low < high) {
+        U32 mid = low + (high - low) / 2;
+        if (index->blocks[mid].memory <= (U8*)address) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == 0) {
+        return NULL;
+    }
+    const ExecutableBlock* block = &index->blocks[low - 1];
+    if ((U8*)address >= block->memory + block->size) {
+        return NULL;
+    }
+    return block;
+}
+
+std::atomic<BtCodeChunk*>* Memory::findExecutableSlot(void* address) {
+    const ExecutableBlock* block = findExecutableBlock(address);
+    if (!block) {
+        return NULL;
+    }
+    return &block->slots[((U8*)address - block->memory) >> block->slotShift];
+}
+
+// must hold executableMemoryMutex
+void Memory::addExecutableBlock(U8* memory, U32 size, U32 slotShift) {
+    ExecutableBlockIndex* oldIndex = this->executableBlockIndex.load();
+    U32 oldCount = oldIndex ? oldIndex->count : 0;
+    ExecutableBlockIndex* index = (ExecutableBlockIndex*)malloc(sizeof(ExecutableBlockIndex) + sizeof(ExecutableBlock) * oldCount);
+    U32 slotCount = size >> slotShift;
+    ExecutableBlock block;
+    U32 i = 0;
+
+    if (slotCount == 0) {
+        slotCount = 1;
+    }
+    block.memory = memory;
+    block.size = size;
+    block.slotShift = slotShift;
+    block.slots = new std::atomic<BtCodeChunk*>[slotCount];
+    for (U32 s = 0; s < slotCount; s++) {
+        block.slots[s].store(NULL, std::memory_order_relaxed);
+    }
+    index->count = oldCount + 1;
+    index->epoch = 0;
+    for (U32 j = 0; j < oldCount; j++) {
+        if (i == j && oldIndex->blocks[j].memory > memory) {
+            index->blocks[i++] = block;
+        }
+        index->blocks[i++] = oldIndex->blocks[j];
+    }
+    if (i == oldCount) {
+        index->blocks[i] = block;
+    }
+    this->executableBlockIndex.store(index, std::memory_order_release);
+    if (oldIndex) {
+        oldIndex->epoch = ++this->executableMemoryEpoch;
+        this->retiredExecutableBlockIndexes.push_back(oldIndex);
+    }
+}
+
+void Memory::freeExecutableBlockIndexes() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(executableMemoryMutex);
+    ExecutableBlockIndex* index = this->executableBlockIndex.exchange(NULL);
+
+    // the retired copies share their slots with the current index
+    if (index) {
+        for (U32 i = 0; i < index->count; i++) {
+            delete[] index->blocks[i].slots;
+        }
+        free(index);
+    }
+    for (auto& retired : this->retiredExecutableBlockIndexes) {
+        free(retired);
+    }
+    this->retiredExecutableBlockIndexes.clear();
+}
+
 std::shared_ptr<BtCodeChunk> Memory::getCodeChunkContainingEip(U32 eip) {
     for (U32 i=0;i<K_MAX_X86_OP_LEN;i++) {
         void* hostAddress = getExistingHostAddress(eip-i);
@@ -1028,6 +1185,154 @@ void Memory::clearHostCodeForWriting(U32 nativePage, U32 count) {
     }
 }
 
+void Memory::addCodeRegions(U64* regions, U32 page, U32 address, U32 len) {
+    U64 pageStart = (U64)page << K_PAGE_SHIFT;
+    U64 start = std::max((U64)address, pageStart);
+    U64 stop = std::min((U64)address + len, pageStart + K_PAGE_SIZE);
+
+    for (U64 i = start; i < stop; i += CODE_REGION_SIZE - ((i - pageStart) & (CODE_REGION_SIZE - 1))) {
+        *regions |= (U64)1 << ((i - pageStart) >> CODE_REGION_SHIFT);
+    }
+}
+
+// chunks don't overlap, so besides the chunks that start in the range, only a chunk in the first page before it that
+// has any chunks can reach into it, see makeNativePageDynamic
+void Memory::getCodeChunksInRange(U32 address, U32 len, std::vector<std::shared_ptr<BtCodeChunk>>& chunks) {
+    U64 stop = (U64)address + len;
+    U32 startPage = address >> K_PAGE_SHIFT;
+    U32 endPage = (U32)((stop - 1) >> K_PAGE_SHIFT);
+
+    for (U32 page = startPage; page <= endPage; page++) {
+        auto it = this->codeChunksByEmulationPage.find(page);
+        if (it != this->codeChunksByEmulationPage.end()) {
+            for (auto& chunk : *it->second) {
+                if (chunk->getEip() >= address && chunk->getEip() < stop) {
+                    chunks.push_back(chunk);
+                }
+            }
+        }
+    }
+    for (U32 page = startPage + 1; page > 0; page--) {
+        auto it = this->codeChunksByEmulationPage.find(page - 1);
+        if (it == this->codeChunksByEmulationPage.end()) {
+            continue;
+        }
+        bool found = false;
+        for (auto& chunk : *it->second) {
+            if (chunk->getEip() < address && (U64)chunk->getEip() + chunk->getEipLen() > address) {
+                chunks.push_back(chunk);
+            }
+            found |= chunk->getEip() < address;
+        }
+        if (found) {
+            break;
+        }
+    }
+}
+
+// the bits in codeRegions can be stale, for example after a chunk was released, this finds the regions that really
+// still have code that hasn't been invalidated
+U64 Memory::findCodeRegions(U32 page) {
+    U64 regions = this->codePageWrites[page].codeRegions;
+    U64 result = 0;
+    std::vector<std::shared_ptr<BtCodeChunk>> chunks;
+
+    if (!regions) {
+        return 0;
+    }
+    getCodeChunksInRange(page << K_PAGE_SHIFT, K_PAGE_SIZE, chunks);
+    for (auto& chunk : chunks) {
+        if (!chunk->isDynamicAware()) {
+            addCodeRegions(&result, page, chunk->getEip(), chunk->getValidEipLen());
+        }
+    }
+    return result & regions;
+}
+
+U64 Memory::getCodeRegions(U32 page) {
+    auto it = this->codePageWrites.find(page);
+    return it == this->codePageWrites.end() ? 0 : it->second.codeRegions;
+}
+
+bool Memory::clearHostCodeOverlapping(U32 address, U32 len, bool fault) {
+    U32 startNativePage = getNativePage(address >> K_PAGE_SHIFT);
+    U32 endNativePage = getNativePage((address + len - 1) >> K_PAGE_SHIFT);
+    bool result = false;
+
+    for (U32 nativePage = startNativePage; nativePage <= endNativePage; nativePage++) {
+        if (!(this->nativeFlags[nativePage] & NATIVE_FLAG_CODEPAGE_READONLY)) {
+            continue;
+        }
+        U32 firstPage = getEmulatedPage(nativePage);
+        if (this->codePageWrites[firstPage].dataWriteCount >= MAX_CODE_PAGE_DATA_WRITE_COUNT) {
+            clearHostCodeForWriting(nativePage, 1);
+            continue;
+        }
+        bool codeWasWritten = false;
+        bool hasCode = false;
+        for (U32 page = firstPage; page < firstPage + K_NATIVE_PAGES_PER_PAGE; page++) {
+            CodePageWrites& writes = this->codePageWrites[page];
+            U64 written = 0;
+            addCodeRegions(&written, page, address, len);
+            if (written & writes.codeRegions) {
+                U64 pageStart = (U64)page << K_PAGE_SHIFT;
+                U32 start = (U32)std::max((U64)address, pageStart);
+                U32 stop = (U32)std::min((U64)address + len, pageStart + K_PAGE_SIZE);
+                std::vector<std::shared_ptr<BtCodeChunk>> chunks;
+
+                getCodeChunksInRange(start, stop - start, chunks);
+                for (auto& chunk : chunks) {
+                    U32 i = std::max(start, chunk->getEip());
+                    if (!chunk->isDynamicAware() && i < chunk->getEip() + chunk->getValidEipLen()) {
+                        chunk->invalidateStartingAt(i);
+                        codeWasWritten = true;
+                    }
+                }
+                writes.codeRegions = findCodeRegions(page);
+            }
+            if (writes.codeRegions) {
+                hasCode = true;
+            }
+        }
+        if (codeWasWritten) {
+            this->codePageCodeWriteCount++;
+            if (dynamicCodePageUpdateCount[nativePage] != MAX_DYNAMIC_CODE_PAGE_COUNT) {
+                dynamicCodePageUpdateCount[nativePage]++;
+                if (dynamicCodePageUpdateCount[nativePage] == MAX_DYNAMIC_CODE_PAGE_COUNT) {
+                    this->makeNativePageDynamic(nativePage);
+                    continue;
+                }
+            }
+        } else if (fault) {
+            CodePageWrites& writes = this->codePageWrites[firstPage];
+            U64 now = KSystem::getMicroCounter();
+            if (now - writes.dataWriteTime > 1000000) {
+                writes.dataWriteTime = now;
+                writes.dataWriteCount = 0;
+            }
+            writes.dataWriteCount++;
+            this->codePageDataWriteCount++;
+        }
+        if (hasCode) {
+            result = true;
+        } else {
+            clearCodePageReadOnly(nativePage);
+        }
+    }
+    return result;
+}
+
+void Memory::allowCodePageWrite(U32 address, U32 len) {
+    U32 startNativePage = getNativePage(address >> K_PAGE_SHIFT);
+    U32 endNativePage = getNativePage((address + len - 1) >> K_PAGE_SHIFT);
+
+    for (U32 nativePage = startNativePage; nativePage <= endNativePage; nativePage++) {
+        if (this->nativeFlags[nativePage] & NATIVE_FLAG_CODEPAGE_READONLY) {
+            updateNativePermission(getEmulatedPage(nativePage), K_NATIVE_PAGES_PER_PAGE, PAGE_READ | PAGE_WRITE);
+        }
+    }
+}
+
 // call during code translation, this needs to be fast
 void* Memory::getExistingHostAddress(U32 eip) {
     if (KSystem::useLargeAddressSpace) {
@@ -1072,13 +1377,7 @@ int powerOf2(U32 requestedSize, U32& size) {
 }
 
 bool Memory::isAddressExecutable(void* address) {
-    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(executableMemoryMutex);
-    for (auto& p : this->allocatedExecutableMemory) {
-        if (address >= p.memory && address < (U8*)p.memory + p.size) {
-            return true;
-        }
-    }
-    return false;
+    return findExecutableBlock(address) != NULL;
 }
 
 void* Memory::allocateExcutableMemory(U32 requestedSize, U32* allocatedSize) {
@@ -1096,6 +1395,15 @@ void* Memory::allocateExcutableMemory(U32 requestedSize, U32* allocatedSize) {
         *allocatedSize = size;
     }
     U32 index = powerOf2Size - EXECUTABLE_MIN_SIZE_POWER;
+    drainPendingExecutableMemory();
+    if (this->freeExecutableMemory[index].empty() && !this->retiredExecutableMemory.empty()) {
+        reclaimExecutableMemory();
+    }
+    this->liveExecutableMemorySize += size;
+    U64 allSize = (allLiveExecutableMemorySize += size);
+    if (allSize > peakLiveExecutableMemorySize) {
+        peakLiveExecutableMemorySize = allSize;
+    }
     if (!this->freeExecutableMemory[index].empty()) {
         void* result = this->freeExecutableMemory[index].front();
         this->freeExecutableMemory[index].pop_front();
@@ -1104,6 +1412,7 @@ void* Memory::allocateExcutableMemory(U32 requestedSize, U32* allocatedSize) {
     U32 count = (size+65535)/65536;
     void* result = Platform::allocExecutable64kBlock(count);
     this->allocatedExecutableMemory.push_back(Memory::AllocatedMemory(result, count*64*1024));
+    addExecutableBlock((U8*)result, count * 64 * 1024, powerOf2Size);
     count = 65536 / size;
     for (U32 i=1;i<count;i++) {
         this->freeExecutableMemory[index].push_back(((U8*)result) + size * i);
@@ -1111,30 +1420,236 @@ void* Memory::allocateExcutableMemory(U32 requestedSize, U32* allocatedSize) {
     return result;
 }
 
-void Memory::freeExcutableMemory(void* hostMemory, U32 actualSize) {
+// canReuse is false if something still points directly at this memory that can't be redirected, like a jmp rel32
+// from another chunk, in which case it is never handed out again
+// chunk is the chunk that owned the memory, it is kept alive until reclaimed
+void Memory::freeExcutableMemory(void* hostMemory, U32 actualSize, bool canReuse, const std::shared_ptr<BtCodeChunk>& chunk) {
     Platform::writeCodeToMemory(hostMemory, actualSize, [hostMemory, actualSize] {
         memset(hostMemory, 0xcd, actualSize);
         });
+    // another thread might be waiting in seh_filter for its turn to jump to this chunk at the same time another
+    // thread retranslated it (I saw this in the Real Deal installer), so the memory is only recycled once
+    // reclaimExecutableMemory knows no thread can still be in it
+    retireExecutableMemory(hostMemory, actualSize, chunk, canReuse);
+}
+
+void Memory::retireExecutableMemory(void* hostMemory, U32 size, const std::shared_ptr<BtCodeChunk>& chunk, bool canReuse) {
+    PendingExecutableMemory* pending = new PendingExecutableMemory(hostMemory, size, chunk, canReuse);
+
+    this->liveExecutableMemorySize -= size;
+    allLiveExecutableMemorySize -= size;
+    pending->next = this->pendingExecutableMemory.load(std::memory_order_relaxed);
+    while (!this->pendingExecutableMemory.compare_exchange_weak(pending->next, pending, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+// must hold executableMemoryMutex
+void Memory::drainPendingExecutableMemory() {
+    PendingExecutableMemory* pending = this->pendingExecutableMemory.exchange(NULL, std::memory_order_acquire);
+    PendingExecutableMemory* oldestFirst = NULL;
+
+    // the pending list is newest first, retiredExecutableMemory has to stay in epoch order
+    while (pending) {
+        PendingExecutableMemory* next = pending->next;
+        pending->next = oldestFirst;
+        oldestFirst = pending;
+        pending = next;
+    }
+    while (oldestFirst) {
+        PendingExecutableMemory* next = oldestFirst->next;
+        this->retiredExecutableMemory.push_back(RetiredExecutableMemory(oldestFirst->memory, oldestFirst->size, ++this->executableMemoryEpoch, oldestFirst->chunk, oldestFirst->canReuse));
+        this->retiredExecutableMemoryCount++;
+        delete oldestFirst;
+        oldestFirst = next;
+    }
+}
+
+void Memory::addCodeThread(BtCPU* cpu) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(executableMemoryMutex);
+    cpu->codeMemory = this;
+    cpu->codeEpochSource = &this->executableMemoryEpoch;
+    cpu->codeGeneration = this->codeGeneration;
+    this->codeThreads.push_back(cpu);
+}
+
+void Memory::codeReleased() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(codeGenerationMutex);
+    U64 generation = (++lastCodeGeneration) << 32;
+    // readers that see a mix of the old and new values will just fail to match
+    this->codeGeneration[1] = (U64)(-(S64)generation);
+    this->codeGeneration[0] = generation;
+}
 
-    //U32 size = 0;
-    //U32 powerOf2Size = powerOf2(actualSize, size);
-    //U32 index = powerOf2Size - EXECUTABLE_MIN_SIZE_POWER;
-    //this->freeExecutableMemory[index].push_back(hostMemory);
+void Memory::removeCodeThread(BtCPU* cpu) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(executableMemoryMutex);
+    this->codeThreads.remove(cpu);
+    cpu->codeMemory = NULL;
+}
+
+// A retired block can be reused once every thread that runs generated code has been at a safe point after the block
+// was retired: either outside of the generated code or at a syscall.  A thread in a syscall will return to the chunk
+// at its codePin, so that block is left alone until it moves on.
+void Memory::reclaimExecutableMemory() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(executableMemoryMutex);
+    drainPendingExecutableMemory();
+    U64 epoch = this->executableMemoryEpoch;
+    std::vector<U64> pins;
+
+    for (auto& cpu : this->codeThreads) {
+        // the generated code writes the pin before the epoch, so read them in the opposite order
+        U64 cpuEpoch = cpu->codeEpoch;
+        if (cpuEpoch < epoch) {
+            epoch = cpuEpoch;
+        }
+        U64 pin = cpu->codePin;
+        if (pin) {
+            pins.push_back(pin);
+        }
+    }
+    for (auto it = this->retiredExecutableMemory.begin(); it != this->retiredExecutableMemory.end() && it->epoch <= epoch;) {
+        U64 start = (U64)it->memory;
+        bool pinned = false;
+        for (U64 pin : pins) {
+            if (pin >= start && pin < start + it->size) {
+                pinned = true;
+                break;
+            }
+        }
+        if (pinned) {
+            ++it;
+            continue;
+        }
+        if (it->chunk) {
+            if (it->chunk->isEvicted()) {
+                removeCodeChunkHostMapping(it->chunk);
+                Platform::writeCodeToMemory(it->memory, it->size, [it] {
+                    memset(it->memory, 0xcd, it->size);
+                    });
+            }
+            it->chunk->releaseRetired();
+        }
+        if (it->canReuse) {
+            U32 size = 0;
+            U32 index = powerOf2(it->size, size) - EXECUTABLE_MIN_SIZE_POWER;
+            this->freeExecutableMemory[index].push_back(it->memory);
+            this->reclaimedExecutableMemoryCount++;
+        }
+        it = this->retiredExecutableMemory.erase(it);
+    }
+    // nothing is pinned to an old block index, a thread that loaded one is still in the same run of generated code
+    while (!this->retiredExecutableBlockIndexes.empty() && this->retiredExecutableBlockIndexes.front()->epoch <= epoch) {
+        free(this->retiredExecutableBlockIndexes.front());
+        this->retiredExecutableBlockIndexes.pop_front();
+    }
+}
+
+void Memory::setSharedCodeFile(U32 page, U32 pageCount, const std::shared_ptr<BtSharedCodeFile>& file, U64 offset) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(sharedCodePagesMutex);
+    if (!file && this->sharedCodePages.empty()) {
+        return;
+    }
+    for (U32 i = 0; i < pageCount; i++) {
+        if (file) {
+            SharedCodePage& sharedPage = this->sharedCodePages[page + i];
+            sharedPage.file = file;
+            sharedPage.offset = offset + ((U64)i << K_PAGE_SHIFT);
+        } else {
+            this->sharedCodePages.erase(page + i);
+        }
+    }
+}
 
-    // :TODO: when this recycled, make sure we delay the recycling in case another thread is also waiting in seh_filter 
-    // for its turn to jump to this chunk at the same time another thread retranslated it
-    //
-    // I saw this in the Real Deal installer
+std::shared_ptr<BtSharedCodeFile> Memory::getSharedCodeFile(U32 address, U32 len, U64* fileOffset) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(sharedCodePagesMutex);
+    U32 page = address >> K_PAGE_SHIFT;
+    U32 endPage = (address + len - 1) >> K_PAGE_SHIFT;
+    auto first = this->sharedCodePages.find(page);
+    if (first == this->sharedCodePages.end()) {
+        return NULL;
+    }
+    for (U32 i = page + 1; i <= endPage; i++) {
+        auto next = this->sharedCodePages.find(i);
+        if (next == this->sharedCodePages.end() || next->second.file != first->second.file || next->second.offset != first->second.offset + ((U64)(i - page) << K_PAGE_SHIFT)) {
+            return NULL;
+        }
+    }
+    *fileOffset = first->second.offset + (address & K_PAGE_MASK);
+    return first->second.file;
+}
+
+bool Memory::isCodeCacheOverLimit() {
+    return KSystem::btCodeCacheSize && this->liveExecutableMemorySize > ((U64)KSystem::btCodeCacheSize << 20);
+}
+
+// A clock approximation of LRU: chunks are visited in the order they were made live, a chunk that was used since the
+// last visit gets a second chance, otherwise it is evicted.  Evicted chunks keep their code so that a thread that is
+// running it can finish, see BtCodeChunk::evict
+void Memory::evictExecutableMemory() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(executableMemoryMutex);
+    U64 limit = (U64)KSystem::btCodeCacheSize << 20;
+    // go a bit under the limit so that this doesn't happen again for the next few chunks
+    U64 target = limit - limit / 4;
+    std::vector<U64> pins;
+
+    for (auto& codeThread : this->codeThreads) {
+        U64 pin = codeThread->codePin;
+        if (pin) {
+            pins.push_back(pin);
+        }
+    }
+    // at most 2 passes, the first might just clear the referenced flags
+    size_t count = this->codeChunkClock.size() * 2;
+    for (size_t i = 0; i < count && this->liveExecutableMemorySize > target && !this->codeChunkClock.empty(); i++) {
+        std::shared_ptr<BtCodeChunk> chunk = this->codeChunkClock.front().lock();
+        this->codeChunkClock.pop_front();
+        if (!chunk || !chunk->isLive() || !chunk->canEvict()) {
+            continue;
+        }
+        bool pinned = false;
+        for (U64 pin : pins) {
+            if (chunk->containsHostAddress((void*)pin)) {
+                pinned = true;
+                break;
+            }
+        }
+        if (pinned || chunk->testAndClearReferenced()) {
+            this->codeChunkClock.push_back(chunk);
+            continue;
+        }
+        chunk->evict(this);
+        this->evictedCodeChunkCount++;
+    }
+    reclaimExecutableMemory();
 }
 
 void Memory::executableMemoryReleased() {
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(executableMemoryMutex);
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
-    this->codeChunksByHostPage.clear();
+    ExecutableBlockIndex* index = this->executableBlockIndex.load();
+    if (index) {
+        for (U32 i = 0; i < index->count; i++) {
+            const ExecutableBlock& block = index->blocks[i];
+            U32 slotCount = std::max(block.size >> block.slotShift, (U32)1);
+            for (U32 s = 0; s < slotCount; s++) {
+                block.slots[s].store(NULL);
+            }
+        }
+    }
     this->codeChunksByEmulationPage.clear();
     for (U32 i = 0; i < EXECUTABLE_SIZES; i++) {
         this->freeExecutableMemory[i].clear();
     }
+    drainPendingExecutableMemory();
+    for (auto& retired : this->retiredExecutableMemory) {
+        if (retired.chunk) {
+            retired.chunk->releaseRetired();
+        }
+    }
+    this->retiredExecutableMemory.clear();
+    this->codeChunkClock.clear();
+    allLiveExecutableMemorySize -= this->liveExecutableMemorySize;
+    this->liveExecutableMemorySize = 0;
+    codeReleased();
 #endif   
 }
 #endif
@@ -3,27 +3,40 @@
 #ifdef BOXEDWINE_DEFAULT_MMU
 #include "soft_code_page.h"
 
-CodePage::CodePageEntry* CodePage::freeCodePageEntries;
+#ifdef __TEST
+CodePageStats CodePage::stats;
+#endif
 
+// must hold Memory::pageMutex, next isn't cleared since a reader might still be on the entry
 CodePage::CodePageEntry* CodePage::allocCodePageEntry() {
     CodePageEntry* result;
 
     if (freeCodePageEntries) {
         result = freeCodePageEntries;
-        freeCodePageEntries = result->next;        
+        freeCodePageEntries = result->nextFree;        
     } else {
        result = new CodePageEntry();
+       result->block = NULL;
+       result->offset = 0;
+       result->next = NULL;
     }	
-    memset(result, 0, sizeof(CodePageEntry));
+    result->len = 0;
+    result->prev = NULL;
+    result->linkedPrev = NULL;
+    result->linkedNext = NULL;
+    result->nextFree = NULL;
     return result;
 }
 
+// must hold Memory::pageMutex
 void CodePage::freeCodePageEntry(CodePageEntry* entry) {	
     U32 offset = entry->offset >> CODE_ENTRIES_SHIFT;
-    CodePageEntry** entries = entry->page->entries;
    
-    if (entry->block)
-        entry->block->dealloc(false);
+    if (entry->block) {
+        DecodedBlock* block = entry->block;
+        entry->block = NULL;
+        block->dealloc(false);
+    }
 
     // remove any entries linked to this one from other pages
     if (entry->linkedPrev) {
@@ -37,17 +50,18 @@ void CodePage::freeCodePageEntry(CodePageEntry* entry) {
         entry->linkedNext = NULL;
     }
 
-    // remove this entry from this page's list
+    // remove this entry from this page's list, its next is left alone for anyone still walking the list
+    CodePageEntry* next = entry->next;
     if (entry->prev) {
-        entry->prev->next = entry->next;
+        entry->prev->next = next;
     } else {
-        entries[offset] = entry->next;
+        entries[offset] = next;
     }
-    if (entry->next) {
-        entry->next->prev = entry->prev;
+    if (next) {
+        next->prev = entry->prev;
     }
     // add the entry to the free list
-    entry->next = freeCodePageEntries;
+    entry->nextFree = freeCodePageEntries;
     freeCodePageEntries = entry; 
 }
 
@@ -55,11 +69,23 @@ CodePage* CodePage::alloc(U8* page, U32 address, U32 flags) {
     return new CodePage(page, address, flags);
 }
 
-CodePage::CodePage(U8* page, U32 address, U32 flags) : RWPage(page, address, flags, Code_Page) {
-    memset(this->entries, 0, sizeof(this->entries));
+CodePage::CodePage(U8* page, U32 address, U32 flags) : RWPage(page, address, flags, Code_Page), freeCodePageEntries(NULL) {
+    for (U32 i = 0; i < CODE_ENTRIES; i++) {
+        this->entries[i] = NULL;
+    }
+    memset(this->codeRegions, 0, sizeof(this->codeRegions));
 }
 
 CodePage::~CodePage() {
+    removeAllCode();
+    while (freeCodePageEntries) {
+        CodePageEntry* next = freeCodePageEntries->nextFree;
+        delete freeCodePageEntries;
+        freeCodePageEntries = next;
+    }
+}
+
+void CodePage::removeAllCode() {
     int i;
 
     for (i=0;i<CODE_ENTRIES;i++) {
@@ -71,18 +97,20 @@ CodePage::~CodePage() {
             entry = next;
         }
     }
+    memset(this->codeRegions, 0, sizeof(this->codeRegions));
 }
 
 // :TODO: what if address+len is in the next page
 CodePage::CodePageEntry* CodePage::findCode(U32 address, U32 len) {
     U32 offset = address & K_PAGE_MASK;
-    U32 stop = offset + ((len+31) >> CODE_ENTRIES_SHIFT);
+    U32 stop = (offset + len - 1) >> CODE_ENTRIES_SHIFT;
     if (stop>=CODE_ENTRIES)
         stop = CODE_ENTRIES-1;
+    // a block can start in any bucket before the one that has the end of the write
     for (U32 i=0;i<=stop;i++) {
         CodePageEntry* entry = entries[i];
         while (entry) {
-            if (((entry->offset <= offset && offset < (entry->offset + entry->len)) || (entry->offset <= (offset + len) && (offset + len) < (entry->offset + entry->len))) && !entry->linkedPrev)
+            if (entry->offset < offset + len && offset < entry->offset + entry->len && !entry->linkedPrev)
                 return entry;
             entry = entry->next;
         }
@@ -97,6 +125,7 @@ static void OPCALL emptyOp(CPU* cpu, DecodedOp* op) {
 
 
 void CodePage::removeBlockAt(U32 address, U32 len) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(KThread::currentThread()->memory->pageMutex);
     CodePageEntry* entry = findCode(address, len);
 
     while (entry) {
@@ -117,45 +146,80 @@ void CodePage::removeBlockAt(U32 address, U32 len) {
                 }
             }
 
-            entry->block->dealloc(true);
+            DecodedBlock* block = entry->block;
             entry->block = NULL; // so that freeCodePageEntry won't dealloc it
+            block->dealloc(true);
         }
         freeCodePageEntry(entry);
+        CODE_PAGE_STAT(blocksInvalidated);
         entry = findCode(address, len);
     }
+    updateCodeRegions();
+}
+
+void CodePage::addCodeRegions(U32 offset, U32 len) {
+    U32 stop = (offset + len - 1) >> CODE_ENTRIES_SHIFT;
+
+    for (U32 i = offset >> CODE_ENTRIES_SHIFT; i <= stop && i < CODE_ENTRIES; i++) {
+        this->codeRegions[i >> 5] |= (U32)1 << (i & 31);
+    }
+}
+
+// the regions are only ever added to when a block is added, so this is called after blocks are removed
+void CodePage::updateCodeRegions() {
+    memset(this->codeRegions, 0, sizeof(this->codeRegions));
+    for (U32 i = 0; i < CODE_ENTRIES; i++) {
+        for (CodePageEntry* entry = this->entries[i]; entry; entry = entry->next) {
+            if (!entry->linkedPrev) {
+                addCodeRegions(entry->offset, entry->len);
+            }
+        }
+    }
+}
+
+bool CodePage::hasCode(U32 address, U32 len) {
+    U32 offset = address & K_PAGE_MASK;
+    U32 stop = (offset + len - 1) >> CODE_ENTRIES_SHIFT;
+
+    for (U32 i = offset >> CODE_ENTRIES_SHIFT; i <= stop && i < CODE_ENTRIES; i++) {
+        if (this->codeRegions[i >> 5] & ((U32)1 << (i & 31))) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void CodePage::addCode(U32 eip, DecodedBlock* block, U32 len, CodePageEntry* link) {
     U32 offset = eip & K_PAGE_MASK;
 
-    CodePageEntry** entry = &this->entries[offset >> CODE_ENTRIES_SHIFT];
+    std::atomic<CodePageEntry*>& head = this->entries[offset >> CODE_ENTRIES_SHIFT];
+    CodePageEntry* entry = allocCodePageEntry();
 
-    if (!*entry) {
-        *entry = allocCodePageEntry();
-        (*entry)->next = 0;
-    } else {
-        CodePageEntry* add = allocCodePageEntry();
-        add->next = *entry;
-		(*entry)->prev = add;
-        *entry = add;
-    }
-    (*entry)->offset = offset;
-    (*entry)->block = block;
-	(*entry)->page = this;
-	if (offset+len>K_PAGE_SIZE)
-		(*entry)->len = K_PAGE_SIZE-offset;
-	else
-		(*entry)->len = len;
+    // everything getCode looks at is set before the entry is linked
 	if (link) {
-		(*entry)->linkedPrev = link;
-		link->linkedNext = (*entry);
+		entry->linkedPrev = link;
+		link->linkedNext = entry;
         if (link->linkedPrev) {
             kpanic("Code block too big");
         }
 	}
+    entry->block = block;
+    entry->offset = offset;
+	if (offset+len>K_PAGE_SIZE)
+		entry->len = K_PAGE_SIZE-offset;
+	else
+		entry->len = len;
+    entry->next = head.load();
+    if (entry->next) {
+		entry->next.load()->prev = entry;
+    }
+    head = entry;
+	if (!link) {
+        addCodeRegions(offset, entry->len);
+    }
 	if (offset + len > K_PAGE_SIZE) {
 		U32 nextPage = (eip + 0xFFF) & 0xFFFFF000;
-		this->addCode(nextPage, NULL, len - (nextPage - eip), *entry);
+		this->addCode(nextPage, NULL, len - (nextPage - eip), entry);
 	}
 }
 
@@ -163,33 +227,52 @@ void CodePage::addCode(U32 eip, DecodedBlock* op, U32 len) {
     this->addCode(eip, op, len, NULL);
 }
 
+// doesn't need a lock, see CodePageEntry
 DecodedBlock* CodePage::getCode(U32 eip) {
     U32 offset = eip & K_PAGE_MASK;
-    CodePageEntry* entry = this->entries[offset >> CODE_ENTRIES_SHIFT];
+    CodePageEntry* entry = this->entries[offset >> CODE_ENTRIES_SHIFT].load(std::memory_order_acquire);
     while (entry) {
-        if (entry->offset == offset && !entry->linkedPrev)
-            return entry->block;
-        entry = entry->next;
+        if (entry->offset == offset && !entry->linkedPrev) {
+            DecodedBlock* block = entry->block.load(std::memory_order_acquire);
+            // the entry might have been reused for another eip while it was read
+            if (block && block->address == eip)
+                return block;
+            return 0;
+        }
+        entry = entry->next.load(std::memory_order_acquire);
     }
     return 0;
 }
 
+// data that shares a page with code, like a jump table or a game's variables, shouldn't have to search the blocks
 void CodePage::writeb(U32 address, U8 value) {    
-    if (value!=this->readb(address)) {
+    if (!hasCode(address, 1)) {
+        CODE_PAGE_STAT(fastWrites);
+        RWPage::writeb(address, value);
+    } else if (value!=this->readb(address)) {
+        CODE_PAGE_STAT(slowWrites);
         removeBlockAt(address, 1);
         RWPage::writeb(address, value);
     }
 }
 
 void CodePage::writew(U32 address, U16 value) {
-    if (value!=this->readw(address)) {
+    if (!hasCode(address, 2)) {
+        CODE_PAGE_STAT(fastWrites);
+        RWPage::writew(address, value);
+    } else if (value!=this->readw(address)) {
+        CODE_PAGE_STAT(slowWrites);
         removeBlockAt(address, 2);
         RWPage::writew(address, value);
     }
 }
 
 void CodePage::writed(U32 address, U32 value) {
-    if (value!=this->readd(address)) {
+    if (!hasCode(address, 4)) {
+        CODE_PAGE_STAT(fastWrites);
+        RWPage::writed(address, value);
+    } else if (value!=this->readd(address)) {
+        CODE_PAGE_STAT(slowWrites);
         removeBlockAt(address, 4);
         RWPage::writed(address, value);
     }
@@ -26,6 +26,21 @@
 #define CODE_ENTRIES 128
 #define CODE_ENTRIES_SHIFT 5
 
+#ifdef __TEST
+// copying it gives a snapshot, every guest thread can write to a code page at the same time.  Only kept for the tests
+// and benchmarks, a shared counter on every guest write would cost more than the fast path saves.
+#define CODE_PAGE_STAT(x) stats.x++
+struct CodePageStats {
+    CodePageStats() : fastWrites(0), slowWrites(0), blocksInvalidated(0) {}
+    CodePageStats(const CodePageStats& s) : fastWrites(s.fastWrites.load()), slowWrites(s.slowWrites.load()), blocksInvalidated(s.blocksInvalidated.load()) {}
+    std::atomic<U32> fastWrites; // writes that didn't touch a block, so they didn't have to look for one
+    std::atomic<U32> slowWrites; // writes to a 32-byte region that has a block in it
+    std::atomic<U32> blocksInvalidated;
+};
+#else
+#define CODE_PAGE_STAT(x)
+#endif
+
 class CodePage : public RWPage {
 protected:
     CodePage(U8* page, U32 address, U32 flags);
@@ -45,26 +60,39 @@ public:
 
     void addCode(U32 eip, DecodedBlock* block, U32 len);
     DecodedBlock* getCode(U32 eip);
+    bool hasCode(U32 address, U32 len);
+    void removeAllCode();
+
+#ifdef __TEST
+    static CodePageStats stats;
+#endif
 private:
+    // getCode walks the lists without a lock while another thread, holding Memory::pageMutex, adds or frees
+    // entries.  So an entry is filled in before it is linked, a freed entry keeps its next pointer and has its block
+    // cleared, and entries are only deleted with the page, which isn't closed until no thread can be reading it.
+    // A reader that lands on a freed or reused entry will either miss or find a block for the eip it asked for.
     class CodePageEntry {
     public:
-        DecodedBlock* block;
+        std::atomic<DecodedBlock*> block;
         U32 offset;
 	    U32 len;
-        CodePageEntry* next;
+        std::atomic<CodePageEntry*> next;
 	    CodePageEntry* prev;
 	    CodePageEntry* linkedPrev;
 	    CodePageEntry* linkedNext;
-        CodePage* page;
+        CodePageEntry* nextFree;
     };
     void removeBlockAt(U32 address, U32 len);
     CodePageEntry* findCode(U32 address, U32 len);
     void addCode(U32 eip, DecodedBlock* block, U32 len, CodePageEntry* link);
-    CodePageEntry* entries[CODE_ENTRIES];
+    void addCodeRegions(U32 offset, U32 len);
+    void updateCodeRegions();
+    std::atomic<CodePageEntry*> entries[CODE_ENTRIES];
+    U32 codeRegions[CODE_ENTRIES / 32]; // a bit for each 32-byte region that a block covers, same size as an entries bucket
 
-    static CodePageEntry* freeCodePageEntries;
-    static CodePageEntry* allocCodePageEntry();
-    static void freeCodePageEntry(CodePageEntry* entry);
+    CodePageEntry* freeCodePageEntries; // only reused by this page, see CodePageEntry
+    CodePageEntry* allocCodePageEntry();
+    void freeCodePageEntry(CodePageEntry* entry);
 };
 
 #endif
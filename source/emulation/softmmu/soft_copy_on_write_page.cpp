@@ -20,6 +20,10 @@ void CopyOnWritePage::copyOnWrite(U32 address) {
     bool read = this->canRead() || this->canExec();
     bool write = this->canWrite();
     U8* ram;
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(memory->pageMutex);
+    if (memory->getPage(page) != this) {
+        return; // another thread got here first
+    }
 
     if (ramPageRefCount(this->page)>1) {
         ram = ramPageAlloc();
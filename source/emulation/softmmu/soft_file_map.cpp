@@ -41,6 +41,10 @@ void FilePage::ondemmandFile(U32 address) {
     bool write = this->canWrite();
     bool shared = this->mapShared();
     U8* ram=NULL;
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(memory->pageMutex);
+    if (memory->getPage(page) != this) {
+        return; // another thread got here first
+    }
 
     address = address & (~K_PAGE_MASK);
     if ((read && !write) || shared) {
@@ -39,9 +39,17 @@
 
 //#undef LOG_OPS
 
+#ifdef BOXEDWINE_MULTI_THREADED
+#include "../cpu/normal/normalCPU.h"
+
+THREAD_LOCAL Page** Memory::currentMMU;
+THREAD_LOCAL U8** Memory::currentMMUReadPtr;
+THREAD_LOCAL U8** Memory::currentMMUWritePtr;
+#else
 Page** Memory::currentMMU;
 U8** Memory::currentMMUReadPtr;
 U8** Memory::currentMMUWritePtr;
+#endif
 
 void Memory::log_pf(KThread* thread, U32 address) {
     U32 start = 0;
@@ -105,6 +113,11 @@ void Memory::addCallback(OpCallback func) {
 }
 
 Memory::Memory() : nativeAddressStart(0) {
+#ifdef BOXEDWINE_MULTI_THREADED
+    this->codeEpoch = 0;
+    this->retiredCodeCount = 0;
+    this->reclaimedCodeCount = 0;
+#endif
     for (int i=0;i<K_NUMBER_OF_PAGES;i++) {
         this->mmu[i] = invalidPage;
         this->mmuReadPtr[i] = NULL;
@@ -127,6 +140,20 @@ Memory::Memory() : nativeAddressStart(0) {
 }
 
 Memory::~Memory() {
+#ifdef BOXEDWINE_MULTI_THREADED
+    // no thread can be running in this memory anymore, so everything can be freed now
+    for (auto& cpu : this->codeThreads) {
+        cpu->codeMemory = NULL;
+        cpu->codeEpochSource = NULL;
+    }
+    this->codeThreads.clear();
+    for (int i=0;i<K_NUMBER_OF_PAGES;i++) {
+        if (this->mmu[i]->type == Page::Type::Code_Page) {
+            ((CodePage*)this->mmu[i])->removeAllCode();
+        }
+    }
+    this->reclaimRetiredCode();
+#endif
     for (int i=0;i<K_NUMBER_OF_PAGES;i++) {
         this->mmu[i]->close();
     }
@@ -145,12 +172,14 @@ void Memory::reset() {
 }
 
 void Memory::reset(U32 page, U32 pageCount) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
     for (U32 i=page;i<page+pageCount;i++) {
         this->setPage(i, invalidPage);
     }
 }
 
 void Memory::clone(Memory* from) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(from->pageMutex);
     for (int i=0;i<0x100000;i++) {
         Page* page = from->getPage(i);
 
@@ -245,6 +274,7 @@ void writeMemory(U32 address, U8* data, int len) {
 }
 
 void Memory::allocPages(U32 page, U32 pageCount, U8 permissions, FD fd, U64 offset, const BoxedPtr<MappedFile>& mappedFile) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
 
     if (mappedFile) {
         U32 filePage = (U32)(offset>>K_PAGE_SHIFT);
@@ -264,6 +294,7 @@ void Memory::allocPages(U32 page, U32 pageCount, U8 permissions, FD fd, U64 offs
 }
 
 void Memory::protectPage(U32 i, U32 permissions) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
     Page* page = this->getPage(i);
 
     U32 flags = page->flags;
@@ -565,6 +596,7 @@ char* getNativeStringW(U32 address, char* buffer, U32 cbBuffer) {
 }
 
 U32 Memory::mapNativeMemory(void* hostAddress, U32 size) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
     U32 result = 0;
 
     if (this->nativeAddressStart && hostAddress>=this->nativeAddressStart && (U8*)hostAddress+size<(U8*)this->nativeAddressStart+0x10000000) {
@@ -597,6 +629,7 @@ U32 Memory::mapNativeMemory(void* hostAddress, U32 size) {
 void Memory::map(U32 startPage, const std::vector<U8*>& pages, U32 permissions) {
     bool read = (permissions & PAGE_READ)!=0 || (permissions & PAGE_EXEC)!=0;
     bool write = (permissions & PAGE_WRITE)!=0;
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
 
     for (U32 page=0;page<pages.size();page++) {
         if (read && write) {
@@ -611,6 +644,7 @@ void Memory::map(U32 startPage, const std::vector<U8*>& pages, U32 permissions)
     }
 }
 
+// Lock free, a page replaced by setPage is retired so it stays valid until this thread starts another block
 DecodedBlock* Memory::getCodeBlock(U32 startIp) {
     Page* page = this->getPage(startIp >> K_PAGE_SHIFT);
     if (page->type == Page::Type::Code_Page) {
@@ -621,6 +655,7 @@ DecodedBlock* Memory::getCodeBlock(U32 startIp) {
 }
 
 void Memory::addCodeBlock(U32 startIp, DecodedBlock* block) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
     // might have changed after a read
     Page* page = this->getPage(startIp >> K_PAGE_SHIFT);
 
@@ -655,10 +690,89 @@ void Memory::onThreadChanged() {
 }
 
 void Memory::setPage(U32 index, Page* page) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
     Page* p = this->mmu[index]; 
     this->mmu[index] = page; 
     this->mmuReadPtr[index] = page->getCurrentReadPtr();
     this->mmuWritePtr[index] = page->getCurrentWritePtr();
+#ifdef BOXEDWINE_MULTI_THREADED
+    if (p != invalidPage) {
+        if (p->type == Page::Type::Code_Page) {
+            // the blocks have to be unlinked now so that nothing new can run them
+            ((CodePage*)p)->removeAllCode();
+        }
+        this->retirePage(p);
+    }
+#else
     p->close();
+#endif
+}
+
+#ifdef BOXEDWINE_MULTI_THREADED
+void Memory::addCodeThread(NormalCPU* cpu) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
+    cpu->codeMemory = this;
+    cpu->codeEpochSource = &this->codeEpoch;
+    this->codeThreads.push_back(cpu);
+}
+
+void Memory::removeCodeThread(NormalCPU* cpu) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
+    this->codeThreads.remove(cpu);
+    cpu->codeMemory = NULL;
+    cpu->codeEpochSource = NULL;
 }
+
+void Memory::retireBlock(DecodedBlock* block) {
+    std::atomic_thread_fence(std::memory_order_release);
+    this->retiredCode.push_back(RetiredCode(block, NULL, ++this->codeEpoch));
+    this->retiredCodeCount++;
+}
+
+void Memory::retirePage(Page* page) {
+    std::atomic_thread_fence(std::memory_order_release);
+    this->retiredCode.push_back(RetiredCode(NULL, page, ++this->codeEpoch));
+    this->retiredCodeCount++;
+}
+
+// Something retired can be freed once every thread has started a block after it was retired, or is waiting in a
+// syscall.  A waiting thread will go back to the block at its codePin, so that block is left alone until it moves on.
+void Memory::reclaimRetiredCode() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pageMutex);
+    U64 epoch = this->codeEpoch;
+    std::vector<DecodedBlock*> pins;
+
+    for (auto& cpu : this->codeThreads) {
+        // NormalCPU::beforeWait writes the pin before the epoch and NormalCPU::run clears it after, so a pin that was
+        // missed before reading the epoch is seen after it
+        DecodedBlock* pin = cpu->codePin;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        U64 cpuEpoch = cpu->codeEpoch;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (cpuEpoch < epoch) {
+            epoch = cpuEpoch;
+        }
+        if (pin) {
+            pins.push_back(pin);
+        }
+        pin = cpu->codePin;
+        if (pin) {
+            pins.push_back(pin);
+        }
+    }
+    for (auto it = this->retiredCode.begin(); it != this->retiredCode.end() && it->epoch <= epoch;) {
+        if (it->block && std::find(pins.begin(), pins.end(), it->block) != pins.end()) {
+            ++it;
+            continue;
+        }
+        if (it->block) {
+            NormalCPU::freeRetiredBlock(it->block);
+        } else {
+            it->page->close();
+        }
+        this->reclaimedCodeCount++;
+        it = this->retiredCode.erase(it);
+    }
+}
+#endif
 #endif
@@ -18,6 +18,10 @@ void OnDemandPage::ondemmand(U32 address) {
     U32 page = address >> K_PAGE_SHIFT;
     bool read = this->canRead() || this->canExec();
     bool write = this->canWrite();
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(memory->pageMutex);
+    if (memory->getPage(page) != this) {
+        return; // another thread got here first
+    }
     
     if (read && write) {
         memory->setPage(page, RWPage::alloc(NULL, page << K_PAGE_SHIFT, this->flags));
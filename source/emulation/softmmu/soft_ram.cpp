@@ -1,5 +1,8 @@
 #include "boxedwine.h"
 
+// pages are shared between processes, so with BOXEDWINE_MULTI_THREADED the ref count can change on several threads
+static BOXEDWINE_MUTEX ramPageMutex;
+
 U8* ramPageAlloc() {
     U8* ram = new U8[K_PAGE_SIZE+1];
     memset(ram, 0, K_PAGE_SIZE);
@@ -8,6 +11,7 @@ U8* ramPageAlloc() {
 }
 
 void ramPageIncRef(U8* ram) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(ramPageMutex);
     if (ram[K_PAGE_SIZE]==255) {
         kpanic("max ram page ref count reached");
     }
@@ -15,11 +19,13 @@ void ramPageIncRef(U8* ram) {
 }
 
 void ramPageDecRef(U8* ram) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(ramPageMutex);
     ram[K_PAGE_SIZE]--;
     if (ram[K_PAGE_SIZE]==0)
         delete[] ram;
 }
 
 U32 ramPageRefCount(U8* ram) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(ramPageMutex);
     return ram[K_PAGE_SIZE];
 }
\ No newline at end of file
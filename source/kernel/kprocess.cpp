@@ -30,6 +30,9 @@
 
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
 #include "../emulation/cpu/binaryTranslation/btCodeMemoryWrite.h"
+#include "../emulation/cpu/binaryTranslation/btTranslationWorkers.h"
+#elif defined(BOXEDWINE_MULTI_THREADED)
+#include "../emulation/cpu/normal/normalCPU.h"
 #endif
 
 #include <stdlib.h>
@@ -91,6 +94,8 @@ KProcess::KProcess(U32 id) : id(id),
     returnToLoopAddress = NULL;
     reTranslateChunkAddress = NULL;
     reTranslateChunkAddressFromReg = NULL;
+    reTranslateLinkAddress = NULL;
+    formTraceAddress = NULL;
 #ifdef BOXEDWINE_BT_DEBUG_NO_EXCEPTIONS
     jmpAndTranslateIfNecessary = NULL;
 #endif
@@ -195,6 +200,8 @@ void KProcess::onExec() {
     returnToLoopAddress = NULL;
     reTranslateChunkAddress = NULL;
     reTranslateChunkAddressFromReg = NULL;
+    reTranslateLinkAddress = NULL;
+    formTraceAddress = NULL;
 #ifdef BOXEDWINE_BT_DEBUG_NO_EXCEPTIONS
     jmpAndTranslateIfNecessary = NULL;
 #endif
@@ -255,6 +262,9 @@ U32 KProcess::getThreadCount() {
 }
 
 void KProcess::deleteThread(KThread* thread) {
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    BtTranslationWorkers::removeThread(thread);
+#endif
     thread->cleanup();
     if (this->threads.size() == 0) {
         if (this->memory) {
@@ -823,6 +833,7 @@ U32 KProcess::execve(BString path, std::vector<BString>& args, const std::vector
 
     // reset memory must come after we grab the args and env
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
+	BtTranslationWorkers::removeThread(KThread::currentThread());
 	this->previousMemory = this->memory;
 	this->memory = new Memory();
 	this->memory->onThreadChanged();
@@ -832,6 +843,10 @@ U32 KProcess::execve(BString path, std::vector<BString>& args, const std::vector
 		this->memory->reset();
 	}
 	else {
+#ifdef BOXEDWINE_MULTI_THREADED
+		// whoever else is using the old memory might delete it before this thread runs another block
+		this->memory->removeCodeThread((NormalCPU*)KThread::currentThread()->cpu);
+#endif
 		this->memory->decRefCount();
 		this->memory = new Memory();
 		this->memory->onThreadChanged();
@@ -63,9 +63,16 @@ bool KSystem::useLargeAddressSpace = false;
 bool KSystem::useLargeAddressSpace = true;
 #endif
 bool KSystem::useSingleMemOffset = true;
+U32 KSystem::btTranslationThreads = 0;
+bool KSystem::btShadowStack = false;
+U32 KSystem::btCodeCacheSize = 0;
+U32 KSystem::btHotThreshold = 0;
+bool KSystem::btSubPageCodeWrites = false;
+U32 KSystem::btTraceThreshold = 0;
 #endif
 #ifdef BOXEDWINE_MULTI_THREADED
 U32 KSystem::cpuAffinityCountForApp = 0;
+bool KSystem::spinBackoff = false;
 #endif
 U32 KSystem::pollRate = DEFAULT_POLL_RATE;
 FILE* KSystem::logFile;
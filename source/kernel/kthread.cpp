@@ -25,7 +25,7 @@
 #include <string.h>
 #include <setjmp.h>
 
-#ifdef BOXEDWINE_BINARY_TRANSLATOR
+#ifdef BOXEDWINE_MULTI_THREADED
 THREAD_LOCAL
 #endif
 KThread* KThread::runningThread;
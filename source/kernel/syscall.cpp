@@ -782,7 +782,16 @@ static U32 syscall_sched_getscheduler(CPU* cpu, U32 eipCount) {
 static U32 syscall_sched_yield(CPU* cpu, U32 eipCount) {    
     cpu->yield = true;
     U32 result = 0;
+#ifdef BOXEDWINE_MULTI_THREADED
+    if (KSystem::spinBackoff) {
+        // a thread that keeps calling this is usually waiting on another thread
+        cpu->spinWait();
+    } else {
+        std::this_thread::yield();
+    }
+#else
     std::this_thread::yield();
+#endif
     SYS_LOG1(SYSCALL_SYSTEM, cpu, "yield: result=%d(0x%X)\n", result, result);
     return result;
 }
@@ -28,6 +28,10 @@
 #include "knativewindow.h"
 #include "knativeaudio.h"
 #include "knativesocket.h"
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+#include "../emulation/cpu/binaryTranslation/btTranslationWorkers.h"
+#include "../emulation/cpu/binaryTranslation/btCodeCache.h"
+#endif
 
 #ifndef BOXEDWINE_DISABLE_UI
 #include "../ui/data/globalSettings.h"
@@ -220,6 +224,35 @@ std::vector<BString> StartUpArgs::buildArgs() {
         args.push_back(B("-cpuAffinity"));
         args.push_back(BString::valueOf(cpuAffinity));
     }
+    if (spinBackoff) {
+        args.push_back(B("-spinBackoff"));
+    }
+    if (btThreads) {
+        args.push_back(B("-btThreads"));
+        args.push_back(BString::valueOf(btThreads));
+    }
+    if (btCacheDir.length()) {
+        args.push_back(B("-btCache"));
+        args.push_back(btCacheDir);
+    }
+    if (btShadowStack) {
+        args.push_back(B("-btShadowStack"));
+    }
+    if (btCodeCacheSize) {
+        args.push_back(B("-btCodeCacheSize"));
+        args.push_back(BString::valueOf(btCodeCacheSize));
+    }
+    if (btHotThreshold) {
+        args.push_back(B("-btHotThreshold"));
+        args.push_back(BString::valueOf(btHotThreshold));
+    }
+    if (btSubPageCodeWrites) {
+        args.push_back(B("-btSubPageCodeWrites"));
+    }
+    if (btTraceThreshold) {
+        args.push_back(B("-btTraceThreshold"));
+        args.push_back(BString::valueOf(btTraceThreshold));
+    }
     if (pollRate > 0) {
         args.push_back(B("-pollRate"));
         args.push_back(BString::valueOf(this->pollRate));
@@ -254,6 +287,22 @@ bool StartUpArgs::apply() {
     if (KSystem::cpuAffinityCountForApp) {
         klog("CPU Affinity set to %d", KSystem::cpuAffinityCountForApp);
     }
+    KSystem::spinBackoff = this->spinBackoff;
+#endif
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    KSystem::btTranslationThreads = this->btThreads;
+    if (KSystem::btTranslationThreads) {
+        klog("Using %d translation threads", KSystem::btTranslationThreads);
+        BtTranslationWorkers::start(KSystem::btTranslationThreads);
+    }
+    if (this->btCacheDir.length()) {
+        BtCodeCache::open(this->btCacheDir);
+    }
+    KSystem::btShadowStack = this->btShadowStack;
+    KSystem::btCodeCacheSize = this->btCodeCacheSize;
+    KSystem::btHotThreshold = this->btHotThreshold;
+    KSystem::btSubPageCodeWrites = this->btSubPageCodeWrites;
+    KSystem::btTraceThreshold = this->btTraceThreshold;
 #endif
     KSystem::pentiumLevel = this->pentiumLevel;
     KSystem::pollRate = this->pollRate;
@@ -511,9 +560,16 @@ bool StartUpArgs::apply() {
 #ifdef GENERATE_SOURCE
     if (gensrc)
         writeSource();
+#endif
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    BtCodeCache::close(); // logs how much was translated vs loaded from the cache
+    BtCodeCache::logSharing();
 #endif
     klog("Boxedwine has shutdown"); // must call before KSystem::destroy()
 	KSystem::destroy();
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    BtTranslationWorkers::stop();
+#endif
     KNativeWindow::shutdown();
     KNativeAudio::shutdown();
     dspShutdown();
@@ -697,6 +753,59 @@ bool StartUpArgs::parseStartupArgs(int argc, const char **argv) {
             this->cpuAffinity = atoi(argv[i+1]);
 #else
             klog("ignoring -cpuAffinity");
+#endif
+            i++;
+        } else if (!strcmp(argv[i], "-spinBackoff")) {
+#ifdef BOXEDWINE_MULTI_THREADED
+            this->spinBackoff = true;
+#else
+            klog("ignoring -spinBackoff");
+#endif
+        } else if (!strcmp(argv[i], "-btThreads") && i + 1 < argc) {
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+            this->btThreads = atoi(argv[i + 1]);
+#else
+            klog("ignoring -btThreads");
+#endif
+            i++;
+        } else if (!strcmp(argv[i], "-btCache") && i + 1 < argc) {
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+            this->btCacheDir = BString::copy(argv[i + 1]);
+#else
+            klog("ignoring -btCache");
+#endif
+            i++;
+        } else if (!strcmp(argv[i], "-btShadowStack")) {
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+            this->btShadowStack = true;
+#else
+            klog("ignoring -btShadowStack");
+#endif
+        } else if (!strcmp(argv[i], "-btCodeCacheSize") && i + 1 < argc) {
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+            this->btCodeCacheSize = atoi(argv[i + 1]);
+#else
+            klog("ignoring -btCodeCacheSize");
+#endif
+            i++;
+        } else if (!strcmp(argv[i], "-btHotThreshold") && i + 1 < argc) {
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+            this->btHotThreshold = atoi(argv[i + 1]);
+#else
+            klog("ignoring -btHotThreshold");
+#endif
+            i++;
+        } else if (!strcmp(argv[i], "-btSubPageCodeWrites")) {
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+            this->btSubPageCodeWrites = true;
+#else
+            klog("ignoring -btSubPageCodeWrites");
+#endif
+        } else if (!strcmp(argv[i], "-btTraceThreshold") && i + 1 < argc) {
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+            this->btTraceThreshold = atoi(argv[i + 1]);
+#else
+            klog("ignoring -btTraceThreshold");
 #endif
             i++;
         } else if (!strcmp(argv[i], "-skipFrameFPS") && i+1<argc) {
@@ -0,0 +1,750 @@
+#include "boxedwine.h"
+
+#ifdef __TEST
+
+#include "testCPU.h"
+#include "benchCPU.h"
+#include "../emulation/cpu/normal/normalCPU.h"
+#include "../emulation/softmmu/soft_code_page.h"
+#ifdef BOXEDWINE_X64
+#include "../emulation/cpu/binaryTranslation/btCpu.h"
+#include "../emulation/cpu/binaryTranslation/btInterpreter.h"
+#include "../emulation/cpu/x64/x64CPU.h"
+#endif
+#ifdef BOXEDWINE_MULTI_THREADED
+#include <thread>
+#include <ctime>
+#endif
+
+// Each benchmark is a loop body that is run by
+//
+// mov esi, iterations
+// loop:
+// <body>
+// dec esi
+// jnz loop
+//
+// The body must not touch esi or esp.
+struct CpuBenchmark {
+    const char* name;
+    void (*pushBody)();
+    U32 instructionsPerLoop; // doesn't include dec/jnz
+};
+
+static void pushAluMix() {
+    pushCode8(0x83); pushCode8(0xc0); pushCode8(0x05); // add eax, 5
+    pushCode8(0x29); pushCode8(0xd9); // sub ecx, ebx
+    pushCode8(0x31); pushCode8(0xc2); // xor edx, eax
+    pushCode8(0x83); pushCode8(0xe3); pushCode8(0x7f); // and ebx, 0x7f
+    pushCode8(0xc1); pushCode8(0xe7); pushCode8(0x03); // shl edi, 3
+    pushCode8(0x45); // inc ebp
+    pushCode8(0x01); pushCode8(0xc7); // add edi, eax
+    pushCode8(0xc1); pushCode8(0xfa); pushCode8(0x02); // sar edx, 2
+    pushCode8(0x09); pushCode8(0xc1); // or ecx, eax
+    pushCode8(0x4f); // dec edi
+}
+
+static void pushFlagConsumerMix() {
+    pushCode8(0x01); pushCode8(0xd8); // add eax, ebx
+    pushCode8(0x83); pushCode8(0xd2); pushCode8(0x00); // adc edx, 0
+    pushCode8(0x39); pushCode8(0xc8); // cmp eax, ecx
+    pushCode8(0x0f); pushCode8(0x92); pushCode8(0xc3); // setb bl
+    pushCode8(0x83); pushCode8(0xe9); pushCode8(0x01); // sub ecx, 1
+    pushCode8(0x0f); pushCode8(0x44); pushCode8(0xf8); // cmovz edi, eax
+    pushCode8(0x85); pushCode8(0xc0); // test eax, eax
+    pushCode8(0x74); pushCode8(0x00); // jz +0
+}
+
+// jcc's that read each of the flags after different kinds of instructions
+static void pushConditionMix() {
+    pushCode8(0x01); pushCode8(0xd8); // add eax, ebx
+    pushCode8(0x70); pushCode8(0x00); // jo +0
+    pushCode8(0x29); pushCode8(0xd1); // sub ecx, edx
+    pushCode8(0x76); pushCode8(0x00); // jbe +0
+    pushCode8(0x47); // inc edi
+    pushCode8(0x7e); pushCode8(0x00); // jle +0
+    pushCode8(0xd1); pushCode8(0xe3); // shl ebx, 1
+    pushCode8(0x72); pushCode8(0x00); // jb +0
+    pushCode8(0x85); pushCode8(0xc0); // test eax, eax
+    pushCode8(0x7a); pushCode8(0x00); // jp +0
+}
+
+static void pushMemoryMix() {
+    pushCode8(0x8b); pushCode8(0x05); pushCode32(0x10); // mov eax, [0x10]
+    pushCode8(0x01); pushCode8(0x05); pushCode32(0x14); // add [0x14], eax
+    pushCode8(0x83); pushCode8(0x05); pushCode32(0x18); pushCode8(0x01); // add dword ptr [0x18], 1
+    pushCode8(0x33); pushCode8(0x15); pushCode32(0x1c); // xor edx, [0x1c]
+    pushCode8(0x89); pushCode8(0x15); pushCode32(0x20); // mov [0x20], edx
+    pushCode8(0xff); pushCode8(0x05); pushCode32(0x24); // inc dword ptr [0x24]
+}
+
+static void pushFusionMix() {
+    pushCode8(0x89); pushCode8(0xc2); // mov edx, eax
+    pushCode8(0x83); pushCode8(0xc2); pushCode8(0x08); // add edx, 8
+    pushCode8(0x50); // push eax
+    pushCode8(0x51); // push ecx
+    pushCode8(0x6a); pushCode8(0x01); // push 1
+    pushCode8(0x83); pushCode8(0xc4); pushCode8(0x0c); // add esp, 12
+    pushCode8(0x39); pushCode8(0xcb); // cmp ebx, ecx
+    pushCode8(0x72); pushCode8(0x00); // jb +0
+    pushCode8(0x85); pushCode8(0xd2); // test edx, edx
+    pushCode8(0x75); pushCode8(0x00); // jnz +0
+}
+
+static void pushFpuMix() {
+    pushCode8(0xd9); pushCode8(0x05); pushCode32(0x10); // fld dword ptr [0x10]
+    pushCode8(0xd9); pushCode8(0xeb); // fldpi
+    pushCode8(0xd8); pushCode8(0xc9); // fmul st0, st1
+    pushCode8(0xd8); pushCode8(0xc1); // fadd st0, st1
+    pushCode8(0xd8); pushCode8(0x25); pushCode32(0x14); // fsub dword ptr [0x14]
+    pushCode8(0xd8); pushCode8(0xf1); // fdiv st0, st1
+    pushCode8(0xd9); pushCode8(0xc9); // fxch st1
+    pushCode8(0xdd); pushCode8(0xd8); // fstp st0
+    pushCode8(0xd9); pushCode8(0x1d); pushCode32(0x18); // fstp dword ptr [0x18]
+}
+
+// packed SSE/SSE2 arithmetic, compare builds with and without BOXEDWINE_SSE_NATIVE
+static void pushSsePackedMix() {
+    pushCode8(0x0f); pushCode8(0x58); pushCode8(0xc1); // addps xmm0, xmm1
+    pushCode8(0x0f); pushCode8(0x59); pushCode8(0xd3); // mulps xmm2, xmm3
+    pushCode8(0x0f); pushCode8(0x5c); pushCode8(0xee); // subps xmm5, xmm6
+    pushCode8(0x66); pushCode8(0x0f); pushCode8(0x58); pushCode8(0xe5); // addpd xmm4, xmm5
+    pushCode8(0x66); pushCode8(0x0f); pushCode8(0x59); pushCode8(0xf7); // mulpd xmm6, xmm7
+    pushCode8(0x66); pushCode8(0x0f); pushCode8(0xfe); pushCode8(0xca); // paddd xmm1, xmm2
+    pushCode8(0x66); pushCode8(0x0f); pushCode8(0xef); pushCode8(0xdc); // pxor xmm3, xmm4
+    pushCode8(0x66); pushCode8(0x0f); pushCode8(0xd5); pushCode8(0xf9); // pmullw xmm7, xmm1
+}
+
+static void pushCallMix() {
+    pushCode8(0xe8); pushCode32(2); // call sub
+    pushCode8(0xeb); pushCode8(0x04); // jmp over
+    pushCode8(0x83); pushCode8(0xc0); pushCode8(0x01); // sub: add eax, 1
+    pushCode8(0xc3); // ret
+    // over:
+}
+
+static CpuBenchmark callBenchmark = {"Call mix", pushCallMix, 4};
+
+// the exception exits of segment loads are cold code for the binary translator
+static void pushSegmentMix() {
+    pushCode8(0x1e); // push ds
+    pushCode8(0x07); // pop es
+    pushCode8(0x8c); pushCode8(0xd8); // mov eax, ds
+    pushCode8(0x8e); pushCode8(0xc0); // mov es, ax
+    pushCode8(0x01); pushCode8(0xd9); // add ecx, ebx
+    pushCode8(0x83); pushCode8(0xd2); pushCode8(0x00); // adc edx, 0
+}
+
+static CpuBenchmark segmentBenchmark = {"Segment mix", pushSegmentMix, 6};
+
+// a 16-bit rep movs is done by a host helper in the binary translator, ebx and ebp are live across it
+static void pushStringMix() {
+    pushCode8(0x56); // push esi
+    pushCode8(0xb9); pushCode32(16); // mov ecx, 16
+    pushCode8(0xbe); pushCode32(0x100); // mov esi, 0x100
+    pushCode8(0xbf); pushCode32(0x200); // mov edi, 0x200
+    pushCode8(0x67); pushCode8(0xf3); pushCode8(0xa4); // a16 rep movsb
+    pushCode8(0x5e); // pop esi
+    pushCode8(0x01); pushCode8(0xfb); // add ebx, edi
+    pushCode8(0x45); // inc ebp
+}
+
+static CpuBenchmark stringBenchmark = {"String mix", pushStringMix, 8};
+
+// 4k memcpy and memset, ES has to point to the same memory as DS
+static void pushMemcpy() {
+    pushCode8(0x56); // push esi
+    pushCode8(0xb9); pushCode32(1024); // mov ecx, 1024
+    pushCode8(0xbe); pushCode32(0); // mov esi, 0
+    pushCode8(0xbf); pushCode32(0x8000); // mov edi, 0x8000
+    pushCode8(0x67); pushCode8(0xf3); pushCode8(0xa5); // a16 rep movsd
+    pushCode8(0x5e); // pop esi
+}
+
+static void pushMemset() {
+    pushCode8(0xb9); pushCode32(1024); // mov ecx, 1024
+    pushCode8(0xbf); pushCode32(0x8000); // mov edi, 0x8000
+    pushCode8(0x67); pushCode8(0xf3); pushCode8(0xab); // a16 rep stosd
+}
+
+static CpuBenchmark memcpyBenchmark = {"Memcpy 4k", pushMemcpy, 6};
+static CpuBenchmark memsetBenchmark = {"Memset 4k", pushMemset, 3};
+
+// a counter on the same page as the loop, like a game's variables in its code segment
+static void pushCodePageWrite() {
+    pushCode8(0x2e); pushCode8(0x83); pushCode8(0x05); pushCode32(0x800); pushCode8(0x01); // add dword ptr cs:[0x800], 1
+}
+
+static void pushHeapWrite() {
+    pushCode8(0x83); pushCode8(0x05); pushCode32(0x800); pushCode8(0x01); // add dword ptr [0x800], 1
+}
+
+static CpuBenchmark codePageWriteBenchmark = {"Data write", pushCodePageWrite, 1};
+static CpuBenchmark heapWriteBenchmark = {"Data write", pushHeapWrite, 1};
+
+// call through a register that alternates between 2 targets, like a virtual call
+static void pushVirtualCallMix() {
+    U32 f1 = cseip + 19 - cpu->seg[CS].address;
+    pushCode8(0x40); // inc eax
+    pushCode8(0x89); pushCode8(0xc3); // mov ebx, eax
+    pushCode8(0x83); pushCode8(0xe3); pushCode8(0x01); // and ebx, 1
+    pushCode8(0x6b); pushCode8(0xdb); pushCode8(0x04); // imul ebx, ebx, 4
+    pushCode8(0x81); pushCode8(0xc3); pushCode32(f1); // add ebx, f1
+    pushCode8(0xff); pushCode8(0xd3); // call ebx
+    pushCode8(0xeb); pushCode8(0x08); // jmp over
+    pushCode8(0x83); pushCode8(0xc1); pushCode8(0x01); // f1: add ecx, 1
+    pushCode8(0xc3); // ret
+    pushCode8(0x83); pushCode8(0xc2); pushCode8(0x01); // f2: add edx, 1
+    pushCode8(0xc3); // ret
+    // over:
+}
+
+static CpuBenchmark virtualCallBenchmark = {"Virtual call mix", pushVirtualCallMix, 9};
+
+// the jmp ends the chunk, so each loop goes through 2 links unless they are translated again as one trace
+static void pushSplitLoop() {
+    pushAluMix();
+    pushCode8(0xeb); // jmp next
+    pushCode8(0x00);
+    pushAluMix();
+}
+static CpuBenchmark splitLoopBenchmark = {"Split loop", pushSplitLoop, 21};
+
+static CpuBenchmark cpuBenchmarks[] = {
+    {"ALU mix", pushAluMix, 10},
+    {"Flag consumer mix", pushFlagConsumerMix, 8},
+    {"Condition mix", pushConditionMix, 10},
+    {"Memory mix", pushMemoryMix, 6},
+    {"Fusion mix", pushFusionMix, 10},
+    {"FPU mix", pushFpuMix, 9},
+    {"SSE packed mix", pushSsePackedMix, 8},
+    callBenchmark,
+    virtualCallBenchmark,
+};
+
+static void pushBenchmarkLoop(CpuBenchmark* benchmark, U32 iterations) {
+    newInstruction(0);
+    cpu->eip.u32 = CODE_ADDRESS - cpu->seg[CS].address;
+    // mov esi, iterations
+    pushCode8(0xbe);
+    pushCode32(iterations);
+    U32 loopStart = cseip;
+    benchmark->pushBody();
+    // dec esi
+    pushCode8(0x4e);
+    // jnz loopStart
+    pushCode8(0x0f);
+    pushCode8(0x85);
+    pushCode32(loopStart - (cseip + 4));
+}
+
+// don't let the next run use the blocks that were cached for this one
+static void clearBenchmarkLoop() {
+    for (U32 address = CODE_ADDRESS; address < cseip; address++) {
+        writeb(address, 0);
+    }
+}
+
+// returns the number of microseconds it took to run the loop
+static U64 runBenchmarkLoop(CpuBenchmark* benchmark, U32 iterations, bool dynamicPage) {
+    pushBenchmarkLoop(benchmark, iterations);
+#ifdef BOXEDWINE_X64
+    if (dynamicPage) {
+        // every instruction checks that its guest bytes haven't changed
+        cpu->thread->memory->dynamicCodePageUpdateCount[cpu->thread->memory->getNativePage(CODE_ADDRESS >> K_PAGE_SHIFT)] = MAX_DYNAMIC_CODE_PAGE_COUNT;
+    }
+#endif
+
+    U64 startTime = KSystem::getMicroCounter();
+    runTestCPU();
+    U64 result = KSystem::getMicroCounter() - startTime;
+    clearBenchmarkLoop();
+    return result;
+}
+
+static void runBenchmark(CpuBenchmark* benchmark, const char* variant, bool dynamicPage = false) {
+    const U32 iterations = 2000000;
+    U64 instructions = (U64)iterations * (benchmark->instructionsPerLoop + 2);
+
+    runBenchmarkLoop(benchmark, 1000, dynamicPage); // warm up
+    U64 time = runBenchmarkLoop(benchmark, iterations, dynamicPage);
+    if (!time) {
+        time = 1;
+    }
+    printf("%-24s %-24s %8llu ms %8.1f MIPS\n", benchmark->name, variant, (unsigned long long)(time / 1000), (double)instructions / (double)time);
+}
+
+struct CpuBenchmarkVariant {
+    const char* name;
+    bool flagLiveness;
+    bool fusion;
+};
+
+static CpuBenchmarkVariant cpuBenchmarkVariants[] = {
+    {"baseline", false, false},
+    {"flag liveness", true, false},
+    {"fusion", false, true},
+    {"flag liveness + fusion", true, true},
+};
+
+// MB/s for string ops that copy or fill 4k each loop
+static void runStringThroughputBenchmark() {
+    CpuBenchmark* benchmarks[] = {&memcpyBenchmark, &memsetBenchmark};
+    const U32 iterations = 20000;
+    U32 esAddress = cpu->seg[ES].address;
+    cpu->seg[ES].address = cpu->seg[DS].address;
+
+    for (auto& benchmark : benchmarks) {
+        runBenchmarkLoop(benchmark, 100, false); // warm up
+        U64 time = runBenchmarkLoop(benchmark, iterations, false);
+        if (!time) {
+            time = 1;
+        }
+        printf("%-24s %-24s %8llu ms %8.1f MB/s\n", benchmark->name, "", (unsigned long long)(time / 1000), (double)iterations * 4096 / (double)time);
+    }
+    cpu->seg[ES].address = esAddress;
+}
+
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+// The same loop on more and more threads at once, each with its own copy of the registers, so the only thing they
+// share is the code cache.  The total MIPS should go up with the thread count until there are more threads than
+// host cores.
+static void runThreadScalingBenchmark(CpuBenchmark* benchmark) {
+    const U32 iterations = 2000000;
+    double singleThreadMips = 0;
+
+    for (U32 threadCount = 1; threadCount <= 8; threadCount *= 2) {
+        U64 instructions = (U64)iterations * (benchmark->instructionsPerLoop + 2) * threadCount;
+        pushBenchmarkLoop(benchmark, iterations);
+        U64 time = runTestCPUOnThreads(threadCount);
+        clearBenchmarkLoop();
+        if (!time) {
+            time = 1;
+        }
+        double mips = (double)instructions / (double)time;
+        if (threadCount == 1) {
+            singleThreadMips = mips;
+        }
+        char variant[32];
+        snprintf(variant, sizeof(variant), "%d threads", threadCount);
+        printf("%-24s %-24s %8llu ms %8.1f MIPS %5.2fx\n", benchmark->name, variant, (unsigned long long)(time / 1000), mips, mips / singleThreadMips);
+    }
+}
+#endif
+
+#ifdef BOXEDWINE_MULTI_THREADED
+// A guest thread waits on a flag that a host thread sets after 20ms.  Shows how much of a host core the waiting thread
+// used and how long after the flag was set it noticed.
+static void runSpinContentionBenchmark() {
+    const char* loops[] = {"pause loop", "poll loop"};
+    bool spinBackoff = KSystem::spinBackoff;
+
+    for (U32 loop = 0; loop < 2; loop++) {
+        for (U32 i = 0; i < 2; i++) {
+            KSystem::spinBackoff = i == 1;
+            writed(HEAP_ADDRESS + 0x100, 0);
+            newInstruction(0);
+            if (loop == 0) {
+                pushCode8(0xf3); // pause
+                pushCode8(0x90);
+            }
+            pushCode8(0x83); // cmp dword [0x100], 0
+            pushCode8(0x3d);
+            pushCode32(0x100);
+            pushCode8(0x00);
+            pushCode8(0x74); // je loop start
+            pushCode8(loop == 0 ? 0xf5 : 0xf7);
+
+            U64 setTime = 0;
+            KThread* thread = cpu->thread;
+            std::thread writer([thread, &setTime]() {
+                KThread::setCurrentThread(thread);
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                setTime = KSystem::getMicroCounter();
+                writed(HEAP_ADDRESS + 0x100, 1);
+            });
+            std::clock_t startClock = std::clock();
+            U64 startTime = KSystem::getMicroCounter();
+            runTestCPU();
+            U64 endTime = KSystem::getMicroCounter();
+            std::clock_t endClock = std::clock();
+            writer.join();
+            clearBenchmarkLoop();
+
+            double cpuTime = (double)(endClock - startClock) * 1000000.0 / CLOCKS_PER_SEC;
+            U64 time = endTime - startTime;
+            if (!time) {
+                time = 1;
+            }
+            char variant[32];
+            snprintf(variant, sizeof(variant), "%s%s", loops[loop], KSystem::spinBackoff ? ", back off" : "");
+            printf("%-24s %-24s %8llu us wake latency %5.1f%% cpu\n", "Spin contention", variant, (unsigned long long)(endTime > setTime ? endTime - setTime : 0), 100.0 * cpuTime / (double)time);
+        }
+    }
+    KSystem::spinBackoff = spinBackoff;
+}
+#endif
+
+#ifdef BOXEDWINE_X64
+// The work the exception handler does to map the host address of a fault back to an eip, spread over enough chunks
+// that the executable memory is made up of many blocks
+static void runFaultLookupBenchmark() {
+    const U32 pageCount = 16;
+    const U32 blockCount = pageCount * K_PAGE_SIZE / 3;
+    const U32 lookups = 2000000;
+    Memory* memory = cpu->thread->memory;
+    std::vector<void*> hostAddresses;
+
+    newInstruction(0);
+    for (U32 i = 0; i < blockCount; i++) {
+        pushCode8(0x40); // inc eax
+        pushCode8(0xcd); // int 0x97
+        pushCode8(0x97);
+    }
+    for (U32 i = 0; i < blockCount; i++) {
+        ((BtCPU*)cpu)->translateEip(i * 3);
+        U8* host = (U8*)memory->getExistingHostAddress(CODE_ADDRESS + i * 3);
+        if (host) {
+            hostAddresses.push_back(host + 1);
+        }
+    }
+    // visit the chunks out of order so that this isn't just measuring the cache
+    std::vector<void*> order;
+    for (U32 i = 0; i < hostAddresses.size(); i++) {
+        order.push_back(hostAddresses[(i * 7919) % hostAddresses.size()]);
+    }
+    U64 eipSum = 0;
+    U64 startTime = KSystem::getMicroCounter();
+    for (U32 i = 0; i < lookups; i++) {
+        void* address = order[i % order.size()];
+        BtCodeChunk* chunk = memory->findCodeChunkContainingHostAddress(address);
+        if (chunk && chunk->getEipLen()) {
+            eipSum += chunk->getEipThatContainsHostAddress(address, NULL, NULL);
+        }
+    }
+    U64 time = KSystem::getMicroCounter() - startTime;
+    printf("%-24s %-24s %8.1f ns/lookup (%d chunks, %d blocks)\n", "Fault lookup", "lock free index", (double)time * 1000.0 / lookups, (int)hostAddresses.size(), (int)memory->allocatedExecutableMemory.size());
+
+    startTime = KSystem::getMicroCounter();
+    for (U32 i = 0; i < lookups; i++) {
+        void* address = order[i % order.size()];
+        if (memory->isAddressExecutable(address)) {
+            std::shared_ptr<BtCodeChunk> chunk = memory->getCodeChunkContainingHostAddress(address);
+            if (chunk && chunk->getEipLen()) {
+                eipSum += chunk->getEipThatContainsHostAddress(address, NULL, NULL);
+            }
+        }
+    }
+    time = KSystem::getMicroCounter() - startTime;
+    printf("%-24s %-24s %8.1f ns/lookup\n", "Fault lookup", "shared_ptr", (double)time * 1000.0 / lookups);
+    if (eipSum == 0) {
+        printf("Fault lookup didn't find any chunks\n");
+    }
+
+    for (U32 i = 0; i < pageCount; i++) {
+        memory->clearCodePageFromCache((CODE_ADDRESS >> K_PAGE_SHIFT) + i);
+    }
+    ((BtCPU*)cpu)->postTestRun();
+}
+
+static void pushTranslationBlock(U32 block) {
+    U32 start = cseip;
+    pushCode8(0x83); pushCode8(0xc0); pushCode8(block & 0x7f); // add eax, block
+    pushCode8(0x29); pushCode8(0xd9); // sub ecx, ebx
+    pushCode8(0x8b); pushCode8(0x55); pushCode8(0x08); // mov edx, [ebp+8]
+    pushCode8(0x39); pushCode8(0xc8); // cmp eax, ecx
+    pushCode8(0x74); pushCode8(0x02); // jz +2
+    pushCode8(0x31); pushCode8(0xd2); // xor edx, edx
+    pushCode8(0x43); // inc ebx
+    pushCode8(0x8d); pushCode8(0x77); pushCode8(0x04); // lea esi, [edi+4]
+    pushCode8(0x50); // push eax
+    pushCode8(0x89); pushCode8(0x45); pushCode8(0xfc); // mov [ebp-4], eax
+    pushCode8(0x58); // pop eax
+    pushCode8(0x85); pushCode8(0xc0); // test eax, eax
+    pushCode8(0x75); pushCode8((U8)(start - (cseip + 1))); // jnz start
+    pushCode8(0x0f); pushCode8(0x8c); pushCode32(3); // jl +3
+    pushCode8(0x01); pushCode8(0xd8); // add eax, ebx
+    pushCode8(0x90); // nop
+    pushCode8(0xeb); pushCode8(0x00); // jmp to the next block, ends the chunk
+}
+
+// How many bytes of guest code can be translated per second, the blocks are translated last to first so that each
+// jmp at the end of a block links to code that is already translated like it mostly would for a real program
+static void runTranslationBenchmark() {
+    const U32 pageCount = 16;
+    const U32 passes = 20;
+    Memory* memory = cpu->thread->memory;
+    std::vector<U32> blocks;
+
+    newInstruction(0);
+    while (cseip < CODE_ADDRESS + pageCount * K_PAGE_SIZE - 64) {
+        blocks.push_back(cseip - cpu->seg[CS].address);
+        pushTranslationBlock((U32)blocks.size());
+    }
+    pushCode8(0xcd); // int 0x97
+    pushCode8(0x97);
+    U32 bytes = cseip - CODE_ADDRESS;
+    U64 time = 0;
+    for (U32 pass = 0; pass < passes; pass++) {
+        U64 startTime = KSystem::getMicroCounter();
+        for (S32 i = (S32)blocks.size() - 1; i >= 0; i--) {
+            ((BtCPU*)cpu)->translateEip(blocks[i]);
+        }
+        time += KSystem::getMicroCounter() - startTime;
+        for (U32 i = 0; i < pageCount; i++) {
+            memory->clearCodePageFromCache((CODE_ADDRESS >> K_PAGE_SHIFT) + i);
+        }
+    }
+    if (!time) {
+        time = 1;
+    }
+    printf("%-24s %-24s %8llu ms %8.1f MB/s guest code (%d chunks)\n", "Translation", "", (unsigned long long)(time / 1000), (double)bytes * passes / (double)time, (int)blocks.size());
+    ((BtCPU*)cpu)->postTestRun();
+}
+
+// How much of a translated loop body is in the hot path and how much was moved out of line, along with how fast the
+// loop runs.  On a dynamic page each instruction that needs the flags restores them before its retranslation trap.
+static void runColdCodeBenchmark() {
+    CpuBenchmark* benchmarks[] = {&cpuBenchmarks[1], &segmentBenchmark};
+    Memory* memory = cpu->thread->memory;
+    U32 page = CODE_ADDRESS >> K_PAGE_SHIFT;
+
+    for (auto& benchmark : benchmarks) {
+        for (U32 dynamicPage = 0; dynamicPage < 2; dynamicPage++) {
+            newInstruction(0);
+            benchmark->pushBody();
+            pushCode8(0xcd); // int 0x97
+            pushCode8(0x97);
+            if (dynamicPage) {
+                memory->dynamicCodePageUpdateCount[memory->getNativePage(page)] = MAX_DYNAMIC_CODE_PAGE_COUNT;
+            }
+            ((BtCPU*)cpu)->translateEip(cpu->eip.u32);
+            std::shared_ptr<BtCodeChunk> chunk = memory->getCodeChunkContainingEip(CODE_ADDRESS);
+            U32 coldLen = 0;
+            for (U32 i = 0; chunk && i <= benchmark->instructionsPerLoop; i++) {
+                U8* coldHost;
+                U32 len;
+                if (chunk->getColdCode(i, &coldHost, &len)) {
+                    coldLen += len;
+                }
+            }
+            const char* variant = dynamicPage ? "dynamic page" : "";
+            if (chunk) {
+                printf("%-24s %-24s %5d bytes hot %5d bytes cold\n", benchmark->name, variant, chunk->getHostAddressLen() - coldLen, coldLen);
+            }
+            memory->clearCodePageFromCache(page);
+            ((BtCPU*)cpu)->postTestRun();
+            runBenchmark(benchmark, variant, dynamicPage != 0);
+        }
+    }
+}
+
+static void pushRunOnceBlock(U32 block) {
+    pushCode8(0x83); pushCode8(0xc0); pushCode8(block & 0x7f); // add eax, block
+    pushCode8(0x29); pushCode8(0xd9); // sub ecx, ebx
+    pushCode8(0x50); // push eax
+    pushCode8(0x8b); pushCode8(0x14); pushCode8(0x24); // mov edx, [esp]
+    pushCode8(0x58); // pop eax
+    pushCode8(0x39); pushCode8(0xc8); // cmp eax, ecx
+    pushCode8(0x74); pushCode8(0x02); // jz +2
+    pushCode8(0x31); pushCode8(0xd2); // xor edx, edx
+    pushCode8(0x43); // inc ebx
+    pushCode8(0xc1); pushCode8(0xe7); pushCode8(0x03); // shl edi, 3
+    pushCode8(0xeb); pushCode8(0x00); // jmp to the next block
+}
+
+// A program's start up code is mostly run once, this runs a lot of straight line blocks once (start up) and then
+// again and again (steady state) with and without interpreting cold blocks before they are translated
+static void runTieredExecutionBenchmark() {
+    const U32 pageCount = 16;
+    const U32 steadyRuns = 200;
+    const U32 thresholds[] = {0, 50};
+    Memory* memory = cpu->thread->memory;
+    BtInterpreter* interpreter = ((BtCPU*)cpu)->interpreter;
+    U32 threshold = KSystem::btHotThreshold;
+
+    newInstruction(0);
+    U32 blocks = 0;
+    while (cseip < CODE_ADDRESS + pageCount * K_PAGE_SIZE - 64) {
+        pushRunOnceBlock(blocks++);
+    }
+    pushCode8(0xcd); // int 0x97
+    pushCode8(0x97);
+    for (U32 t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++) {
+        KSystem::btHotThreshold = thresholds[t];
+        interpreter->clear();
+        U32 blockCount = BtInterpreter::blockCount;
+        U32 promotedCount = BtInterpreter::promotedCount;
+        U64 startTime = KSystem::getMicroCounter();
+        cpu->eip.u32 = 0;
+        cpu->run();
+        U64 startUpTime = KSystem::getMicroCounter() - startTime;
+        startTime = KSystem::getMicroCounter();
+        for (U32 i = 0; i < steadyRuns; i++) {
+            cpu->eip.u32 = 0;
+            cpu->run();
+        }
+        U64 steadyTime = KSystem::getMicroCounter() - startTime;
+        char variant[32];
+        snprintf(variant, sizeof(variant), "hot threshold %d", thresholds[t]);
+        printf("%-24s %-24s %8llu us start up %8llu us for %d more runs (%d blocks, %d interpreted, %d translated after becoming hot)\n", "Tiered execution", variant, (unsigned long long)startUpTime, (unsigned long long)steadyTime, steadyRuns, blocks, BtInterpreter::blockCount - blockCount, BtInterpreter::promotedCount - promotedCount);
+        for (U32 i = 0; i < pageCount; i++) {
+            memory->clearCodePageFromCache((CODE_ADDRESS >> K_PAGE_SHIFT) + i);
+        }
+    }
+    interpreter->clear();
+    KSystem::btHotThreshold = threshold;
+    ((BtCPU*)cpu)->postTestRun();
+}
+
+// A loop on a page that also has data, every so often the loop writes to the data.  Without sub-page tracking each
+// write throws away the page's code and after enough of them the page becomes dynamic, with it each write is a fault
+// that leaves the code alone.
+static void runSubPageCodeWriteBenchmark() {
+    const U32 rounds = 250; // fewer than MAX_DYNAMIC_CODE_PAGE_COUNT and MAX_CODE_PAGE_DATA_WRITE_COUNT
+    const U32 innerLoops = 2000;
+    Memory* memory = cpu->thread->memory;
+    U32 page = CODE_ADDRESS >> K_PAGE_SHIFT;
+    bool subPageCodeWrites = KSystem::btSubPageCodeWrites;
+
+    for (U32 subPage = 0; subPage < 2; subPage++) {
+        KSystem::btSubPageCodeWrites = subPage != 0;
+        newInstruction(0);
+        U32 outer = cseip;
+        pushCode8(0xbe); pushCode32(innerLoops); // mov esi, innerLoops
+        U32 inner = cseip;
+        pushAluMix();
+        pushCode8(0x4e); // dec esi
+        pushCode8(0x75); pushCode8((U8)(inner - (cseip + 1))); // jnz inner
+        pushCode8(0x2e); pushCode8(0x83); pushCode8(0x2d); pushCode32(0x800); pushCode8(0x01); // sub dword ptr cs:[0x800], 1
+        pushCode8(0x0f); pushCode8(0x85); pushCode32(outer - (cseip + 4)); // jnz outer
+        pushCode8(0xcd); // int 0x97
+        pushCode8(0x97);
+        writed(CODE_ADDRESS + 0x800, rounds);
+
+        U64 dataWrites = memory->codePageDataWriteCount;
+        cpu->eip.u32 = 0;
+        U64 startTime = KSystem::getMicroCounter();
+        ((BtCPU*)cpu)->translateEip(cpu->eip.u32);
+        cpu->run();
+        U64 time = KSystem::getMicroCounter() - startTime;
+        if (!time) {
+            time = 1;
+        }
+        U64 instructions = (U64)rounds * (innerLoops * (cpuBenchmarks[0].instructionsPerLoop + 2) + 3);
+        printf("%-24s %-24s %8llu ms %8.1f MIPS %5d data write faults, page %s\n", "Code page data writes", subPage ? "sub-page" : "whole page", (unsigned long long)(time / 1000), (double)instructions / (double)time, (int)(memory->codePageDataWriteCount - dataWrites), memory->dynamicCodePageUpdateCount[memory->getNativePage(page)] == MAX_DYNAMIC_CODE_PAGE_COUNT ? "became dynamic" : "stayed read-only");
+        memory->clearCodePageFromCache(page);
+        ((BtCPU*)cpu)->postTestRun();
+    }
+    KSystem::btSubPageCodeWrites = subPageCodeWrites;
+}
+#endif
+
+int runCpuBenchmarks() {
+    setup();
+    for (U32 i = 0; i < sizeof(cpuBenchmarks) / sizeof(cpuBenchmarks[0]); i++) {
+        for (U32 v = 0; v < sizeof(cpuBenchmarkVariants) / sizeof(cpuBenchmarkVariants[0]); v++) {
+            NormalCPU::useFlagLiveness = cpuBenchmarkVariants[v].flagLiveness;
+            NormalCPU::useFusion = cpuBenchmarkVariants[v].fusion;
+            runBenchmark(&cpuBenchmarks[i], cpuBenchmarkVariants[v].name);
+        }
+    }
+    NormalCPU::useFlagLiveness = true;
+    NormalCPU::useFusion = true;
+    printf("fused blocks: cmp/test+jcc=%d mov+add=%d push runs=%d, saved dispatches=%d\n", NormalCPU::fusionStats.cmpJcc.load(), NormalCPU::fusionStats.movAdd.load(), NormalCPU::fusionStats.pushRuns.load(), NormalCPU::fusionStats.opsFused.load());
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+    CpuBenchmark* indirectBenchmarks[] = {&callBenchmark, &virtualCallBenchmark};
+    NormalIndirectStats& indirectStats = ((NormalCPU*)cpu)->indirectStats;
+    for (auto& benchmark : indirectBenchmarks) {
+        for (U32 i = 0; i < 2; i++) {
+            NormalCPU::useIndirectPrediction = i == 1;
+            NormalIndirectStats stats = indirectStats;
+            runBenchmark(benchmark, NormalCPU::useIndirectPrediction ? "indirect prediction" : "no indirect prediction");
+            U32 targetHits = indirectStats.targetHits - stats.targetHits;
+            U32 targetMisses = indirectStats.targetMisses - stats.targetMisses;
+            U32 returnHits = indirectStats.returnHits - stats.returnHits;
+            U32 returnMisses = indirectStats.returnMisses - stats.returnMisses;
+            if (targetHits + targetMisses) {
+                printf("indirect targets: %d hits, %d misses, %.2f%% hit rate\n", targetHits, targetMisses, 100.0 * targetHits / (targetHits + targetMisses));
+            }
+            if (returnHits + returnMisses) {
+                printf("return stack: %d hits, %d misses, %.2f%% hit rate\n", returnHits, returnMisses, 100.0 * returnHits / (returnHits + returnMisses));
+            }
+        }
+    }
+    NormalCPU::useIndirectPrediction = true;
+#endif
+    runStringThroughputBenchmark();
+#ifdef BOXEDWINE_DYNAMIC
+    // the same loops with the blocks left to the normal core instead of being compiled
+    NormalCPU* normalCpu = (NormalCPU*)cpu;
+    OpCallback firstOp = normalCpu->firstOp;
+    for (U32 i = 0; i < sizeof(cpuBenchmarks) / sizeof(cpuBenchmarks[0]); i++) {
+        for (U32 dynamic = 0; dynamic < 2; dynamic++) {
+            normalCpu->firstOp = dynamic ? firstOp : NULL;
+            runBenchmark(&cpuBenchmarks[i], dynamic ? "dynamic" : "normal");
+        }
+    }
+    normalCpu->firstOp = firstOp;
+#endif
+#ifdef BOXEDWINE_DEFAULT_MMU
+    CodePageStats codePageStats = CodePage::stats;
+    runBenchmark(&heapWriteBenchmark, "heap page");
+    runBenchmark(&codePageWriteBenchmark, "code page");
+    printf("code page writes: %d fast, %d slow, %d blocks invalidated\n", CodePage::stats.fastWrites - codePageStats.fastWrites, CodePage::stats.slowWrites - codePageStats.slowWrites, CodePage::stats.blocksInvalidated - codePageStats.blocksInvalidated);
+#endif
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    runThreadScalingBenchmark(&cpuBenchmarks[0]);
+#endif
+#ifdef BOXEDWINE_MULTI_THREADED
+    runSpinContentionBenchmark();
+#endif
+#ifdef BOXEDWINE_X64
+    // the shadow stack is only used for flat code
+    U32 csAddress = cpu->seg[CS].address;
+    bool hasSetCS = cpu->thread->process->hasSetSeg[CS];
+    bool shadowStack = KSystem::btShadowStack;
+    cpu->seg[CS].address = 0;
+    cpu->thread->process->hasSetSeg[CS] = false;
+    x64CPU* x64 = (x64CPU*)cpu;
+    for (U32 i = 0; i < 2; i++) {
+        KSystem::btShadowStack = i == 0;
+        x64->shadowStackHits = 0;
+        x64->shadowStackMisses = 0;
+        runBenchmark(&callBenchmark, KSystem::btShadowStack ? "flat, shadow stack" : "flat, no shadow stack");
+        U32 returns = x64->shadowStackHits + x64->shadowStackMisses;
+        if (returns) {
+            printf("shadow stack: %d hits, %d misses, %.2f%% hit rate\n", x64->shadowStackHits, x64->shadowStackMisses, 100.0 * x64->shadowStackHits / returns);
+        }
+    }
+    KSystem::btShadowStack = shadowStack;
+
+    cpu->seg[CS].address = csAddress;
+    cpu->thread->process->hasSetSeg[CS] = hasSetCS;
+
+    runFaultLookupBenchmark();
+    runTranslationBenchmark();
+    runColdCodeBenchmark();
+    runTieredExecutionBenchmark();
+    runSubPageCodeWriteBenchmark();
+
+    U32 traceThreshold = KSystem::btTraceThreshold;
+    for (U32 i = 0; i < 2; i++) {
+        KSystem::btTraceThreshold = i ? 50 : 0;
+        U32 tracesFormed = BtCPU::tracesFormed;
+        runBenchmark(&splitLoopBenchmark, i ? "trace threshold 50" : "no traces");
+        printf("traces: %d formed\n", BtCPU::tracesFormed - tracesFormed);
+    }
+    KSystem::btTraceThreshold = traceThreshold;
+
+    // host calls from translated code, the fpu helpers are only used when the fpu is emulated
+    runBenchmark(&stringBenchmark, "");
+    bool emulateFPU = cpu->thread->process->emulateFPU;
+    cpu->thread->process->emulateFPU = true;
+    runBenchmark(&cpuBenchmarks[5], "emulated fpu");
+    cpu->thread->process->emulateFPU = emulateFPU;
+#endif
+    return 0;
+}
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __BENCH_CPU_H__
+#define __BENCH_CPU_H__
+
+int runCpuBenchmarks();
+
+#endif
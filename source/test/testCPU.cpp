@@ -22,9 +22,21 @@
 #include <stdio.h>
 
 #include "../emulation/softmmu/soft_memory.h"
+#include "../emulation/softmmu/soft_code_page.h"
 #include "../emulation/hardmmu/hard_memory.h"
 #include "../emulation/cpu/binaryTranslation/btCpu.h"
+#include "../emulation/cpu/binaryTranslation/btCodeChunk.h"
+#include "../emulation/cpu/binaryTranslation/btTranslationWorkers.h"
+#include "../emulation/cpu/binaryTranslation/btCodeCache.h"
+#include "../emulation/cpu/binaryTranslation/btInterpreter.h"
+#ifdef BOXEDWINE_X64
+#include "../emulation/cpu/x64/x64CPU.h"
+#endif
+#include "../emulation/cpu/normal/normalCPU.h"
 #include "knativethread.h"
+#ifdef BOXEDWINE_MULTI_THREADED
+#include <thread>
+#endif
 
 #ifdef BOXEDWINE_MSVC
 #include <nmmintrin.h>
@@ -34,12 +46,13 @@
 #include "testMMX.h"
 #include "testSSE.h"
 #include "testSSE2.h"
+#include "benchCPU.h"
 
 #ifdef BOXEDWINE_MULTI_THREADED
 void initThreadForTesting();
 #endif
 
-static int cseip;
+U32 cseip;
 
 #define G(rm) ((rm >> 3) & 7)
 #define E(rm) (rm & 7)
@@ -235,6 +248,19 @@ void useFlags() {
     pushCode8(0x02);
 }
 
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+// runs until it gets to the 2 jo's that runTestCPU puts at the end of the code
+static void runTestCPUBlocks(CPU* cpu) {
+    cpu->nextBlock = cpu->getNextBlock();    
+    do {
+        cpu->run();
+        if (!cpu->nextBlock) {
+            cpu->nextBlock = cpu->getNextBlock();
+        }
+    } while (cpu->nextBlock->op->inst != JumpO && (cpu->nextBlock->op->inst != Custom1 || cpu->nextBlock->op->next->inst != JumpO));
+}
+#endif
+
 void runTestCPU() {    
 #ifdef BOXEDWINE_BINARY_TRANSLATOR    
     pushCode8(0xcd);
@@ -246,14 +272,7 @@ void runTestCPU() {
     pushCode8(0);
     pushCode8(0x70); // jump will fetch the next block as well
     pushCode8(0);
-    cpu->nextBlock = cpu->getNextBlock();    
-    do {
-        cpu->run();
-        if (!cpu->nextBlock) {
-            cpu->nextBlock = cpu->getNextBlock();
-        }
-    } while (cpu->nextBlock->op->inst != JumpO && (cpu->nextBlock->op->inst != Custom1 || cpu->nextBlock->op->next->inst != JumpO));
-
+    runTestCPUBlocks(cpu);
 #endif    
 #ifdef BOXEDWINE_64BIT_MMU
     KThread::currentThread()->memory->clearCodePageFromCache(CODE_ADDRESS>>K_PAGE_SHIFT);    
@@ -264,6 +283,48 @@ void runTestCPU() {
 #endif
 }
 
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+// Runs the code at CODE_ADDRESS on threadCount host threads at the same time, each one starts with a copy of the test
+// cpu's registers.  Returns how many microseconds it took for all of them to finish.
+U64 runTestCPUOnThreads(U32 threadCount) {
+    pushCode8(0x70); // jump causes the decoder to stop building the block
+    pushCode8(0);
+    pushCode8(0x70); // jump will fetch the next block as well
+    pushCode8(0);
+
+    std::vector<KThread*> threads;
+    for (U32 i = 0; i < threadCount; i++) {
+        KThread* thread = new KThread(KSystem::getNextThreadId(), process);
+        CPU* threadCpu = thread->cpu;
+        memcpy(threadCpu->reg, cpu->reg, sizeof(cpu->reg));
+        memcpy(threadCpu->seg, cpu->seg, sizeof(cpu->seg));
+        threadCpu->eip = cpu->eip;
+        threadCpu->flags = cpu->flags;
+        threadCpu->lazyFlags = cpu->lazyFlags;
+        threadCpu->df = cpu->df;
+        threadCpu->setIsBig(cpu->big);
+        threads.push_back(thread);
+    }
+
+    std::vector<std::thread> hostThreads;
+    U64 startTime = KSystem::getMicroCounter();
+    for (KThread* thread : threads) {
+        hostThreads.push_back(std::thread([thread]() {
+            KThread::setCurrentThread(thread);
+            runTestCPUBlocks(thread->cpu);
+        }));
+    }
+    for (std::thread& hostThread : hostThreads) {
+        hostThread.join();
+    }
+    U64 result = KSystem::getMicroCounter() - startTime;
+    for (KThread* thread : threads) {
+        delete thread;
+    }
+    return result;
+}
+#endif
+
 struct Data {
     int valid;
     U32 var1;
@@ -8426,6 +8487,97 @@ void testFPU0x2d9() {cpu->big=true;testFPUD9();}
 void testFPU0x0da() { cpu->big = false; testFPUDA(); }
 void testFPU0x2da() { cpu->big = true; testFPUDA(); }
 
+static void pushFpuMem(U8 op, int group, int index) {
+    pushCode8(op);
+    pushCode8(rm(true, group, cpu->big ? 5 : 6));
+    if (cpu->big)
+        pushCode32(4 * index);
+    else
+        pushCode16(4 * index);
+}
+
+// round to nearest even with a 24-bit significand but without limiting the exponent, like the x87 does
+static double roundToSingleSignificand(double d) {
+    int exp;
+    double m = frexp(d, &exp);
+    return ldexp(nearbyint(m * 16777216.0) / 16777216.0, exp);
+}
+
+// fldcw, fld x, <op> y, fstp qword and compare the result
+static void doFPrecision(U16 cw, U8 op, int group, float x, float y, double r) {
+    newInstruction(0);
+    fpu_init();
+    writew(HEAP_ADDRESS, cw);
+    pushFpuMem(0xd9, 5, 0); // fldcw
+    fldf32(x, 1);
+    writeF(y, 2);
+    if (group < 0) {
+        pushCode8(0xd9); pushCode8(0xfa); // fsqrt
+    } else {
+        pushFpuMem(op, group, 2);
+    }
+    pushFpuMem(0xdd, 3, 4); // fstp qword
+    runTestCPU();
+    struct FPU_Reg result;
+    result.l = readq(HEAP_ADDRESS + 4 * 4);
+    assertTrue(result.d == r);
+}
+
+// fldcw, fld qword x, <op> qword y, fstp qword and compare the result
+static void doFPrecision64(U16 cw, U8 op, int group, double x, double y, double r) {
+    struct FPU_Reg value;
+
+    newInstruction(0);
+    fpu_init();
+    writew(HEAP_ADDRESS, cw);
+    pushFpuMem(0xd9, 5, 0); // fldcw
+    value.d = x;
+    writeq(HEAP_ADDRESS + 2 * 4, value.l);
+    pushFpuMem(0xdd, 0, 2); // fld qword
+    value.d = y;
+    writeq(HEAP_ADDRESS + 4 * 4, value.l);
+    pushFpuMem(op, group, 4);
+    pushFpuMem(0xdd, 3, 6); // fstp qword
+    runTestCPU();
+    struct FPU_Reg result;
+    result.l = readq(HEAP_ADDRESS + 6 * 4);
+    assertTrue(result.d == r);
+}
+
+void testFPUPrecision() {
+    cpu->big = true;
+    for (U32 i = 0; i < 3; i++) {
+        // 24, 53 and 64 bit precision control, 64-bit is approximated with doubles
+        U16 cw = (i == 0) ? 0x07F : ((i == 1) ? 0x27F : 0x37F);
+        bool single = (i == 0);
+
+        doFPrecision(cw, 0xd8, 6, 1.0f, 3.0f, single ? (double)(1.0f / 3.0f) : 1.0 / 3.0); // fdiv
+        doFPrecision(cw, 0xd8, 7, 3.0f, 1.0f, single ? (double)(1.0f / 3.0f) : 1.0 / 3.0); // fdivr
+        doFPrecision(cw, 0xd8, 0, 1.0f, 5.9604645e-08f, single ? 1.0 : 1.0 + (double)5.9604645e-08f); // fadd, halfway case rounds to even
+        doFPrecision(cw, 0xd8, 4, 1.0f, -1.7881393e-07f, single ? 1.0 + 2.384185791015625e-07 : 1.0 - (double)-1.7881393e-07f); // fsub
+        doFPrecision(cw, 0xd8, 1, 1.1f, 1.3f, single ? roundToSingleSignificand((double)1.1f * (double)1.3f) : (double)1.1f * (double)1.3f); // fmul
+        doFPrecision(cw, 0xd8, 1, 1e30f, 1e30f, single ? roundToSingleSignificand((double)1e30f * (double)1e30f) : (double)1e30f * (double)1e30f); // fmul, out of float range
+        doFPrecision(cw, 0, -1, 2.0f, 0.0f, single ? (double)sqrtf(2.0f) : sqrt(2.0)); // fsqrt
+    }
+
+    // 24-bit results honor the rounding control, 1/3 and sqrt(2) round up to nearest as a float
+    float third = 1.0f / 3.0f;
+    float thirdDown = nextafterf(third, 0.0f);
+    doFPrecision(0x47F, 0xd8, 6, 1.0f, 3.0f, thirdDown); // fdiv, down
+    doFPrecision(0x87F, 0xd8, 6, 1.0f, 3.0f, third); // fdiv, up
+    doFPrecision(0xC7F, 0xd8, 6, 1.0f, 3.0f, thirdDown); // fdiv, chop
+    doFPrecision(0x47F, 0xd8, 6, -1.0f, 3.0f, -third); // fdiv, down
+    doFPrecision(0x87F, 0xd8, 6, -1.0f, 3.0f, -thirdDown); // fdiv, up
+    doFPrecision(0xC7F, 0xd8, 6, -1.0f, 3.0f, -thirdDown); // fdiv, chop
+    doFPrecision(0x87F, 0, -1, 2.0f, 0.0f, nextafterf(sqrtf(2.0f), 2.0f)); // fsqrt, up
+    doFPrecision(0xC7F, 0, -1, 2.0f, 0.0f, sqrtf(2.0f)); // fsqrt, chop
+
+    // rounded once from the exact result, going through a double first would give 1.0 for both
+    doFPrecision64(0x07F, 0xdc, 0, 1.0 + ldexp(1.0, -24), ldexp(1.0, -80), 1.0 + ldexp(1.0, -23)); // fadd, just above halfway
+    doFPrecision64(0xC7F, 0xdc, 0, 1.0, -ldexp(1.0, -80), 1.0 - ldexp(1.0, -24)); // fadd, chop just below 1
+    doFPrecision64(0xC7F, 0xdc, 1, 1.0 - ldexp(1.0, -30), 1.0 + ldexp(1.0, -30), 1.0 - ldexp(1.0, -24)); // fmul, chop just below 1
+}
+
 void doLoopZ(U32 instruction, bool big, bool neg) {
     cpu->big = big;
     for (int setFlags = 0; setFlags < 2; setFlags++) {
@@ -11487,6 +11639,1162 @@ void testSelfModifyingBack() {
     assertTrue(EAX == 0x60); // 0x20 from first run + 0x40 from second run
 }
 
+static U32 flagLivenessSeed;
+
+static U32 flagLivenessRandom(U32 max) {
+    flagLivenessSeed = flagLivenessSeed * 1103515245 + 12345;
+    return (flagLivenessSeed >> 16) % max;
+}
+
+// eax, ecx, edx, ebx, ebp, edi (esp is the stack and esi is the loop counter)
+static const U8 flagLivenessRegs[] = {0, 1, 2, 3, 5, 7};
+
+static void pushFlagLivenessOp() {
+    U8 dst = flagLivenessRegs[flagLivenessRandom(6)];
+    U8 src = flagLivenessRegs[flagLivenessRandom(6)];
+
+    switch (flagLivenessRandom(10)) {
+    case 0: // add/or/adc/sbb/and/sub/xor/cmp r32, imm8
+        pushCode8(0x83);
+        pushCode8(0xc0 | (flagLivenessRandom(8) << 3) | dst);
+        pushCode8(flagLivenessRandom(256));
+        break;
+    case 1: // add/or/adc/sbb/and/sub/xor/cmp r32, r32
+        pushCode8(0x01 + (flagLivenessRandom(8) << 3));
+        pushCode8(0xc0 | (src << 3) | dst);
+        break;
+    case 2: // add/or/adc/sbb/and/sub/xor/cmp r8, r8
+        pushCode8(0x00 + (flagLivenessRandom(8) << 3));
+        pushCode8(0xc0 | (flagLivenessRandom(8) << 3) | flagLivenessRandom(8));
+        break;
+    case 3: // add/or/adc/sbb/and/sub/xor/cmp r16, imm8
+        pushCode8(0x66);
+        pushCode8(0x83);
+        pushCode8(0xc0 | (flagLivenessRandom(8) << 3) | dst);
+        pushCode8(flagLivenessRandom(256));
+        break;
+    case 4: // inc/dec r32
+        pushCode8((flagLivenessRandom(2) ? 0x40 : 0x48) + dst);
+        break;
+    case 5: // neg r32
+        pushCode8(0xf7);
+        pushCode8(0xd8 | dst);
+        break;
+    case 6: // shl/shr/sar r32, imm8
+        pushCode8(0xc1);
+        pushCode8(0xc0 | ((flagLivenessRandom(2) ? 4 : 5 + flagLivenessRandom(2) * 2) << 3) | dst);
+        pushCode8(1 + flagLivenessRandom(31));
+        break;
+    case 7: // setcc r8 (al, cl, dl, bl)
+        pushCode8(0x0f);
+        pushCode8(0x90 + flagLivenessRandom(16));
+        pushCode8(0xc0 | flagLivenessRandom(4));
+        break;
+    case 8: // adc r32, 0
+        pushCode8(0x83);
+        pushCode8(0xd0 | dst);
+        pushCode8(0);
+        break;
+    case 9: // jcc +0, splits the sequence into blocks linked through next1/next2
+        pushCode8(0x70 + 2 + flagLivenessRandom(14));
+        pushCode8(0);
+        break;
+    }
+}
+
+// Runs random flag producing/consuming sequences twice, once with the flag liveness pass and once without, and
+// makes sure the registers and flags end up the same.  The sequence is run in a loop so that the blocks get linked
+// and the pass also considers the successor blocks.
+void testFlagLiveness() {
+    flagLivenessSeed = 1;
+    for (U32 i = 0; i < 200; i++) {
+        U32 seed = flagLivenessSeed;
+        U32 regs[2][8];
+        U32 flags[2];
+
+        for (U32 pass = 0; pass < 2; pass++) {
+            NormalCPU::useFlagLiveness = (pass == 0);
+            flagLivenessSeed = seed;
+            newInstruction(0);
+            // mov esi, 2
+            pushCode8(0xbe);
+            pushCode32(2);
+            U32 loopStart = cseip;
+            U32 count = 4 + flagLivenessRandom(16);
+            for (U32 j = 0; j < count; j++) {
+                pushFlagLivenessOp();
+            }
+            // dec esi
+            pushCode8(0x4e);
+            // jnz loopStart
+            pushCode8(0x75);
+            pushCode8((U8)(loopStart - (cseip + 1)));
+            EAX = 0x12345678;
+            ECX = 0x80000000;
+            EDX = 0xFFFFFFFF;
+            EBX = 0x00FF00FF;
+            EBP = 0x7FFFFFFF;
+            EDI = 1;
+            runTestCPU();
+            for (U32 r = 0; r < 8; r++) {
+                regs[pass][r] = cpu->reg[r].u32;
+            }
+            cpu->fillFlags();
+            flags[pass] = cpu->flags & FMASK_TEST;
+            // writing the same code again won't throw away the cached blocks
+            for (U32 address = CODE_ADDRESS; address < (U32)cseip; address++) {
+                writeb(address, 0);
+            }
+        }
+        for (U32 r = 0; r < 8; r++) {
+            if (regs[0][r] != regs[1][r]) {
+                failed("flag liveness sequence %d reg %d: %X != %X", i, r, regs[0][r], regs[1][r]);
+            }
+        }
+        if (flags[0] != flags[1]) {
+            failed("flag liveness sequence %d flags: %X != %X", i, flags[0], flags[1]);
+        }
+    }
+    NormalCPU::useFlagLiveness = true;
+
+#if !defined(BOXEDWINE_BINARY_TRANSLATOR) && !defined(BOXEDWINE_DYNAMIC)
+    // add eax, 5 doesn't need flags since sub eax, 3 overwrites all of them
+    newInstruction(0);
+    pushCode8(0x83);
+    pushCode8(0xc0);
+    pushCode8(0x05);
+    pushCode8(0x83);
+    pushCode8(0xe8);
+    pushCode8(0x03);
+    runTestCPU();
+    assertTrue(EAX == 2);
+    DecodedBlock* block = cpu->thread->memory->getCodeBlock(CODE_ADDRESS);
+    assertTrue(block && block->op->inst == AddR32I32 && block->op->pfn != NormalCPU::getFunctionForOp(block->op));
+    assertTrue(block && block->op->next->inst == SubR32I32 && block->op->next->pfn == NormalCPU::getFunctionForOp(block->op->next));
+
+    // A: add eax, 1 only doesn't need its flags because C 2 blocks later overwrites them.  Once C is changed to read CF,
+    // A has to set the flags again even though only the link from B to C changed.
+    newInstruction(0);
+    pushCode8(0x83); // A: add eax, 1
+    pushCode8(0xc0);
+    pushCode8(0x01);
+    pushCode8(0xeb); // jmp B
+    pushCode8(0x00);
+    pushCode8(0x89); // B: mov ebx, ecx
+    pushCode8(0xcb);
+    pushCode8(0xeb); // jmp C
+    pushCode8(0x00);
+    pushCode8(0x83); // C: and ecx, 0
+    pushCode8(0xe1);
+    pushCode8(0x00);
+    pushCode8(0x70); // jo, ends the run
+    pushCode8(0);
+    pushCode8(0x70);
+    pushCode8(0);
+    // link B to C first so that A sees C when it is linked to B
+    cpu->eip.u32 = 5;
+    runTestCPUBlocks(cpu);
+    cpu->eip.u32 = 0;
+    runTestCPUBlocks(cpu);
+    block = cpu->thread->memory->getCodeBlock(CODE_ADDRESS);
+    assertTrue(block && block->op->inst == AddR32I32 && block->op->pfn != NormalCPU::getFunctionForOp(block->op));
+
+    writeb(CODE_ADDRESS + 10, 0xd1); // C: adc ecx, 0
+    cpu->eip.u32 = 0;
+    EAX = 0xFFFFFFFF;
+    ECX = 0;
+    runTestCPUBlocks(cpu);
+    assertTrue(EAX == 0);
+    assertTrue(ECX == 1);
+#endif
+}
+
+static void pushFusionOp() {
+    U8 dst = flagLivenessRegs[flagLivenessRandom(6)];
+    U8 src = flagLivenessRegs[flagLivenessRandom(6)];
+
+    switch (flagLivenessRandom(6)) {
+    case 0: // cmp/test r32, r32 or r32, imm
+        switch (flagLivenessRandom(4)) {
+        case 0: pushCode8(0x39); pushCode8(0xc0 | (src << 3) | dst); break;
+        case 1: pushCode8(0x83); pushCode8(0xf8 | dst); pushCode8(flagLivenessRandom(256)); break;
+        case 2: pushCode8(0x85); pushCode8(0xc0 | (src << 3) | dst); break;
+        case 3: pushCode8(0xf7); pushCode8(0xc0 | dst); pushCode32(flagLivenessSeed); break;
+        }
+        // jcc over inc ebp so that both sides of the jump leave a different result
+        pushCode8(0x70 + flagLivenessRandom(16));
+        pushCode8(1);
+        pushCode8(0x45);
+        break;
+    case 1: // cmp [0x10], imm8 or cmp r32, [0x14] followed by jcc
+        if (flagLivenessRandom(2)) {
+            pushCode8(0x83); pushCode8(0x3d); pushCode32(0x10); pushCode8(flagLivenessRandom(256));
+        } else {
+            pushCode8(0x3b); pushCode8(0x05 | (dst << 3)); pushCode32(0x14);
+        }
+        pushCode8(0x70 + flagLivenessRandom(16));
+        pushCode8(1);
+        pushCode8(0x45);
+        break;
+    case 2: { // runs of push r32/push imm
+        U32 count = 1 + flagLivenessRandom(4);
+        for (U32 i = 0; i < count; i++) {
+            if (flagLivenessRandom(2)) {
+                pushCode8(0x50 + flagLivenessRandom(8)); // including push esp and push esi
+            } else {
+                pushCode8(0x68); pushCode32(flagLivenessSeed);
+            }
+        }
+        break;
+    }
+    case 3: // mov r32, r32 + add r32, imm/r32
+        pushCode8(0x89); pushCode8(0xc0 | (src << 3) | dst);
+        if (flagLivenessRandom(2)) {
+            pushCode8(0x83); pushCode8(0xc0 | dst); pushCode8(flagLivenessRandom(256));
+        } else {
+            pushCode8(0x01); pushCode8(0xc0 | (flagLivenessRandom(2) ? dst : flagLivenessRegs[flagLivenessRandom(6)]) << 3 | dst);
+        }
+        break;
+    case 4: // setcc, reads the flags left by a fused pair
+        pushCode8(0x0f);
+        pushCode8(0x90 + flagLivenessRandom(16));
+        pushCode8(0xc0 | flagLivenessRandom(4));
+        break;
+    case 5:
+        pushFlagLivenessOp();
+        break;
+    }
+}
+
+// Same idea as testFlagLiveness, random sequences of the instructions that NormalCPU::fuseOps combines are run with
+// and without fusion and the registers, flags and stack must match.
+void testFusion() {
+    flagLivenessSeed = 7;
+    for (U32 i = 0; i < 300; i++) {
+        U32 seed = flagLivenessSeed;
+        U32 regs[2][8];
+        U32 flags[2];
+        U32 stack[2][64];
+
+        for (U32 pass = 0; pass < 2; pass++) {
+            NormalCPU::useFusion = (pass == 0);
+            flagLivenessSeed = seed;
+            newInstruction(0);
+            U32 esp = ESP;
+            writed(cpu->seg[DS].address + 0x10, 0x80);
+            writed(cpu->seg[DS].address + 0x14, 0xFFFFFF00);
+            // mov esi, 2
+            pushCode8(0xbe);
+            pushCode32(2);
+            U32 loopStart = cseip;
+            U32 count = 2 + flagLivenessRandom(6);
+            for (U32 j = 0; j < count; j++) {
+                pushFusionOp();
+            }
+            // dec esi
+            pushCode8(0x4e);
+            // jnz loopStart
+            pushCode8(0x0f);
+            pushCode8(0x85);
+            pushCode32(loopStart - (cseip + 4));
+            EAX = 0x12345678;
+            ECX = 0x80000000;
+            EDX = 0xFFFFFFFF;
+            EBX = 0x00FF00FF;
+            EBP = 0x7FFFFFFF;
+            EDI = 0x80;
+            runTestCPU();
+            for (U32 r = 0; r < 8; r++) {
+                regs[pass][r] = cpu->reg[r].u32;
+            }
+            for (U32 j = 0; j < 64; j++) {
+                stack[pass][j] = (ESP + j * 4 < esp) ? readd(cpu->seg[SS].address + ESP + j * 4) : 0;
+            }
+            cpu->fillFlags();
+            flags[pass] = cpu->flags & FMASK_TEST;
+            ESP = esp;
+            for (U32 address = CODE_ADDRESS; address < (U32)cseip; address++) {
+                writeb(address, 0);
+            }
+        }
+        for (U32 r = 0; r < 8; r++) {
+            if (regs[0][r] != regs[1][r]) {
+                failed("fusion sequence %d reg %d: %X != %X", i, r, regs[0][r], regs[1][r]);
+            }
+        }
+        if (flags[0] != flags[1]) {
+            failed("fusion sequence %d flags: %X != %X", i, flags[0], flags[1]);
+        }
+        if (memcmp(stack[0], stack[1], sizeof(stack[0]))) {
+            failed("fusion sequence %d stack is different", i);
+        }
+    }
+    NormalCPU::useFusion = true;
+
+#if !defined(BOXEDWINE_BINARY_TRANSLATOR) && !defined(BOXEDWINE_DYNAMIC)
+    // cmp eax, ecx; jz +0
+    newInstruction(0);
+    pushCode8(0x39);
+    pushCode8(0xc8);
+    pushCode8(0x74);
+    pushCode8(0x00);
+    U32 cmpJcc = NormalCPU::fusionStats.cmpJcc;
+    runTestCPU();
+    assertTrue(NormalCPU::fusionStats.cmpJcc == cmpJcc + 1);
+    DecodedBlock* block = cpu->thread->memory->getCodeBlock(CODE_ADDRESS);
+    assertTrue(block && block->op->inst == CmpR32R32 && block->op->pfn != NormalCPU::getFunctionForOp(block->op));
+#endif
+}
+
+#if !defined(BOXEDWINE_BINARY_TRANSLATOR) && !defined(BOXEDWINE_DYNAMIC)
+// call through a register that alternates between 2 targets, after a ret that isn't paired with a call.  The second run
+// changes one of the targets, the blocks that the predictions point to must not be used after that.
+void testIndirectPrediction() {
+    newInstruction(0);
+    U32 start = cseip - cpu->seg[CS].address;
+    pushCode8(0x68); pushCode32(start + 6); // push A
+    pushCode8(0xc3); // ret
+    pushCode8(0xbe); pushCode32(8); // A: mov esi, 8
+    U32 loopStart = cseip;
+    U32 f1 = cseip + 21 - cpu->seg[CS].address;
+    pushCode8(0x89); pushCode8(0xf3); // loop: mov ebx, esi
+    pushCode8(0x83); pushCode8(0xe3); pushCode8(0x01); // and ebx, 1
+    pushCode8(0x6b); pushCode8(0xdb); pushCode8(0x04); // imul ebx, ebx, 4
+    pushCode8(0x81); pushCode8(0xc3); pushCode32(f1); // add ebx, f1
+    pushCode8(0xff); pushCode8(0xd3); // call ebx
+    pushCode8(0x4e); // dec esi
+    pushCode8(0x75); pushCode8((U8)(loopStart - (cseip + 1))); // jnz loop
+    pushCode8(0xeb); pushCode8(0x08); // jmp over
+    pushCode8(0x83); pushCode8(0xc1); pushCode8(0x01); // f1: add ecx, 1
+    pushCode8(0xc3); // ret
+    pushCode8(0x83); pushCode8(0xc2); pushCode8(0x01); // f2: add edx, 1
+    pushCode8(0xc3); // ret
+    // over:
+
+    NormalIndirectStats& indirectStats = ((NormalCPU*)cpu)->indirectStats;
+    NormalIndirectStats stats = indirectStats;
+    ECX = 0;
+    EDX = 0;
+    runTestCPU();
+    assertTrue(ECX == 4);
+    assertTrue(EDX == 4);
+    assertTrue(indirectStats.targetHits > stats.targetHits);
+    assertTrue(indirectStats.returnHits > stats.returnHits);
+
+    // f1: add ecx, 2
+    writeb(f1 + cpu->seg[CS].address + 2, 2);
+    cpu->eip.u32 = start;
+    ECX = 0;
+    EDX = 0;
+    runTestCPU();
+    assertTrue(ECX == 8);
+    assertTrue(EDX == 4);
+}
+#endif
+
+static void runPauseLoop(U32 count) {
+    newInstruction(0);
+    pushCode8(0xb9); // mov ecx, count
+    pushCode32(count);
+    pushCode8(0xf3); // pause
+    pushCode8(0x90);
+    pushCode8(0x49); // dec ecx
+    pushCode8(0x75); // jnz pause
+    pushCode8(0xfb);
+    cpu->spinCountdown = CPU_SPIN_COUNT;
+    runTestCPU();
+    assertTrue(ECX == 0);
+}
+
+// with spinBackoff every CPU_SPIN_COUNT pauses call spinWait, which starts the count again, without it pause does nothing
+void testPauseSpinCount() {
+    cpu->big = true;
+#ifdef BOXEDWINE_MULTI_THREADED
+    bool spinBackoff = KSystem::spinBackoff;
+    KSystem::spinBackoff = true;
+    runPauseLoop(3000);
+    assertTrue(cpu->spinCountdown == CPU_SPIN_COUNT - (3000 % CPU_SPIN_COUNT));
+    KSystem::spinBackoff = false;
+#endif
+    runPauseLoop(3000);
+    assertTrue(cpu->spinCountdown == CPU_SPIN_COUNT);
+#ifdef BOXEDWINE_MULTI_THREADED
+    KSystem::spinBackoff = spinBackoff;
+#endif
+}
+
+// rep string ops with 16-bit addressing that cross pages, the binary translator does these a page at a time on host
+// memory
+void testRepStringPages() {
+    cpu->big = true;
+    cpu->seg[ES].address = HEAP_ADDRESS;
+    for (U32 i = 0; i < 0x4000; i++) {
+        writeb(HEAP_ADDRESS + i, (U8)(i * 7));
+    }
+
+    // rep movsb, both the source and destination cross pages
+    newInstruction(0);
+    pushCode8(0x67); pushCode8(0xf3); pushCode8(0xa4);
+    ECX = 0x12342100;
+    ESI = 0x56780f80;
+    EDI = 0x9abc5f40;
+    runTestCPU();
+    assertTrue(ECX == 0x12340000 && ESI == 0x56783080 && EDI == 0x9abc8040);
+    bool same = true;
+    for (U32 i = 0; i < 0x2100; i++) {
+        same = same && readb(HEAP_ADDRESS + 0x5f40 + i) == (U8)((0xf80 + i) * 7);
+    }
+    assertTrue(same);
+
+    // a destination just ahead of the source repeats the first byte
+    newInstruction(0);
+    pushCode8(0x67); pushCode8(0xf3); pushCode8(0xa4);
+    ECX = 0x1000;
+    ESI = 0x100;
+    EDI = 0x101;
+    runTestCPU();
+    same = true;
+    for (U32 i = 0; i < 0x1000; i++) {
+        same = same && readb(HEAP_ADDRESS + 0x101 + i) == (U8)(0x100 * 7);
+    }
+    assertTrue(same && ESI == 0x1100 && EDI == 0x1101);
+
+    // rep stosd, DI wraps
+    newInstruction(0);
+    pushCode8(0x67); pushCode8(0xf3); pushCode8(0xab);
+    EAX = 0x11223344;
+    ECX = 0x10;
+    EDI = 0x1234fff0;
+    runTestCPU();
+    assertTrue(ECX == 0 && EDI == 0x12340030);
+    assertTrue(readd(HEAP_ADDRESS + 0xfff0) == 0x11223344 && readd(HEAP_ADDRESS + 0xfffc) == 0x11223344);
+    assertTrue(readd(HEAP_ADDRESS) == 0x11223344 && readd(HEAP_ADDRESS + 0x2c) == 0x11223344 && readd(HEAP_ADDRESS + 0x30) != 0x11223344);
+
+    // repne scasb, the match is on the next page
+    for (U32 i = 0x1000; i < 0x3000; i++) {
+        writeb(HEAP_ADDRESS + i, 1);
+    }
+    writeb(HEAP_ADDRESS + 0x2345, 0);
+    newInstruction(0);
+    pushCode8(0x67); pushCode8(0xf2); pushCode8(0xae);
+    ECX = 0x1000;
+    EDI = 0x1f00;
+    runTestCPU();
+    assertTrue(EDI == 0x2346 && ECX == 0x1000 - 0x446 && cpu->getZF());
+
+    // repne scasb, no match
+    newInstruction(0);
+    pushCode8(0x67); pushCode8(0xf2); pushCode8(0xae);
+    ECX = 0x100;
+    EDI = 0x2400;
+    runTestCPU();
+    assertTrue(EDI == 0x2500 && ECX == 0 && !cpu->getZF());
+}
+
+#ifdef BOXEDWINE_DEFAULT_MMU
+// data on a page with code shouldn't make the code page look for blocks or throw them away when it is written
+void testCodePageWrites() {
+    Memory* memory = cpu->thread->memory;
+
+    newInstruction(0);
+    pushCode8(0xb9); pushCode32(100); // mov ecx, 100
+    U32 loop = cseip;
+    pushCode8(0x2e); pushCode8(0x83); pushCode8(0x05); pushCode32(0x800); pushCode8(0x03); // add dword ptr cs:[0x800], 3
+    pushCode8(0x49); // dec ecx
+    pushCode8(0x75); pushCode8((U8)(loop - (cseip + 1))); // jnz loop
+    writed(CODE_ADDRESS + 0x800, 0);
+    CodePageStats stats = CodePage::stats;
+    runTestCPU();
+    assertTrue(ECX == 0 && readd(CODE_ADDRESS + 0x800) == 300);
+    assertTrue(CodePage::stats.fastWrites - stats.fastWrites >= 100); // runTestCPU adds a few bytes of code too
+    assertTrue(CodePage::stats.slowWrites == stats.slowWrites && CodePage::stats.blocksInvalidated == stats.blocksInvalidated);
+
+    Page* page = memory->getPage(CODE_ADDRESS >> K_PAGE_SHIFT);
+    assertTrue(page->type == Page::Type::Code_Page);
+    CodePage* codePage = (CodePage*)page;
+    assertTrue(memory->getCodeBlock(loop) != NULL);
+    assertTrue(codePage->hasCode(loop, 1) && !codePage->hasCode(CODE_ADDRESS + 0x800, 4));
+
+    // changing the add's immediate throws away the blocks it is in
+    writeb(loop + 7, 5);
+    assertTrue(CodePage::stats.slowWrites == stats.slowWrites + 1 && CodePage::stats.blocksInvalidated > stats.blocksInvalidated);
+    assertTrue(memory->getCodeBlock(loop) == NULL);
+}
+#endif
+
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+// lock doesn't change the result or the flags, in multi-threaded builds the memory operand versions go through the
+// atomic ops instead of the normal ones.  The register versions would be an invalid instruction on real hardware, the
+// binary translator would pass the prefix on to the host.
+void testLockPrefix0x0f0() {
+    cpu->big = false;
+    EwGw(0x01, addw, 0xf0);
+    EwGw(0x09, orw, 0xf0);
+    EwGw(0x11, adcw, 0xf0);
+    EwGw(0x19, sbbw, 0xf0);
+    EwGw(0x21, andw, 0xf0);
+    EwGw(0x29, subw, 0xf0);
+    EwGw(0x31, xorw, 0xf0);
+    EwGw(0x87, xchgw, 0xf0);
+    EwGw(0x1c1, xaddw, 0xf0);
+}
+
+void testLockPrefix0x2f0() {
+    cpu->big = true;
+    EdGd(0x01, addd, 0xf0);
+    EdGd(0x09, ord, 0xf0);
+    EdGd(0x11, adcd, 0xf0);
+    EdGd(0x19, sbbd, 0xf0);
+    EdGd(0x21, andd, 0xf0);
+    EdGd(0x29, subd, 0xf0);
+    EdGd(0x31, xord, 0xf0);
+    EdGd(0x87, xchgd, 0xf0);
+    EdGd(0x3c1, xaddd, 0xf0);
+}
+#endif
+
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+// Each thread adds to the same counters and takes turns with a spin lock built on lock cmpxchg, nothing is lost if
+// the locked instructions are atomic
+void testMultiThreadedLocks() {
+    const U32 threadCount = 4;
+    const U32 loops = 200000;
+    const U32 total = threadCount * loops;
+
+    newInstruction(0);
+    pushCode8(0xb9); pushCode32(loops); // mov ecx, loops
+    U32 loop = cseip;
+    pushCode8(0xf0); pushCode8(0xff); pushCode8(0x05); pushCode32(0x100); // lock inc dword ptr [0x100]
+    pushCode8(0xb8); pushCode32(2); // mov eax, 2
+    pushCode8(0xf0); pushCode8(0x0f); pushCode8(0xc1); pushCode8(0x05); pushCode32(0x104); // lock xadd [0x104], eax
+    pushCode8(0xf0); pushCode8(0x80); pushCode8(0x05); pushCode32(0x110); pushCode8(0x01); // lock add byte ptr [0x110], 1
+    // code pages don't have a host pointer so this one takes the mutex
+    pushCode8(0x2e); pushCode8(0xf0); pushCode8(0x83); pushCode8(0x05); pushCode32(0x800); pushCode8(0x01); // lock add dword ptr cs:[0x800], 1
+    U32 spin = cseip;
+    pushCode8(0x31); pushCode8(0xc0); // xor eax, eax
+    pushCode8(0xba); pushCode32(1); // mov edx, 1
+    pushCode8(0xf0); pushCode8(0x0f); pushCode8(0xb1); pushCode8(0x15); pushCode32(0x108); // lock cmpxchg [0x108], edx
+    pushCode8(0x75); pushCode8((U8)(spin - (cseip + 1))); // jnz spin
+    pushCode8(0x83); pushCode8(0x05); pushCode32(0x10c); pushCode8(0x01); // add dword ptr [0x10c], 1
+    pushCode8(0x31); pushCode8(0xd2); // xor edx, edx
+    pushCode8(0x87); pushCode8(0x15); pushCode32(0x108); // xchg [0x108], edx
+    pushCode8(0x49); // dec ecx
+    pushCode8(0x75); pushCode8((U8)(loop - (cseip + 1))); // jnz loop
+    writed(CODE_ADDRESS + 0x800, 0);
+
+    runTestCPUOnThreads(threadCount);
+    assertTrue(readd(HEAP_ADDRESS + 0x100) == total);
+    assertTrue(readd(HEAP_ADDRESS + 0x104) == total * 2);
+    assertTrue(readd(HEAP_ADDRESS + 0x108) == 0);
+    assertTrue(readd(HEAP_ADDRESS + 0x10c) == total);
+    assertTrue(readb(HEAP_ADDRESS + 0x110) == (U8)total);
+    assertTrue(readd(CODE_ADDRESS + 0x800) == total);
+}
+#endif
+
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+// The target of the jmp should be translated by a worker before the jmp is run
+void testTranslationWorkers() {
+    newInstruction(0);
+    // the workers only translate flat code
+    cpu->seg[CS].address = 0;
+    cpu->eip.u32 = CODE_ADDRESS;
+    BtTranslationWorkers::start(1);
+    U32 translatedCount = BtTranslationWorkers::translatedCount;
+
+    // mov eax, 1
+    pushCode8(0xb8);
+    pushCode32(1);
+    // jmp +16
+    pushCode8(0xe9);
+    pushCode32(16);
+    cseip += 16;
+    U32 target = cseip;
+    // add eax, 2
+    pushCode8(0x83);
+    pushCode8(0xc0);
+    pushCode8(0x02);
+    pushCode8(0xcd);
+    pushCode8(0x97);
+
+    Memory* memory = cpu->thread->memory;
+    ((BtCPU*)cpu)->translateEip(cpu->eip.u32);
+    BtTranslationWorkers::waitUntilIdle();
+    assertTrue(BtTranslationWorkers::translatedCount == translatedCount + 1);
+    void* host = memory->getExistingHostAddress(target);
+    assertTrue(host != NULL);
+    if (host) {
+        std::shared_ptr<BtCodeChunk> chunk = memory->getCodeChunkContainingHostAddress(host);
+        assertTrue(chunk && !chunk->isStub());
+    }
+    cpu->run();
+    assertTrue(EAX == 3);
+
+    BtTranslationWorkers::stop();
+    memory->clearCodePageFromCache(CODE_ADDRESS >> K_PAGE_SHIFT);
+    ((BtCPU*)cpu)->postTestRun();
+    cpu->seg[CS].address = CODE_ADDRESS;
+}
+
+static void runCachedCode(U32 expectedLoaded, U32 expectedTranslated, U32 expectedShared = 0) {
+    Memory* memory = cpu->thread->memory;
+    U32 loadedCount = BtCodeCache::loadedCount;
+    U32 translatedCount = BtCodeCache::translatedCount;
+    U32 sharedCount = BtCodeCache::sharedCount;
+
+    memory->clearCodePageFromCache(CODE_ADDRESS >> K_PAGE_SHIFT);
+    EAX = 0;
+    cpu->eip.u32 = CODE_ADDRESS;
+    cpu->run();
+    ((BtCPU*)cpu)->postTestRun();
+    assertTrue(EAX == 0x0101);
+    assertTrue(BtCodeCache::loadedCount == loadedCount + expectedLoaded);
+    assertTrue(BtCodeCache::translatedCount == translatedCount + expectedTranslated);
+    assertTrue(BtCodeCache::sharedCount == sharedCount + expectedShared);
+}
+
+// The chunk should be translated once and then come from the cache, including after the cache is reopened from disk
+void testCodeCache() {
+    newInstruction(0);
+    // the cache only saves flat code
+    cpu->seg[CS].address = 0;
+    cpu->eip.u32 = CODE_ADDRESS;
+
+    // mov eax, 0x0b
+    pushCode8(0xb8);
+    pushCode32(0x0b);
+    // aaa, this calls into a host function so the chunk needs its host address relocated
+    pushCode8(0x37);
+    pushCode8(0xcd);
+    pushCode8(0x97);
+
+    // the cache only saves code the guest can't write to
+    Memory* memory = cpu->thread->memory;
+    U32 page = CODE_ADDRESS >> K_PAGE_SHIFT;
+    U8 flags = memory->flags[page];
+    memory->flags[page] &= ~PAGE_WRITE;
+
+    BString dir = B("btCodeCacheTest");
+    BString path = dir ^ "bt.cache";
+    ::remove(path.c_str());
+    assertTrue(BtCodeCache::open(dir));
+
+    runCachedCode(0, 1);
+    assertTrue(BtCodeCache::savedCount == 1);
+    runCachedCode(1, 0);
+
+    BtCodeCache::close();
+    assertTrue(BtCodeCache::open(dir));
+    runCachedCode(1, 0);
+
+    // the guest code changed, so the saved chunk should not be used
+    BtCodeCache::close();
+    memory->flags[page] = flags;
+    memory->clearCodePageFromCache(page);
+    writeb(CODE_ADDRESS + 1, 0x0c);
+    memory->flags[page] &= ~PAGE_WRITE;
+    assertTrue(BtCodeCache::open(dir));
+    cpu->eip.u32 = CODE_ADDRESS;
+    cpu->run();
+    ((BtCPU*)cpu)->postTestRun();
+    assertTrue(EAX == 0x0102);
+    assertTrue(BtCodeCache::loadedCount == 0 && BtCodeCache::translatedCount == 1);
+
+    BtCodeCache::close();
+    ::remove(path.c_str());
+    ::remove(dir.c_str());
+    memory->flags[page] = flags;
+    memory->clearCodePageFromCache(page);
+    cpu->seg[CS].address = CODE_ADDRESS;
+}
+
+// Another process that maps the same file at the same address should use the chunk the first one translated, even
+// without a cache file.  Clearing the page from the code cache stands in for the other process here.
+void testSharedCode() {
+    newInstruction(0);
+    cpu->seg[CS].address = 0;
+    cpu->eip.u32 = CODE_ADDRESS;
+
+    // mov eax, 0x0b
+    pushCode8(0xb8);
+    pushCode32(0x0b);
+    // aaa
+    pushCode8(0x37);
+    pushCode8(0xcd);
+    pushCode8(0x97);
+
+    Memory* memory = cpu->thread->memory;
+    U32 page = CODE_ADDRESS >> K_PAGE_SHIFT;
+    U8 flags = memory->flags[page];
+    memory->flags[page] &= ~PAGE_WRITE;
+    U64 sharedSize = BtCodeCache::sharedSize;
+    assertTrue(!BtCodeCache::isOpen());
+
+    std::shared_ptr<BtSharedCodeFile> file = BtCodeCache::getSharedFile(B("/lib/libshared.so"));
+    memory->setSharedCodeFile(page, 1, file, 0x3000);
+    runCachedCode(0, 1);
+    assertTrue(BtCodeCache::sharedSize > sharedSize);
+    runCachedCode(0, 0, 1);
+
+    // a different file or a different part of the same file isn't the same code
+    memory->setSharedCodeFile(page, 1, BtCodeCache::getSharedFile(B("/lib/libother.so")), 0x3000);
+    runCachedCode(0, 1);
+    memory->setSharedCodeFile(page, 1, file, 0x4000);
+    runCachedCode(0, 1);
+    memory->setSharedCodeFile(page, 1, file, 0x3000);
+    runCachedCode(0, 0, 1);
+
+    // private pages can be written to, the chunk is only used while the guest bytes are the same
+    memory->flags[page] = flags;
+    memory->clearCodePageFromCache(page);
+    writeb(CODE_ADDRESS + 1, 0x0c);
+    memory->flags[page] &= ~PAGE_WRITE;
+    cpu->eip.u32 = CODE_ADDRESS;
+    EAX = 0;
+    cpu->run();
+    ((BtCPU*)cpu)->postTestRun();
+    assertTrue(EAX == 0x0102);
+    memory->flags[page] = flags;
+    memory->clearCodePageFromCache(page);
+    writeb(CODE_ADDRESS + 1, 0x0b);
+    memory->flags[page] &= ~PAGE_WRITE;
+    runCachedCode(0, 0, 1);
+
+    // the translations are freed once nothing maps the file
+    memory->setSharedCodeFile(page, 1, NULL, 0);
+    file = NULL;
+    assertTrue(BtCodeCache::sharedSize == sharedSize);
+    runCachedCode(0, 1);
+
+    memory->flags[page] = flags;
+    memory->clearCodePageFromCache(page);
+    cpu->seg[CS].address = CODE_ADDRESS;
+}
+
+static U32 getExecutableMemorySize() {
+    U32 result = 0;
+    for (auto& p : memory->allocatedExecutableMemory) {
+        result += p.size;
+    }
+    return result;
+}
+
+// translating and throwing away code over and over again should keep reusing the same executable memory
+void testCodeMemoryReuse() {
+    U32 size = 0;
+    U64 reclaimed = memory->reclaimedExecutableMemoryCount;
+
+    for (U32 i = 0; i < 4000; i++) {
+        newInstruction(0);
+        for (U32 j = 0; j < (i & 15); j++) {
+            pushCode8(0x40); // inc eax
+        }
+        runTestCPU();
+        assertTrue(EAX == (i & 15));
+        if (i == 100) {
+            size = getExecutableMemorySize();
+        }
+    }
+    assertTrue(getExecutableMemorySize() == size);
+    assertTrue(memory->reclaimedExecutableMemoryCount > reclaimed);
+}
+
+// with a code cache limit, chunks that haven't been used recently are evicted and retranslated when needed again
+void testCodeCacheLimit() {
+    const U32 pageCount = 16;
+    const U32 blockCount = pageCount * K_PAGE_SIZE / 3;
+    U32 codeCacheSize = KSystem::btCodeCacheSize;
+    U64 evicted = memory->evictedCodeChunkCount;
+
+    KSystem::btCodeCacheSize = 1;
+    newInstruction(0);
+    for (U32 i = 0; i < blockCount; i++) {
+        pushCode8(0x40); // inc eax
+        pushCode8(0xcd); // int 0x97
+        pushCode8(0x97);
+    }
+    U32 size = getExecutableMemorySize();
+    for (U32 i = 0; i < blockCount + 1; i++) {
+        EAX = 0;
+        cpu->eip.u32 = (i % blockCount) * 3;
+        ((BtCPU*)cpu)->translateEip(cpu->eip.u32);
+        cpu->run();
+        assertTrue(EAX == 1);
+        assertTrue(memory->liveExecutableMemorySize <= (1 << 20) + 64 * 1024);
+    }
+    // block 0 was evicted long ago and had to be translated again
+    assertTrue(memory->evictedCodeChunkCount > evicted);
+    assertTrue(getExecutableMemorySize() <= size + 2 * (1 << 20));
+
+    for (U32 i = 0; i < pageCount; i++) {
+        memory->clearCodePageFromCache((CODE_ADDRESS >> K_PAGE_SHIFT) + i);
+    }
+    ((BtCPU*)cpu)->postTestRun();
+    KSystem::btCodeCacheSize = codeCacheSize;
+}
+
+// the exception handler maps host addresses back to chunks without taking a lock
+void testHostAddressLookup() {
+    const U32 blockCount = 200;
+
+    newInstruction(0);
+    for (U32 i = 0; i < blockCount; i++) {
+        pushCode8(0x40); // inc eax
+        pushCode8(0xcd); // int 0x97
+        pushCode8(0x97);
+    }
+    for (U32 i = 0; i < blockCount; i++) {
+        ((BtCPU*)cpu)->translateEip(i * 3);
+    }
+    for (U32 i = 0; i < blockCount; i++) {
+        U8* host = (U8*)memory->getExistingHostAddress(CODE_ADDRESS + i * 3);
+        assertTrue(host != NULL);
+        if (!host) {
+            continue;
+        }
+        BtCodeChunk* chunk = memory->findCodeChunkContainingHostAddress(host + 1);
+        assertTrue(chunk != NULL);
+        if (chunk) {
+            assertTrue(memory->isAddressExecutable(host + 1));
+            assertTrue(chunk->getEipThatContainsHostAddress(host + 1, NULL, NULL) == CODE_ADDRESS + i * 3);
+            assertTrue(memory->getCodeChunkContainingHostAddress(host).get() == chunk);
+            // past the end of the code but still in its slot
+            assertTrue(memory->findCodeChunkContainingHostAddress((U8*)chunk->getHostAddress() + chunk->getHostAddressLen()) == NULL);
+        }
+    }
+    assertTrue(!memory->isAddressExecutable((void*)&blockCount));
+    assertTrue(memory->findCodeChunkContainingHostAddress((void*)memory->id) == NULL);
+
+    U8* host = (U8*)memory->getExistingHostAddress(CODE_ADDRESS);
+    memory->clearCodePageFromCache(CODE_ADDRESS >> K_PAGE_SHIFT);
+    // released, the memory isn't reused until no thread can still be looking at it
+    if (host) {
+        assertTrue(memory->findCodeChunkContainingHostAddress(host + 1) == NULL);
+    }
+    ((BtCPU*)cpu)->postTestRun();
+}
+
+// a jcc into the middle of an instruction in the same chunk can't be resolved to it and has to leave the chunk
+void testJumpIntoInstruction() {
+    for (U32 taken = 0; taken < 2; taken++) {
+        newInstruction(0);
+        if (taken) {
+            pushCode8(0x31); pushCode8(0xc0); // xor eax, eax
+        } else {
+            pushCode8(0x83); pushCode8(0xc8); pushCode8(0x01); // or eax, 1
+        }
+        pushCode8(0x74); pushCode8(0x01); // jz into the 0x40 below, which is inc eax
+        pushCode8(0xb0); pushCode8(0x40); // mov al, 0x40
+        pushCode8(0x40); // inc eax
+        runTestCPU();
+        assertTrue(EAX == (taken ? 2 : 0x41));
+    }
+}
+
+// a data write to a page with code only faults, it doesn't throw away the code, and a write to code only throws away
+// the chunk it hit
+void testSubPageCodeWrites() {
+    Memory* memory = cpu->thread->memory;
+    U32 page = CODE_ADDRESS >> K_PAGE_SHIFT;
+    U32 nativePage = memory->getNativePage(page);
+    bool subPageCodeWrites = KSystem::btSubPageCodeWrites;
+    KSystem::btSubPageCodeWrites = true;
+
+    // the same self modifying code tests as above
+    void (*selfModifyingTests[])() = {testSelfModifying, testSelfModifyingMovsb, testSelfModifyingFront, testSelfModifyingBack};
+    for (auto& test : selfModifyingTests) {
+        setup();
+        test();
+    }
+    setup();
+
+    newInstruction(0);
+    pushCode8(0xb9); // mov ecx, 50
+    pushCode32(50);
+    pushCode8(0x2e); // loop: mov cs:[0x800], ecx
+    pushCode8(0x89);
+    pushCode8(0x0d);
+    pushCode32(0x800);
+    pushCode8(0x2e); // add dword ptr cs:[0x804], 1
+    pushCode8(0x83);
+    pushCode8(0x05);
+    pushCode32(0x804);
+    pushCode8(0x01);
+    pushCode8(0x49); // dec ecx
+    pushCode8(0x75); // jnz loop
+    pushCode8(0xee);
+    pushCode8(0xcd); // int 0x97
+    pushCode8(0x97);
+    cseip = CODE_ADDRESS + 0x400;
+    pushCode8(0xb8); // mov eax, 7
+    pushCode32(7);
+    pushCode8(0xcd); // int 0x97
+    pushCode8(0x97);
+    writed(CODE_ADDRESS + 0x804, 0);
+
+    ((BtCPU*)cpu)->translateEip(0);
+    ((BtCPU*)cpu)->translateEip(0x400);
+    std::shared_ptr<BtCodeChunk> chunk = memory->getCodeChunkContainingEip(CODE_ADDRESS);
+    assertTrue(chunk != nullptr);
+    assertTrue((memory->nativeFlags[nativePage] & NATIVE_FLAG_CODEPAGE_READONLY) != 0);
+    assertTrue(memory->getCodeRegions(page) == ((U64)1 | ((U64)1 << (0x400 >> CODE_REGION_SHIFT))));
+
+    U64 dataWrites = memory->codePageDataWriteCount;
+    U64 codeWrites = memory->codePageCodeWriteCount;
+    cpu->eip.u32 = 0;
+    cpu->run();
+    assertTrue(readd(CODE_ADDRESS + 0x800) == 1);
+    assertTrue(readd(CODE_ADDRESS + 0x804) == 50);
+    assertTrue(memory->codePageDataWriteCount - dataWrites == 100);
+    assertTrue(memory->codePageCodeWriteCount == codeWrites);
+    assertTrue(memory->getCodeChunkContainingEip(CODE_ADDRESS) == chunk);
+    assertTrue(chunk->getValidEipLen() == chunk->getEipLen());
+    assertTrue(memory->dynamicCodePageUpdateCount[nativePage] == 0);
+
+    // change the mov eax, 7 into mov eax, 9
+    writeb(CODE_ADDRESS + 0x401, 9);
+    assertTrue(memory->codePageCodeWriteCount - codeWrites == 1);
+    assertTrue(chunk->getValidEipLen() == chunk->getEipLen());
+    assertTrue((memory->nativeFlags[nativePage] & NATIVE_FLAG_CODEPAGE_READONLY) != 0);
+    assertTrue(memory->getCodeRegions(page) == 1);
+    cpu->eip.u32 = 0x400;
+    cpu->run();
+    assertTrue(EAX == 9);
+
+    memory->clearCodePageFromCache(page);
+    ((BtCPU*)cpu)->postTestRun();
+    KSystem::btSubPageCodeWrites = subPageCodeWrites;
+}
+
+#ifdef BOXEDWINE_X64
+// ret should find its return address on the shadow stack once the code it returns to has been translated, without
+// disturbing the guest's ecx or flags
+void testShadowStack() {
+    newInstruction(0);
+    // the shadow stack is only used for flat code
+    cpu->seg[CS].address = 0;
+    cpu->thread->process->hasSetSeg[CS] = false;
+    cpu->eip.u32 = CODE_ADDRESS;
+    bool shadowStack = KSystem::btShadowStack;
+    KSystem::btShadowStack = true;
+
+    pushCode8(0x31); // xor eax, eax
+    pushCode8(0xc0);
+    pushCode8(0xb9); // mov ecx, 4
+    pushCode32(4);
+    pushCode8(0xe8); // call sub
+    pushCode32(8);
+    pushCode8(0x83); // adc eax, 0
+    pushCode8(0xd0);
+    pushCode8(0x00);
+    pushCode8(0x49); // dec ecx
+    pushCode8(0x75); // jnz call
+    pushCode8(0xf5);
+    pushCode8(0xcd); // int 0x97
+    pushCode8(0x97);
+    pushCode8(0x40); // sub: inc eax
+    pushCode8(0xf9); // stc
+    pushCode8(0xc3); // ret
+
+    x64CPU* x64 = (x64CPU*)cpu;
+    U32 hits = x64->shadowStackHits;
+    U32 misses = x64->shadowStackMisses;
+    cpu->run();
+    assertTrue(EAX == 8);
+    assertTrue(ECX == 0);
+    assertTrue(ESP == 4096);
+    // the first return goes to a stub that gets retranslated, which invalidates the shadow stack
+    assertTrue(x64->shadowStackMisses - misses == 1);
+    assertTrue(x64->shadowStackHits - hits == 3);
+
+    cpu->thread->memory->clearCodePageFromCache(CODE_ADDRESS >> K_PAGE_SHIFT);
+    cpu->seg[CS].address = CODE_ADDRESS;
+    cpu->thread->process->hasSetSeg[CS] = true;
+    KSystem::btShadowStack = shadowStack;
+}
+
+// releasing code in one process must not invalidate the shadow stack of another one
+void testCodeGeneration() {
+    Memory* memory = cpu->thread->memory;
+    U64 generation = memory->codeGeneration[0];
+    Memory* other = new Memory();
+    assertTrue(other->codeGeneration[0] != generation);
+    other->codeReleased();
+    assertTrue(memory->codeGeneration[0] == generation);
+    memory->codeReleased();
+    assertTrue(memory->codeGeneration[0] != generation);
+    assertTrue(memory->codeGeneration[1] == (U64)(-(S64)memory->codeGeneration[0]));
+    other->decRefCount();
+}
+
+// a dynamic check that has to restore the flags puts its retranslation trap in the chunk's cold code, the trap has to
+// find its way back to the instruction it belongs to, which is then retranslated in place along with its cold code
+void testColdCode() {
+    Memory* memory = cpu->thread->memory;
+    U32 nativePage = memory->getNativePage(CODE_ADDRESS >> K_PAGE_SHIFT);
+
+    newInstruction(0);
+    pushCode8(0xf9); // stc
+    pushCode8(0x83); // adc eax, 1
+    pushCode8(0xd0);
+    pushCode8(0x01);
+    pushCode8(0x40); // inc eax
+    pushCode8(0xcd);
+    pushCode8(0x97);
+    memory->dynamicCodePageUpdateCount[nativePage] = MAX_DYNAMIC_CODE_PAGE_COUNT;
+    ((BtCPU*)cpu)->translateEip(0);
+    std::shared_ptr<BtCodeChunk> chunk = memory->getCodeChunkContainingEip(CODE_ADDRESS);
+    U8* coldHost = NULL;
+    U32 coldLen = 0;
+    assertTrue(chunk && chunk->isDynamicAware() && chunk->getColdCode(1, &coldHost, &coldLen));
+    if (coldHost) {
+        assertTrue(chunk->getEipThatContainsHostAddress(coldHost, NULL, NULL) == CODE_ADDRESS + 1);
+        assertTrue(chunk->getEipThatContainsHostAddress(coldHost + coldLen - 1, NULL, NULL) == CODE_ADDRESS + 1);
+    }
+    cpu->run();
+    assertTrue(EAX == 3);
+
+    for (U32 i = 0; i < 2; i++) {
+        writeb(CODE_ADDRESS + 3, 0x10 + i);
+        EAX = 0;
+        cpu->eip.u32 = 0;
+        cpu->run();
+        assertTrue(EAX == 0x12 + i);
+        assertTrue(memory->getCodeChunkContainingEip(CODE_ADDRESS) == chunk);
+    }
+    memory->clearCodePageFromCache(CODE_ADDRESS >> K_PAGE_SHIFT);
+    ((BtCPU*)cpu)->postTestRun();
+}
+
+// code that only runs a few times is interpreted, once a block is hot it is translated and the translated code
+// returns to the interpreter when it jumps to a block that is still cold
+void testTieredExecution() {
+    Memory* memory = cpu->thread->memory;
+    U32 threshold = KSystem::btHotThreshold;
+    U32 blockCount = BtInterpreter::blockCount;
+    U32 promotedCount = BtInterpreter::promotedCount;
+    KSystem::btHotThreshold = 3;
+
+    newInstruction(0);
+    pushCode8(0x31); // xor eax, eax
+    pushCode8(0xc0);
+    pushCode8(0xb9); // mov ecx, 10
+    pushCode32(10);
+    pushCode8(0xe8); // call sub
+    pushCode32(8);
+    pushCode8(0x83); // adc eax, 0
+    pushCode8(0xd0);
+    pushCode8(0x00);
+    pushCode8(0x49); // dec ecx
+    pushCode8(0x75); // jnz call
+    pushCode8(0xf5);
+    pushCode8(0xcd); // int 0x97
+    pushCode8(0x97);
+    pushCode8(0x40); // sub: inc eax
+    pushCode8(0xf9); // stc
+    pushCode8(0xc3); // ret
+    U32 esp = ESP;
+    cpu->run();
+    assertTrue(EAX == 20);
+    assertTrue(ECX == 0);
+    assertTrue(ESP == esp);
+    assertTrue(BtInterpreter::blockCount - blockCount >= 6);
+    assertTrue(BtInterpreter::promotedCount > promotedCount);
+    // the start up code only ran once, it should never have been translated
+    assertTrue(memory->getExistingHostAddress(CODE_ADDRESS) == NULL);
+    assertTrue(memory->getExistingHostAddress(CODE_ADDRESS + 7) != NULL);
+
+    memory->clearCodePageFromCache(CODE_ADDRESS >> K_PAGE_SHIFT);
+    ((BtCPU*)cpu)->postTestRun();
+    KSystem::btHotThreshold = threshold;
+}
+
+// the jmp in the middle of the loop splits it over 2 chunks, once the links between them are hot they should be
+// translated again as one chunk
+void testTraces() {
+    Memory* memory = cpu->thread->memory;
+    U32 threshold = KSystem::btTraceThreshold;
+    U32 tracesFormed = BtCPU::tracesFormed;
+    KSystem::btTraceThreshold = 3;
+
+    newInstruction(0);
+    pushCode8(0x31); // xor eax, eax
+    pushCode8(0xc0);
+    pushCode8(0xb9); // mov ecx, 10
+    pushCode32(10);
+    pushCode8(0x40); // inc eax
+    pushCode8(0xeb); // jmp add
+    pushCode8(0x00);
+    pushCode8(0x83); // add: add eax, 2
+    pushCode8(0xc0);
+    pushCode8(0x02);
+    pushCode8(0x49); // dec ecx
+    pushCode8(0x75); // jnz inc
+    pushCode8(0xf7);
+    pushCode8(0xcd); // int 0x97
+    pushCode8(0x97);
+    cpu->run();
+    assertTrue(EAX == 30);
+    assertTrue(ECX == 0);
+    assertTrue(BtCPU::tracesFormed - tracesFormed == 1);
+    std::shared_ptr<BtCodeChunk> chunk = memory->getCodeChunkContainingEip(CODE_ADDRESS + 7);
+    assertTrue(chunk && chunk->getEip() == CODE_ADDRESS);
+    assertTrue(chunk && chunk->getHostFromEip(CODE_ADDRESS + 10) != NULL);
+
+    memory->clearCodePageFromCache(CODE_ADDRESS >> K_PAGE_SHIFT);
+    ((BtCPU*)cpu)->postTestRun();
+    KSystem::btTraceThreshold = threshold;
+}
+
+// a loop that only reads a flag should back off until another thread sets it, a loop that walks a list through the
+// memory it reads is not waiting on anyone
+void testSpinLoop() {
+    bool spinBackoff = KSystem::spinBackoff;
+    KSystem::spinBackoff = true;
+    cpu->big = true;
+
+    newInstruction(0);
+    writed(HEAP_ADDRESS + 0x100, 0);
+    pushCode8(0x83); // cmp dword [0x100], 0
+    pushCode8(0x3d);
+    pushCode32(0x100);
+    pushCode8(0x00);
+    pushCode8(0x74); // je cmp
+    pushCode8(0xf7);
+    pushCode8(0xa1); // mov eax, [0x100]
+    pushCode32(0x100);
+    U64 sleepCount = CPU::spinSleepCount;
+    volatile U32* flag = (volatile U32*)getNativeAddress(cpu->thread->memory, HEAP_ADDRESS + 0x100);
+    std::thread writer([flag]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        *flag = 5;
+    });
+    runTestCPU();
+    writer.join();
+    assertTrue(EAX == 5);
+    assertTrue(CPU::spinSleepCount > sleepCount);
+
+    newInstruction(0);
+    for (U32 i = 0; i < 16; i++) {
+        writed(HEAP_ADDRESS + 0x100 + i * 4, i == 15 ? 0 : 0x104 + i * 4);
+    }
+    EAX = 0x100;
+    pushCode8(0x8b); // mov eax, [eax]
+    pushCode8(0x00);
+    pushCode8(0x85); // test eax, eax
+    pushCode8(0xc0);
+    pushCode8(0x75); // jne mov
+    pushCode8(0xfa);
+    cpu->spinCountdown = CPU_SPIN_COUNT;
+    runTestCPU();
+    assertTrue(EAX == 0);
+    assertTrue(cpu->spinCountdown == CPU_SPIN_COUNT);
+
+    KSystem::spinBackoff = spinBackoff;
+}
+#endif
+#endif
+
 int runCpuTests() {
     printf("Please wait, these first 2 tests can take a while\n");
     run(test32BitMemoryAccess, "32-bit Memory Access");
@@ -11953,6 +13261,7 @@ int runCpuTests() {
     run(testFPU0x2d9, "FPU 2d9");    
     run(testFPU0x0da, "FPU 0da");
     run(testFPU0x2da, "FPU 2da");
+    run(testFPUPrecision, "FPU Precision");
 
     run(testLoopNZ0x0e0, "LoopNZ 0e0");
     run(testLoopNZ0x2e0, "LoopNZ 2e0");
@@ -12404,6 +13713,41 @@ int runCpuTests() {
     printf("Self Modifying Code Same Block(Next) ... Skipping\n");
 #else
     run(testSelfModifyingBack, "Self Modifying Code Same Block(Next)");
+#endif
+    run(testFlagLiveness, "Flag Liveness");
+    run(testFusion, "Fusion");
+#if !defined(BOXEDWINE_BINARY_TRANSLATOR) && !defined(BOXEDWINE_DYNAMIC)
+    run(testIndirectPrediction, "Indirect Prediction");
+#endif
+    run(testPauseSpinCount, "Pause Spin Count");
+    run(testRepStringPages, "Rep String Pages");
+#ifdef BOXEDWINE_DEFAULT_MMU
+    run(testCodePageWrites, "Code Page Writes");
+#endif
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+    run(testLockPrefix0x0f0, "Lock prefix 0f0");
+    run(testLockPrefix0x2f0, "Lock prefix 2f0");
+#endif
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+    run(testMultiThreadedLocks, "Multi-threaded Locks");
+#endif
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    run(testTranslationWorkers, "BT Translation Workers");
+    run(testCodeCache, "BT Code Cache");
+    run(testSharedCode, "BT Shared Code");
+    run(testCodeMemoryReuse, "BT Code Memory Reuse");
+    run(testCodeCacheLimit, "BT Code Cache Limit");
+    run(testHostAddressLookup, "BT Host Address Lookup");
+    run(testJumpIntoInstruction, "BT Jump Into Instruction");
+    run(testSubPageCodeWrites, "BT Sub-Page Code Writes");
+#ifdef BOXEDWINE_X64
+    run(testShadowStack, "BT Shadow Stack");
+    run(testCodeGeneration, "BT Code Generation");
+    run(testColdCode, "BT Cold Code");
+    run(testTieredExecution, "BT Tiered Execution");
+    run(testTraces, "BT Traces");
+    run(testSpinLoop, "BT Spin Loop");
+#endif
 #endif
     printf("%d tests FAILED\n", totalFails);
     KNativeThread::sleep(5000);
@@ -12430,6 +13774,9 @@ int runCpuTestsMac(void) {
 }
 #else
 int main(int argc, char** argv) {
+    if (argc > 1 && !strcmp(argv[1], "-bench")) {
+        return runCpuBenchmarks();
+    }
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
     int result = runCpuTests();
     KSystem::useSingleMemOffset = false;
@@ -1,14 +1,19 @@
 #ifndef __TEST_CPU_H__
 #define __TEST_CPU_H__
 
+void setup();
 void newInstruction(int flags);
 void pushCode8(int value);
 void pushCode16(int value);
 void pushCode32(int value);
 void runTestCPU();
+#if defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU)
+U64 runTestCPUOnThreads(U32 threadCount);
+#endif
 void failed(const char* msg, ...);
 
 extern CPU* cpu;
+extern U32 cseip;
 
 #define FLAG_MASK (AF|CF|SF|PF|ZF|OF)
 
@@ -61,9 +61,11 @@ void BoxedWineCondition::wait(std::unique_lock<std::mutex>& lock) {
     KThread* thread = KThread::currentThread();
     if (thread) {
         thread->waitingCond = this;
+        thread->cpu->beforeWait();
     }
     this->c.wait(lock);
     if (thread) {
+        thread->cpu->afterWait();
         thread->waitingCond = NULL;
     }
     if (parent) {
@@ -77,9 +79,11 @@ void BoxedWineCondition::waitWithTimeout(std::unique_lock<std::mutex>& lock, U32
     KThread* thread = KThread::currentThread();
     if (thread) {
         thread->waitingCond = this;
+        thread->cpu->beforeWait();
     }
     this->c.wait_for(lock, std::chrono::milliseconds(KSystem::emulatedMilliesToHost(ms)));
     if (thread) {
+        thread->cpu->afterWait();
         thread->waitingCond = NULL;
     }    
     if (parent) {